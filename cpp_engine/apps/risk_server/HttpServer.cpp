@@ -0,0 +1,559 @@
+#include "HttpServer.h"
+
+#include "Json.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace RiskServer {
+
+namespace {
+
+const char* statusText(int status) {
+    switch (status) {
+    case 200: return "OK";
+    case 201: return "Created";
+    case 202: return "Accepted";
+    case 204: return "No Content";
+    case 400: return "Bad Request";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 411: return "Length Required";
+    case 413: return "Payload Too Large";
+    case 429: return "Too Many Requests";
+    case 431: return "Request Header Fields Too Large";
+    case 500: return "Internal Server Error";
+    case 501: return "Not Implemented";
+    case 503: return "Service Unavailable";
+    default: return "Unknown";
+    }
+}
+
+std::string lowercase(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return text;
+}
+
+std::string trim(const std::string& text) {
+    const size_t begin = text.find_first_not_of(" \t");
+    if (begin == std::string::npos) {
+        return std::string();
+    }
+    return text.substr(begin, text.find_last_not_of(" \t") - begin + 1);
+}
+
+// Messages carry e.what(), so control characters must be escaped too
+std::string errorBody(const std::string& message) {
+    return Json::write(Json::Value::object({{"error", Json::Value::string(message)}}));
+}
+
+void setNonBlocking(int fd) {
+    const int flags = fcntl(fd, F_GETFL, 0);
+    if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+        throw std::runtime_error(std::string("fcntl failed: ") + std::strerror(errno));
+    }
+}
+
+} // namespace
+
+const std::string* HttpRequest::header(const std::string& name) const {
+    for (const auto& entry : headers) {
+        if (entry.first == name) {
+            return &entry.second;
+        }
+    }
+    return nullptr;
+}
+
+struct HttpServer::Connection {
+    uint64_t id = 0;
+    int fd = -1;
+    std::string input;
+    std::string output;
+    size_t output_offset = 0;
+    bool busy = false;              // a request is with the workers
+    bool close_after_write = false;
+    bool peer_closed = false;       // the client has sent everything it will
+    std::chrono::steady_clock::time_point last_active;
+};
+
+HttpServer::HttpServer(const Options& options, Handler handler)
+    : options_(options),
+      handler_(std::move(handler)),
+      listen_fd_(-1),
+      wake_fds_{-1, -1},
+      port_(0),
+      stopping_(false),
+      next_connection_id_(1),
+      jobs_closed_(false) {
+    if (options_.workers == 0) {
+        options_.workers = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_fd_ < 0) {
+        throw std::runtime_error(std::string("socket failed: ") + std::strerror(errno));
+    }
+    const int reuse = 1;
+    setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(options_.port));
+    if (inet_pton(AF_INET, options_.host.c_str(), &address.sin_addr) != 1) {
+        close(listen_fd_);
+        throw std::runtime_error("Invalid IPv4 address: " + options_.host);
+    }
+    if (bind(listen_fd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 ||
+        listen(listen_fd_, SOMAXCONN) < 0) {
+        const std::string error = std::strerror(errno);
+        close(listen_fd_);
+        throw std::runtime_error("Cannot listen on " + options_.host + ":" +
+                                 std::to_string(options_.port) + ": " + error);
+    }
+    socklen_t length = sizeof(address);
+    getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&address), &length);
+    port_ = ntohs(address.sin_port);
+
+    if (pipe(wake_fds_) < 0) {
+        close(listen_fd_);
+        throw std::runtime_error(std::string("pipe failed: ") + std::strerror(errno));
+    }
+    setNonBlocking(listen_fd_);
+    setNonBlocking(wake_fds_[0]);
+    setNonBlocking(wake_fds_[1]);
+}
+
+HttpServer::~HttpServer() {
+    for (auto& entry : connections_) {
+        close(entry.second->fd);
+    }
+    close(listen_fd_);
+    close(wake_fds_[0]);
+    close(wake_fds_[1]);
+}
+
+int HttpServer::getPort() const {
+    return port_;
+}
+
+unsigned HttpServer::getWorkers() const {
+    return options_.workers;
+}
+
+void HttpServer::stop() {
+    stopping_ = true;
+    wake();
+}
+
+void HttpServer::wake() {
+    const char byte = 1;
+    // A full pipe already guarantees a wake-up
+    ssize_t ignored = write(wake_fds_[1], &byte, 1);
+    (void)ignored;
+}
+
+void HttpServer::run() {
+    for (unsigned i = 0; i < options_.workers; ++i) {
+        workers_.emplace_back(&HttpServer::workerLoop, this);
+    }
+
+    std::vector<pollfd> fds;
+    std::vector<uint64_t> ids;
+    while (!stopping_) {
+        const int timeout_ms = closeIdleConnections();
+        fds.clear();
+        ids.clear();
+        // At the cap, further clients stay in the listen backlog until a
+        // connection closes or idles out
+        fds.push_back({listen_fd_, static_cast<short>(connections_.size() < options_.max_connections ? POLLIN : 0), 0});
+        fds.push_back({wake_fds_[0], POLLIN, 0});
+        for (const auto& entry : connections_) {
+            const Connection& connection = *entry.second;
+            short events = 0;
+            if (!connection.busy && !connection.close_after_write && !connection.peer_closed) {
+                events |= POLLIN;
+            }
+            if (connection.output_offset < connection.output.size()) {
+                events |= POLLOUT;
+            }
+            fds.push_back({connection.fd, events, 0});
+            ids.push_back(entry.first);
+        }
+
+        if (poll(fds.data(), fds.size(), timeout_ms) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error(std::string("poll failed: ") + std::strerror(errno));
+        }
+
+        if (fds[1].revents & POLLIN) {
+            char buffer[256];
+            while (read(wake_fds_[0], buffer, sizeof(buffer)) > 0) {
+            }
+            drainCompletions();
+        }
+        for (size_t i = 2; i < fds.size(); ++i) {
+            auto it = connections_.find(ids[i - 2]);
+            if (it == connections_.end()) {
+                continue;
+            }
+            Connection& connection = *it->second;
+            if ((fds[i].revents & (POLLIN | POLLHUP | POLLERR)) && !connection.peer_closed) {
+                readFrom(connection);
+            }
+            // Both directions are down, so a response could not be delivered
+            if (connection.fd >= 0 && (fds[i].revents & (POLLHUP | POLLERR))) {
+                close(connection.fd);
+                connection.fd = -1;
+            }
+            if (connection.fd >= 0 && (fds[i].revents & POLLOUT)) {
+                writeTo(connection);
+            }
+            if (connection.fd < 0) {
+                connections_.erase(it);
+            }
+        }
+        if (fds[0].revents & POLLIN) {
+            acceptConnections();
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(jobs_mutex_);
+        jobs_closed_ = true;
+    }
+    jobs_ready_.notify_all();
+    for (std::thread& worker : workers_) {
+        worker.join();
+    }
+    workers_.clear();
+}
+
+void HttpServer::acceptConnections() {
+    while (true) {
+        const int fd = accept(listen_fd_, nullptr, nullptr);
+        if (fd < 0) {
+            return;
+        }
+        setNonBlocking(fd);
+        const int no_delay = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay));
+
+        auto connection = std::make_unique<Connection>();
+        connection->id = next_connection_id_++;
+        connection->fd = fd;
+        connection->last_active = std::chrono::steady_clock::now();
+        connections_.emplace(connection->id, std::move(connection));
+        if (connections_.size() >= options_.max_connections) {
+            return;
+        }
+    }
+}
+
+// Closes connections that have not sent or received anything for the idle
+// timeout; a request with the workers does not count as idle. Returns the
+// poll() timeout until the next connection could idle out.
+int HttpServer::closeIdleConnections() {
+    if (options_.idle_timeout_ms <= 0) {
+        return -1;
+    }
+    const auto now = std::chrono::steady_clock::now();
+    const auto idle_timeout = std::chrono::milliseconds(options_.idle_timeout_ms);
+    auto next_deadline = std::chrono::steady_clock::time_point::max();
+    for (auto it = connections_.begin(); it != connections_.end();) {
+        Connection& connection = *it->second;
+        if (connection.busy) {
+            ++it;
+            continue;
+        }
+        const auto deadline = connection.last_active + idle_timeout;
+        if (deadline <= now) {
+            close(connection.fd);
+            it = connections_.erase(it);
+            continue;
+        }
+        next_deadline = std::min(next_deadline, deadline);
+        ++it;
+    }
+    if (next_deadline == std::chrono::steady_clock::time_point::max()) {
+        return -1;
+    }
+    const auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(next_deadline - now);
+    return static_cast<int>(wait.count()) + 1;
+}
+
+// Reads no further than the first buffered request may reach under the
+// header and body limits. dispatchRequest then answers or rejects it, and
+// any bytes beyond stay in the socket until the connection polls again.
+void HttpServer::readFrom(Connection& connection) {
+    char buffer[64 * 1024];
+    size_t header_end = connection.input.find("\r\n\r\n");
+    while (true) {
+        const size_t limit = header_end == std::string::npos
+            ? options_.max_header_bytes + 4
+            : header_end + 4 + options_.max_body_bytes;
+        if (connection.input.size() >= limit) {
+            break;
+        }
+        const size_t wanted = std::min(sizeof(buffer), limit - connection.input.size());
+        const ssize_t received = recv(connection.fd, buffer, wanted, 0);
+        if (received > 0) {
+            // The terminator may straddle the previous read
+            const size_t scan_from = connection.input.size() < 3 ? 0 : connection.input.size() - 3;
+            connection.input.append(buffer, static_cast<size_t>(received));
+            connection.last_active = std::chrono::steady_clock::now();
+            if (header_end == std::string::npos) {
+                header_end = connection.input.find("\r\n\r\n", scan_from);
+            }
+            continue;
+        }
+        if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        }
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received == 0) {
+            // End of input; requests already buffered are still answered
+            connection.peer_closed = true;
+            break;
+        }
+        // Failed: a response in progress has nowhere to go, so the worker's
+        // result is dropped when it arrives
+        close(connection.fd);
+        connection.fd = -1;
+        return;
+    }
+    dispatchRequest(connection);
+    closeIfPeerDone(connection);
+}
+
+// Once a half-closed client has no request in flight, nothing more can come:
+// close after the last response is written. An incomplete request left in
+// the buffer is discarded.
+void HttpServer::closeIfPeerDone(Connection& connection) {
+    if (!connection.peer_closed || connection.busy || connection.fd < 0) {
+        return;
+    }
+    if (connection.output_offset < connection.output.size()) {
+        connection.close_after_write = true;
+        return;
+    }
+    close(connection.fd);
+    connection.fd = -1;
+}
+
+void HttpServer::dispatchRequest(Connection& connection) {
+    if (connection.busy || connection.close_after_write || connection.fd < 0) {
+        return;
+    }
+
+    const size_t header_end = connection.input.find("\r\n\r\n");
+    if (header_end == std::string::npos) {
+        if (connection.input.size() > options_.max_header_bytes) {
+            respond(connection, {431, "application/json", errorBody("Request headers too large")}, false);
+        }
+        return;
+    }
+    if (header_end > options_.max_header_bytes) {
+        respond(connection, {431, "application/json", errorBody("Request headers too large")}, false);
+        return;
+    }
+
+    HttpRequest request;
+    size_t line_end = connection.input.find("\r\n");
+    const std::string request_line = connection.input.substr(0, line_end);
+    const size_t first_space = request_line.find(' ');
+    const size_t second_space = request_line.find(' ', first_space + 1);
+    if (first_space == std::string::npos || second_space == std::string::npos) {
+        respond(connection, {400, "application/json", errorBody("Malformed request line")}, false);
+        return;
+    }
+    request.method = request_line.substr(0, first_space);
+    const std::string target = request_line.substr(first_space + 1, second_space - first_space - 1);
+    const std::string version = request_line.substr(second_space + 1);
+    const size_t query = target.find('?');
+    request.path = target.substr(0, query);
+    if (query != std::string::npos) {
+        request.query = target.substr(query + 1);
+    }
+
+    while (line_end < header_end) {
+        const size_t next = connection.input.find("\r\n", line_end + 2);
+        const std::string line = connection.input.substr(line_end + 2, next - line_end - 2);
+        line_end = next;
+        const size_t colon = line.find(':');
+        if (colon == std::string::npos) {
+            respond(connection, {400, "application/json", errorBody("Malformed header line")}, false);
+            return;
+        }
+        request.headers.emplace_back(lowercase(trim(line.substr(0, colon))), trim(line.substr(colon + 1)));
+    }
+
+    if (request.header("transfer-encoding")) {
+        respond(connection, {501, "application/json", errorBody("Chunked request bodies are not supported")}, false);
+        return;
+    }
+    size_t content_length = 0;
+    if (const std::string* length = request.header("content-length")) {
+        char* end = nullptr;
+        errno = 0;
+        const unsigned long long parsed = std::strtoull(length->c_str(), &end, 10);
+        if (length->empty() || *end != '\0' || errno == ERANGE) {
+            respond(connection, {400, "application/json", errorBody("Invalid Content-Length")}, false);
+            return;
+        }
+        if (parsed > options_.max_body_bytes) {
+            respond(connection, {413, "application/json", errorBody("Request body too large")}, false);
+            return;
+        }
+        content_length = static_cast<size_t>(parsed);
+    }
+
+    const size_t body_begin = header_end + 4;
+    if (connection.input.size() < body_begin + content_length) {
+        return;  // the rest of the body has not arrived yet
+    }
+    request.body = connection.input.substr(body_begin, content_length);
+    connection.input.erase(0, body_begin + content_length);
+
+    const std::string* connection_header = request.header("connection");
+    const std::string connection_option = connection_header ? lowercase(*connection_header) : "";
+    const bool keep_alive = (version == "HTTP/1.0" ? connection_option == "keep-alive"
+                                                   : connection_option != "close") &&
+                            !(connection.peer_closed && connection.input.empty());
+
+    {
+        std::lock_guard<std::mutex> lock(jobs_mutex_);
+        if (jobs_.size() < options_.max_queued_requests) {
+            connection.busy = true;
+            jobs_.push_back({connection.id, keep_alive, std::move(request),
+                             options_.trace ? TraceRecorder::Clock::now() : TraceRecorder::Clock::time_point()});
+        }
+    }
+    if (connection.busy) {
+        jobs_ready_.notify_one();
+    } else {
+        respond(connection, {503, "application/json", errorBody("Server busy, retry later")}, keep_alive);
+    }
+}
+
+void HttpServer::respond(Connection& connection, const HttpResponse& response, bool keep_alive) {
+    std::string& out = connection.output;
+    out += "HTTP/1.1 " + std::to_string(response.status) + " " + statusText(response.status) + "\r\n";
+    out += "Content-Type: " + response.content_type + "\r\n";
+    out += "Content-Length: " + std::to_string(response.body.size()) + "\r\n";
+    out += "Access-Control-Allow-Origin: *\r\n";
+    out += "Access-Control-Allow-Methods: GET, POST, OPTIONS\r\n";
+    out += "Access-Control-Allow-Headers: Content-Type\r\n";
+    out += keep_alive ? "Connection: keep-alive\r\n\r\n" : "Connection: close\r\n\r\n";
+    out += response.body;
+    if (!keep_alive) {
+        connection.close_after_write = true;
+    }
+    writeTo(connection);
+}
+
+void HttpServer::writeTo(Connection& connection) {
+    while (connection.output_offset < connection.output.size()) {
+        const ssize_t sent = send(connection.fd, connection.output.data() + connection.output_offset,
+                                  connection.output.size() - connection.output_offset, 0);
+        if (sent > 0) {
+            connection.output_offset += static_cast<size_t>(sent);
+            connection.last_active = std::chrono::steady_clock::now();
+            continue;
+        }
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return;
+        }
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        close(connection.fd);
+        connection.fd = -1;
+        return;
+    }
+    connection.output.clear();
+    connection.output_offset = 0;
+    if (connection.close_after_write) {
+        close(connection.fd);
+        connection.fd = -1;
+    }
+}
+
+void HttpServer::drainCompletions() {
+    std::vector<Completion> completions;
+    {
+        std::lock_guard<std::mutex> lock(completions_mutex_);
+        completions.swap(completions_);
+    }
+    for (Completion& completion : completions) {
+        auto it = connections_.find(completion.connection_id);
+        if (it == connections_.end()) {
+            continue;  // the client went away
+        }
+        Connection& connection = *it->second;
+        connection.busy = false;
+        connection.last_active = std::chrono::steady_clock::now();
+        if (connection.fd >= 0) {
+            respond(connection, completion.response, completion.keep_alive);
+        }
+        // A pipelined request may already be buffered
+        dispatchRequest(connection);
+        closeIfPeerDone(connection);
+        if (connection.fd < 0) {
+            connections_.erase(it);
+        }
+    }
+}
+
+void HttpServer::workerLoop() {
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(jobs_mutex_);
+            jobs_ready_.wait(lock, [this]() { return jobs_closed_ || !jobs_.empty(); });
+            if (jobs_.empty()) {
+                return;
+            }
+            job = std::move(jobs_.front());
+            jobs_.pop_front();
+        }
+
+        HttpResponse response;
+        try {
+            if (options_.trace) {
+                options_.trace->record("queue_wait", "http", job.queued, TraceRecorder::Clock::now());
+            }
+            TraceSpan request_span(options_.trace, "request", "http");
+            response = handler_(job.request);
+        } catch (const std::exception& e) {
+            response = {500, "application/json", errorBody(std::string("Internal server error: ") + e.what())};
+        } catch (...) {
+            response = {500, "application/json", errorBody("Internal server error")};
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(completions_mutex_);
+            completions_.push_back({job.connection_id, job.keep_alive, std::move(response)});
+        }
+        wake();
+    }
+}
+
+} // namespace RiskServer
@@ -0,0 +1,127 @@
+#ifndef RISK_SERVER_HTTP_SERVER_H
+#define RISK_SERVER_HTTP_SERVER_H
+
+#include "TraceRecorder.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace RiskServer {
+
+struct HttpRequest {
+    std::string method;
+    std::string path;           // without the query string
+    std::string query;
+    std::vector<std::pair<std::string, std::string>> headers;  // names lowercased
+    std::string body;
+
+    // Value of the first header with this (lowercase) name, or nullptr
+    const std::string* header(const std::string& name) const;
+};
+
+struct HttpResponse {
+    int status = 200;
+    std::string content_type = "application/json";
+    std::string body;
+};
+
+using Handler = std::function<HttpResponse(const HttpRequest&)>;
+
+// HTTP/1.1 server for local use. One thread runs a poll() event loop that
+// accepts connections, reads requests and writes responses without blocking;
+// complete requests are handed to a fixed pool of worker threads running the
+// handler, so a long calculation never stalls other connections. Requests
+// need a Content-Length (no chunked bodies); connections are kept alive
+// unless the client asks otherwise. A client that half-closes after sending
+// still gets its responses. Connections idle past the timeout are closed, and
+// at the connection cap new clients wait in the listen backlog.
+class HttpServer {
+public:
+    struct Options {
+        std::string host = "127.0.0.1";
+        int port = 10001;                           // 0 picks a free port
+        unsigned workers = 0;                       // 0: one per hardware thread
+        size_t max_queued_requests = 256;           // beyond this: 503
+        size_t max_header_bytes = 16 * 1024;        // beyond this: 431
+        size_t max_body_bytes = 64 * 1024 * 1024;   // beyond this: 413
+        size_t max_connections = 1024;              // beyond this: not accepted yet
+        int idle_timeout_ms = 30000;                // 0: never; requests in flight never idle
+        TraceRecorder* trace = nullptr;             // queue waits and handler spans
+    };
+
+    // Binds and listens; throws std::runtime_error on failure
+    HttpServer(const Options& options, Handler handler);
+    ~HttpServer();
+
+    HttpServer(const HttpServer&) = delete;
+    HttpServer& operator=(const HttpServer&) = delete;
+
+    // Serves until stop(); returns once the workers have finished
+    void run();
+
+    // Safe from any thread and from a signal handler
+    void stop();
+
+    int getPort() const;
+    unsigned getWorkers() const;
+
+private:
+    struct Connection;
+    struct Job {
+        uint64_t connection_id;
+        bool keep_alive;
+        HttpRequest request;
+        TraceRecorder::Clock::time_point queued;
+    };
+    struct Completion {
+        uint64_t connection_id;
+        bool keep_alive;
+        HttpResponse response;
+    };
+
+    Options options_;
+    Handler handler_;
+    int listen_fd_;
+    int wake_fds_[2];
+    int port_;
+    std::atomic<bool> stopping_;
+
+    std::map<uint64_t, std::unique_ptr<Connection>> connections_;
+    uint64_t next_connection_id_;
+
+    std::vector<std::thread> workers_;
+    std::mutex jobs_mutex_;
+    std::condition_variable jobs_ready_;
+    std::deque<Job> jobs_;
+    bool jobs_closed_;
+
+    std::mutex completions_mutex_;
+    std::vector<Completion> completions_;
+
+    void wake();
+    void acceptConnections();
+    int closeIdleConnections();
+    void readFrom(Connection& connection);
+    void closeIfPeerDone(Connection& connection);
+    void dispatchRequest(Connection& connection);
+    void respond(Connection& connection, const HttpResponse& response, bool keep_alive);
+    void writeTo(Connection& connection);
+    void drainCompletions();
+    void workerLoop();
+};
+
+} // namespace RiskServer
+
+#endif
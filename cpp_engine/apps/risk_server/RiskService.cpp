@@ -0,0 +1,451 @@
+#include "RiskService.h"
+
+#include "Ingestion.h"
+#include "Json.h"
+#include "Portfolio.h"
+
+#include <climits>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace RiskServer {
+
+namespace {
+
+// A malformed request, reported as 400 with the message verbatim
+class RequestError : public std::runtime_error {
+public:
+    explicit RequestError(const std::string& message) : std::runtime_error(message) {}
+};
+
+Json::Value number(double value) {
+    return Json::Value::number(value);
+}
+
+Json::Value integer(long long value) {
+    return Json::Value::number(static_cast<double>(value), true);
+}
+
+HttpResponse json(int status, const Json::Value& body) {
+    return {status, "application/json", Json::write(body)};
+}
+
+HttpResponse error(int status, const std::string& message) {
+    return json(status, Json::Value::object({{"error", Json::Value::string(message)}}));
+}
+
+Json::Value parseBody(const HttpRequest& request) {
+    Json::Value body;
+    try {
+        body = Json::parse(request.body);
+    } catch (const std::invalid_argument&) {
+        throw RequestError("Request body must be valid JSON");
+    }
+    if (!body.isObject() || body.asObject().empty()) {
+        throw RequestError("Request body must be valid JSON");
+    }
+    return body;
+}
+
+const int kMaxTailScenarios = 100;
+const int kMaxSimulations = 1000000;
+
+// 1000000 as "1,000,000"
+std::string grouped(long long value) {
+    std::string digits = std::to_string(value);
+    for (int i = static_cast<int>(digits.size()) - 3; i > 0; i -= 3) {
+        digits.insert(static_cast<size_t>(i), ",");
+    }
+    return digits;
+}
+
+// The Flask service's validate_var_parameters, with the same defaults and
+// messages; `echo` receives the response's var_parameters block. A sharded
+// run passes `total_paths`, which receives its path count instead of the
+// config and may go up to RiskEngine::kMaxShardedSimulations.
+RiskConfig varConfig(const Json::Value* params, Json::Value& echo, int& tail_scenarios,
+                     long long* total_paths = nullptr) {
+    const long long max_simulations = total_paths ? RiskEngine::kMaxShardedSimulations : kMaxSimulations;
+    int simulations = 10000;
+    double confidence = 0.95;
+    double horizon = 1.0;
+    RiskConfig config;
+    tail_scenarios = 0;
+
+    if (params && !params->isNull()) {
+        if (!params->isObject()) {
+            throw std::invalid_argument("var_parameters must be an object");
+        }
+        if (const Json::Value* value = params->find("simulations")) {
+            if (!value->isInteger() || value->asNumber() <= 0 || value->asNumber() > max_simulations) {
+                throw std::invalid_argument("VaR simulations must be a positive integer <= " +
+                                            grouped(max_simulations));
+            }
+            simulations = static_cast<int>(value->asNumber());
+        }
+        if (const Json::Value* value = params->find("confidence")) {
+            if (!value->isNumber() || value->asNumber() <= 0.0 || value->asNumber() >= 1.0) {
+                throw std::invalid_argument("VaR confidence must be between 0 and 1");
+            }
+            confidence = value->asNumber();
+        }
+        if (const Json::Value* value = params->find("time_horizon")) {
+            if (!value->isNumber() || value->asNumber() <= 0.0 || value->asNumber() > 252.0) {
+                throw std::invalid_argument("VaR time horizon must be between 0 and 252 days");
+            }
+            horizon = value->asNumber();
+        }
+        const Json::Value* seed = params->find("seed");
+        if (seed && !seed->isNull()) {
+            if (!seed->isInteger() || seed->asNumber() < 0 || seed->asNumber() > UINT_MAX) {
+                throw std::invalid_argument("Random seed must be a non-negative integer");
+            }
+            config = config.withRandomSeed(static_cast<unsigned int>(seed->asNumber()));
+        }
+        if (const Json::Value* value = params->find("fast_american_revaluation")) {
+            if (!value->isBoolean()) {
+                throw std::invalid_argument("fast_american_revaluation must be a boolean");
+            }
+            config = config.withFastAmericanRevaluation(value->asBoolean());
+        }
+        if (const Json::Value* value = params->find("jump_scenarios")) {
+            if (!value->isBoolean()) {
+                throw std::invalid_argument("jump_scenarios must be a boolean");
+            }
+            config = config.withJumpDiffusionScenarios(value->asBoolean());
+        }
+        if (const Json::Value* value = params->find("diagnostics")) {
+            if (!value->isBoolean()) {
+                throw std::invalid_argument("diagnostics must be a boolean");
+            }
+            config = config.withDiagnostics(value->asBoolean());
+        }
+        if (const Json::Value* value = params->find("random_generator")) {
+            const std::string generator = value->isString() ? value->asString() : "";
+            if (generator != "mersenne_twister" && generator != "philox") {
+                throw std::invalid_argument("random_generator must be 'mersenne_twister' or 'philox'");
+            }
+            config = config.withRandomGenerator(generator == "philox" ? RandomGenerator::Philox
+                                                                      : RandomGenerator::MersenneTwister);
+        }
+        if (const Json::Value* value = params->find("tail_scenarios")) {
+            if (!value->isInteger() || value->asNumber() < 0 || value->asNumber() > kMaxTailScenarios) {
+                throw std::invalid_argument("tail_scenarios must be an integer between 0 and " +
+                                            std::to_string(kMaxTailScenarios));
+            }
+            tail_scenarios = static_cast<int>(value->asNumber());
+        }
+        if (tail_scenarios > 0 &&
+            (config.getRandomGenerator() != RandomGenerator::Philox || !config.getUseFixedSeed())) {
+            throw std::invalid_argument("tail_scenarios requires random_generator 'philox' and a seed");
+        }
+    }
+
+    echo = Json::Value::object({
+        {"simulations", integer(simulations)},
+        {"confidence_level", number(confidence)},
+        {"time_horizon_days", number(horizon)},
+    });
+    if (total_paths) {
+        *total_paths = simulations;
+        return config.withVaRTimeHorizonDays(horizon);
+    }
+    return config.withVaRSimulations(simulations).withVaRTimeHorizonDays(horizon);
+}
+
+// The portfolio and market data of a risk request; returns the market data
+// block as given, for echoing back
+Json::Value parsePortfolio(const Json::Value& body, Portfolio& portfolio,
+                           std::map<std::string, MarketData>& market_data_map) {
+    const Json::Value* items = body.find("portfolio");
+    if (!items) {
+        throw RequestError("Missing required field 'portfolio'");
+    }
+    const Json::Value* market_data = body.find("market_data");
+    const Json::Value empty_market_data = Json::Value::object();
+    if (!market_data || market_data->isNull()) {
+        market_data = &empty_market_data;
+    }
+    if (!items->isArray()) {
+        throw RequestError("Field 'portfolio' must be an array");
+    }
+    if (!market_data->isObject()) {
+        throw RequestError("Field 'market_data' must be an object");
+    }
+    if (items->asArray().empty()) {
+        throw RequestError("Portfolio cannot be empty");
+    }
+
+    portfolio.reserve(items->asArray().size());
+    for (size_t i = 0; i < items->asArray().size(); ++i) {
+        Ingestion::Position position;
+        try {
+            position = Ingestion::positionFromJson(items->asArray()[i]);
+        } catch (const std::invalid_argument& e) {
+            throw std::invalid_argument("Portfolio item " + std::to_string(i) + ": " + e.what());
+        }
+        portfolio.addInstrument(std::move(position.instrument), position.quantity);
+    }
+
+    for (const auto& member : market_data->asObject()) {
+        market_data_map[member.first] = Ingestion::marketDataFromJson(member.first, member.second);
+    }
+    std::string missing;
+    for (const auto& net : portfolio.getNetPositions()) {
+        if (market_data_map.find(net.first) == market_data_map.end()) {
+            missing += (missing.empty() ? "" : ", ") + net.first;
+        }
+    }
+    if (!missing.empty()) {
+        throw RequestError("Missing market data for: " + missing +
+                           ". The native server does not fetch market data; please provide it.");
+    }
+    return *market_data;
+}
+
+Json::Value scenariosJson(const std::vector<RiskScenario>& scenarios) {
+    Json::Value::Array rows;
+    for (const RiskScenario& scenario : scenarios) {
+        Json::Value::Object spots;
+        for (const auto& spot : scenario.spots) {
+            spots.emplace_back(spot.first, number(spot.second));
+        }
+        rows.push_back(Json::Value::object({
+            {"path", integer(scenario.path)},
+            {"pnl", number(scenario.pnl)},
+            {"spots", Json::Value::object(std::move(spots))},
+        }));
+    }
+    return Json::Value::array(std::move(rows));
+}
+
+Json::Value diagnosticsJson(const RiskDiagnostics& diagnostics) {
+    Json::Value::Array phases;
+    for (const RiskPhaseTiming& timing : diagnostics.phases) {
+        Json::Value::Object phase = {
+            {"phase", Json::Value::string(timing.phase)},
+            {"wall_seconds", number(timing.wall_seconds)},
+            {"cpu_seconds", number(timing.cpu_seconds)},
+        };
+        if (diagnostics.allocations_counted) {
+            phase.emplace_back("allocations", integer(timing.allocations));
+            phase.emplace_back("allocated_bytes", integer(timing.allocated_bytes));
+        }
+        phases.push_back(Json::Value::object(std::move(phase)));
+    }
+    Json::Value::Object revaluations;
+    for (const auto& count : diagnostics.revaluations) {
+        revaluations.emplace_back(count.first, integer(count.second));
+    }
+    Json::Value::Array slowest;
+    for (const PositionTiming& timing : diagnostics.slowest_positions) {
+        slowest.push_back(Json::Value::object({
+            {"position", integer(static_cast<long long>(timing.position))},
+            {"asset_id", Json::Value::string(timing.asset_id)},
+            {"pricing_model", Json::Value::string(timing.pricing_model)},
+            {"seconds", number(timing.seconds)},
+        }));
+    }
+    Json::Value::Object result = {
+        {"phases", Json::Value::array(std::move(phases))},
+        {"revaluations", Json::Value::object(std::move(revaluations))},
+        {"slowest_positions", Json::Value::array(std::move(slowest))},
+    };
+    if (diagnostics.allocations_counted) {
+        result.emplace_back("allocations", integer(diagnostics.allocations));
+        result.emplace_back("allocated_bytes", integer(diagnostics.allocated_bytes));
+    }
+    return Json::Value::object(std::move(result));
+}
+
+} // namespace
+
+RiskService::RiskService(size_t cache_bytes, std::shared_ptr<TraceRecorder> trace)
+    : cache_(cache_bytes),
+      trace_(std::move(trace)),
+      started_(std::chrono::steady_clock::now()),
+      requests_(0) {
+}
+
+HttpResponse RiskService::handle(const HttpRequest& request) {
+    ++requests_;
+
+    struct Route {
+        const char* path;
+        const char* method;
+        HttpResponse (RiskService::*handler)(const HttpRequest&);
+    };
+    static const Route kRoutes[] = {
+        {"/calculate_risk", "POST", &RiskService::calculateRisk},
+        {"/price_option", "POST", &RiskService::priceOption},
+        {"/var_shard", "POST", &RiskService::varShard},
+    };
+
+    if (request.path == "/health") {
+        return request.method == "GET" ? health() : error(405, "Method not allowed");
+    }
+    for (const Route& route : kRoutes) {
+        if (request.path != route.path) {
+            continue;
+        }
+        if (request.method == "OPTIONS") {
+            return {204, "application/json", ""};
+        }
+        if (request.method != route.method) {
+            return error(405, "Method not allowed");
+        }
+        try {
+            return (this->*route.handler)(request);
+        } catch (const RequestError& e) {
+            return error(400, e.what());
+        } catch (const std::invalid_argument& e) {
+            return error(400, std::string("Validation error: ") + e.what());
+        } catch (const std::exception& e) {
+            return error(500, std::string("Runtime error: ") + e.what());
+        }
+    }
+    return error(404, "Endpoint not found");
+}
+
+HttpResponse RiskService::calculateRisk(const HttpRequest& request) {
+    const Json::Value body = parseBody(request);
+
+    Portfolio portfolio;
+    std::map<std::string, MarketData> market_data_map;
+    const Json::Value market_data = parsePortfolio(body, portfolio, market_data_map);
+
+    Json::Value var_parameters;
+    int tail_scenarios = 0;
+    const RiskConfig config =
+        varConfig(body.find("var_parameters"), var_parameters, tail_scenarios).withTrace(trace_);
+
+    RiskResultCache::Source source = RiskResultCache::Source::Computed;
+    const PortfolioRiskResult result =
+        cache_.calculate(engine_, portfolio, market_data_map, config, &source);
+    if (!result.isValid()) {
+        return error(500, "Risk calculation produced invalid results");
+    }
+
+    Json::Value::Object response = {
+        {"total_pv", number(result.total_pv)},
+        {"total_delta", number(result.total_delta)},
+        {"total_gamma", number(result.total_gamma)},
+        {"total_vega", number(result.total_vega)},
+        {"total_theta", number(result.total_theta)},
+        {"value_at_risk_95", number(result.value_at_risk_95)},
+        {"portfolio_size", integer(static_cast<long long>(portfolio.size()))},
+        {"var_parameters", var_parameters},
+        {"market_data_info", Json::Value::object({
+            {"auto_fetched_assets", Json::Value::array()},
+            {"market_data_used", market_data},
+        })},
+        {"cached", Json::Value::boolean(source == RiskResultCache::Source::Cached)},
+        {"coalesced", Json::Value::boolean(source == RiskResultCache::Source::Coalesced)},
+    };
+    if (result.diagnostics.enabled) {
+        response.emplace_back("diagnostics", diagnosticsJson(result.diagnostics));
+    }
+    if (tail_scenarios > 0) {
+        response.emplace_back("tail_scenarios", scenariosJson(engine_.worstScenarios(
+            portfolio, market_data_map, config, static_cast<size_t>(tail_scenarios))));
+    }
+    return json(200, Json::Value::object(std::move(response)));
+}
+
+HttpResponse RiskService::varShard(const HttpRequest& request) {
+    const Json::Value body = parseBody(request);
+
+    Portfolio portfolio;
+    std::map<std::string, MarketData> market_data_map;
+    parsePortfolio(body, portfolio, market_data_map);
+
+    const Json::Value* shard = body.find("shard");
+    if (!shard) {
+        throw RequestError("Missing required field 'shard'");
+    }
+    if (!shard->isObject()) {
+        throw RequestError("Field 'shard' must be an object");
+    }
+    long long range[2] = {0, 0};
+    const char* bounds[2] = {"first_path", "last_path"};
+    for (int i = 0; i < 2; ++i) {
+        const Json::Value* value = shard->find(bounds[i]);
+        if (!value || !value->isInteger()) {
+            throw RequestError(std::string("Field 'shard.") + bounds[i] + "' must be an integer");
+        }
+        range[i] = static_cast<long long>(value->asNumber());
+    }
+
+    Json::Value var_parameters;
+    int tail_scenarios = 0;
+    long long total_paths = 0;
+    const RiskConfig config = varConfig(body.find("var_parameters"), var_parameters, tail_scenarios,
+                                        &total_paths).withTrace(trace_);
+    const VaRShard result =
+        engine_.calculateVaRShard(portfolio, market_data_map, config, total_paths, range[0], range[1]);
+    return {200, "application/octet-stream", result.serialize()};
+}
+
+HttpResponse RiskService::priceOption(const HttpRequest& request) {
+    const Json::Value body = parseBody(request);
+
+    for (const char* field : {"type", "strike", "expiry", "asset_id"}) {
+        if (!body.find(field)) {
+            throw RequestError(std::string("Missing required field '") + field + "'");
+        }
+    }
+    const Json::Value* market_data = body.find("market_data");
+    const bool complete = market_data && market_data->isObject() && market_data->find("spot") &&
+                          market_data->find("rate") && market_data->find("vol");
+    const std::string asset_id = body.find("asset_id")->isString() ? body.find("asset_id")->asString() : "";
+    if (!complete) {
+        throw RequestError("Could not fetch market data for " + asset_id +
+                           ": the native server does not fetch market data. Please provide manually.");
+    }
+
+    // The option is built as a one-lot portfolio item
+    Json::Value::Object members;
+    for (const auto& member : body.asObject()) {
+        if (member.first != "market_data" && member.first != "quantity") {
+            members.push_back(member);
+        }
+    }
+    members.emplace_back("quantity", integer(1));
+    const Ingestion::Position position = Ingestion::positionFromJson(Json::Value::object(std::move(members)));
+    const MarketData md = Ingestion::marketDataFromJson(position.instrument->getAssetId(), *market_data);
+    const Instrument& option = *position.instrument;
+
+    return json(200, Json::Value::object({
+        {"price", number(option.price(md))},
+        {"delta", number(option.delta(md))},
+        {"gamma", number(option.gamma(md))},
+        {"vega", number(option.vega(md))},
+        {"theta", number(option.theta(md))},
+        {"instrument_type", Json::Value::string(option.getInstrumentType())},
+        {"market_data_auto_fetched", Json::Value::boolean(false)},
+        {"market_data_used", *market_data},
+    }));
+}
+
+HttpResponse RiskService::health() {
+    const double uptime =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - started_).count();
+    return json(200, Json::Value::object({
+        {"status", Json::Value::string("healthy")},
+        {"service", Json::Value::string("quant-risk-engine-native")},
+        {"version", Json::Value::string("3.1")},
+        {"uptime_seconds", number(uptime)},
+        {"requests", integer(static_cast<long long>(requests_.load()))},
+        {"risk_cache", Json::Value::object({
+            {"entries", integer(static_cast<long long>(cache_.size()))},
+            {"hits", integer(static_cast<long long>(cache_.getHits()))},
+            {"misses", integer(static_cast<long long>(cache_.getMisses()))},
+            {"coalesced", integer(static_cast<long long>(cache_.getCoalesced()))},
+        })},
+    }));
+}
+
+} // namespace RiskServer
@@ -0,0 +1,42 @@
+#ifndef RISK_SERVER_RISK_SERVICE_H
+#define RISK_SERVER_RISK_SERVICE_H
+
+#include "HttpServer.h"
+#include "RiskEngine.h"
+#include "RiskResultCache.h"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+
+namespace RiskServer {
+
+// The hot endpoints of python_api/app.py with the same JSON contract:
+// POST /calculate_risk, POST /price_option and GET /health, plus
+// POST /var_shard for var_coordinator. Bodies are parsed straight into
+// engine objects. Market data is never fetched: every asset must be priced
+// from the request. Risk runs record into `trace` when one is given.
+class RiskService {
+public:
+    explicit RiskService(size_t cache_bytes = 8 * 1024 * 1024,
+                         std::shared_ptr<TraceRecorder> trace = nullptr);
+
+    // Thread-safe; called concurrently by the server's workers
+    HttpResponse handle(const HttpRequest& request);
+
+private:
+    RiskEngine engine_;
+    RiskResultCache cache_;
+    std::shared_ptr<TraceRecorder> trace_;
+    std::chrono::steady_clock::time_point started_;
+    std::atomic<size_t> requests_;
+
+    HttpResponse calculateRisk(const HttpRequest& request);
+    HttpResponse priceOption(const HttpRequest& request);
+    HttpResponse varShard(const HttpRequest& request);
+    HttpResponse health();
+};
+
+} // namespace RiskServer
+
+#endif
@@ -0,0 +1,114 @@
+#include "HttpServer.h"
+#include "RiskService.h"
+
+#include <csignal>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <string>
+
+// Standalone risk server: the /calculate_risk and /price_option endpoints of
+// the Flask API served natively, for deployments and latency comparisons
+// without Python in the request path. With --trace, request queueing and
+// risk runs are recorded and written on shutdown as a trace-event file for
+// Perfetto. POST /var_shard makes the server a remote worker for
+// var_coordinator. Heap allocations are counted so that diagnostics runs
+// report them per phase.
+//
+//   risk_server [--host 127.0.0.1] [--port 10001] [--workers N] [--cache-bytes B]
+//               [--max-connections N] [--idle-timeout MS] [--trace FILE]
+
+namespace {
+
+RiskServer::HttpServer* g_server = nullptr;
+
+void handleSignal(int) {
+    if (g_server) {
+        g_server->stop();
+    }
+}
+
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program
+              << " [--host ADDRESS] [--port PORT] [--workers N] [--cache-bytes BYTES]"
+                 " [--max-connections N] [--idle-timeout MS] [--trace FILE]\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    RiskServer::HttpServer::Options options;
+    size_t cache_bytes = 8 * 1024 * 1024;
+    std::string trace_path;
+    if (const char* port = std::getenv("PORT")) {
+        options.port = std::atoi(port);
+    }
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            printUsage(argv[0]);
+            return 0;
+        }
+        if (i + 1 >= argc) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        const std::string value = argv[++i];
+        try {
+            if (arg == "--host") {
+                options.host = value;
+            } else if (arg == "--port") {
+                options.port = std::stoi(value);
+            } else if (arg == "--workers") {
+                options.workers = static_cast<unsigned>(std::stoul(value));
+            } else if (arg == "--cache-bytes") {
+                cache_bytes = std::stoull(value);
+            } else if (arg == "--max-connections") {
+                options.max_connections = std::stoull(value);
+            } else if (arg == "--idle-timeout") {
+                options.idle_timeout_ms = std::stoi(value);
+            } else if (arg == "--trace") {
+                trace_path = value;
+            } else {
+                printUsage(argv[0]);
+                return 1;
+            }
+        } catch (const std::exception&) {
+            std::cerr << "Invalid value for " << arg << ": " << value << std::endl;
+            return 1;
+        }
+    }
+
+    try {
+        std::shared_ptr<TraceRecorder> trace;
+        if (!trace_path.empty()) {
+            trace = std::make_shared<TraceRecorder>();
+            options.trace = trace.get();
+        }
+        RiskServer::RiskService service(cache_bytes, trace);
+        RiskServer::HttpServer server(options, [&service](const RiskServer::HttpRequest& request) {
+            return service.handle(request);
+        });
+
+        g_server = &server;
+        std::signal(SIGINT, handleSignal);
+        std::signal(SIGTERM, handleSignal);
+        std::signal(SIGPIPE, SIG_IGN);
+
+        std::cout << "Risk server listening on http://" << options.host << ":" << server.getPort()
+                  << " with " << server.getWorkers() << " workers" << std::endl;
+        server.run();
+        g_server = nullptr;
+        if (trace) {
+            trace->write(trace_path);
+            std::cout << "Trace written to " << trace_path << std::endl;
+        }
+        std::cout << "Risk server stopped" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,524 @@
+#include "Ingestion.h"
+#include "Json.h"
+#include "Portfolio.h"
+#include "RiskEngine.h"
+
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <csignal>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Sharded VaR coordinator: splits the Monte Carlo paths of one
+// /calculate_risk request into contiguous shards, simulates them in forked
+// processes or on risk_server workers (POST /var_shard), and merges the
+// partial results into the VaR and ES a single run would give. Runs use the
+// Philox generator; without a seed in the request one is drawn and reported
+// so the run can be repeated.
+//
+//   var_coordinator REQUEST.json [--processes N | --workers HOST:PORT,...] [--shards S]
+//                   [--timeout SECONDS]
+
+namespace {
+
+// A worker silent for this long on connect, send or any read fails its shard
+const long long kDefaultTimeoutSeconds = 600;
+
+struct Shard {
+    long long first_path;
+    long long last_path;
+};
+
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program
+              << " REQUEST.json [--processes N | --workers HOST:PORT,...] [--shards S]"
+                 " [--timeout SECONDS]\n";
+}
+
+std::string readFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Cannot open request file " + path);
+    }
+    std::ostringstream text;
+    text << file.rdbuf();
+    return text.str();
+}
+
+std::vector<std::string> split(const std::string& text, char separator) {
+    std::vector<std::string> parts;
+    std::stringstream stream(text);
+    std::string part;
+    while (std::getline(stream, part, separator)) {
+        if (!part.empty()) {
+            parts.push_back(part);
+        }
+    }
+    return parts;
+}
+
+// The request with var_parameters forced to Philox and `seed`, and the
+// shard range when one is given
+Json::Value shardRequest(const Json::Value& request, unsigned int seed, const Shard* shard) {
+    Json::Value::Object params;
+    if (const Json::Value* given = request.find("var_parameters")) {
+        if (given->isObject()) {
+            for (const auto& member : given->asObject()) {
+                if (member.first != "seed" && member.first != "random_generator" &&
+                    member.first != "tail_scenarios" && member.first != "diagnostics") {
+                    params.push_back(member);
+                }
+            }
+        }
+    }
+    params.emplace_back("random_generator", Json::Value::string("philox"));
+    params.emplace_back("seed", Json::Value::number(seed, true));
+
+    Json::Value::Object members;
+    for (const auto& member : request.asObject()) {
+        if (member.first != "var_parameters" && member.first != "shard") {
+            members.push_back(member);
+        }
+    }
+    members.emplace_back("var_parameters", Json::Value::object(std::move(params)));
+    if (shard) {
+        members.emplace_back("shard", Json::Value::object({
+            {"first_path", Json::Value::number(static_cast<double>(shard->first_path), true)},
+            {"last_path", Json::Value::number(static_cast<double>(shard->last_path), true)},
+        }));
+    }
+    return Json::Value::object(std::move(members));
+}
+
+// Paths in the whole run, which may exceed what a single run allows
+long long totalPaths(const Json::Value& request) {
+    const Json::Value* params = request.find("var_parameters");
+    const Json::Value* value = params && params->isObject() ? params->find("simulations") : nullptr;
+    if (!value) {
+        return RiskConfig().getVaRSimulations();
+    }
+    if (!value->isInteger() || value->asNumber() <= 0 ||
+        value->asNumber() > RiskEngine::kMaxShardedSimulations) {
+        throw std::invalid_argument("VaR simulations must be a positive integer <= 100,000,000");
+    }
+    return static_cast<long long>(value->asNumber());
+}
+
+// The engine inputs of a request other than its path count, for the forked
+// workers
+RiskConfig localConfig(const Json::Value& request, unsigned int seed) {
+    RiskConfig config = RiskConfig().withRandomGenerator(RandomGenerator::Philox).withRandomSeed(seed);
+    const Json::Value* params = request.find("var_parameters");
+    if (!params || !params->isObject()) {
+        return config;
+    }
+    if (const Json::Value* value = params->find("time_horizon")) {
+        config = config.withVaRTimeHorizonDays(value->asNumber());
+    }
+    if (const Json::Value* value = params->find("jump_scenarios")) {
+        config = config.withJumpDiffusionScenarios(value->asBoolean());
+    }
+    if (const Json::Value* value = params->find("fast_american_revaluation")) {
+        config = config.withFastAmericanRevaluation(value->asBoolean());
+    }
+    return config;
+}
+
+void localPortfolio(const Json::Value& request, Portfolio& portfolio,
+                    std::map<std::string, MarketData>& market_data_map) {
+    const Json::Value* items = request.find("portfolio");
+    if (!items || !items->isArray() || items->asArray().empty()) {
+        throw std::invalid_argument("Request needs a non-empty 'portfolio' array");
+    }
+    for (size_t i = 0; i < items->asArray().size(); ++i) {
+        Ingestion::Position position;
+        try {
+            position = Ingestion::positionFromJson(items->asArray()[i]);
+        } catch (const std::invalid_argument& e) {
+            throw std::invalid_argument("Portfolio item " + std::to_string(i) + ": " + e.what());
+        }
+        portfolio.addInstrument(std::move(position.instrument), position.quantity);
+    }
+    const Json::Value* market_data = request.find("market_data");
+    if (market_data && market_data->isObject()) {
+        for (const auto& member : market_data->asObject()) {
+            market_data_map[member.first] = Ingestion::marketDataFromJson(member.first, member.second);
+        }
+    }
+}
+
+void writeAll(int fd, const std::string& bytes) {
+    size_t written = 0;
+    while (written < bytes.size()) {
+        const ssize_t n = ::write(fd, bytes.data() + written, bytes.size() - written);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            throw std::runtime_error(std::string("Write failed: ") + std::strerror(errno));
+        }
+        written += static_cast<size_t>(n);
+    }
+}
+
+// Runs every shard in a child process, at most `processes` at a time. Each
+// child writes 'S' and its serialized shard, or 'E' and an error message,
+// to its pipe and exits.
+std::vector<VaRShard> runForked(const Json::Value& request, unsigned int seed,
+                                const std::vector<Shard>& shards, unsigned processes) {
+    Portfolio portfolio;
+    std::map<std::string, MarketData> market_data_map;
+    localPortfolio(request, portfolio, market_data_map);
+    const RiskConfig config = localConfig(request, seed);
+    const long long total_paths = totalPaths(request);
+    const RiskEngine engine;
+
+    struct Child {
+        pid_t pid;
+        int fd;
+        size_t shard;
+        std::string output;
+    };
+    std::vector<Child> running;
+    std::vector<VaRShard> results;
+    std::string failure;
+    size_t next = 0;
+
+    while (next < shards.size() || !running.empty()) {
+        while (next < shards.size() && running.size() < processes && failure.empty()) {
+            int fds[2];
+            if (::pipe(fds) != 0) {
+                throw std::runtime_error(std::string("pipe failed: ") + std::strerror(errno));
+            }
+            const pid_t pid = ::fork();
+            if (pid < 0) {
+                throw std::runtime_error(std::string("fork failed: ") + std::strerror(errno));
+            }
+            if (pid == 0) {
+                ::close(fds[0]);
+                int status = 0;
+                try {
+                    const VaRShard shard = engine.calculateVaRShard(portfolio, market_data_map, config, total_paths,
+                                                                    shards[next].first_path, shards[next].last_path);
+                    writeAll(fds[1], "S" + shard.serialize());
+                } catch (const std::exception& e) {
+                    try {
+                        writeAll(fds[1], std::string("E") + e.what());
+                    } catch (const std::exception&) {
+                        status = 1;
+                    }
+                }
+                ::_exit(status);
+            }
+            ::close(fds[1]);
+            running.push_back({pid, fds[0], next, ""});
+            ++next;
+        }
+        if (running.empty()) {
+            break;
+        }
+
+        std::vector<pollfd> fds;
+        for (const Child& child : running) {
+            fds.push_back({child.fd, POLLIN, 0});
+        }
+        if (::poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error(std::string("poll failed: ") + std::strerror(errno));
+        }
+        for (size_t i = running.size(); i-- > 0;) {
+            if (!(fds[i].revents & (POLLIN | POLLHUP | POLLERR))) {
+                continue;
+            }
+            Child& child = running[i];
+            char buffer[65536];
+            const ssize_t n = ::read(child.fd, buffer, sizeof(buffer));
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n > 0) {
+                child.output.append(buffer, static_cast<size_t>(n));
+                continue;
+            }
+            ::close(child.fd);
+            int status = 0;
+            ::waitpid(child.pid, &status, 0);
+            if (!child.output.empty() && child.output[0] == 'S') {
+                results.push_back(VaRShard::deserialize(child.output.substr(1)));
+            } else if (failure.empty()) {
+                failure = !child.output.empty() ? child.output.substr(1)
+                                                : "shard process " + std::to_string(child.pid) + " exited abnormally";
+            }
+            running.erase(running.begin() + static_cast<long>(i));
+        }
+    }
+    if (!failure.empty()) {
+        throw std::runtime_error("Shard failed: " + failure);
+    }
+    return results;
+}
+
+// POST /var_shard to a risk_server; one blocking connection per shard. The
+// connect, the request write and every read give up after `timeout_seconds`.
+VaRShard fetchShard(const std::string& worker, const std::string& body, long long timeout_seconds) {
+    const size_t colon = worker.rfind(':');
+    if (colon == std::string::npos) {
+        throw std::invalid_argument("Worker must be HOST:PORT, got " + worker);
+    }
+    const std::string host = worker.substr(0, colon);
+    const std::string port = worker.substr(colon + 1);
+
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* addresses = nullptr;
+    if (::getaddrinfo(host.c_str(), port.c_str(), &hints, &addresses) != 0) {
+        throw std::runtime_error("Cannot resolve worker " + worker);
+    }
+    timeval timeout{};
+    timeout.tv_sec = static_cast<time_t>(timeout_seconds);
+    const std::string timed_out =
+        "Worker " + worker + " timed out after " + std::to_string(timeout_seconds) + " s";
+    int fd = -1;
+    bool connect_timed_out = false;
+    for (addrinfo* address = addresses; address; address = address->ai_next) {
+        fd = ::socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+        if (fd >= 0 && ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) == 0 &&
+            ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout)) == 0 &&
+            ::connect(fd, address->ai_addr, address->ai_addrlen) == 0) {
+            break;
+        }
+        connect_timed_out = connect_timed_out || errno == EINPROGRESS || errno == EAGAIN;
+        if (fd >= 0) {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+    ::freeaddrinfo(addresses);
+    if (fd < 0) {
+        throw std::runtime_error(connect_timed_out ? timed_out : "Cannot connect to worker " + worker);
+    }
+
+    std::string response;
+    try {
+        const std::string message = "POST /var_shard HTTP/1.1\r\nHost: " + host +
+                                    "\r\nContent-Type: application/json\r\nContent-Length: " +
+                                    std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+        for (size_t written = 0; written < message.size();) {
+            const ssize_t n = ::write(fd, message.data() + written, message.size() - written);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                throw std::runtime_error(timed_out);
+            }
+            if (n <= 0) {
+                throw std::runtime_error("Write to worker " + worker + " failed: " + std::strerror(errno));
+            }
+            written += static_cast<size_t>(n);
+        }
+        char buffer[65536];
+        for (;;) {
+            const ssize_t n = ::read(fd, buffer, sizeof(buffer));
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                throw std::runtime_error(timed_out);
+            }
+            if (n < 0) {
+                throw std::runtime_error("Read from worker " + worker + " failed: " + std::strerror(errno));
+            }
+            if (n == 0) {
+                break;
+            }
+            response.append(buffer, static_cast<size_t>(n));
+        }
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+    ::close(fd);
+
+    const size_t header_end = response.find("\r\n\r\n");
+    const size_t status_start = response.find(' ');
+    if (header_end == std::string::npos || status_start == std::string::npos) {
+        throw std::runtime_error("Malformed response from worker " + worker);
+    }
+    const int status = std::atoi(response.c_str() + status_start + 1);
+    const std::string payload = response.substr(header_end + 4);
+    if (status != 200) {
+        throw std::runtime_error("Worker " + worker + " answered " + std::to_string(status) + ": " + payload);
+    }
+    return VaRShard::deserialize(payload);
+}
+
+// Shard i goes to worker i mod the worker count. Each worker gets one thread
+// that sends its shards one after another, so a worker never has more than
+// one shard in flight; after the first failure the remaining shards are
+// not sent.
+std::vector<VaRShard> runRemote(const Json::Value& request, unsigned int seed,
+                                const std::vector<Shard>& shards, const std::vector<std::string>& workers,
+                                long long timeout_seconds) {
+    std::vector<VaRShard> results(shards.size());
+    std::vector<std::string> errors(shards.size());
+    std::atomic<bool> failed(false);
+    std::vector<std::thread> threads;
+    for (size_t w = 0; w < workers.size() && w < shards.size(); ++w) {
+        threads.emplace_back([&, w]() {
+            for (size_t i = w; i < shards.size() && !failed; i += workers.size()) {
+                try {
+                    const std::string body = Json::write(shardRequest(request, seed, &shards[i]));
+                    results[i] = fetchShard(workers[w], body, timeout_seconds);
+                } catch (const std::exception& e) {
+                    errors[i] = "paths [" + std::to_string(shards[i].first_path) + ", " +
+                                std::to_string(shards[i].last_path) + "): " + e.what();
+                    failed = true;
+                }
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    for (const std::string& error : errors) {
+        if (!error.empty()) {
+            throw std::runtime_error("Shard failed: " + error);
+        }
+    }
+    return results;
+}
+
+Json::Value number(double value) {
+    return Json::Value::number(value);
+}
+
+Json::Value integer(long long value) {
+    return Json::Value::number(static_cast<double>(value), true);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 2 || std::string(argv[1]) == "--help" || std::string(argv[1]) == "-h") {
+        printUsage(argv[0]);
+        return argc < 2 ? 1 : 0;
+    }
+    const std::string request_path = argv[1];
+    unsigned processes = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::string> workers;
+    long long shard_count = 0;
+    long long timeout_seconds = kDefaultTimeoutSeconds;
+
+    for (int i = 2; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        const std::string value = argv[++i];
+        try {
+            if (arg == "--processes") {
+                processes = static_cast<unsigned>(std::stoul(value));
+            } else if (arg == "--workers") {
+                workers = split(value, ',');
+            } else if (arg == "--shards") {
+                shard_count = std::stoll(value);
+            } else if (arg == "--timeout") {
+                timeout_seconds = std::stoll(value);
+            } else {
+                printUsage(argv[0]);
+                return 1;
+            }
+        } catch (const std::exception&) {
+            std::cerr << "Invalid value for " << arg << ": " << value << std::endl;
+            return 1;
+        }
+    }
+
+    try {
+        const Json::Value request = Json::parse(readFile(request_path));
+        if (!request.isObject()) {
+            throw std::invalid_argument("Request must be a JSON object");
+        }
+        if (processes == 0) {
+            throw std::invalid_argument("--processes must be positive");
+        }
+        if (timeout_seconds <= 0) {
+            throw std::invalid_argument("--timeout must be positive");
+        }
+
+        // Without a seed the shards could not agree on their paths
+        unsigned int seed;
+        const Json::Value* params = request.find("var_parameters");
+        const Json::Value* given_seed = params ? params->find("seed") : nullptr;
+        if (given_seed && given_seed->isInteger() && given_seed->asNumber() >= 0 &&
+            given_seed->asNumber() <= UINT_MAX) {
+            seed = static_cast<unsigned int>(given_seed->asNumber());
+        } else if (given_seed && !given_seed->isNull()) {
+            throw std::invalid_argument("Random seed must be a non-negative integer");
+        } else {
+            seed = std::random_device()();
+        }
+
+        const long long simulations = totalPaths(request);
+        if (shard_count <= 0) {
+            shard_count = workers.empty() ? processes : static_cast<long long>(workers.size());
+        }
+        shard_count = std::min(shard_count, simulations);
+        std::vector<Shard> shards;
+        for (long long i = 0; i < shard_count; ++i) {
+            shards.push_back({simulations * i / shard_count, simulations * (i + 1) / shard_count});
+        }
+
+        std::signal(SIGPIPE, SIG_IGN);
+        const auto start = std::chrono::steady_clock::now();
+        const VaRShard merged = VaRShard::merge(workers.empty()
+            ? runForked(request, seed, shards, processes)
+            : runRemote(request, seed, shards, workers, timeout_seconds));
+        const RiskMetrics metrics = merged.metrics();
+        const double seconds =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::cout << Json::write(Json::Value::object({
+            {"value_at_risk_95", number(metrics.var_95)},
+            {"value_at_risk_99", number(metrics.var_99)},
+            {"expected_shortfall_95", number(metrics.es_95)},
+            {"expected_shortfall_99", number(metrics.es_99)},
+            {"mean_pnl", number(merged.mean())},
+            {"pnl_std_dev", number(merged.standardDeviation())},
+            {"simulations", integer(merged.size())},
+            {"shards", integer(static_cast<long long>(shards.size()))},
+            {"seed", integer(seed)},
+            {"seconds", number(seconds)},
+        })) << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
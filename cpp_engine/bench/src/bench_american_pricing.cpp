@@ -0,0 +1,186 @@
+#include "AndersenLakeOffengeld.h"
+#include "BaroneAdesiWhaley.h"
+#include "BinomialTree.h"
+#include "FiniteDifference.h"
+#include "Instrument.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Compares American put pricers at equal accuracy against a 10,000-step
+// binomial reference: for each error tolerance, the cheapest configuration of
+// each method that meets it and its time per option. The tree itself is only
+// good to ~1e-4, so collocation is also checked against a fully resolved
+// collocation boundary.
+
+struct Case {
+    double S, K, r, T, sigma;
+};
+
+struct Config {
+    std::string method;
+    std::string label;
+    std::function<double(const Case&)> price;
+    double max_error = 0.0;
+    double micros_per_option = 0.0;
+};
+
+double timePerOption(const std::vector<Case>& cases, const std::function<double(const Case&)>& price) {
+    using clock = std::chrono::steady_clock;
+    volatile double sink = 0.0;
+    long evaluations = 0;
+    const auto start = clock::now();
+    auto elapsed = std::chrono::duration<double>::zero();
+    do {
+        for (const auto& c : cases) {
+            sink = sink + price(c);
+            ++evaluations;
+        }
+        elapsed = clock::now() - start;
+    } while (elapsed.count() < 0.05);
+    return 1e6 * elapsed.count() / evaluations;
+}
+
+int main() {
+    const std::vector<double> strikes = {90.0, 100.0, 110.0};
+    const std::vector<OptionType> puts(strikes.size(), OptionType::Put);
+
+    // One shared reference lattice per (T, sigma) for the whole strike chain
+    std::vector<Case> cases;
+    std::vector<double> reference;
+    for (double T : {0.25, 1.0}) {
+        for (double sigma : {0.2, 0.4}) {
+            const std::vector<double> prices =
+                BinomialTree::americanOptionPrices(100.0, strikes, puts, 0.05, T, sigma, 10000);
+            for (size_t k = 0; k < strikes.size(); ++k) {
+                cases.push_back({100.0, strikes[k], 0.05, T, sigma});
+                reference.push_back(prices[k]);
+            }
+        }
+    }
+
+    std::vector<Config> configs;
+    for (int steps : {50, 100, 200, 400, 800, 1600, 3200}) {
+        configs.push_back({"binomial", std::to_string(steps) + " steps",
+            [steps](const Case& c) {
+                return BinomialTree::americanOptionPrice(c.S, c.K, c.r, c.T, c.sigma,
+                                                         OptionType::Put, steps);
+            }});
+    }
+    for (int space : {50, 100, 200, 400, 800, 1600}) {
+        FiniteDifference::GridSettings settings;
+        settings.space_steps = space;
+        settings.time_steps = space;
+        configs.push_back({"crank-nicolson", std::to_string(space) + "x" + std::to_string(space),
+            [settings](const Case& c) {
+                return FiniteDifference::americanOptionPrice(c.S, c.K, c.r, c.T, c.sigma,
+                                                             OptionType::Put, settings);
+            }});
+    }
+
+    struct Collocation {
+        std::string label;
+        AndersenLakeOffengeld::CollocationSettings settings;
+    };
+    std::vector<Collocation> collocations;
+    for (auto [n, l, m, p] : std::vector<std::array<int, 4>>{
+             {5, 8, 2, 16}, {8, 8, 4, 16}, {12, 12, 6, 32}, {20, 16, 8, 48}}) {
+        AndersenLakeOffengeld::CollocationSettings settings;
+        settings.collocation_nodes = n;
+        settings.integration_nodes = l;
+        settings.iterations = m;
+        settings.pricing_nodes = p;
+        collocations.push_back({std::to_string(n) + "/" + std::to_string(l) + "/" +
+                                std::to_string(m) + "/" + std::to_string(p), settings});
+    }
+    for (const auto& collocation : collocations) {
+        const auto settings = collocation.settings;
+        configs.push_back({"alo", collocation.label,
+            [settings](const Case& c) {
+                return AndersenLakeOffengeld::americanOptionPrice(c.S, c.K, c.r, c.T, c.sigma,
+                                                                  OptionType::Put, settings);
+            }});
+    }
+    configs.push_back({"baw", "quadratic",
+        [](const Case& c) {
+            return BaroneAdesiWhaley::americanOptionPrice(c.S, c.K, c.r, c.T, c.sigma,
+                                                          OptionType::Put);
+        }});
+
+    std::cout << std::fixed;
+    std::cout << std::left << std::setw(16) << "method" << std::setw(14) << "config"
+              << std::right << std::setw(14) << "max error" << std::setw(16) << "us/option" << "\n";
+
+    for (auto& config : configs) {
+        for (size_t i = 0; i < cases.size(); ++i) {
+            config.max_error = std::max(config.max_error, std::abs(config.price(cases[i]) - reference[i]));
+        }
+        config.micros_per_option = timePerOption(cases, config.price);
+
+        std::cout << std::left << std::setw(16) << config.method << std::setw(14) << config.label
+                  << std::right << std::scientific << std::setprecision(2) << std::setw(14) << config.max_error
+                  << std::fixed << std::setprecision(2) << std::setw(16) << config.micros_per_option << "\n";
+    }
+
+    std::cout << "\nCheapest configuration meeting each tolerance:\n";
+    for (double tolerance : {1e-1, 1e-2, 5e-3, 1e-3}) {
+        std::cout << "  tol " << std::scientific << std::setprecision(0) << tolerance << std::fixed << ":";
+        for (const std::string method : {"binomial", "crank-nicolson", "alo", "baw"}) {
+            const Config* best = nullptr;
+            for (const auto& config : configs) {
+                if (config.method == method && config.max_error <= tolerance &&
+                    (!best || config.micros_per_option < best->micros_per_option)) {
+                    best = &config;
+                }
+            }
+            std::cout << "  " << method << " ";
+            if (best) {
+                std::cout << best->label << " (" << std::setprecision(2) << best->micros_per_option << " us)";
+            } else {
+                std::cout << "n/a";
+            }
+        }
+        std::cout << "\n";
+    }
+
+    // Collocation against its own converged boundary, and the cost of
+    // repricing off a boundary that is already built (the VaR scenario path)
+    AndersenLakeOffengeld::CollocationSettings converged;
+    converged.collocation_nodes = 48;
+    converged.integration_nodes = 64;
+    converged.iterations = 40;
+    converged.pricing_nodes = 128;
+    std::vector<double> resolved;
+    for (const auto& c : cases) {
+        resolved.push_back(AndersenLakeOffengeld::americanOptionPrice(c.S, c.K, c.r, c.T, c.sigma,
+                                                                      OptionType::Put, converged));
+    }
+    std::cout << "\nCollocation against a converged boundary (48/64/40/128):\n";
+    for (const auto& collocation : collocations) {
+        double max_error = 0.0;
+        for (size_t i = 0; i < cases.size(); ++i) {
+            const double price = AndersenLakeOffengeld::americanOptionPrice(
+                cases[i].S, cases[i].K, cases[i].r, cases[i].T, cases[i].sigma,
+                OptionType::Put, collocation.settings);
+            max_error = std::max(max_error, std::abs(price - resolved[i]));
+        }
+        std::cout << "  " << std::left << std::setw(14) << collocation.label << std::right
+                  << std::scientific << std::setprecision(2) << std::setw(12) << max_error << "\n";
+    }
+
+    const AndersenLakeOffengeld::ExerciseBoundary boundary(0.05, 1.0, 0.2);
+    const double reprice_micros = timePerOption(cases, [&boundary](const Case& c) {
+        return boundary.price(c.S * 0.99, c.K, OptionType::Put);
+    });
+    std::cout << "\nRepricing off a built boundary: " << std::fixed << std::setprecision(3)
+              << reprice_micros << " us/option\n";
+
+    return 0;
+}
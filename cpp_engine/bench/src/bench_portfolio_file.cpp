@@ -0,0 +1,90 @@
+#include "Instrument.h"
+#include "Portfolio.h"
+
+#include <chrono>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Save and load times of the binary portfolio format for books of up to a
+// million rows, against building the same book row by row from ready-made
+// asset ids. Fails if loading the largest book is slower than building it.
+
+int main() {
+    using clock = std::chrono::steady_clock;
+    const int assets = 500;
+    const std::string path = "bench_portfolio_file.qepf";
+
+    std::cout << std::setw(10) << "rows"
+              << std::setw(12) << "build ms"
+              << std::setw(12) << "save ms"
+              << std::setw(12) << "load ms"
+              << std::setw(12) << "load/build"
+              << std::setw(12) << "MB" << "\n";
+
+    std::vector<std::string> asset_ids;
+    for (int a = 0; a < assets; ++a) {
+        asset_ids.push_back("SYM" + std::to_string(a));
+    }
+
+    double load_ratio = 0.0;
+    for (size_t rows : {10000, 100000, 1000000}) {
+        auto start = clock::now();
+        Portfolio portfolio;
+        portfolio.reserve(rows);
+        for (size_t i = 0; i < rows; ++i) {
+            const std::string& asset_id = asset_ids[i % assets];
+            if (i % 10 == 0) {
+                portfolio.addInstrument(
+                    std::make_unique<AmericanOption>(OptionType::Put, 80.0 + (i / assets) % 40,
+                                                     0.25 * (1 + i % 4), asset_id, 200),
+                    static_cast<int>(i % 7) - 3);
+            } else {
+                portfolio.addInstrument(
+                    std::make_unique<EuropeanOption>(i % 2 ? OptionType::Call : OptionType::Put,
+                                                     80.0 + (i / assets) % 40,
+                                                     0.25 * (1 + i % 4), asset_id),
+                    static_cast<int>(i % 7) - 3);
+            }
+        }
+        const double build_ms = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+        start = clock::now();
+        portfolio.saveBinary(path);
+        const double save_ms = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+        start = clock::now();
+        Portfolio loaded;
+        loaded.loadBinary(path);
+        const double load_ms = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+        std::FILE* file = std::fopen(path.c_str(), "rb");
+        std::fseek(file, 0, SEEK_END);
+        const double megabytes = std::ftell(file) / 1e6;
+        std::fclose(file);
+
+        if (loaded.size() != portfolio.size() ||
+            loaded.getNettedPositions().size() != portfolio.getNettedPositions().size()) {
+            std::cerr << "Round trip mismatch at " << rows << " rows\n";
+            return 1;
+        }
+
+        load_ratio = load_ms / build_ms;
+        std::cout << std::fixed << std::setprecision(1)
+                  << std::setw(10) << rows
+                  << std::setw(12) << build_ms
+                  << std::setw(12) << save_ms
+                  << std::setw(12) << load_ms
+                  << std::setprecision(2) << std::setw(12) << load_ratio
+                  << std::setprecision(1) << std::setw(12) << megabytes << "\n";
+    }
+    std::remove(path.c_str());
+    if (load_ratio > 1.0) {
+        std::cerr << "Loading the largest book was slower than building it row by row\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,73 @@
+#include "Instrument.h"
+#include "Portfolio.h"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+// Per-asset queries and single-position edits against book size: each should
+// cost the same on a million-row book as on a ten-thousand-row one.
+
+template <typename F>
+double nanosPerCall(int calls, F&& f) {
+    using clock = std::chrono::steady_clock;
+    const auto start = clock::now();
+    for (int i = 0; i < calls; ++i) {
+        f(i);
+    }
+    return std::chrono::duration<double, std::nano>(clock::now() - start).count() / calls;
+}
+
+int main() {
+    const int assets = 500;
+    const int calls = 100000;
+
+    std::cout << std::setw(10) << "rows"
+              << std::setw(14) << "net qty ns"
+              << std::setw(14) << "update ns"
+              << std::setw(14) << "remove ns" << "\n";
+
+    for (size_t rows : {10000, 100000, 1000000}) {
+        Portfolio portfolio;
+        portfolio.reserve(rows);
+        std::vector<std::string> asset_ids;
+        for (int a = 0; a < assets; ++a) {
+            asset_ids.push_back("SYM" + std::to_string(a));
+        }
+        std::vector<PositionHandle> handles;
+        handles.reserve(rows);
+        for (size_t i = 0; i < rows; ++i) {
+            handles.push_back(portfolio.addInstrument(
+                std::make_unique<EuropeanOption>(
+                    i % 2 ? OptionType::Call : OptionType::Put,
+                    80.0 + (i / assets) % 40, 0.25 * (1 + i % 4), asset_ids[i % assets]),
+                static_cast<int>(i % 7) - 3));
+        }
+
+        std::mt19937 generator(1);
+        volatile long long sink = 0;
+        const double query = nanosPerCall(calls, [&](int i) {
+            sink = sink + portfolio.getTotalQuantityForAsset(asset_ids[i % assets]);
+        });
+        const double update = nanosPerCall(calls, [&](int i) {
+            portfolio.updateQuantity(generator() % portfolio.size(), i % 5);
+        });
+        const double remove = nanosPerCall(static_cast<int>(rows / 10), [&](int) {
+            const size_t k = generator() % handles.size();
+            portfolio.removePosition(handles[k]);
+            handles[k] = handles.back();
+            handles.pop_back();
+        });
+
+        std::cout << std::fixed << std::setprecision(0)
+                  << std::setw(10) << rows
+                  << std::setw(14) << query
+                  << std::setw(14) << update
+                  << std::setw(14) << remove << "\n";
+    }
+    return 0;
+}
@@ -0,0 +1,82 @@
+#include "Instrument.h"
+#include "MarketData.h"
+#include "Portfolio.h"
+#include "RiskEngine.h"
+#include "RiskSession.h"
+
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+
+// One-ticker market updates on a 10,000-position book over 500 underlyings:
+// RiskSession::refresh() against a full RiskEngine pass over the book.
+
+int main() {
+    const int assets = 500;
+    const int positions_per_asset = 20;
+    const int ticks = 2000;
+
+    Portfolio portfolio;
+    MarketDataManager market_data;
+    portfolio.reserve(assets * positions_per_asset);
+    for (int a = 0; a < assets; ++a) {
+        const std::string asset_id = "SYM" + std::to_string(a);
+        market_data.addMarketData(asset_id, MarketData(asset_id, 100.0, 0.05, 0.25));
+        for (int p = 0; p < positions_per_asset; ++p) {
+            const OptionType type = p % 2 == 0 ? OptionType::Call : OptionType::Put;
+            const double strike = 80.0 + 2.0 * p;
+            const double expiry = 0.25 * (1 + p % 4);
+            portfolio.addInstrument(
+                std::make_unique<EuropeanOption>(type, strike, expiry, asset_id),
+                p % 3 == 0 ? -10 : 10);
+        }
+    }
+
+    using clock = std::chrono::steady_clock;
+
+    RiskEngine engine(1);
+    const auto full_start = clock::now();
+    const PortfolioRiskResult full = engine.calculatePortfolioRisk(portfolio, market_data.getAllMarketData());
+    const double full_micros =
+        std::chrono::duration<double, std::micro>(clock::now() - full_start).count();
+
+    RiskSession session(portfolio, market_data);
+    session.refresh();
+
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<int> pick(0, assets - 1);
+    std::uniform_real_distribution<double> move(-0.01, 0.01);
+
+    std::chrono::duration<double, std::micro> refresh_time(0);
+    size_t repriced = 0;
+    for (int t = 0; t < ticks; ++t) {
+        const std::string asset_id = "SYM" + std::to_string(pick(generator));
+        MarketData md = market_data.getMarketData(asset_id);
+        md.spot_price *= 1.0 + move(generator);
+        market_data.updateMarketData(asset_id, md);
+
+        const auto start = clock::now();
+        session.refresh();
+        refresh_time += clock::now() - start;
+        repriced += session.getLastRepricedPositions();
+    }
+
+    const PortfolioRiskResult check = engine.calculatePortfolioRisk(portfolio, market_data.getAllMarketData());
+    const PortfolioRiskResult& incremental = session.getResult();
+
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "Book: " << portfolio.size() << " positions on " << assets << " assets\n";
+    std::cout << "Full pass (Greeks + 1-path VaR): " << full_micros << " us\n";
+    std::cout << "Incremental refresh per tick:    "
+              << refresh_time.count() / ticks << " us ("
+              << static_cast<double>(repriced) / ticks << " positions repriced)\n";
+    std::cout << std::scientific << std::setprecision(2);
+    std::cout << "PV drift after " << ticks << " ticks: "
+              << std::abs(incremental.total_pv - check.total_pv)
+              << " (initial PV " << full.total_pv << ")\n";
+    return 0;
+}
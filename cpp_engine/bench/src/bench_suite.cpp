@@ -0,0 +1,555 @@
+#include "AllocationCounter.h"
+#include "AndersenLakeOffengeld.h"
+#include "BaroneAdesiWhaley.h"
+#include "BatchPricing.h"
+#include "BinomialTree.h"
+#include "BlackScholes.h"
+#include "FiniteDifference.h"
+#include "ImpliedVolatilitySurface.h"
+#include "Instrument.h"
+#include "Json.h"
+#include "JumpDiffusion.h"
+#include "MarketData.h"
+#include "Philox.h"
+#include "Portfolio.h"
+#include "RiskEngine.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Microbenchmarks for the pricers, the volatility surface and the risk
+// engine. Each case is run in batches sized to take at least --min-time
+// seconds, --repetitions times; the table on stdout and the --json report
+// give nanoseconds per operation (median, min, max) and heap allocations per
+// operation so builds can be compared case by case.
+//
+//   bench_suite [--filter TEXT] [--min-time SECONDS] [--repetitions N]
+//               [--json PATH|-] [--list]
+
+namespace {
+
+// Results are summed into a volatile so the work cannot be optimised away
+volatile double g_sink = 0.0;
+
+struct Case {
+    std::string name;
+    Json::Value::Object params;
+    std::function<void(size_t)> run;  // performs `iterations` operations
+};
+
+struct Options {
+    std::string filter;
+    double min_time = 0.05;
+    int repetitions = 5;
+    std::string json_path;
+    bool list = false;
+};
+
+// Wraps a per-operation function so the loop over it is compiled inline
+template <typename Operation>
+std::function<void(size_t)> loop(Operation operation) {
+    return [operation](size_t iterations) {
+        double sum = 0.0;
+        for (size_t i = 0; i < iterations; ++i) {
+            sum += operation(i);
+        }
+        g_sink = g_sink + sum;
+    };
+}
+
+// Inputs cycle through a small range so no two neighbouring calls are equal
+double spotAt(size_t i) {
+    return 80.0 + static_cast<double>(i % 64) * 0.625;
+}
+
+Json::Value integer(long long value) {
+    return Json::Value::number(static_cast<double>(value), true);
+}
+
+void addPricerCases(std::vector<Case>& cases) {
+    const double K = 100.0, r = 0.05, T = 0.5, sigma = 0.25;
+
+    cases.push_back({"black_scholes/N", {}, loop([](size_t i) {
+        return BlackScholes::N(-3.0 + static_cast<double>(i % 64) * 0.09375);
+    })});
+    cases.push_back({"black_scholes/call_price", {}, loop([=](size_t i) {
+        return BlackScholes::callPrice(spotAt(i), K, r, T, sigma);
+    })});
+    cases.push_back({"black_scholes/put_price", {}, loop([=](size_t i) {
+        return BlackScholes::putPrice(spotAt(i), K, r, T, sigma);
+    })});
+    cases.push_back({"black_scholes/call_delta", {}, loop([=](size_t i) {
+        return BlackScholes::callDelta(spotAt(i), K, r, T, sigma);
+    })});
+    cases.push_back({"black_scholes/gamma", {}, loop([=](size_t i) {
+        return BlackScholes::gamma(spotAt(i), K, r, T, sigma);
+    })});
+    cases.push_back({"black_scholes/vega", {}, loop([=](size_t i) {
+        return BlackScholes::vega(spotAt(i), K, r, T, sigma);
+    })});
+    cases.push_back({"black_scholes/call_theta", {}, loop([=](size_t i) {
+        return BlackScholes::callTheta(spotAt(i), K, r, T, sigma);
+    })});
+
+    std::vector<double> quotes(64);
+    for (size_t i = 0; i < quotes.size(); ++i) {
+        quotes[i] = BlackScholes::callPrice(spotAt(i), K, r, T, sigma);
+    }
+    cases.push_back({"black_scholes/implied_volatility", {}, loop([=](size_t i) {
+        return BlackScholes::impliedVolatility(quotes[i % 64], spotAt(i), K, r, T, true);
+    })});
+
+    for (int steps : {50, 100, 200, 500, 1000}) {
+        const Json::Value::Object params = {{"steps", integer(steps)}};
+        cases.push_back({"binomial/european_price/steps:" + std::to_string(steps), params, loop([=](size_t i) {
+            return BinomialTree::europeanOptionPrice(spotAt(i), K, r, T, sigma, OptionType::Call, steps);
+        })});
+        cases.push_back({"binomial/american_price/steps:" + std::to_string(steps), params, loop([=](size_t i) {
+            return BinomialTree::americanOptionPrice(spotAt(i), K, r, T, sigma, OptionType::Put, steps);
+        })});
+    }
+
+    // One operation values a whole chain; per-option cost is ns_per_op / strikes
+    for (int strikes : {10, 50}) {
+        std::vector<double> chain_strikes;
+        std::vector<OptionType> chain_types;
+        for (int k = 0; k < strikes; ++k) {
+            chain_strikes.push_back(70.0 + 60.0 * k / strikes);
+            chain_types.push_back(k % 2 ? OptionType::Call : OptionType::Put);
+        }
+        const Json::Value::Object params = {{"strikes", integer(strikes)}, {"steps", integer(200)}};
+        cases.push_back({"binomial/american_chain/strikes:" + std::to_string(strikes), params,
+                         loop([=](size_t i) {
+            return BinomialTree::americanOptionPrices(spotAt(i), chain_strikes, chain_types, r, T, sigma, 200)
+                .front();
+        })});
+        cases.push_back({"jump_diffusion/chain_greeks/strikes:" + std::to_string(strikes),
+                         {{"strikes", integer(strikes)}}, loop([=](size_t i) {
+            return JumpDiffusion::mertonOptionGreeks(spotAt(i), chain_strikes, chain_types, r, T, sigma,
+                                                     2.0, -0.05, 0.15)
+                .front().delta;
+        })});
+    }
+
+    cases.push_back({"jump_diffusion/price", {}, loop([=](size_t i) {
+        return JumpDiffusion::mertonOptionPrice(spotAt(i), K, r, T, sigma, OptionType::Call, 2.0, -0.05, 0.15);
+    })});
+    cases.push_back({"jump_diffusion/greeks", {}, loop([=](size_t i) {
+        return JumpDiffusion::mertonOptionGreeks(spotAt(i), K, r, T, sigma, OptionType::Call, 2.0, -0.05, 0.15)
+            .delta;
+    })});
+}
+
+// Grid and collocation pricers for American options, and the quadratic
+// approximation used to revalue them across VaR scenarios
+void addAmericanCases(std::vector<Case>& cases) {
+    const double K = 100.0, r = 0.05, T = 0.5, sigma = 0.25;
+
+    for (int space_steps : {100, 200, 400}) {
+        FiniteDifference::GridSettings grid;
+        grid.space_steps = space_steps;
+        grid.time_steps = space_steps / 2;
+        const std::string size = std::to_string(space_steps) + "x" + std::to_string(grid.time_steps);
+        const Json::Value::Object params = {{"space_steps", integer(grid.space_steps)},
+                                            {"time_steps", integer(grid.time_steps)}};
+        cases.push_back({"finite_difference/european_price/grid:" + size, params, loop([=](size_t i) {
+            return FiniteDifference::europeanOptionPrice(spotAt(i), K, r, T, sigma, OptionType::Call, grid);
+        })});
+        cases.push_back({"finite_difference/american_price/grid:" + size, params, loop([=](size_t i) {
+            return FiniteDifference::americanOptionPrice(spotAt(i), K, r, T, sigma, OptionType::Put, grid);
+        })});
+    }
+    // Price, delta and gamma read off one solved grid, as a scenario would
+    auto slice = std::make_shared<FiniteDifference::SolutionSlice>(
+        FiniteDifference::solve(100.0, K, r, T, sigma, OptionType::Put, true));
+    cases.push_back({"finite_difference/slice_greeks", {}, loop([slice](size_t i) {
+        return slice->price(spotAt(i)) + slice->delta(spotAt(i)) + slice->gamma(spotAt(i));
+    })});
+
+    AndersenLakeOffengeld::CollocationSettings fast;
+    fast.collocation_nodes = 8;
+    fast.integration_nodes = 8;
+    fast.iterations = 4;
+    fast.pricing_nodes = 16;
+    cases.push_back({"alo/american_price", {}, loop([=](size_t i) {
+        return AndersenLakeOffengeld::americanOptionPrice(spotAt(i), K, r, T, sigma, OptionType::Put);
+    })});
+    cases.push_back({"alo/american_price/fast", {{"collocation_nodes", integer(8)}}, loop([=](size_t i) {
+        return AndersenLakeOffengeld::americanOptionPrice(spotAt(i), K, r, T, sigma, OptionType::Put, fast);
+    })});
+    cases.push_back({"alo/boundary", {}, loop([=](size_t i) {
+        return AndersenLakeOffengeld::ExerciseBoundary(r, T, sigma + static_cast<double>(i % 64) * 1e-4)(T);
+    })});
+    auto boundary = std::make_shared<AndersenLakeOffengeld::ExerciseBoundary>(r, T, sigma);
+    cases.push_back({"alo/boundary_price", {}, loop([boundary](size_t i) {
+        return boundary->price(spotAt(i), 100.0, OptionType::Put);
+    })});
+    for (int strikes : {10, 50}) {
+        std::vector<double> chain_strikes;
+        std::vector<OptionType> chain_types;
+        for (int k = 0; k < strikes; ++k) {
+            chain_strikes.push_back(70.0 + 60.0 * k / strikes);
+            chain_types.push_back(k % 2 ? OptionType::Call : OptionType::Put);
+        }
+        cases.push_back({"alo/american_chain/strikes:" + std::to_string(strikes),
+                         {{"strikes", integer(strikes)}}, loop([=](size_t i) {
+            return AndersenLakeOffengeld::americanOptionPrices(spotAt(i), chain_strikes, chain_types, r, T, sigma)
+                .front();
+        })});
+    }
+
+    cases.push_back({"baw/american_price", {}, loop([=](size_t i) {
+        return BaroneAdesiWhaley::americanOptionPrice(spotAt(i), K, r, T, sigma, OptionType::Put);
+    })});
+    auto approximation =
+        std::make_shared<BaroneAdesiWhaley::QuadraticApproximation>(K, r, T, sigma, OptionType::Put);
+    cases.push_back({"baw/approximation_price", {}, loop([approximation](size_t i) {
+        return approximation->price(spotAt(i));
+    })});
+}
+
+// Columns of `size` options for BatchPricing, Black-Scholes unless `model`
+// is given; American elements share one chain per expiry
+struct BatchColumns {
+    std::vector<double> spot, strike, expiry, rate, volatility;
+    std::vector<int32_t> type, model;
+    std::vector<uint8_t> american;
+    std::vector<double> prices, delta, gamma, vega, theta;
+
+    BatchColumns(size_t size, PricingModel pricing_model, bool is_american)
+        : spot(size), strike(size), expiry(size), rate(size, 0.05), volatility(size), type(size),
+          model(size, static_cast<int32_t>(pricing_model)), american(size, is_american ? 1 : 0),
+          prices(size), delta(size), gamma(size), vega(size), theta(size) {
+        for (size_t i = 0; i < size; ++i) {
+            spot[i] = is_american ? 100.0 : spotAt(i);
+            strike[i] = 70.0 + static_cast<double>(i % 61);
+            expiry[i] = 0.25 * static_cast<double>(1 + i % 4);
+            volatility[i] = is_american ? 0.25 : 0.1 + static_cast<double>(i % 7) * 0.05;
+            type[i] = static_cast<int32_t>(i % 2);
+        }
+    }
+
+    BatchPricing::OptionArrays arrays() const {
+        BatchPricing::OptionArrays options;
+        options.size = spot.size();
+        options.spot = spot.data();
+        options.strike = strike.data();
+        options.expiry = expiry.data();
+        options.rate = rate.data();
+        options.volatility = volatility.data();
+        options.type = type.data();
+        options.model = model.data();
+        options.american = american.data();
+        return options;
+    }
+};
+
+// One operation values the whole batch on a single thread, so results do not
+// depend on the machine's core count; per-option cost is ns_per_op / options
+void addBatchPricingCases(std::vector<Case>& cases) {
+    for (size_t size : {1000, 10000}) {
+        auto columns = std::make_shared<BatchColumns>(size, PricingModel::BlackScholes, false);
+        const Json::Value::Object params = {{"options", integer(static_cast<long long>(size))}};
+        cases.push_back({"batch_pricing/price/options:" + std::to_string(size), params, loop([columns](size_t) {
+            BatchPricing::price(columns->arrays(), columns->prices.data(), 1);
+            return columns->prices.back();
+        })});
+        cases.push_back({"batch_pricing/greeks/options:" + std::to_string(size), params, loop([columns](size_t) {
+            BatchPricing::GreekArrays out;
+            out.price = columns->prices.data();
+            out.delta = columns->delta.data();
+            out.gamma = columns->gamma.data();
+            out.vega = columns->vega.data();
+            out.theta = columns->theta.data();
+            BatchPricing::greeks(columns->arrays(), out, 1);
+            return columns->delta.back();
+        })});
+    }
+    auto chains = std::make_shared<BatchColumns>(200, PricingModel::Binomial, true);
+    cases.push_back({"batch_pricing/american_chains/options:200", {{"options", integer(200)}},
+                     loop([chains](size_t) {
+        BatchPricing::price(chains->arrays(), chains->prices.data(), 1);
+        return chains->prices.back();
+    })});
+}
+
+void addSurfaceCases(std::vector<Case>& cases) {
+    for (int side : {4, 8, 16, 32}) {
+        auto surface = std::make_shared<VolatilitySurface::ImpliedVolSurface>();
+        for (int s = 0; s < side; ++s) {
+            for (int e = 0; e < side; ++e) {
+                const double strike = 50.0 + 100.0 * s / (side - 1);
+                const double expiry = 0.1 + 1.9 * e / (side - 1);
+                surface->addPoint(strike, expiry, 0.2 + 0.1 * std::abs(strike - 100.0) / 50.0 + 0.02 * expiry);
+            }
+        }
+        const int points = side * side;
+        cases.push_back({"vol_surface/interpolate/points:" + std::to_string(points),
+                         {{"points", integer(points)}}, loop([surface](size_t i) {
+            const double strike = 55.0 + static_cast<double>(i % 61) * 1.5;
+            const double expiry = 0.15 + static_cast<double>(i % 37) * 0.05;
+            return surface->interpolate(strike, expiry);
+        })});
+    }
+}
+
+// Normal shocks as the VaR loop draws them. One bulk operation fills a block
+// of 256 paths; per-draw cost is ns_per_op / 256.
+void addRandomCases(std::vector<Case>& cases) {
+    auto generator = std::make_shared<std::mt19937>(42);
+    auto distribution = std::make_shared<std::normal_distribution<double>>(0.0, 1.0);
+    cases.push_back({"random/mt19937_normal", {}, loop([=](size_t) {
+        return (*distribution)(*generator);
+    })});
+    cases.push_back({"random/philox_normal", {}, loop([](size_t i) {
+        return Philox::normal(42, i, 0, 0);
+    })});
+
+    const size_t block = 256;
+    auto paths = std::make_shared<std::vector<uint64_t>>(block);
+    auto draws = std::make_shared<std::vector<double>>(block);
+    cases.push_back({"random/philox_fill_normals/block:256", {{"block", integer(block)}}, loop([=](size_t i) {
+        for (size_t p = 0; p < block; ++p) {
+            (*paths)[p] = i * block + p;
+        }
+        Philox::fillNormals(42, paths->data(), block, 0, 0, draws->data());
+        return draws->back();
+    })});
+}
+
+// `positions` Black-Scholes options spread evenly over `assets` underlyings,
+// valued with a fixed-seed VaR of `simulations` paths per operation
+Case riskCase(const std::string& axis, int positions, int assets, int simulations,
+              RandomGenerator generator = RandomGenerator::MersenneTwister) {
+    auto portfolio = std::make_shared<Portfolio>();
+    auto market_data = std::make_shared<std::map<std::string, MarketData>>();
+    portfolio->reserve(positions);
+    for (int a = 0; a < assets; ++a) {
+        const std::string asset_id = "SYM" + std::to_string(a);
+        (*market_data)[asset_id] = MarketData(asset_id, 100.0 + a % 10, 0.05, 0.2 + 0.01 * (a % 10));
+    }
+    for (int p = 0; p < positions; ++p) {
+        const std::string asset_id = "SYM" + std::to_string(p % assets);
+        const OptionType type = p % 2 ? OptionType::Call : OptionType::Put;
+        portfolio->addInstrument(
+            std::make_unique<EuropeanOption>(type, 80.0 + (p % 20) * 2.0, 0.25 * (1 + p % 4), asset_id),
+            p % 3 == 0 ? -10 : 10);
+    }
+    const RiskConfig config =
+        RiskConfig().withVaRSimulations(simulations).withRandomSeed(42).withRandomGenerator(generator);
+    auto engine = std::make_shared<RiskEngine>();
+
+    const std::string value = axis == "positions"   ? std::to_string(positions)
+                              : axis == "assets"    ? std::to_string(assets)
+                              : axis == "generator" ? std::string("philox")
+                                                    : std::to_string(simulations);
+    return {"risk_engine/" + axis + ":" + value,
+            {{"positions", integer(positions)}, {"assets", integer(assets)}, {"simulations", integer(simulations)}},
+            [=](size_t iterations) {
+                double sum = 0.0;
+                for (size_t i = 0; i < iterations; ++i) {
+                    sum += engine->calculatePortfolioRisk(*portfolio, *market_data, config).value_at_risk_95;
+                }
+                g_sink = g_sink + sum;
+            }};
+}
+
+void addRiskEngineCases(std::vector<Case>& cases) {
+    for (int positions : {10, 100, 1000}) {
+        cases.push_back(riskCase("positions", positions, 10, 10000));
+    }
+    for (int assets : {1, 10, 100}) {
+        cases.push_back(riskCase("assets", 1000, assets, 10000));
+    }
+    for (int simulations : {1000, 10000, 100000}) {
+        cases.push_back(riskCase("simulations", 100, 10, simulations));
+    }
+    cases.push_back(riskCase("generator", 100, 10, 100000, RandomGenerator::Philox));
+}
+
+double secondsFor(const Case& bench, size_t iterations) {
+    const auto start = std::chrono::steady_clock::now();
+    bench.run(iterations);
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Doubles the batch until one takes min_time, then times `repetitions` batches
+Json::Value measure(const Case& bench, const Options& options) {
+    size_t iterations = 1;
+    double elapsed = secondsFor(bench, iterations);
+    while (elapsed < options.min_time && iterations < (size_t(1) << 40)) {
+        const double scale = elapsed > 0.0 ? 1.4 * options.min_time / elapsed : 16.0;
+        iterations = std::max(iterations * 2, static_cast<size_t>(static_cast<double>(iterations) *
+                                                                  std::min(scale, 1000.0)));
+        elapsed = secondsFor(bench, iterations);
+    }
+
+    // Allocations are counted over the timed batches only; reserving first
+    // keeps the result vector out of the count
+    std::vector<double> ns_per_op;
+    ns_per_op.reserve(static_cast<size_t>(options.repetitions));
+    const AllocationCounter::Counts before = AllocationCounter::current();
+    for (int r = 0; r < options.repetitions; ++r) {
+        ns_per_op.push_back(secondsFor(bench, iterations) * 1e9 / static_cast<double>(iterations));
+    }
+    const AllocationCounter::Counts after = AllocationCounter::current();
+    const double ops = static_cast<double>(iterations) * options.repetitions;
+    std::sort(ns_per_op.begin(), ns_per_op.end());
+    const size_t n = ns_per_op.size();
+    const double median = n % 2 ? ns_per_op[n / 2] : 0.5 * (ns_per_op[n / 2 - 1] + ns_per_op[n / 2]);
+
+    return Json::Value::object({
+        {"name", Json::Value::string(bench.name)},
+        {"params", Json::Value::object(bench.params)},
+        {"iterations", integer(static_cast<long long>(iterations))},
+        {"repetitions", integer(options.repetitions)},
+        {"ns_per_op", Json::Value::object({
+            {"median", Json::Value::number(median)},
+            {"min", Json::Value::number(ns_per_op.front())},
+            {"max", Json::Value::number(ns_per_op.back())},
+        })},
+        {"ops_per_second", Json::Value::number(1e9 / median)},
+        {"allocs_per_op", Json::Value::number(static_cast<double>(after.allocations - before.allocations) / ops)},
+        {"bytes_per_op", Json::Value::number(static_cast<double>(after.bytes - before.bytes) / ops)},
+    });
+}
+
+Json::Value context(const Options& options) {
+    char date[32];
+    const std::time_t now = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+#if defined(__clang__)
+    const std::string compiler = std::string("clang ") + __clang_version__;
+#elif defined(__GNUC__)
+    const std::string compiler = std::string("gcc ") + __VERSION__;
+#elif defined(_MSC_VER)
+    const std::string compiler = "MSVC " + std::to_string(_MSC_VER);
+#else
+    const std::string compiler = "unknown";
+#endif
+#ifdef NDEBUG
+    const char* build = "release";
+#else
+    const char* build = "debug";
+#endif
+    return Json::Value::object({
+        {"date", Json::Value::string(date)},
+        {"compiler", Json::Value::string(compiler)},
+        {"build", Json::Value::string(build)},
+        {"hardware_threads", integer(std::thread::hardware_concurrency())},
+        {"min_time_seconds", Json::Value::number(options.min_time)},
+        {"repetitions", integer(options.repetitions)},
+    });
+}
+
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program
+              << " [--filter TEXT] [--min-time SECONDS] [--repetitions N] [--json PATH|-] [--list]\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--list") {
+            options.list = true;
+            continue;
+        }
+        if (arg == "--help" || arg == "-h" || i + 1 >= argc) {
+            printUsage(argv[0]);
+            return arg == "--help" || arg == "-h" ? 0 : 1;
+        }
+        const std::string value = argv[++i];
+        try {
+            if (arg == "--filter") {
+                options.filter = value;
+            } else if (arg == "--min-time") {
+                options.min_time = std::stod(value);
+            } else if (arg == "--repetitions") {
+                options.repetitions = std::max(1, std::stoi(value));
+            } else if (arg == "--json") {
+                options.json_path = value;
+            } else {
+                printUsage(argv[0]);
+                return 1;
+            }
+        } catch (const std::exception&) {
+            std::cerr << "Invalid value for " << arg << ": " << value << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<Case> cases;
+    addPricerCases(cases);
+    addAmericanCases(cases);
+    addBatchPricingCases(cases);
+    addSurfaceCases(cases);
+    addRandomCases(cases);
+    addRiskEngineCases(cases);
+
+    // With the JSON report on stdout the table goes to stderr
+    std::ostream& table = options.json_path == "-" ? std::cerr : std::cout;
+    Json::Value::Array results;
+    for (const Case& bench : cases) {
+        if (bench.name.find(options.filter) == std::string::npos) {
+            continue;
+        }
+        if (options.list) {
+            std::cout << bench.name << "\n";
+            continue;
+        }
+        Json::Value result;
+        try {
+            result = measure(bench, options);
+        } catch (const std::exception& e) {
+            table << std::left << std::setw(48) << bench.name << " failed: " << e.what() << std::endl;
+            results.push_back(Json::Value::object({
+                {"name", Json::Value::string(bench.name)},
+                {"error", Json::Value::string(e.what())},
+            }));
+            continue;
+        }
+        const Json::Value& ns = *result.find("ns_per_op");
+        table << std::left << std::setw(48) << bench.name << std::right << std::fixed << std::setprecision(1)
+              << std::setw(16) << ns.find("median")->asNumber() << " ns/op" << std::setw(14)
+              << static_cast<long long>(result.find("iterations")->asNumber()) << " iterations"
+              << std::setw(12) << result.find("allocs_per_op")->asNumber() << " allocs/op" << std::endl;
+        results.push_back(result);
+    }
+    if (options.list || options.json_path.empty()) {
+        return 0;
+    }
+
+    const std::string report = Json::write(Json::Value::object({
+        {"context", context(options)},
+        {"benchmarks", Json::Value::array(std::move(results))},
+    }));
+    if (options.json_path == "-") {
+        std::cout << report << std::endl;
+        return 0;
+    }
+    std::ofstream out(options.json_path);
+    if (!out) {
+        std::cerr << "Error: cannot write " << options.json_path << std::endl;
+        return 1;
+    }
+    out << report << "\n";
+    return 0;
+}
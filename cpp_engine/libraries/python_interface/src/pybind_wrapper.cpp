@@ -1,16 +1,122 @@
+#include <pybind11/numpy.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 #include <pybind11/stl_bind.h>
 
+#include "BatchPricing.h"
+#include "Ingestion.h"
 #include "Instrument.h"
 #include "Portfolio.h"
 #include "RiskEngine.h"
+#include "RiskResultCache.h"
+#include "RiskSession.h"
+#include "TraceRecorder.h"
 #include "MarketData.h"
 
 #include <memory>
+#include <optional>
+#include <string>
 
 namespace py = pybind11;
 
+namespace {
+
+// float64/int32 C-contiguous inputs are read in place; anything else is
+// converted once. Outputs must already have the right type and layout,
+// since results written to a converted copy would be lost.
+using DoubleArray = py::array_t<double, py::array::c_style | py::array::forcecast>;
+using IntArray = py::array_t<int32_t, py::array::c_style | py::array::forcecast>;
+using FlagArray = py::array_t<uint8_t, py::array::c_style | py::array::forcecast>;
+using OutputArray = py::array_t<double, py::array::c_style>;
+
+template <typename Array>
+void checkLength(const Array &array, size_t size, const char *name)
+{
+    if (static_cast<size_t>(array.size()) != size) {
+        throw std::invalid_argument(std::string(name) + " has " + std::to_string(array.size()) +
+                                    " elements, expected " + std::to_string(size));
+    }
+}
+
+BatchPricing::OptionArrays optionArrays(const DoubleArray &spot, const DoubleArray &strike,
+                                        const DoubleArray &expiry, const DoubleArray &rate,
+                                        const DoubleArray &vol, const IntArray &option_type,
+                                        const std::optional<IntArray> &model,
+                                        const std::optional<FlagArray> &american,
+                                        const std::optional<DoubleArray> &dividend)
+{
+    BatchPricing::OptionArrays options;
+    options.size = static_cast<size_t>(spot.size());
+    checkLength(strike, options.size, "strike");
+    checkLength(expiry, options.size, "expiry");
+    checkLength(rate, options.size, "rate");
+    checkLength(vol, options.size, "vol");
+    checkLength(option_type, options.size, "option_type");
+    options.spot = spot.data();
+    options.strike = strike.data();
+    options.expiry = expiry.data();
+    options.rate = rate.data();
+    options.volatility = vol.data();
+    options.type = option_type.data();
+    if (model) {
+        checkLength(*model, options.size, "model");
+        options.model = model->data();
+    }
+    if (american) {
+        checkLength(*american, options.size, "american");
+        options.american = american->data();
+    }
+    if (dividend) {
+        checkLength(*dividend, options.size, "dividend");
+        options.dividend = dividend->data();
+    }
+    return options;
+}
+
+OutputArray priceBatch(const DoubleArray &spot, const DoubleArray &strike, const DoubleArray &expiry,
+                       const DoubleArray &rate, const DoubleArray &vol, const IntArray &option_type,
+                       const std::optional<IntArray> &model, const std::optional<FlagArray> &american,
+                       const std::optional<DoubleArray> &dividend, std::optional<OutputArray> out,
+                       unsigned threads)
+{
+    const BatchPricing::OptionArrays options =
+        optionArrays(spot, strike, expiry, rate, vol, option_type, model, american, dividend);
+    OutputArray prices = out ? *out : OutputArray(static_cast<py::ssize_t>(options.size));
+    checkLength(prices, options.size, "out");
+    double *data = prices.mutable_data();
+    {
+        py::gil_scoped_release release;
+        BatchPricing::price(options, data, threads);
+    }
+    return prices;
+}
+
+// Output rows are price, delta, gamma, vega and theta
+OutputArray greeksBatch(const DoubleArray &spot, const DoubleArray &strike, const DoubleArray &expiry,
+                        const DoubleArray &rate, const DoubleArray &vol, const IntArray &option_type,
+                        const std::optional<IntArray> &model, const std::optional<FlagArray> &american,
+                        const std::optional<DoubleArray> &dividend, std::optional<OutputArray> out,
+                        unsigned threads)
+{
+    const BatchPricing::OptionArrays options =
+        optionArrays(spot, strike, expiry, rate, vol, option_type, model, american, dividend);
+    const py::ssize_t n = static_cast<py::ssize_t>(options.size);
+    OutputArray greeks = out ? *out : OutputArray({py::ssize_t(5), n});
+    if (greeks.ndim() != 2 || greeks.shape(0) != 5 || greeks.shape(1) != n) {
+        throw std::invalid_argument("out must have shape (5, " + std::to_string(n) + ")");
+    }
+    double *data = greeks.mutable_data();
+    const size_t row = options.size;
+    const BatchPricing::GreekArrays columns{data, data + row, data + 2 * row, data + 3 * row, data + 4 * row};
+    {
+        py::gil_scoped_release release;
+        BatchPricing::greeks(options, columns, threads);
+    }
+    return greeks;
+}
+
+} // namespace
+
 PYBIND11_MODULE(quant_risk_engine, m)
 {
     m.doc() = "Python bindings for the Quant Enthusiasts Risk Engine";
@@ -24,6 +130,9 @@ PYBIND11_MODULE(quant_risk_engine, m)
         .value("BlackScholes", PricingModel::BlackScholes)
         .value("Binomial", PricingModel::Binomial)
         .value("MertonJumpDiffusion", PricingModel::MertonJumpDiffusion)
+        .value("FiniteDifference", PricingModel::FiniteDifference)
+        .value("AndersenLakeOffengeld", PricingModel::AndersenLakeOffengeld)
+        .value("BaroneAdesiWhaley", PricingModel::BaroneAdesiWhaley)
         .export_values();
 
     py::class_<MarketData>(m, "MarketData")
@@ -40,6 +149,20 @@ PYBIND11_MODULE(quant_risk_engine, m)
         .def("validate", &MarketData::validate)
         .def("is_valid", &MarketData::isValid);
 
+    py::class_<MarketDataSnapshot, std::shared_ptr<MarketDataSnapshot>>(m, "MarketDataSnapshot")
+        .def("get_market_data", &MarketDataSnapshot::getMarketData,
+             py::arg("asset_id"))
+        .def("has_market_data", &MarketDataSnapshot::hasMarketData,
+             py::arg("asset_id"))
+        .def("size", &MarketDataSnapshot::size)
+        .def("get_all_market_data", &MarketDataSnapshot::getAllMarketData)
+        .def("get_version", &MarketDataSnapshot::getVersion)
+        .def("get_asset_version", &MarketDataSnapshot::getAssetVersion,
+             py::arg("asset_id"))
+        .def("get_changed_assets", &MarketDataSnapshot::getChangedAssets,
+             py::arg("since_version"))
+        .def("__len__", &MarketDataSnapshot::size);
+
     py::class_<MarketDataManager>(m, "MarketDataManager")
         .def(py::init<>())
         .def("add_market_data", &MarketDataManager::addMarketData,
@@ -55,6 +178,13 @@ PYBIND11_MODULE(quant_risk_engine, m)
         .def("clear", &MarketDataManager::clear)
         .def("size", &MarketDataManager::size)
         .def("get_all_market_data", &MarketDataManager::getAllMarketData)
+        .def("get_version", &MarketDataManager::getVersion)
+        .def("get_asset_version", &MarketDataManager::getAssetVersion,
+             py::arg("asset_id"))
+        .def("get_changed_assets", &MarketDataManager::getChangedAssets,
+             py::arg("since_version"))
+        .def("snapshot", [](const MarketDataManager &mdm)
+             { return std::const_pointer_cast<MarketDataSnapshot>(mdm.snapshot()); })
         .def("__len__", &MarketDataManager::size);
 
     py::class_<Instrument, std::shared_ptr<Instrument>>(m, "Instrument")
@@ -65,7 +195,8 @@ PYBIND11_MODULE(quant_risk_engine, m)
         .def("theta", &Instrument::theta)
         .def("get_asset_id", &Instrument::getAssetId)
         .def("get_instrument_type", &Instrument::getInstrumentType)
-        .def("is_valid", &Instrument::isValid);
+        .def("is_valid", &Instrument::isValid)
+        .def("get_contract_key", &Instrument::getContractKey);
 
     py::class_<EuropeanOption, Instrument, std::shared_ptr<EuropeanOption>>(m, "EuropeanOption")
         .def(py::init<OptionType, double, double, std::string>(),
@@ -80,6 +211,12 @@ PYBIND11_MODULE(quant_risk_engine, m)
         .def("set_jump_parameters", &EuropeanOption::setJumpParameters,
              py::arg("lambda"), py::arg("jump_mean"), py::arg("jump_vol"))
         .def("get_jump_intensity", &EuropeanOption::getJumpIntensity)
+        .def("get_jump_mean", &EuropeanOption::getJumpMean)
+        .def("get_jump_volatility", &EuropeanOption::getJumpVolatility)
+        .def("set_finite_difference_grid", &EuropeanOption::setFiniteDifferenceGrid,
+             py::arg("space_steps"), py::arg("time_steps"))
+        .def("get_finite_difference_space_steps", &EuropeanOption::getFiniteDifferenceSpaceSteps)
+        .def("get_finite_difference_time_steps", &EuropeanOption::getFiniteDifferenceTimeSteps)
         .def("get_option_type", &EuropeanOption::getOptionType)
         .def("get_strike", &EuropeanOption::getStrike)
         .def("get_time_to_expiry", &EuropeanOption::getTimeToExpiry);
@@ -91,29 +228,76 @@ PYBIND11_MODULE(quant_risk_engine, m)
              py::arg("option_type"), py::arg("strike"), py::arg("expiry"),
              py::arg("asset_id"), py::arg("binomial_steps"))
         .def("set_binomial_steps", &AmericanOption::setBinomialSteps)
-        .def("get_binomial_steps", &AmericanOption::getBinomialSteps);
+        .def("get_binomial_steps", &AmericanOption::getBinomialSteps)
+        .def("set_pricing_model", &AmericanOption::setPricingModel)
+        .def("get_pricing_model", &AmericanOption::getPricingModel)
+        .def("set_finite_difference_grid", &AmericanOption::setFiniteDifferenceGrid,
+             py::arg("space_steps"), py::arg("time_steps"))
+        .def("get_finite_difference_space_steps", &AmericanOption::getFiniteDifferenceSpaceSteps)
+        .def("get_finite_difference_time_steps", &AmericanOption::getFiniteDifferenceTimeSteps)
+        .def("get_option_type", &AmericanOption::getOptionType)
+        .def("get_strike", &AmericanOption::getStrike)
+        .def("get_time_to_expiry", &AmericanOption::getTimeToExpiry);
+
+    py::class_<NettedPosition>(m, "NettedPosition")
+        .def_readonly("instrument_index", &NettedPosition::instrument_index)
+        .def_readonly("quantity", &NettedPosition::quantity)
+        .def_readonly("rows", &NettedPosition::rows);
 
     py::class_<Portfolio>(m, "Portfolio")
         .def(py::init<>())
         .def("add_instrument", [](Portfolio &p, EuropeanOption &instr, int quantity)
              {
             auto owned_instr = std::make_unique<EuropeanOption>(instr);
-            p.addInstrument(std::move(owned_instr), quantity); }, py::arg("instrument"), py::arg("quantity"))
+            return p.addInstrument(std::move(owned_instr), quantity); }, py::arg("instrument"), py::arg("quantity"))
         .def("add_instrument", [](Portfolio &p, AmericanOption &instr, int quantity)
              {
             auto owned_instr = std::make_unique<AmericanOption>(instr);
-            p.addInstrument(std::move(owned_instr), quantity); }, py::arg("instrument"), py::arg("quantity"))
+            return p.addInstrument(std::move(owned_instr), quantity); }, py::arg("instrument"), py::arg("quantity"))
         .def("size", &Portfolio::size)
         .def("empty", &Portfolio::empty)
         .def("clear", &Portfolio::clear)
         .def("reserve", &Portfolio::reserve)
         .def("get_total_quantity", &Portfolio::getTotalQuantityForAsset)
+        .def("get_rows_for_asset", &Portfolio::getRowsForAsset)
+        .def("get_net_positions", &Portfolio::getNetPositions)
         .def("remove_instrument", &Portfolio::removeInstrument)
+        .def("remove_position", &Portfolio::removePosition, py::arg("handle"))
+        .def("get_handle", &Portfolio::getHandle, py::arg("index"))
+        .def("get_index", &Portfolio::getIndex, py::arg("handle"))
         .def("update_quantity", &Portfolio::updateQuantity)
+        .def("get_netted_positions", &Portfolio::getNettedPositions)
+        .def("get_version", &Portfolio::getVersion)
+        .def("save_binary", &Portfolio::saveBinary, py::arg("path"),
+             py::call_guard<py::gil_scoped_release>())
+        .def("load_binary", &Portfolio::loadBinary, py::arg("path"),
+             py::call_guard<py::gil_scoped_release>())
         .def("__len__", &Portfolio::size)
         .def("__bool__", [](const Portfolio &p)
              { return !p.empty(); });
 
+    py::class_<RiskPhaseTiming>(m, "RiskPhaseTiming")
+        .def_readonly("phase", &RiskPhaseTiming::phase)
+        .def_readonly("wall_seconds", &RiskPhaseTiming::wall_seconds)
+        .def_readonly("cpu_seconds", &RiskPhaseTiming::cpu_seconds)
+        .def_readonly("allocations", &RiskPhaseTiming::allocations)
+        .def_readonly("allocated_bytes", &RiskPhaseTiming::allocated_bytes);
+
+    py::class_<PositionTiming>(m, "PositionTiming")
+        .def_readonly("position", &PositionTiming::position)
+        .def_readonly("asset_id", &PositionTiming::asset_id)
+        .def_readonly("pricing_model", &PositionTiming::pricing_model)
+        .def_readonly("seconds", &PositionTiming::seconds);
+
+    py::class_<RiskDiagnostics>(m, "RiskDiagnostics")
+        .def_readonly("enabled", &RiskDiagnostics::enabled)
+        .def_readonly("phases", &RiskDiagnostics::phases)
+        .def_readonly("revaluations", &RiskDiagnostics::revaluations)
+        .def_readonly("slowest_positions", &RiskDiagnostics::slowest_positions)
+        .def_readonly("allocations_counted", &RiskDiagnostics::allocations_counted)
+        .def_readonly("allocations", &RiskDiagnostics::allocations)
+        .def_readonly("allocated_bytes", &RiskDiagnostics::allocated_bytes);
+
     py::class_<PortfolioRiskResult>(m, "PortfolioRiskResult")
         .def(py::init<>())
         .def_readwrite("total_pv", &PortfolioRiskResult::total_pv)
@@ -125,17 +309,239 @@ PYBIND11_MODULE(quant_risk_engine, m)
         .def_readwrite("value_at_risk_99", &PortfolioRiskResult::value_at_risk_99)
         .def_readwrite("expected_shortfall_95", &PortfolioRiskResult::expected_shortfall_95)
         .def_readwrite("expected_shortfall_99", &PortfolioRiskResult::expected_shortfall_99)
+        .def_readonly("diagnostics", &PortfolioRiskResult::diagnostics)
         .def("is_valid", &PortfolioRiskResult::isValid)
         .def("reset", &PortfolioRiskResult::reset);
 
+    py::class_<TraceRecorder, std::shared_ptr<TraceRecorder>>(m, "TraceRecorder")
+        .def(py::init<size_t>(), py::arg("events_per_thread") = 65536)
+        .def("to_json", &TraceRecorder::toJson,
+             "Chrome trace-event JSON, for Perfetto or chrome://tracing")
+        .def("write", &TraceRecorder::write, py::arg("path"),
+             py::call_guard<py::gil_scoped_release>())
+        .def("clear", &TraceRecorder::clear)
+        .def_property_readonly("dropped", &TraceRecorder::getDropped)
+        .def_property_readonly("events_per_thread", &TraceRecorder::getEventsPerThread)
+        .def("__len__", &TraceRecorder::size);
+
+    py::enum_<RandomGenerator>(m, "RandomGenerator")
+        .value("MersenneTwister", RandomGenerator::MersenneTwister)
+        .value("Philox", RandomGenerator::Philox);
+
+    py::class_<RiskScenario>(m, "RiskScenario")
+        .def_readonly("path", &RiskScenario::path)
+        .def_readonly("spots", &RiskScenario::spots)
+        .def_readonly("pnl", &RiskScenario::pnl);
+
+    py::class_<RiskMetrics>(m, "RiskMetrics")
+        .def_readonly("var_95", &RiskMetrics::var_95)
+        .def_readonly("var_99", &RiskMetrics::var_99)
+        .def_readonly("es_95", &RiskMetrics::es_95)
+        .def_readonly("es_99", &RiskMetrics::es_99);
+
+    py::class_<VaRShard>(m, "VaRShard")
+        .def_readonly("total_paths", &VaRShard::total_paths)
+        .def_readonly("first_path", &VaRShard::first_path)
+        .def_readonly("last_path", &VaRShard::last_path)
+        .def_readonly("tail", &VaRShard::tail)
+        .def("size", &VaRShard::size)
+        .def("is_complete", &VaRShard::isComplete)
+        .def("mean", &VaRShard::mean)
+        .def("standard_deviation", &VaRShard::standardDeviation)
+        .def("metrics", &VaRShard::metrics)
+        .def("serialize", [](const VaRShard& shard) { return py::bytes(shard.serialize()); })
+        .def_static("deserialize", [](const py::bytes& bytes) {
+            return VaRShard::deserialize(static_cast<std::string>(bytes));
+        }, py::arg("data"))
+        .def_static("merge", &VaRShard::merge, py::arg("shards"));
+
+    py::class_<RiskConfig>(m, "RiskConfig")
+        .def(py::init([](int simulations, double time_horizon_days, std::optional<unsigned int> seed,
+                         bool fast_american_revaluation, bool jump_diffusion_scenarios, bool diagnostics,
+                         std::shared_ptr<TraceRecorder> trace, RandomGenerator random_generator)
+                      {
+            RiskConfig config = RiskConfig()
+                .withVaRSimulations(simulations)
+                .withVaRTimeHorizonDays(time_horizon_days)
+                .withFastAmericanRevaluation(fast_american_revaluation)
+                .withJumpDiffusionScenarios(jump_diffusion_scenarios)
+                .withDiagnostics(diagnostics)
+                .withTrace(std::move(trace))
+                .withRandomGenerator(random_generator);
+            return seed ? config.withRandomSeed(*seed) : config; }),
+             py::arg("simulations") = 10000, py::arg("time_horizon_days") = 1.0,
+             py::arg("seed") = py::none(), py::arg("fast_american_revaluation") = false,
+             py::arg("jump_diffusion_scenarios") = false, py::arg("diagnostics") = false,
+             py::arg("trace") = py::none(), py::arg("random_generator") = RandomGenerator::MersenneTwister)
+        .def("with_var_simulations", &RiskConfig::withVaRSimulations)
+        .def("with_var_time_horizon_days", &RiskConfig::withVaRTimeHorizonDays)
+        .def("with_random_seed", &RiskConfig::withRandomSeed)
+        .def("without_fixed_seed", &RiskConfig::withoutFixedSeed)
+        .def("with_fast_american_revaluation", &RiskConfig::withFastAmericanRevaluation)
+        .def("with_jump_diffusion_scenarios", &RiskConfig::withJumpDiffusionScenarios)
+        .def("with_diagnostics", &RiskConfig::withDiagnostics)
+        .def("with_trace", &RiskConfig::withTrace, py::arg("trace"))
+        .def("with_random_generator", &RiskConfig::withRandomGenerator, py::arg("generator"))
+        .def_property_readonly("var_simulations", &RiskConfig::getVaRSimulations)
+        .def_property_readonly("var_time_horizon_days", &RiskConfig::getVaRTimeHorizonDays)
+        .def_property_readonly("random_seed", &RiskConfig::getRandomSeed)
+        .def_property_readonly("use_fixed_seed", &RiskConfig::getUseFixedSeed)
+        .def_property_readonly("fast_american_revaluation", &RiskConfig::getFastAmericanRevaluation)
+        .def_property_readonly("jump_diffusion_scenarios", &RiskConfig::getJumpDiffusionScenarios)
+        .def_property_readonly("diagnostics", &RiskConfig::getDiagnostics)
+        .def_property_readonly("random_generator", &RiskConfig::getRandomGenerator);
+
+    py::register_exception<RiskCalculationCancelled>(m, "RiskCalculationCancelled", PyExc_RuntimeError);
+
+    // Polled and cancelled from other threads while a calculation runs
+    py::class_<RiskRunControl>(m, "RiskRunControl")
+        .def(py::init<>())
+        .def("cancel", &RiskRunControl::cancel)
+        .def("is_cancelled", &RiskRunControl::isCancelled)
+        .def("get_completed_simulations", &RiskRunControl::getCompletedSimulations)
+        .def("get_total_simulations", &RiskRunControl::getTotalSimulations)
+        .def("get_progress", &RiskRunControl::getProgress)
+        .def("has_greeks", &RiskRunControl::hasGreeks)
+        .def("has_partial_var", &RiskRunControl::hasPartialVaR)
+        .def("get_partial_result", &RiskRunControl::getPartialResult);
+
+    // Calculations release the GIL; one engine may serve many request threads
+    // as long as its default config is not changed meanwhile and the
+    // portfolio is not edited during a call.
     py::class_<RiskEngine>(m, "RiskEngine")
         .def(py::init<>())
         .def(py::init<int>())
-        .def("calculate_portfolio_risk", &RiskEngine::calculatePortfolioRisk)
+        .def(py::init<const RiskConfig &>(), py::arg("config"))
+        .def("calculate_portfolio_risk",
+             py::overload_cast<const Portfolio &, const std::map<std::string, MarketData> &>(
+                 &RiskEngine::calculatePortfolioRisk, py::const_),
+             py::arg("portfolio"), py::arg("market_data"),
+             py::call_guard<py::gil_scoped_release>())
+        .def("calculate_portfolio_risk",
+             py::overload_cast<const Portfolio &, const std::map<std::string, MarketData> &, const RiskConfig &>(
+                 &RiskEngine::calculatePortfolioRisk, py::const_),
+             py::arg("portfolio"), py::arg("market_data"), py::arg("config"),
+             py::call_guard<py::gil_scoped_release>())
+        .def("calculate_portfolio_risk",
+             py::overload_cast<const Portfolio &, const std::map<std::string, MarketData> &, const RiskConfig &,
+                               RiskRunControl &>(&RiskEngine::calculatePortfolioRisk, py::const_),
+             py::arg("portfolio"), py::arg("market_data"), py::arg("config"), py::arg("control"),
+             py::call_guard<py::gil_scoped_release>())
+        .def("replay_scenarios", &RiskEngine::replayScenarios,
+             py::arg("portfolio"), py::arg("market_data"), py::arg("config"), py::arg("paths"),
+             py::call_guard<py::gil_scoped_release>())
+        .def("worst_scenarios", &RiskEngine::worstScenarios,
+             py::arg("portfolio"), py::arg("market_data"), py::arg("config"), py::arg("count"),
+             py::call_guard<py::gil_scoped_release>())
+        .def("calculate_var_shard", &RiskEngine::calculateVaRShard,
+             py::arg("portfolio"), py::arg("market_data"), py::arg("config"),
+             py::arg("total_paths"), py::arg("first_path"), py::arg("last_path"),
+             py::call_guard<py::gil_scoped_release>())
+        .def("get_config", &RiskEngine::getConfig)
+        .def("set_config", &RiskEngine::setConfig, py::arg("config"))
         .def("set_var_simulations", &RiskEngine::setVaRSimulations)
         .def("get_var_simulations", &RiskEngine::getVaRSimulations)
         .def("set_var_time_horizon_days", &RiskEngine::setVaRTimeHorizonDays)
         .def("get_var_time_horizon_days", &RiskEngine::getVaRTimeHorizonDays)
         .def("set_random_seed", &RiskEngine::setRandomSeed)
-        .def("set_use_fixed_seed", &RiskEngine::setUseFixedSeed);
+        .def("set_use_fixed_seed", &RiskEngine::setUseFixedSeed)
+        .def("set_fast_american_revaluation", &RiskEngine::setFastAmericanRevaluation)
+        .def("get_fast_american_revaluation", &RiskEngine::getFastAmericanRevaluation)
+        .def("set_jump_diffusion_scenarios", &RiskEngine::setJumpDiffusionScenarios)
+        .def("get_jump_diffusion_scenarios", &RiskEngine::getJumpDiffusionScenarios);
+
+    py::class_<RiskSession>(m, "RiskSession")
+        .def(py::init<const Portfolio &, const MarketDataManager &>(),
+             py::arg("portfolio"), py::arg("market_data"),
+             py::keep_alive<1, 2>(), py::keep_alive<1, 3>())
+        .def("refresh", &RiskSession::refresh, py::return_value_policy::copy,
+             py::call_guard<py::gil_scoped_release>())
+        .def("get_result", &RiskSession::getResult, py::return_value_policy::copy)
+        .def("get_asset_subtotal", &RiskSession::getAssetSubtotal, py::arg("asset_id"))
+        .def("get_last_repriced_positions", &RiskSession::getLastRepricedPositions);
+
+    m.def("risk_cache_key",
+          [](const Portfolio &portfolio, const std::map<std::string, MarketData> &market_data,
+             const RiskConfig &config) {
+              return RiskCacheKey::of(portfolio, market_data, config).toString();
+          },
+          py::arg("portfolio"), py::arg("market_data"), py::arg("config"),
+          "Stable content hash of a risk calculation's inputs, as 48 hex digits");
+
+    py::class_<RiskResultCache> risk_result_cache(m, "RiskResultCache");
+
+    py::enum_<RiskResultCache::Source>(risk_result_cache, "Source")
+        .value("Computed", RiskResultCache::Source::Computed)
+        .value("Cached", RiskResultCache::Source::Cached)
+        .value("Coalesced", RiskResultCache::Source::Coalesced);
+
+    risk_result_cache
+        .def(py::init<size_t>(), py::arg("budget_bytes") = 8 * 1024 * 1024)
+        .def_static("is_cacheable", &RiskResultCache::isCacheable, py::arg("config"))
+        .def("calculate",
+             [](RiskResultCache &cache, const RiskEngine &engine, const Portfolio &portfolio,
+                const std::map<std::string, MarketData> &market_data, const RiskConfig &config) {
+                 RiskResultCache::Source source = RiskResultCache::Source::Computed;
+                 PortfolioRiskResult result;
+                 {
+                     py::gil_scoped_release release;
+                     result = cache.calculate(engine, portfolio, market_data, config, &source);
+                 }
+                 return py::make_tuple(result, source);
+             },
+             py::arg("engine"), py::arg("portfolio"), py::arg("market_data"), py::arg("config"),
+             "Returns (result, source); identical calls in flight share one run")
+        .def("clear", &RiskResultCache::clear)
+        .def_property_readonly("hits", &RiskResultCache::getHits)
+        .def_property_readonly("misses", &RiskResultCache::getMisses)
+        .def_property_readonly("evictions", &RiskResultCache::getEvictions)
+        .def_property_readonly("coalesced", &RiskResultCache::getCoalesced)
+        .def_property_readonly("in_flight", &RiskResultCache::getInFlight)
+        .def_property_readonly("bytes", &RiskResultCache::getBytes)
+        .def_property_readonly("budget_bytes", &RiskResultCache::getBudgetBytes)
+        .def("__len__", &RiskResultCache::size);
+
+    py::enum_<Ingestion::Format>(m, "IngestionFormat")
+        .value("Csv", Ingestion::Format::Csv)
+        .value("JsonLines", Ingestion::Format::JsonLines);
+
+    py::class_<Ingestion::RowError>(m, "RowError")
+        .def_readonly("line", &Ingestion::RowError::line)
+        .def_readonly("message", &Ingestion::RowError::message);
+
+    py::class_<Ingestion::PortfolioData>(m, "PortfolioData")
+        .def_property_readonly("portfolio", [](Ingestion::PortfolioData &d) -> Portfolio &
+                               { return d.portfolio; }, py::return_value_policy::reference_internal)
+        .def_readonly("errors", &Ingestion::PortfolioData::errors)
+        .def_readonly("rows_read", &Ingestion::PortfolioData::rows_read);
+
+    py::class_<Ingestion::MarketDataSet>(m, "MarketDataSet")
+        .def_readonly("market_data", &Ingestion::MarketDataSet::market_data)
+        .def_readonly("errors", &Ingestion::MarketDataSet::errors)
+        .def_readonly("rows_read", &Ingestion::MarketDataSet::rows_read);
+
+    // Parsing runs on native threads, so the GIL is released for the duration
+    m.def("parse_portfolio", &Ingestion::parsePortfolio,
+          py::arg("text"), py::arg("format"), py::arg("threads") = 0,
+          py::call_guard<py::gil_scoped_release>());
+    m.def("parse_market_data", &Ingestion::parseMarketData,
+          py::arg("text"), py::arg("format"), py::arg("threads") = 0,
+          py::call_guard<py::gil_scoped_release>());
+    m.def("load_portfolio", &Ingestion::loadPortfolio,
+          py::arg("path"), py::arg("threads") = 0,
+          py::call_guard<py::gil_scoped_release>());
+    m.def("load_market_data", &Ingestion::loadMarketData,
+          py::arg("path"), py::arg("threads") = 0,
+          py::call_guard<py::gil_scoped_release>());
+
+    // Arrays in, arrays out: one call for many options, priced on native
+    // threads with the GIL released. Invalid elements come back as NaN.
+    m.def("price_batch", &priceBatch,
+          py::arg("spot"), py::arg("strike"), py::arg("expiry"), py::arg("rate"), py::arg("vol"),
+          py::arg("option_type"), py::arg("model") = py::none(), py::arg("american") = py::none(),
+          py::arg("dividend") = py::none(), py::arg("out").noconvert() = py::none(), py::arg("threads") = 0);
+    m.def("greeks_batch", &greeksBatch,
+          py::arg("spot"), py::arg("strike"), py::arg("expiry"), py::arg("rate"), py::arg("vol"),
+          py::arg("option_type"), py::arg("model") = py::none(), py::arg("american") = py::none(),
+          py::arg("dividend") = py::none(), py::arg("out").noconvert() = py::none(), py::arg("threads") = 0);
 }
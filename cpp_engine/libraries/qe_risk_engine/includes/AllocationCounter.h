@@ -0,0 +1,30 @@
+#ifndef ALLOCATION_COUNTER_H
+#define ALLOCATION_COUNTER_H
+
+#include <cstddef>
+
+// Opt-in heap allocation counts for RiskDiagnostics and the benchmarks. The
+// library never replaces operator new itself, since that would change every
+// program linking it: an executable that wants counts also links the
+// qe_allocation_hook object library (src/AllocationCounterHook.cpp). Without
+// the hook, installed() is false and nothing is counted.
+namespace AllocationCounter {
+
+struct Counts {
+    long long allocations = 0;
+    long long bytes = 0;
+};
+
+// True once the executable has installed the hook
+bool installed();
+
+// Allocations made so far by the calling thread
+Counts current();
+
+// Called by the hook; neither allocates
+void record(size_t bytes) noexcept;
+void markInstalled() noexcept;
+
+} // namespace AllocationCounter
+
+#endif
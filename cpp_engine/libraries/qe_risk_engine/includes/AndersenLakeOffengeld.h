@@ -0,0 +1,71 @@
+#ifndef ANDERSENLAKEOFFENGELD_H
+#define ANDERSENLAKEOFFENGELD_H
+
+#include "Instrument.h"
+#include <vector>
+
+// Andersen, Lake & Offengeld (2016) spectral collocation for American
+// options: the exercise boundary is solved as a fixed point of its integral
+// equation on Chebyshev nodes in sqrt(tau), and the price is the European
+// value plus a Gauss-Legendre integral of the early exercise premium.
+namespace AndersenLakeOffengeld {
+
+// Defaults reach about 1e-8 against a fully converged boundary while
+// 2r/sigma^2 stays below ~5 (T up to 3y), and 1e-7..1e-6 in the
+// low-volatility, high-rate corner; (8, 8, 4, 16) gives about 1e-5 at a
+// fraction of the cost.
+struct CollocationSettings {
+    int collocation_nodes = 20;     // Chebyshev nodes for the boundary (n)
+    int integration_nodes = 16;     // Gauss-Legendre nodes per boundary integral (l)
+    int iterations = 8;             // fixed-point sweeps (m)
+    int pricing_nodes = 48;         // Gauss-Legendre nodes for the premium integral (p)
+};
+
+// Exercise boundary of a unit-strike American put for (r, T, sigma). The
+// boundary scales with the strike, so one instance prices every put of a
+// chain, and since it does not depend on spot it is reused across scenarios.
+class ExerciseBoundary {
+public:
+    ExerciseBoundary(double r, double T, double sigma,
+                     const CollocationSettings& settings = CollocationSettings());
+
+    // B(tau) / K for 0 <= tau <= T; zero when early exercise is never optimal
+    double operator()(double tau) const;
+
+    // American price at spot S for strike K; calls carry no early exercise
+    // premium without dividends and come out at their Black-Scholes value
+    double price(double S, double K, OptionType type) const;
+
+    double getRate() const;
+    double getTimeToExpiry() const;
+    double getVolatility() const;
+
+private:
+    double rate_;
+    double expiry_;
+    double volatility_;
+    bool early_exercise_;
+    // Chebyshev coefficients of H(sqrt(tau)) = ln(B(tau) / K)^2
+    std::vector<double> coefficients_;
+    // Premium quadrature tabulated for this (r, T, sigma)
+    std::vector<double> pricing_log_boundary_;
+    std::vector<double> pricing_weight_;
+    std::vector<double> pricing_drift_;
+    std::vector<double> pricing_inv_vol_;
+};
+
+double americanOptionPrice(double S, double K, double r, double T, double sigma,
+                           OptionType type,
+                           const CollocationSettings& settings = CollocationSettings());
+
+// Prices a strike chain sharing (S, r, T, sigma) off a single boundary
+std::vector<double> americanOptionPrices(double S,
+                                         const std::vector<double>& strikes,
+                                         const std::vector<OptionType>& types,
+                                         double r, double T, double sigma,
+                                         const CollocationSettings& settings = CollocationSettings());
+
+void validateSettings(const CollocationSettings& settings);
+} // namespace AndersenLakeOffengeld
+
+#endif
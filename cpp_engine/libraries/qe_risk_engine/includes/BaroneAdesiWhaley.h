@@ -0,0 +1,40 @@
+#ifndef BARONEADESIWHALEY_H
+#define BARONEADESIWHALEY_H
+
+#include "Instrument.h"
+
+// Barone-Adesi & Whaley (1987) quadratic approximation for American options.
+// Accurate to a few cents, with no lattice or grid, which makes it the cheap
+// tier for revaluing American positions across VaR scenarios.
+namespace BaroneAdesiWhaley {
+
+// Critical price and premium coefficient solved once for (K, r, T, sigma);
+// repricing at a new spot is then a Black-Scholes price plus one power.
+class QuadraticApproximation {
+public:
+    QuadraticApproximation(double K, double r, double T, double sigma, OptionType type);
+
+    double price(double S) const;
+    double criticalPrice() const;
+
+private:
+    double strike_;
+    double rate_;
+    double expiry_;
+    double volatility_;
+    OptionType type_;
+    bool early_exercise_;
+    double critical_price_;
+    double exponent_;
+    double coefficient_;
+};
+
+double americanOptionPrice(double S, double K, double r, double T, double sigma,
+                           OptionType type);
+
+// Spot at which immediate exercise becomes optimal (S** for puts)
+double criticalPrice(double K, double r, double T, double sigma,
+                     OptionType type);
+} // namespace BaroneAdesiWhaley
+
+#endif
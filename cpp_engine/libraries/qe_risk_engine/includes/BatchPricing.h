@@ -0,0 +1,61 @@
+#ifndef BATCH_PRICING_H
+#define BATCH_PRICING_H
+
+#include "Instrument.h"
+#include "TraceRecorder.h"
+#include <cstddef>
+#include <cstdint>
+
+// Vectorised valuation of many independent options held as parallel arrays,
+// for callers (numpy, bulk endpoints) that would otherwise build one
+// Instrument per option. Every element is priced exactly as the equivalent
+// EuropeanOption/AmericanOption would price it.
+namespace BatchPricing {
+
+// Struct-of-arrays view of `size` options; every non-null pointer addresses
+// `size` elements, none of which are copied
+struct OptionArrays {
+    size_t size = 0;
+    const double* spot = nullptr;
+    const double* strike = nullptr;
+    const double* expiry = nullptr;
+    const double* rate = nullptr;
+    const double* volatility = nullptr;
+    const int32_t* type = nullptr;      // OptionType values: 0 call, 1 put
+    const int32_t* model = nullptr;     // PricingModel values; null means BlackScholes
+    const uint8_t* american = nullptr;  // non-zero for American style; null means all European
+    const double* dividend = nullptr;   // continuous dividend yield; null means none. Carried
+                                        // into MarketData as for a single instrument,
+                                        // whose pricers do not apply it
+};
+
+// Output columns, `size` elements each; null columns are skipped
+struct GreekArrays {
+    double* price = nullptr;
+    double* delta = nullptr;
+    double* gamma = nullptr;
+    double* vega = nullptr;
+    double* theta = nullptr;
+};
+
+// Defaults applied to MertonJumpDiffusion elements, as in the API
+const double kDefaultJumpIntensity = 2.0;
+const double kDefaultJumpMean = -0.05;
+const double kDefaultJumpVolatility = 0.15;
+
+// Both functions split the arrays across up to `threads` threads (0: one per
+// hardware thread). Binomial American and jump-diffusion European elements
+// sharing spot, rate, volatility, dividend and expiry (a chain's strike ladder) are
+// valued together with one lattice or Poisson series, with the same results
+// as pricing them one by one. An element that cannot be priced (bad inputs, a
+// model without that style) gets NaN in every output instead of failing the
+// batch; the return value is the number of such elements. With a `trace`,
+// each thread records its wait for a first block, every block and every chain.
+size_t price(const OptionArrays& options, double* prices, unsigned threads = 0,
+             TraceRecorder* trace = nullptr);
+size_t greeks(const OptionArrays& options, const GreekArrays& out, unsigned threads = 0,
+              TraceRecorder* trace = nullptr);
+
+} // namespace BatchPricing
+
+#endif
\ No newline at end of file
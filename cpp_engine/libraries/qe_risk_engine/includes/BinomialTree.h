@@ -11,6 +11,16 @@ double europeanOptionPrice(double S, double K, double r, double T, double sigma,
 double americanOptionPrice(double S, double K, double r, double T, double sigma,
                            OptionType type, int steps);
 
+// Prices a chain of American options sharing (S, r, T, sigma, steps) on one
+// lattice. Node values are stored node-major, with each node's strikes
+// contiguous, so the backward induction runs over contiguous strikes and
+// vectorizes; results match americanOptionPrice.
+std::vector<double> americanOptionPrices(double S,
+                                         const std::vector<double> &strikes,
+                                         const std::vector<OptionType> &types,
+                                         double r, double T, double sigma,
+                                         int steps);
+
 struct TreeNode {
   double stock_price;
   double option_value;
@@ -0,0 +1,68 @@
+#ifndef FINITEDIFFERENCE_H
+#define FINITEDIFFERENCE_H
+
+#include "Instrument.h"
+#include <vector>
+
+namespace FiniteDifference {
+
+struct GridSettings {
+    int space_steps = 200;      // log-spot intervals
+    int time_steps = 100;       // time intervals
+    double std_devs = 5.0;      // half-width of the grid in units of sigma * sqrt(T)
+    int rannacher_steps = 2;    // CN steps replaced by implicit half-steps
+};
+
+// Option values at t = 0 on the whole log-spot grid. Price, delta and gamma
+// at any spot are read off the grid without another solve, which also makes
+// the slice a spot -> price interpolant for scenario revaluation.
+class SolutionSlice {
+public:
+    SolutionSlice() = default;
+    SolutionSlice(double x_min, double dx, std::vector<double> values,
+                  double K, double r, double T, OptionType type, bool is_american);
+
+    double price(double spot) const;
+    double delta(double spot) const;
+    double gamma(double spot) const;
+
+    double minSpot() const;
+    double maxSpot() const;
+    bool contains(double spot) const;
+
+    const std::vector<double>& values() const;
+
+private:
+    double x_min_ = 0.0;
+    double dx_ = 0.0;
+    std::vector<double> values_;
+    double strike_ = 0.0;
+    double rate_ = 0.0;
+    double expiry_ = 0.0;
+    OptionType type_ = OptionType::Call;
+    bool is_american_ = false;
+
+    double boundaryValue(double spot) const;
+    // Quadratic fit through the three nodes nearest to x; returns V, V_x, V_xx
+    void localFit(double x, double& v, double& v_x, double& v_xx) const;
+};
+
+// Crank-Nicolson in x = ln(S) with Rannacher start-up and a Thomas solve per
+// step. Early exercise is enforced by Brennan-Schwartz projection inside the
+// tridiagonal substitution.
+SolutionSlice solve(double S, double K, double r, double T, double sigma,
+                    OptionType type, bool is_american,
+                    const GridSettings& settings = GridSettings());
+
+double europeanOptionPrice(double S, double K, double r, double T, double sigma,
+                           OptionType type,
+                           const GridSettings& settings = GridSettings());
+
+double americanOptionPrice(double S, double K, double r, double T, double sigma,
+                           OptionType type,
+                           const GridSettings& settings = GridSettings());
+
+void validateSettings(const GridSettings& settings);
+} // namespace FiniteDifference
+
+#endif
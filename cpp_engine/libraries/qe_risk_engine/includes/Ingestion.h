@@ -0,0 +1,71 @@
+#ifndef INGESTION_H
+#define INGESTION_H
+
+#include "Json.h"
+#include "MarketData.h"
+#include "Portfolio.h"
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Bulk loading of portfolios and market data from CSV or JSON-lines text.
+//
+// Portfolio rows use the fields of the API's portfolio items: type, strike,
+// expiry, asset_id, quantity, and optionally style, pricing_model,
+// binomial_steps, jump_lambda, jump_mean, jump_vol, fd_space_steps and
+// fd_time_steps (JSON rows may nest the last five as jump_parameters
+// {lambda, mean, vol} and fd_grid {space_steps, time_steps}). Market-data
+// rows have asset_id, spot, rate, vol and optionally dividend. CSV input
+// starts with a header row naming its columns in any order.
+namespace Ingestion {
+
+enum class Format { Csv, JsonLines };
+
+// A row that failed to parse or validate; it is left out of the result
+struct RowError {
+    size_t line;                // 1-based line in the input
+    std::string message;
+};
+
+struct PortfolioData {
+    Portfolio portfolio;
+    std::vector<RowError> errors;
+    size_t rows_read = 0;       // data rows seen, valid or not
+};
+
+struct MarketDataSet {
+    std::map<std::string, MarketData> market_data;
+    std::vector<RowError> errors;
+    size_t rows_read = 0;
+};
+
+// The input is split at line boundaries into chunks that are parsed and
+// validated on up to `threads` threads (0: one per hardware thread); rows
+// are then added in input order, so results do not depend on the split.
+// Quoted CSV fields therefore may not contain line breaks.
+PortfolioData parsePortfolio(const std::string& text, Format format, unsigned threads = 0);
+MarketDataSet parseMarketData(const std::string& text, Format format, unsigned threads = 0);
+
+// .csv is CSV; .jsonl and .ndjson are JSON lines
+Format formatFromPath(const std::string& path);
+
+PortfolioData loadPortfolio(const std::string& path, unsigned threads = 0);
+MarketDataSet loadMarketData(const std::string& path, unsigned threads = 0);
+
+struct Position {
+    std::unique_ptr<Instrument> instrument;
+    int quantity = 0;
+};
+
+// Single records already parsed from a request body, validated exactly as
+// JSON-lines rows are; both throw std::invalid_argument. The market-data
+// record takes its asset id from `asset_id` (an API map key) rather than
+// from a field.
+Position positionFromJson(const Json::Value& item);
+MarketData marketDataFromJson(const std::string& asset_id, const Json::Value& record);
+
+} // namespace Ingestion
+
+#endif
\ No newline at end of file
@@ -5,13 +5,38 @@
 #include <string>
 #include <stdexcept>
 #include <memory>
+#include <vector>
+#include <functional>
 
 enum class OptionType { Call, Put };
 
 enum class PricingModel { 
     BlackScholes, 
     Binomial, 
-    MertonJumpDiffusion 
+    MertonJumpDiffusion,
+    FiniteDifference,
+    AndersenLakeOffengeld,
+    BaroneAdesiWhaley
+};
+
+namespace FiniteDifference {
+class SolutionSlice;
+}
+
+namespace AndersenLakeOffengeld {
+class ExerciseBoundary;
+}
+
+namespace BaroneAdesiWhaley {
+class QuadraticApproximation;
+}
+
+struct InstrumentGreeks {
+    double price = 0.0;
+    double delta = 0.0;
+    double gamma = 0.0;
+    double vega = 0.0;
+    double theta = 0.0;
 };
 
 class Instrument {
@@ -25,8 +50,16 @@ public:
     virtual double theta(const MarketData& md) const = 0;
     virtual std::string getAssetId() const = 0;
     
+    // All five measures at once; models that produce them together (one
+    // series pass, one PDE solve) override this to avoid repeated work.
+    virtual InstrumentGreeks greeks(const MarketData& md) const;
+    
     virtual std::string getInstrumentType() const = 0;
     virtual bool isValid() const = 0;
+    
+    // Canonical description of every field that affects valuation; rows with
+    // equal keys are the same contract and can be netted.
+    virtual std::string getContractKey() const = 0;
 };
 
 class EuropeanOption : public Instrument {
@@ -51,9 +84,11 @@ public:
     double gamma(const MarketData& md) const override;
     double vega(const MarketData& md) const override;
     double theta(const MarketData& md) const override;
+    InstrumentGreeks greeks(const MarketData& md) const override;
     std::string getAssetId() const override;
     std::string getInstrumentType() const override;
     bool isValid() const override;
+    std::string getContractKey() const override;
     
     void setPricingModel(PricingModel model);
     PricingModel getPricingModel() const;
@@ -63,10 +98,33 @@ public:
     
     void setJumpParameters(double lambda, double jump_mean, double jump_vol);
     double getJumpIntensity() const;
+    double getJumpMean() const;
+    double getJumpVolatility() const;
+    
+    void setFiniteDifferenceGrid(int space_steps, int time_steps);
+    int getFiniteDifferenceSpaceSteps() const;
+    int getFiniteDifferenceTimeSteps() const;
+    
+    // Full t = 0 solution of the PDE; price, delta and gamma of this option
+    // at any nearby spot can be read from it without another solve.
+    FiniteDifference::SolutionSlice solveFiniteDifference(const MarketData& md) const;
     
     OptionType getOptionType() const;
     double getStrike() const;
     double getTimeToExpiry() const;
+    
+    // Batch valuation of MertonJumpDiffusion options sharing expiry and jump
+    // parameters on one underlying: one pass over the Poisson series prices
+    // the whole chain, with the same results as price()/delta()/... per option.
+    static std::vector<double> priceBatch(
+        const std::vector<const EuropeanOption*>& options,
+        const MarketData& md
+    );
+    
+    static std::vector<InstrumentGreeks> greeksBatch(
+        const std::vector<const EuropeanOption*>& options,
+        const MarketData& md
+    );
 
 private:
     OptionType option_type_;
@@ -79,6 +137,8 @@ private:
     double jump_intensity_;
     double jump_mean_;
     double jump_volatility_;
+    int fd_space_steps_;
+    int fd_time_steps_;
     
     void validateParameters() const;
     void validateMarketData(const MarketData& md) const;
@@ -86,6 +146,7 @@ private:
     double priceBlackScholes(const MarketData& md) const;
     double priceBinomial(const MarketData& md) const;
     double priceJumpDiffusion(const MarketData& md) const;
+    InstrumentGreeks greeksJumpDiffusion(const MarketData& md) const;
     
     double deltaBlackScholes(const MarketData& md) const;
     double deltaNumerical(const MarketData& md) const;
@@ -106,12 +167,49 @@ public:
     double gamma(const MarketData& md) const override;
     double vega(const MarketData& md) const override;
     double theta(const MarketData& md) const override;
+    InstrumentGreeks greeks(const MarketData& md) const override;
     std::string getAssetId() const override;
     std::string getInstrumentType() const override;
     bool isValid() const override;
+    std::string getContractKey() const override;
     
     void setBinomialSteps(int steps);
     int getBinomialSteps() const;
+    
+    // Binomial (default), FiniteDifference, AndersenLakeOffengeld or
+    // BaroneAdesiWhaley
+    void setPricingModel(PricingModel model);
+    PricingModel getPricingModel() const;
+    
+    void setFiniteDifferenceGrid(int space_steps, int time_steps);
+    int getFiniteDifferenceSpaceSteps() const;
+    int getFiniteDifferenceTimeSteps() const;
+    
+    FiniteDifference::SolutionSlice solveFiniteDifference(const MarketData& md) const;
+    
+    // Spot-independent parts of the collocation and BAW pricers; price at
+    // any spot with boundary.price(spot, K, type) or approximation.price(spot).
+    AndersenLakeOffengeld::ExerciseBoundary exerciseBoundary(const MarketData& md) const;
+    BaroneAdesiWhaley::QuadraticApproximation quadraticApproximation(const MarketData& md) const;
+    
+    OptionType getOptionType() const;
+    double getStrike() const;
+    double getTimeToExpiry() const;
+    
+    // Batch valuation of binomial-priced options sharing expiry and step
+    // count on one underlying. The lattice is built once per market state and the results
+    // are identical to calling price()/delta()/... on each option. Collocation-priced
+    // options sharing expiry batch the same way: one exercise boundary per
+    // rate, volatility and expiry serves every strike and spot bump.
+    static std::vector<double> priceBatch(
+        const std::vector<const AmericanOption*>& options,
+        const MarketData& md
+    );
+    
+    static std::vector<InstrumentGreeks> greeksBatch(
+        const std::vector<const AmericanOption*>& options,
+        const MarketData& md
+    );
 
 private:
     OptionType option_type_;
@@ -119,10 +217,29 @@ private:
     double time_to_expiry_years_;
     std::string underlying_asset_id_;
     int binomial_steps_;
+    PricingModel pricing_model_;
+    int fd_space_steps_;
+    int fd_time_steps_;
+    
+    static std::vector<double> priceLattice(
+        const std::vector<const AmericanOption*>& options,
+        const MarketData& md,
+        double time_to_expiry
+    );
+    
+    static std::vector<double> priceOnBoundary(
+        const std::vector<const AmericanOption*>& options,
+        const AndersenLakeOffengeld::ExerciseBoundary& boundary,
+        double spot
+    );
     
     void validateParameters() const;
     void validateMarketData(const MarketData& md) const;
     double calculateIntrinsicValue(double spot_price) const;
+    
+    // Price as a function of spot with everything else in md held fixed;
+    // the analytic models solve their spot-independent part once.
+    std::function<double(double)> spotPricer(const MarketData& md) const;
 };
 
 #endif
\ No newline at end of file
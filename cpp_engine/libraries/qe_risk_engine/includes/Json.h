@@ -0,0 +1,70 @@
+#ifndef JSON_H
+#define JSON_H
+
+#include <string>
+#include <utility>
+#include <vector>
+
+// Minimal JSON document model, parser and writer for the ingestion and
+// service layers. Objects keep their members in input order; lookups are linear,
+// which suits the small records these inputs are made of.
+namespace Json {
+
+class Value {
+public:
+    enum class Type { Null, Boolean, Number, String, Array, Object };
+
+    using Array = std::vector<Value>;
+    using Object = std::vector<std::pair<std::string, Value>>;
+
+    Value();
+    static Value boolean(bool value);
+    static Value number(double value, bool integer = false);
+    static Value string(std::string value);
+    static Value array(Array values = {});
+    static Value object(Object members = {});
+
+    Type type() const;
+    bool isNull() const;
+    bool isBoolean() const;
+    bool isNumber() const;
+    bool isString() const;
+    bool isArray() const;
+    bool isObject() const;
+
+    // Numbers written without a fraction or exponent
+    bool isInteger() const;
+
+    // Each throws std::invalid_argument if the value has another type
+    bool asBoolean() const;
+    double asNumber() const;
+    const std::string& asString() const;
+    const Array& asArray() const;
+    const Object& asObject() const;
+
+    // Member of an object, or nullptr if absent (or not an object)
+    const Value* find(const std::string& key) const;
+
+private:
+    Type type_;
+    bool boolean_;
+    bool integer_;
+    double number_;
+    std::string string_;
+    Array array_;
+    Object object_;
+};
+
+// Parses one JSON document, which must span the whole range apart from
+// surrounding whitespace. Throws std::invalid_argument naming the offset of
+// the first error.
+Value parse(const char* begin, const char* end);
+Value parse(const std::string& text);
+
+// Compact JSON text. Numbers use the shortest form that reads back exactly;
+// NaN and infinities, which JSON cannot express, are written as null.
+std::string write(const Value& value);
+
+} // namespace Json
+
+#endif
\ No newline at end of file
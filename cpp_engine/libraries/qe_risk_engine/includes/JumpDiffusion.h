@@ -2,6 +2,7 @@
 #define JUMPDIFFUSION_H
 
 #include "Instrument.h"
+#include <vector>
 
 namespace JumpDiffusion {
 double mertonOptionPrice(double S, double K, double r, double T, double sigma,
@@ -16,6 +17,31 @@ double mertonPutPrice(double S, double K, double r, double T, double sigma,
                       double lambda, double jump_mean, double jump_vol,
                       int max_jumps = 50);
 
+// Price, delta, gamma, vega (per unit of diffusion vol) and theta (per
+// calendar day, as BlackScholes) from a single pass over the Poisson series.
+// The series stops once the bound on its tail falls below 1e-12 * S, or
+// after max_jumps terms.
+InstrumentGreeks mertonOptionGreeks(double S, double K, double r, double T, double sigma,
+                                    OptionType type, double lambda, double jump_mean,
+                                    double jump_vol, int max_jumps = 50);
+
+// Strike chains sharing (S, r, T, sigma) and the jump parameters: the Poisson
+// weights, term volatilities and discount factors are computed once per term
+// for the whole chain.
+std::vector<double> mertonOptionPrices(double S,
+                                       const std::vector<double>& strikes,
+                                       const std::vector<OptionType>& types,
+                                       double r, double T, double sigma,
+                                       double lambda, double jump_mean, double jump_vol,
+                                       int max_jumps = 50);
+
+std::vector<InstrumentGreeks> mertonOptionGreeks(double S,
+                                                 const std::vector<double>& strikes,
+                                                 const std::vector<OptionType>& types,
+                                                 double r, double T, double sigma,
+                                                 double lambda, double jump_mean, double jump_vol,
+                                                 int max_jumps = 50);
+
 double poissonProbability(int n, double lambda_t);
 } // namespace JumpDiffusion
 
@@ -4,7 +4,12 @@
 #include <string>
 #include <stdexcept>
 #include <cmath>
+#include <cstdint>
+#include <deque>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 struct MarketData {
     std::string asset_id;
@@ -75,8 +80,68 @@ struct MarketData {
     }
 };
 
+// Immutable view of every asset at one version. Assets are hashed into
+// shards so that a writer copies only the shard it touches; unchanged shards
+// are shared between consecutive snapshots. Removed assets stay behind as
+// tombstones so getChangedAssets() still reports them, until no live snapshot
+// predates the removal.
+class MarketDataSnapshot {
+public:
+    struct Entry {
+        MarketData market_data;
+        uint64_t version = 0;
+        bool present = false;
+    };
+
+    struct Shard {
+        std::map<std::string, Entry> entries;
+        uint64_t max_version = 0;
+        uint64_t oldest_tombstone = 0;      // 0 when the shard has none
+    };
+
+    static const size_t kShardCount = 64;
+
+    MarketDataSnapshot();
+
+    MarketData getMarketData(const std::string& asset_id) const;
+    bool hasMarketData(const std::string& asset_id) const;
+    size_t size() const;
+    std::map<std::string, MarketData> getAllMarketData() const;
+
+    uint64_t getVersion() const;
+    uint64_t getAssetVersion(const std::string& asset_id) const;
+    std::vector<std::string> getChangedAssets(uint64_t since_version) const;
+
+private:
+    friend class MarketDataManager;
+
+    uint64_t version_;
+    size_t size_;
+    std::vector<std::shared_ptr<const Shard>> shards_;
+
+    static size_t shardIndex(const std::string& asset_id);
+    const Entry* findEntry(const std::string& asset_id) const;
+    void writeEntry(const std::string& asset_id, const MarketData* md);
+    void removeAll();
+    void purgeTombstones(uint64_t horizon);
+};
+
+// Safe for one or more writer threads alongside any number of readers.
+// Writers serialize on a mutex, build the next snapshot off to the side and
+// publish it with an atomic pointer swap. Readers only copy the pointer,
+// under the short lock libstdc++ uses for shared_ptr atomics, so they never
+// wait for a snapshot build. Each read method pins the current snapshot;
+// callers that need several reads to agree (a risk run, say) should hold
+// snapshot() for the duration instead.
+//
+// Copies share the source's current snapshot and version history, then
+// diverge; copying takes the writer lock of the destination only.
 class MarketDataManager {
 public:
+    MarketDataManager();
+    MarketDataManager(const MarketDataManager& other);
+    MarketDataManager& operator=(const MarketDataManager& other);
+
     void addMarketData(const std::string& asset_id, const MarketData& md);
     void updateMarketData(const std::string& asset_id, const MarketData& md);
     MarketData getMarketData(const std::string& asset_id) const;
@@ -86,8 +151,32 @@ public:
     size_t size() const;
     std::map<std::string, MarketData> getAllMarketData() const;
     
+    // Every add, update or removal stamps the asset with the next version, so
+    // callers holding an older version can ask which assets moved since. An
+    // update with values identical to the current ones is a no-op. Removals
+    // are only remembered while a snapshot older than them is alive, so a
+    // caller diffing from a version should hold that version's snapshot.
+    uint64_t getVersion() const;
+    uint64_t getAssetVersion(const std::string& asset_id) const;
+    std::vector<std::string> getChangedAssets(uint64_t since_version) const;
+
+    std::shared_ptr<const MarketDataSnapshot> snapshot() const;
+    
 private:
-    std::map<std::string, MarketData> market_data_map_;
+    std::shared_ptr<const MarketDataSnapshot> snapshot_;
+    std::mutex write_mutex_;
+
+    // Snapshots published so far, oldest first, for finding the oldest one
+    // still held by a reader. Expired entries are compacted away once the
+    // list has doubled since the last pass.
+    std::deque<std::weak_ptr<const MarketDataSnapshot>> published_;
+    size_t compact_at_;
+
+    // Copies the current snapshot's shard list; the caller replaces the
+    // shards it modifies and publishes the result.
+    std::shared_ptr<MarketDataSnapshot> beginWrite() const;
+    void publish(std::shared_ptr<MarketDataSnapshot> next);
+    uint64_t oldestLiveVersion();
 };
 
 #endif
\ No newline at end of file
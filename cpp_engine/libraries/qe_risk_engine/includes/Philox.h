@@ -0,0 +1,42 @@
+#ifndef PHILOX_H
+#define PHILOX_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Philox4x32-10 counter-based generator (Salmon et al., "Parallel random
+// numbers: as easy as 1, 2, 3", SC 2011). Each draw is a pure function of a
+// 64-bit key and a 128-bit counter, so any draw of a simulation can be
+// computed on its own, in any order, on any machine.
+namespace Philox {
+
+using Counter = std::array<uint32_t, 4>;
+using Key = std::array<uint32_t, 2>;
+
+// Ten rounds of the Philox4x32 bijection
+Counter block(Counter counter, Key key);
+
+// Draw addressed by (seed, path, asset, factor): `factor` separates the
+// independent draws one path needs for the same asset. uniform() lies in
+// (0, 1) with 53 random bits; normal() is its standard normal quantile.
+double uniform(uint64_t seed, uint64_t path, uint32_t asset, uint32_t factor);
+double normal(uint64_t seed, uint64_t path, uint32_t asset, uint32_t factor);
+
+// Bulk forms of uniform() and normal() for a block of paths: out[i] is the
+// draw of path paths[i] and gives the same value bit for bit. The Philox
+// rounds and the central branch of the quantile run as loops over the block
+// that the compiler vectorizes; only the tail quantiles are computed one by
+// one.
+void fillUniforms(uint64_t seed, const uint64_t* paths, size_t count, uint32_t asset, uint32_t factor,
+                  double* out);
+void fillNormals(uint64_t seed, const uint64_t* paths, size_t count, uint32_t asset, uint32_t factor,
+                 double* out);
+
+// Standard normal quantile for p in (0, 1), as accurate as p itself allows
+// (Wichura's AS 241)
+double inverseNormal(double p);
+
+} // namespace Philox
+
+#endif
\ No newline at end of file
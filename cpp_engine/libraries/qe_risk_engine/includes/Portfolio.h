@@ -6,10 +6,31 @@
 #include <memory>
 #include <stdexcept>
 #include <string>
+#include <cstdint>
+#include <map>
+#include <unordered_map>
+
+// Rows holding the same contract (equal Instrument::getContractKey()),
+// netted into one position
+struct NettedPosition {
+    size_t instrument_index;        // a row with this contract (the first, barring removePosition)
+    long long quantity;             // sum of the rows' quantities
+    std::vector<size_t> rows;
+};
+
+// Stable identifier for a row: unlike its index, it survives the removal of
+// other rows
+using PositionHandle = uint64_t;
+
+class Portfolio;
+
+namespace PortfolioFile {
+void load(const std::string& path, Portfolio& portfolio);
+}
 
 class Portfolio {
 public:
-    void addInstrument(std::unique_ptr<Instrument> instrument, int quantity);
+    PositionHandle addInstrument(std::unique_ptr<Instrument> instrument, int quantity);
     
     const std::vector<std::pair<std::unique_ptr<Instrument>, int>>& getInstruments() const;
     
@@ -18,16 +39,79 @@ public:
     void clear();
     void reserve(size_t capacity);
     
+    // Net quantity and rows per underlying are kept up to date by every edit,
+    // so these are hash lookups rather than scans of the book
     int getTotalQuantityForAsset(const std::string& asset_id) const;
+    const std::vector<size_t>& getRowsForAsset(const std::string& asset_id) const;
+    // Net quantities are summed in 64 bits, so one heavily netted asset
+    // cannot overflow the whole map the way getTotalQuantityForAsset can
+    std::map<std::string, long long> getNetPositions() const;
     
+    // Preserves the order of the remaining rows, which costs O(n)
     void removeInstrument(size_t index);
     
+    // O(1): the last row moves into the gap, so indices are not preserved
+    void removePosition(PositionHandle handle);
+    
+    PositionHandle getHandle(size_t index) const;
+    size_t getIndex(PositionHandle handle) const;
+    
     void updateQuantity(size_t index, int new_quantity);
     
+    // One entry per distinct contract, kept in step with the rows above, which
+    // remain the reporting view. Instruments must not be modified after they
+    // are added, or their netting goes stale.
+    const std::vector<NettedPosition>& getNettedPositions() const;
+    
+    // Bumped by every change to the rows or quantities
+    uint64_t getVersion() const;
+    
+    // Compact binary snapshot of the rows (see PortfolioFile.h). loadBinary
+    // replaces the contents and leaves the portfolio unchanged on failure.
+    void saveBinary(const std::string& path) const;
+    void loadBinary(const std::string& path);
+    
 private:
+    friend void PortfolioFile::load(const std::string& path, Portfolio& portfolio);
+    
+    struct AssetPositions {
+        long long net_quantity = 0;
+        std::vector<size_t> rows;
+    };
+    
+    // Back-references from a row into the indexes, so it can be unlinked in O(1)
+    struct RowLinks {
+        PositionHandle handle;
+        size_t asset_slot;          // position in the asset's rows
+        size_t netted_index;
+        size_t netted_slot;         // position in that netted position's rows
+    };
+    
     std::vector<std::pair<std::unique_ptr<Instrument>, int>> instruments;
+    std::vector<RowLinks> row_links;
+    uint64_t version = 0;
+    std::vector<NettedPosition> netted_positions;
+    std::unordered_map<std::string, size_t> contract_index;
+    std::unordered_map<std::string, AssetPositions> asset_index;
+    // Row of every live handle; removed handles are erased, so the map stays
+    // the size of the book however many positions have come and gone
+    std::unordered_map<PositionHandle, size_t> handle_rows;
+    PositionHandle next_handle = 0;
     
     void validateIndex(size_t index) const;
+    void indexRow(size_t row, std::string key);
+    void unlinkRow(size_t row);
+    void moveRow(size_t from, size_t to);
+    void rebuildIndexes();
+    
+    // Bulk addInstrument for an empty portfolio. Each row names its
+    // underlying by index into `asset_ids` and its contract by a number below
+    // `contracts`; rows sharing a number must hold the same contract. Each
+    // index is then built once per asset and contract instead of per row.
+    void adoptRows(std::vector<std::pair<std::unique_ptr<Instrument>, int>> rows,
+                   const std::vector<std::string>& asset_ids,
+                   const std::vector<uint32_t>& row_assets,
+                   const std::vector<uint32_t>& row_contracts, size_t contracts);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,32 @@
+#ifndef PORTFOLIOFILE_H
+#define PORTFOLIOFILE_H
+
+#include "Portfolio.h"
+#include <cstdint>
+#include <string>
+
+// Binary portfolio format, little-endian, every section 8-byte aligned:
+//
+//   header   magic "QEPF", format version, row and asset counts, the offset
+//            of each section, the file size and a checksum of every byte
+//            after the header
+//   assets   asset_count + 1 uint64 offsets into the packed asset ids that
+//            follow; each id is stored once and rows refer to it by index
+//   columns  one fixed-width array of row_count values per field (strike,
+//            expiry, jump parameters, quantity, asset index, lattice and
+//            grid sizes, style, option type, pricing model)
+namespace PortfolioFile {
+
+const uint32_t kFormatVersion = 1;
+
+void save(const Portfolio& portfolio, const std::string& path);
+
+// Fills an empty portfolio. The file is memory-mapped where the platform
+// allows it (read whole otherwise) and rows are built straight from the
+// mapped columns. Rows are grouped by contract from the columns, so the
+// netting and asset indexes are built once per contract and asset.
+void load(const std::string& path, Portfolio& portfolio);
+
+} // namespace PortfolioFile
+
+#endif
\ No newline at end of file
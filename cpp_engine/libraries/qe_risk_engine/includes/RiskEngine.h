@@ -3,11 +3,54 @@
 
 #include "Portfolio.h"
 #include "MarketData.h"
+#include "TraceRecorder.h"
+#include <atomic>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <vector>
 #include <string>
 #include <stdexcept>
 
+// Wall and CPU seconds spent in one phase of a calculation
+struct RiskPhaseTiming {
+    std::string phase;
+    double wall_seconds = 0.0;
+    double cpu_seconds = 0.0;
+    long long allocations = 0;
+    long long allocated_bytes = 0;
+};
+
+// Greeks time of one netted position; positions priced together (shared
+// lattice or series) split their group's time evenly
+struct PositionTiming {
+    size_t position = 0;        // row in the portfolio
+    std::string asset_id;
+    std::string pricing_model;
+    double seconds = 0.0;
+};
+
+// Where the time of one calculation went. Only filled when the config asks
+// for diagnostics; otherwise `enabled` is false and everything is empty.
+struct RiskDiagnostics {
+    bool enabled = false;
+    // validation, pricing_plan, greeks, scenario_setup, scenario_generation,
+    // revaluation and tail_metrics, in that order
+    std::vector<RiskPhaseTiming> phases;
+    // Position revaluations across all VaR scenarios, by pricing model
+    std::map<std::string, long long> revaluations;
+    // Most expensive positions in the greeks phase, slowest first
+    std::vector<PositionTiming> slowest_positions;
+    // Heap allocations made by the calculating thread, in total and per
+    // phase. Only counted when the executable links the qe_allocation_hook
+    // object library; `allocations_counted` says whether it did.
+    bool allocations_counted = false;
+    long long allocations = 0;
+    long long allocated_bytes = 0;
+    
+    static constexpr size_t kSlowestPositions = 10;
+};
+
 struct PortfolioRiskResult {
     double total_pv = 0.0;
     double total_delta = 0.0;
@@ -18,6 +61,7 @@ struct PortfolioRiskResult {
     double value_at_risk_99 = 0.0;
     double expected_shortfall_95 = 0.0;
     double expected_shortfall_99 = 0.0;
+    RiskDiagnostics diagnostics;
     
     void reset() {
         total_pv = 0.0;
@@ -29,6 +73,7 @@ struct PortfolioRiskResult {
         value_at_risk_99 = 0.0;
         expected_shortfall_95 = 0.0;
         expected_shortfall_99 = 0.0;
+        diagnostics = RiskDiagnostics();
     }
     
     bool isValid() const {
@@ -45,6 +90,22 @@ struct PortfolioRiskResult {
     }
 };
 
+// Source of the VaR scenario shocks. MersenneTwister, the default, draws
+// them in sequence, so each path depends on every path before it. Philox
+// computes each shock from (seed, path, asset), so any path can be
+// regenerated on its own.
+enum class RandomGenerator {
+    MersenneTwister,
+    Philox
+};
+
+// One VaR scenario regenerated from its path index
+struct RiskScenario {
+    long long path = 0;
+    std::vector<std::pair<std::string, double>> spots;  // per asset, in asset id order
+    double pnl = 0.0;
+};
+
 struct RiskMetrics {
     double var_95 = 0.0;
     double var_99 = 0.0;
@@ -52,15 +113,202 @@ struct RiskMetrics {
     double es_99 = 0.0;
 };
 
+// Partial result of a sharded VaR run: the P&L of paths [first_path,
+// last_path) of a `total_paths` run, reduced to its moments and its
+// smallest values. Contiguous shards of one run merge into a larger shard,
+// and a shard covering every path gives exactly the VaR and ES that one
+// process would have computed.
+struct VaRShard {
+    long long total_paths = 0;
+    long long first_path = 0;
+    long long last_path = 0;
+    double sum = 0.0;
+    double sum_squares = 0.0;
+    std::vector<double> tail;   // ascending, at most tailSize(total_paths)
+    
+    // Smallest P&L values an exact 95% (and so 99%) VaR and ES need
+    static size_t tailSize(long long total_paths);
+    // The shard of the P&L values `pnl` (in any order)
+    static VaRShard of(long long total_paths, long long first_path, std::vector<double> pnl);
+    // Merges shards of one run whose ranges tile a contiguous range, in any
+    // order; throws std::invalid_argument on gaps, overlaps or mixed runs
+    static VaRShard merge(std::vector<VaRShard> shards);
+    // VaR and ES of `simulations` values whose smallest are `ascending`
+    static RiskMetrics tailMetrics(const std::vector<double>& ascending, long long simulations);
+    
+    long long size() const;
+    bool isComplete() const;
+    double mean() const;
+    double standardDeviation() const;
+    // Exact metrics of the whole run; throws std::invalid_argument unless
+    // the shard is complete
+    RiskMetrics metrics() const;
+    
+    // Compact little-endian binary form for moving shards between
+    // processes; deserialize throws std::invalid_argument on malformed input
+    std::string serialize() const;
+    static VaRShard deserialize(const std::string& bytes);
+};
+
+// Thrown out of calculatePortfolioRisk when its RiskRunControl is cancelled
+class RiskCalculationCancelled : public std::runtime_error {
+public:
+    RiskCalculationCancelled() : std::runtime_error("Risk calculation cancelled") {}
+};
+
+// Shared between one running calculation and whoever started it: progress
+// and partial results flow out, cancellation flows in. Every method is
+// thread-safe. The engine checks for cancellation between blocks of VaR
+// paths, so a cancelled run stops within one block.
+class RiskRunControl {
+public:
+    void cancel();
+    bool isCancelled() const;
+    
+    int getCompletedSimulations() const;
+    int getTotalSimulations() const;
+    // Fraction of VaR paths simulated, 0 until greeks are done
+    double getProgress() const;
+    
+    bool hasGreeks() const;
+    bool hasPartialVaR() const;
+    // Greeks once they are known, and VaR/ES estimated from the paths
+    // simulated so far (refreshed every tenth of the run)
+    PortfolioRiskResult getPartialResult() const;
+
+private:
+    friend class RiskEngine;
+    
+    void start(int total_simulations);
+    void publishGreeks(const PortfolioRiskResult& result);
+    void publishMetrics(const RiskMetrics& metrics);
+    void throwIfCancelled() const;
+    
+    std::atomic<bool> cancelled_{false};
+    std::atomic<int> completed_{0};
+    std::atomic<int> total_{0};
+    
+    mutable std::mutex mutex_;
+    PortfolioRiskResult partial_;
+    bool has_greeks_ = false;
+    bool has_partial_var_ = false;
+};
+
+// Run parameters of a risk calculation. Immutable: the with* methods return
+// a validated copy, so one config can be shared by any number of threads.
+class RiskConfig {
+public:
+    RiskConfig();
+    
+    RiskConfig withVaRSimulations(int simulations) const;
+    RiskConfig withVaRTimeHorizonDays(double days) const;
+    // A fixed seed makes VaR reproducible; without one every run is seeded
+    // from std::random_device
+    RiskConfig withRandomSeed(unsigned int seed) const;
+    RiskConfig withoutFixedSeed() const;
+    RiskConfig withFastAmericanRevaluation(bool enabled) const;
+    RiskConfig withJumpDiffusionScenarios(bool enabled) const;
+    // Fills PortfolioRiskResult::diagnostics; off by default, and costs
+    // nothing beyond a branch per phase when off
+    RiskConfig withDiagnostics(bool enabled) const;
+    RiskConfig withRandomGenerator(RandomGenerator generator) const;
+    // Records the run's phases, VaR path blocks and greeks batches as spans
+    // on the calling thread; null (the default) records nothing. Results do
+    // not depend on it, so a cached result is returned without a trace.
+    RiskConfig withTrace(std::shared_ptr<TraceRecorder> trace) const;
+    
+    int getVaRSimulations() const;
+    double getVaRTimeHorizonDays() const;
+    unsigned int getRandomSeed() const;
+    bool getUseFixedSeed() const;
+    bool getFastAmericanRevaluation() const;
+    bool getJumpDiffusionScenarios() const;
+    bool getDiagnostics() const;
+    RandomGenerator getRandomGenerator() const;
+    TraceRecorder* getTrace() const;
+
+private:
+    int var_simulations_;
+    double time_horizon_days_;
+    unsigned int random_seed_;
+    bool use_fixed_seed_;
+    bool fast_american_revaluation_;
+    bool jump_diffusion_scenarios_;
+    bool diagnostics_;
+    RandomGenerator random_generator_;
+    std::shared_ptr<TraceRecorder> trace_;
+};
+
+// calculatePortfolioRisk is const and keeps no state between calls, so one
+// engine can serve concurrent callers. The setters below only change the
+// default config used when none is passed; they must not race with
+// calculations on the same engine.
 class RiskEngine {
 public:
     RiskEngine();
     explicit RiskEngine(int var_simulations);
+    explicit RiskEngine(const RiskConfig& config);
     
     PortfolioRiskResult calculatePortfolioRisk(
         const Portfolio& portfolio, 
         const std::map<std::string, MarketData>& market_data_map
-    );
+    ) const;
+    
+    PortfolioRiskResult calculatePortfolioRisk(
+        const Portfolio& portfolio, 
+        const std::map<std::string, MarketData>& market_data_map,
+        const RiskConfig& config
+    ) const;
+    
+    // As above, reporting into and honouring `control`; throws
+    // RiskCalculationCancelled once it is cancelled
+    PortfolioRiskResult calculatePortfolioRisk(
+        const Portfolio& portfolio, 
+        const std::map<std::string, MarketData>& market_data_map,
+        const RiskConfig& config,
+        RiskRunControl& control
+    ) const;
+    
+    // Regenerates the VaR scenarios at the given path indices exactly as a
+    // run with `config` simulates them, for drilling into single paths.
+    // Needs the Philox generator and a fixed seed; throws
+    // std::invalid_argument otherwise.
+    std::vector<RiskScenario> replayScenarios(
+        const Portfolio& portfolio,
+        const std::map<std::string, MarketData>& market_data_map,
+        const RiskConfig& config,
+        const std::vector<long long>& paths
+    ) const;
+    
+    // The `count` scenarios of the run with the largest losses, worst
+    // first; same requirements as replayScenarios
+    std::vector<RiskScenario> worstScenarios(
+        const Portfolio& portfolio,
+        const std::map<std::string, MarketData>& market_data_map,
+        const RiskConfig& config,
+        size_t count
+    ) const;
+    
+    // Largest `total_paths` of a sharded run; a single run stays within the
+    // 1,000,000 paths RiskConfig allows, since it holds every path's P&L
+    static constexpr long long kMaxShardedSimulations = 100000000;
+    
+    // Simulates paths [first_path, last_path) of a `total_paths` run with
+    // the rest of `config` (its path count is ignored, and greeks are not
+    // computed), for VaR split across processes or machines. Needs the
+    // Philox generator and a fixed seed so that every shard draws the paths
+    // the single run would.
+    VaRShard calculateVaRShard(
+        const Portfolio& portfolio,
+        const std::map<std::string, MarketData>& market_data_map,
+        const RiskConfig& config,
+        long long total_paths,
+        long long first_path,
+        long long last_path
+    ) const;
+    
+    const RiskConfig& getConfig() const;
+    void setConfig(const RiskConfig& config);
     
     void setVaRSimulations(int simulations);
     int getVaRSimulations() const;
@@ -70,28 +318,106 @@ public:
     
     void setRandomSeed(unsigned int seed);
     void setUseFixedSeed(bool use_fixed);
+    
+    // Fast tier: VaR scenarios revalue every American option with the
+    // Barone-Adesi-Whaley approximation instead of its own model. Greeks and
+    // PV still use the position's model.
+    void setFastAmericanRevaluation(bool enabled);
+    bool getFastAmericanRevaluation() const;
+    
+    // Adds compound-Poisson jumps to the VaR scenarios of every asset that
+    // carries MertonJumpDiffusion options, using their (lambda, jump mean,
+    // jump vol); options on one asset must then agree on those parameters.
+    void setJumpDiffusionScenarios(bool enabled);
+    bool getJumpDiffusionScenarios() const;
 
 private:
-    int var_simulations_;
-    double time_horizon_days_;
-    unsigned int random_seed_;
-    bool use_fixed_seed_;
+    RiskConfig config_;
+    
+    // American options with the same underlying, expiry and step count share
+    // one lattice per market state (see AmericanOption::priceBatch).
+    struct AmericanOptionGroup {
+        std::string asset_id;
+        std::vector<const AmericanOption*> options;
+        std::vector<double> quantities;
+        std::vector<size_t> positions;
+    };
+    
+    // Jump-diffusion Europeans with the same underlying, expiry and jump
+    // parameters share one pass over the Merton series (any group size).
+    struct JumpDiffusionGroup {
+        std::string asset_id;
+        std::vector<const EuropeanOption*> options;
+        std::vector<double> quantities;
+        std::vector<size_t> positions;
+    };
+    
+    // Positions are indices into the portfolio rows; only the first row of
+    // each netted contract appears, carrying the netted quantity.
+    struct PricingPlan {
+        std::vector<double> quantities;
+        std::vector<size_t> single_positions;
+        std::vector<AmericanOptionGroup> american_groups;
+        std::vector<JumpDiffusionGroup> jump_diffusion_groups;
+        // Finite-difference positions: one PDE solve per market state gives
+        // price, delta and gamma, and scenario spots are read off the slice.
+        std::vector<size_t> grid_positions;
+        // Collocation-priced Americans: the exercise boundary depends only on
+        // (r, T, sigma), so one boundary per asset and expiry serves every
+        // strike and every VaR scenario. The Greeks phase batches them by
+        // asset and expiry too, with one boundary per bumped market state.
+        std::vector<size_t> collocation_positions;
+        // Americans revalued with BAW in VaR scenarios (fast tier only)
+        std::vector<size_t> approximated_positions;
+    };
+    
+    struct ScenarioCapture;
+    
+    // Jump process of one simulated asset over the VaR horizon
+    struct AssetJumps {
+        size_t asset = 0;
+        double intensity = 0.0;
+        double mean = 0.0;
+        double volatility = 0.0;
+        double compensator = 0.0;       // lambda k dt, removed from the drift
+        std::vector<double> cdf;        // Poisson(lambda dt) CDF for inversion
+    };
+    
+    std::vector<AssetJumps> collectAssetJumps(
+        const Portfolio& portfolio,
+        const std::map<std::string, size_t>& asset_index,
+        double dt
+    ) const;
+    
+    PricingPlan buildPricingPlan(const Portfolio& portfolio,
+                                 bool approximate_americans = false) const;
     
     RiskMetrics calculateRiskMetrics(
         const Portfolio& portfolio, 
-        const std::map<std::string, MarketData>& market_data_map
-    );
+        const std::map<std::string, MarketData>& market_data_map,
+        const PricingPlan& plan,
+        const RiskConfig& config,
+        RiskRunControl* control,
+        RiskDiagnostics* diagnostics,
+        TraceRecorder* trace,
+        ScenarioCapture* capture = nullptr
+    ) const;
+    
+    PortfolioRiskResult calculatePortfolioRisk(
+        const Portfolio& portfolio, 
+        const std::map<std::string, MarketData>& market_data_map,
+        const RiskConfig& config,
+        RiskRunControl* control
+    ) const;
     
     void validateMarketData(
         const Portfolio& portfolio,
         const std::map<std::string, MarketData>& market_data_map
     ) const;
     
-    void validateParameters() const;
-    
     double calculateSingleInstrumentMetric(
         const std::unique_ptr<Instrument>& instrument,
-        int quantity,
+        double quantity,
         const MarketData& md,
         const std::string& metric_name
     ) const;
@@ -0,0 +1,117 @@
+#ifndef RISK_RESULT_CACHE_H
+#define RISK_RESULT_CACHE_H
+
+#include "MarketData.h"
+#include "Portfolio.h"
+#include "RiskEngine.h"
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// Stable 64-bit FNV-1a digests of risk inputs. Doubles are hashed by their
+// bit patterns and strings with their lengths, so a digest depends only on
+// the values: it is the same across runs, processes and machines.
+namespace ContentHash {
+
+// Non-zero netted contracts in contract key order, each as its key and net
+// quantity, so row order and splitting do not change the digest
+uint64_t hashPortfolio(const Portfolio& portfolio);
+uint64_t hashMarketData(const std::map<std::string, MarketData>& market_data_map);
+uint64_t hashConfig(const RiskConfig& config);
+
+} // namespace ContentHash
+
+// Everything a PortfolioRiskResult depends on
+struct RiskCacheKey {
+    uint64_t portfolio = 0;
+    uint64_t market_data = 0;
+    uint64_t config = 0;
+    
+    static RiskCacheKey of(
+        const Portfolio& portfolio,
+        const std::map<std::string, MarketData>& market_data_map,
+        const RiskConfig& config
+    );
+    
+    bool operator==(const RiskCacheKey& other) const {
+        return portfolio == other.portfolio && market_data == other.market_data &&
+               config == other.config;
+    }
+    
+    // 48 hex digits, for logs and API responses
+    std::string toString() const;
+};
+
+// Thread-safe LRU cache of risk results. Only fixed-seed configs are cached,
+// since any other run is meant to draw fresh scenarios. The least recently
+// used entries are evicted once the entries' footprint passes the budget.
+//
+// calculate() is also single-flight: a call whose key matches a run already
+// in progress waits for that run and shares its result (or its exception)
+// instead of starting another, seeded or not. Runs with diagnostics on
+// always compute, since their timings describe that run alone.
+class RiskResultCache {
+public:
+    enum class Source { Computed, Cached, Coalesced };
+    
+    explicit RiskResultCache(size_t budget_bytes = 8 * 1024 * 1024);
+    
+    static bool isCacheable(const RiskConfig& config);
+    
+    bool lookup(const RiskCacheKey& key, PortfolioRiskResult& result);
+    void insert(const RiskCacheKey& key, const PortfolioRiskResult& result);
+    
+    // Cached result if there is one, else the result of the identical run in
+    // flight, else runs the engine (and caches the result if cacheable)
+    PortfolioRiskResult calculate(
+        const RiskEngine& engine,
+        const Portfolio& portfolio,
+        const std::map<std::string, MarketData>& market_data_map,
+        const RiskConfig& config,
+        Source* source = nullptr
+    );
+    
+    void clear();
+    
+    size_t getHits() const;
+    size_t getMisses() const;
+    size_t getEvictions() const;
+    // Calls that joined a run already in flight
+    size_t getCoalesced() const;
+    size_t getInFlight() const;
+    size_t size() const;
+    size_t getBytes() const;
+    size_t getBudgetBytes() const;
+    
+    // Footprint charged per entry: key, result, list and hash nodes
+    static const size_t kEntryBytes;
+
+private:
+    struct KeyHash {
+        size_t operator()(const RiskCacheKey& key) const {
+            return static_cast<size_t>(key.portfolio ^ (key.market_data * 31) ^ (key.config * 131));
+        }
+    };
+    
+    using Entry = std::pair<RiskCacheKey, PortfolioRiskResult>;
+    
+    // Finds and refreshes an entry, counting a hit; the caller holds mutex_
+    bool findLocked(const RiskCacheKey& key, PortfolioRiskResult& result);
+    
+    mutable std::mutex mutex_;
+    size_t budget_bytes_;
+    std::list<Entry> entries_;      // most recently used first
+    std::unordered_map<RiskCacheKey, std::list<Entry>::iterator, KeyHash> index_;
+    std::unordered_map<RiskCacheKey, std::shared_future<PortfolioRiskResult>, KeyHash> in_flight_;
+    size_t hits_;
+    size_t misses_;
+    size_t evictions_;
+    size_t coalesced_;
+};
+
+#endif
\ No newline at end of file
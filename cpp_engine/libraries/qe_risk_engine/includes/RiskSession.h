@@ -0,0 +1,74 @@
+#ifndef RISKSESSION_H
+#define RISKSESSION_H
+
+#include "MarketData.h"
+#include "Portfolio.h"
+#include "RiskEngine.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Keeps the Greeks of a book current as market data ticks and positions are
+// edited. Each row's Greeks per unit of quantity are cached by handle, next to
+// per-asset subtotals. refresh() reprices the rows on assets whose
+// MarketDataManager version moved and the rows added since the last refresh;
+// a quantity update rescales the cached Greeks and a removal drops them, and
+// only the touched assets are re-summed. A portfolio replaced wholesale
+// (clear(), loadBinary()) is evaluated in full. VaR is not maintained here;
+// run RiskEngine for it.
+class RiskSession {
+public:
+    // Both are referenced, not copied, and must outlive the session
+    RiskSession(const Portfolio& portfolio, const MarketDataManager& market_data);
+
+    const PortfolioRiskResult& refresh();
+    const PortfolioRiskResult& getResult() const;
+
+    // Greeks of the positions on one underlying (zero if there are none)
+    PortfolioRiskResult getAssetSubtotal(const std::string& asset_id) const;
+
+    // Positions whose contribution the last refresh() recomputed: repriced
+    // or added, rescaled, or removed
+    size_t getLastRepricedPositions() const;
+
+private:
+    struct CachedRow {
+        const Instrument* instrument;
+        size_t asset;               // index into assets_
+        double quantity;
+        InstrumentGreeks unit;      // Greeks of one unit
+        uint64_t seen;              // last refresh pass that found the row
+    };
+
+    struct AssetBook {
+        std::string asset_id;
+        std::vector<PositionHandle> rows;
+        PortfolioRiskResult subtotal;
+    };
+
+    const Portfolio& portfolio_;
+    const MarketDataManager& market_data_;
+    bool initialized_;
+    uint64_t portfolio_version_;
+    uint64_t market_version_;
+    // Held so the manager keeps tombstones of assets removed since
+    std::shared_ptr<const MarketDataSnapshot> priced_snapshot_;
+    uint64_t pass_;
+    std::unordered_map<PositionHandle, CachedRow> rows_;
+    std::vector<AssetBook> assets_;
+    std::unordered_map<std::string, size_t> asset_index_;
+    PortfolioRiskResult result_;
+    size_t last_repriced_;
+
+    void rebuild(const MarketDataSnapshot& snapshot);
+    size_t bookFor(const std::string& asset_id);
+    void resum(AssetBook& book) const;
+    void resumTotals();
+    std::vector<InstrumentGreeks> priceInstruments(const std::string& asset_id,
+                                                   const std::vector<const Instrument*>& instruments,
+                                                   const MarketDataSnapshot& snapshot) const;
+};
+
+#endif
\ No newline at end of file
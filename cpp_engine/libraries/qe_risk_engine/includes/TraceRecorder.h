@@ -0,0 +1,85 @@
+#ifndef TRACE_RECORDER_H
+#define TRACE_RECORDER_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Timeline of spans in Chrome's trace-event format, for opening a run in
+// Perfetto (ui.perfetto.dev) or chrome://tracing with one track per thread.
+// Each thread records into its own fixed-size ring buffer, allocated on its
+// first event: recording takes only that thread's uncontended lock, and a
+// full buffer overwrites its oldest events. One recorder can be shared by
+// any number of threads and runs.
+class TraceRecorder {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit TraceRecorder(size_t events_per_thread = 65536);
+    ~TraceRecorder();
+
+    TraceRecorder(const TraceRecorder&) = delete;
+    TraceRecorder& operator=(const TraceRecorder&) = delete;
+
+    // A complete event on the calling thread. Events keep the name, category
+    // and argument name pointers, so these must be string literals.
+    void record(const char* name, const char* category, Clock::time_point start, Clock::time_point end,
+                const char* arg_name = nullptr, long long arg = 0);
+
+    // {"traceEvents": [...]} with timestamps in microseconds since the
+    // recorder was created; safe while other threads are recording
+    std::string toJson() const;
+    // Throws std::runtime_error if the file cannot be written
+    void write(const std::string& path) const;
+    void clear();
+
+    size_t size() const;
+    size_t getDropped() const;
+    size_t getEventsPerThread() const;
+
+private:
+    struct ThreadBuffer;
+
+    const uint64_t id_;
+    const size_t events_per_thread_;
+    const Clock::time_point origin_;
+    mutable std::mutex threads_mutex_;
+    std::vector<std::unique_ptr<ThreadBuffer>> threads_;
+
+    ThreadBuffer& threadBuffer();
+};
+
+// Records its own lifetime as one event; does nothing without a recorder
+class TraceSpan {
+public:
+    TraceSpan(TraceRecorder* recorder, const char* name, const char* category,
+              const char* arg_name = nullptr, long long arg = 0)
+        : recorder_(recorder), name_(name), category_(category), arg_name_(arg_name), arg_(arg) {
+        if (recorder_) {
+            start_ = TraceRecorder::Clock::now();
+        }
+    }
+    
+    ~TraceSpan() {
+        if (recorder_) {
+            recorder_->record(name_, category_, start_, TraceRecorder::Clock::now(), arg_name_, arg_);
+        }
+    }
+    
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    TraceRecorder* recorder_;
+    const char* name_;
+    const char* category_;
+    const char* arg_name_;
+    long long arg_;
+    TraceRecorder::Clock::time_point start_;
+};
+
+#endif
\ No newline at end of file
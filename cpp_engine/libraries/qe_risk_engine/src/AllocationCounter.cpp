@@ -0,0 +1,32 @@
+#include "AllocationCounter.h"
+#include <atomic>
+
+namespace AllocationCounter {
+
+namespace {
+
+std::atomic<bool> g_installed(false);
+
+// Per thread, so concurrent calculations do not see each other's allocations
+thread_local Counts t_counts;
+
+} // namespace
+
+bool installed() {
+    return g_installed.load(std::memory_order_relaxed);
+}
+
+Counts current() {
+    return t_counts;
+}
+
+void record(size_t bytes) noexcept {
+    ++t_counts.allocations;
+    t_counts.bytes += static_cast<long long>(bytes);
+}
+
+void markInstalled() noexcept {
+    g_installed.store(true, std::memory_order_relaxed);
+}
+
+} // namespace AllocationCounter
@@ -0,0 +1,54 @@
+#include "AllocationCounter.h"
+#include <cstdlib>
+#include <new>
+
+// Replaces the global allocation functions of any executable that links the
+// qe_allocation_hook object library, so every heap allocation is reported
+// to AllocationCounter. The nothrow and aligned forms keep their library
+// definitions; the nothrow ones forward to these, so they are counted too.
+
+namespace {
+
+void* allocate(std::size_t size) {
+    AllocationCounter::record(size);
+    for (;;) {
+        if (void* memory = std::malloc(size == 0 ? 1 : size)) {
+            return memory;
+        }
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) {
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+}
+
+struct Installer {
+    Installer() { AllocationCounter::markInstalled(); }
+} installer;
+
+} // namespace
+
+void* operator new(std::size_t size) {
+    return allocate(size);
+}
+
+void* operator new[](std::size_t size) {
+    return allocate(size);
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
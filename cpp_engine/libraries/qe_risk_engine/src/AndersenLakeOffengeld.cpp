@@ -0,0 +1,370 @@
+#include "AndersenLakeOffengeld.h"
+#include "BaroneAdesiWhaley.h"
+#include "BlackScholes.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+namespace AndersenLakeOffengeld {
+
+namespace {
+
+constexpr int kMaxQuadratureNodes = 256;
+
+struct QuadratureRule {
+    std::vector<double> nodes;
+    std::vector<double> weights;
+};
+
+// Gauss-Legendre nodes and weights on [-1, 1] by Newton on P_n
+QuadratureRule computeGaussLegendre(int n) {
+    QuadratureRule rule;
+    rule.nodes.assign(n, 0.0);
+    rule.weights.assign(n, 0.0);
+    for (int i = 0; i < (n + 1) / 2; ++i) {
+        double x = std::cos(M_PI * (i + 0.75) / (n + 0.5));
+        double dp = 0.0;
+        for (int iter = 0; iter < 100; ++iter) {
+            double p0 = 1.0;
+            double p1 = x;
+            for (int k = 2; k <= n; ++k) {
+                const double p2 = ((2.0 * k - 1.0) * x * p1 - (k - 1.0) * p0) / k;
+                p0 = p1;
+                p1 = p2;
+            }
+            dp = n * (x * p1 - p0) / (x * x - 1.0);
+            const double dx = p1 / dp;
+            x -= dx;
+            if (std::abs(dx) < 1e-15) {
+                break;
+            }
+        }
+        rule.nodes[i] = -x;
+        rule.nodes[n - 1 - i] = x;
+        rule.weights[i] = rule.weights[n - 1 - i] = 2.0 / ((1.0 - x * x) * dp * dp);
+    }
+    return rule;
+}
+
+// Rules are computed once per order and shared by every pricer thread
+const QuadratureRule& gaussLegendre(int n) {
+    static std::array<std::once_flag, kMaxQuadratureNodes + 1> flags;
+    static std::array<QuadratureRule, kMaxQuadratureNodes + 1> rules;
+    std::call_once(flags[n], [n] { rules[n] = computeGaussLegendre(n); });
+    return rules[n];
+}
+
+// Chebyshev interpolant through values at z_i = cos(i pi / n), i = 0..n.
+// cos_table holds cos(j pi / n) for j < 2n, so the transform needs no trig.
+std::vector<double> chebyshevCoefficients(const std::vector<double>& values,
+                                          const std::vector<double>& cos_table) {
+    const int n = static_cast<int>(values.size()) - 1;
+    std::vector<double> a(n + 1, 0.0);
+    for (int k = 0; k <= n; ++k) {
+        double sum = 0.5 * (values[0] + values[n] * cos_table[(n * k) % (2 * n)]);
+        for (int i = 1; i < n; ++i) {
+            sum += values[i] * cos_table[(i * k) % (2 * n)];
+        }
+        a[k] = 2.0 * sum / n;
+    }
+    a[0] *= 0.5;
+    a[n] *= 0.5;
+    return a;
+}
+
+double chebyshevEvaluate(const std::vector<double>& a, double z) {
+    // Clenshaw recurrence
+    double b1 = 0.0;
+    double b2 = 0.0;
+    for (size_t k = a.size() - 1; k > 0; --k) {
+        const double b0 = 2.0 * z * b1 - b2 + a[k];
+        b2 = b1;
+        b1 = b0;
+    }
+    return z * b1 - b2 + a[0];
+}
+
+// ln(B(tau) / K) from the interpolant of H at z = 2 sqrt(tau / T) - 1
+double logBoundaryAt(const std::vector<double>& a, double z) {
+    return -std::sqrt(std::max(0.0, chebyshevEvaluate(a, std::min(1.0, std::max(-1.0, z)))));
+}
+
+// d-minus and d-plus of Black-Scholes for time tau and moneyness ln(z)
+inline double dMinus(double log_z, double r, double sigma, double tau) {
+    return (log_z + (r - 0.5 * sigma * sigma) * tau) / (sigma * std::sqrt(tau));
+}
+
+inline double dPlus(double log_z, double r, double sigma, double tau) {
+    return (log_z + (r + 0.5 * sigma * sigma) * tau) / (sigma * std::sqrt(tau));
+}
+
+} // namespace
+
+void validateSettings(const CollocationSettings& settings) {
+    if (settings.collocation_nodes < 2 || settings.collocation_nodes > 64) {
+        throw std::invalid_argument("Collocation nodes must be between 2 and 64");
+    }
+    if (settings.integration_nodes < 2 || settings.integration_nodes > kMaxQuadratureNodes) {
+        throw std::invalid_argument("Integration nodes must be between 2 and 256");
+    }
+    if (settings.iterations < 0 || settings.iterations > 100) {
+        throw std::invalid_argument("Collocation iterations must be between 0 and 100");
+    }
+    if (settings.pricing_nodes < 2 || settings.pricing_nodes > kMaxQuadratureNodes) {
+        throw std::invalid_argument("Pricing nodes must be between 2 and 256");
+    }
+}
+
+ExerciseBoundary::ExerciseBoundary(double r, double T, double sigma,
+                                   const CollocationSettings& settings)
+    : rate_(r), expiry_(T), volatility_(sigma),
+      early_exercise_(r > 0.0 && T > 0.0 && sigma > 0.0) {
+    BlackScholes::validateInputs(1.0, 1.0, r, T, sigma);
+    validateSettings(settings);
+
+    if (!early_exercise_) {
+        return;
+    }
+
+    // Without dividends the put boundary starts at the strike (B(0+) = K)
+    // and stays below it, so H = ln(B/K)^2 is well defined and smooth in
+    // sqrt(tau), which is what makes the Chebyshev representation converge fast.
+    const int n = settings.collocation_nodes;
+    const double sqrt_T = std::sqrt(T);
+    std::vector<double> cos_table(2 * n);
+    for (int j = 0; j < 2 * n; ++j) {
+        cos_table[j] = std::cos(M_PI * j / n);
+    }
+    std::vector<double> tau(n + 1);
+    std::vector<double> H(n + 1);
+    for (int i = 0; i <= n; ++i) {
+        const double xi = 0.5 * sqrt_T * (1.0 + cos_table[i]);
+        tau[i] = xi * xi;
+        H[i] = 0.0;
+        if (i < n && tau[i] > 0.0) {
+            const double seed = BaroneAdesiWhaley::criticalPrice(1.0, r, tau[i], sigma, OptionType::Put);
+            const double log_b = std::log(std::min(std::max(seed, 1e-12), 1.0));
+            H[i] = log_b * log_b;
+        }
+    }
+    const std::vector<double> seed_H = H;
+    coefficients_ = chebyshevCoefficients(H, cos_table);
+
+    // Fixed-point sweeps B = K e^{-r tau} N(tau, B) / D(tau, B). The default is
+    // the smooth-pasting form (FP-B in the paper)
+    //   N = phi(d-(tau, B/K)) / (sigma sqrt(tau)) + r int_0^tau e^{ru} phi(d-(tau-u, B(tau)/B(u))) / (sigma sqrt(tau-u)) du
+    //   D = phi(d+(tau, B/K)) / (sigma sqrt(tau)) + Phi(d+(tau, B/K))
+    // which gains about a digit per sweep from the BAW seed. When 2r/sigma^2 is
+    // large FP-B stops contracting, and the sweeps restart on the value-matching
+    // form (FP-A), which is stable there but converges more slowly:
+    //   N = Phi(d-(tau, B/K)) + r int_0^tau e^{ru} Phi(d-(tau-u, B(tau)/B(u))) du
+    //   D = Phi(d+(tau, B/K))
+    // Integrals are taken in theta with u = tau sin^2(theta), which removes the
+    // 1/sqrt(tau - u) singularity and the sqrt(u) behaviour of B near u = 0.
+    // Everything but the boundary is tabulated once, including the Chebyshev
+    // basis at every quadrature node.
+    const QuadratureRule& rule = gaussLegendre(settings.integration_nodes);
+    const int l = settings.integration_nodes;
+    const size_t nodes = static_cast<size_t>(n) * l;
+    const double drift = r - 0.5 * sigma * sigma;
+
+    std::vector<double> sin_theta(l), cos_theta(l);
+    for (int j = 0; j < l; ++j) {
+        const double theta = 0.25 * M_PI * (1.0 + rule.nodes[j]);
+        sin_theta[j] = std::sin(theta);
+        cos_theta[j] = std::cos(theta);
+    }
+
+    std::vector<double> weight_b(nodes);        // FP-B: weight * e^{r u} * du / (sigma sqrt(tau - u))
+    std::vector<double> weight_a(nodes);        // FP-A: weight * e^{r u} * du
+    std::vector<double> node_drift(nodes);      // drift * (tau_i - u)
+    std::vector<double> node_inv_vol(nodes);    // 1 / (sigma sqrt(tau_i - u))
+    std::vector<double> basis((n + 1) * nodes); // T_k(z(u)), k-major
+    for (int i = 0; i < n; ++i) {
+        const double sqrt_t = std::sqrt(tau[i]);
+        for (int j = 0; j < l; ++j) {
+            const size_t q = static_cast<size_t>(i) * l + j;
+            const double u = tau[i] * sin_theta[j] * sin_theta[j];
+            const double growth = rule.weights[j] * std::exp(r * u) * 0.25 * M_PI;
+            // du = 2 tau sin cos dtheta and du / sqrt(tau - u) = 2 sqrt(tau) sin dtheta
+            weight_b[q] = growth * 2.0 * sqrt_t * sin_theta[j] / sigma;
+            weight_a[q] = growth * 2.0 * tau[i] * sin_theta[j] * cos_theta[j];
+            node_drift[q] = drift * (tau[i] - u);
+            node_inv_vol[q] = 1.0 / (sigma * sqrt_t * cos_theta[j]);
+
+            const double z = std::min(1.0, std::max(-1.0, 2.0 * sqrt_t * sin_theta[j] / sqrt_T - 1.0));
+            basis[q] = 1.0;
+            basis[nodes + q] = z;
+            for (int k = 2; k <= n; ++k) {
+                basis[k * nodes + q] = 2.0 * z * basis[(k - 1) * nodes + q] - basis[(k - 2) * nodes + q];
+            }
+        }
+    }
+
+    std::vector<double> H_nodes(nodes);
+    auto sweep = [&](bool value_matching) {
+        std::fill(H_nodes.begin(), H_nodes.end(), 0.0);
+        for (int k = 0; k <= n; ++k) {
+            const double a_k = coefficients_[k];
+            const double* T_k = &basis[k * nodes];
+            for (size_t q = 0; q < nodes; ++q) {
+                H_nodes[q] += a_k * T_k[q];
+            }
+        }
+
+        double change = 0.0;
+        for (int i = 0; i < n; ++i) {
+            const double vol_t = sigma * std::sqrt(tau[i]);
+            const double log_b = -std::sqrt(H[i]);
+            const double d_minus = (log_b + drift * tau[i]) / vol_t;
+            const double d_plus = d_minus + vol_t;
+
+            double integral = 0.0;
+            for (int j = 0; j < l; ++j) {
+                const size_t q = static_cast<size_t>(i) * l + j;
+                const double log_ratio = log_b + std::sqrt(std::max(0.0, H_nodes[q]));
+                const double d = (log_ratio + node_drift[q]) * node_inv_vol[q];
+                integral += value_matching ? weight_a[q] * BlackScholes::N(d)
+                                           : weight_b[q] * BlackScholes::nPrime(d);
+            }
+
+            double N_term, D_term;
+            if (value_matching) {
+                N_term = BlackScholes::N(d_minus) + r * integral;
+                D_term = BlackScholes::N(d_plus);
+            } else {
+                N_term = BlackScholes::nPrime(d_minus) / vol_t + r * integral;
+                D_term = BlackScholes::nPrime(d_plus) / vol_t + BlackScholes::N(d_plus);
+            }
+
+            const double log_updated = std::min(0.0, -r * tau[i] + std::log(N_term / D_term));
+            change = std::max(change, std::abs(log_updated - log_b));
+            H[i] = log_updated * log_updated;
+        }
+        coefficients_ = chebyshevCoefficients(H, cos_table);
+        return change;
+    };
+
+    double previous_change = std::numeric_limits<double>::infinity();
+    for (int iter = 0; iter < settings.iterations; ++iter) {
+        const double change = sweep(false);
+        if (change > 0.5 * previous_change && change > 1e-12) {
+            H = seed_H;
+            coefficients_ = chebyshevCoefficients(H, cos_table);
+            for (int restart = 0; restart < 2 * settings.iterations; ++restart) {
+                sweep(true);
+            }
+            break;
+        }
+        previous_change = change;
+    }
+
+    // Premium integral int_0^T r K e^{-r(T-u)} Phi(-d-(T-u, S/B(u))) du, again
+    // with u = T sin^2(theta); only ln(S/K) changes between puts on this
+    // boundary, so B(u) at the nodes is tabulated with the weights.
+    const QuadratureRule& pricing_rule = gaussLegendre(settings.pricing_nodes);
+    const std::vector<double>& p_y = pricing_rule.nodes;
+    const std::vector<double>& p_w = pricing_rule.weights;
+    for (size_t j = 0; j < p_y.size(); ++j) {
+        const double theta = 0.25 * M_PI * (1.0 + p_y[j]);
+        const double sin_theta = std::sin(theta);
+        const double cos_theta = std::cos(theta);
+        const double remaining = T * cos_theta * cos_theta;
+        pricing_log_boundary_.push_back(logBoundaryAt(coefficients_, 2.0 * sin_theta - 1.0));
+        pricing_weight_.push_back(p_w[j] * std::exp(-r * remaining) * sin_theta * cos_theta * 0.5 * M_PI * T * r);
+        pricing_drift_.push_back(drift * remaining);
+        pricing_inv_vol_.push_back(1.0 / (sigma * sqrt_T * cos_theta));
+    }
+}
+
+double ExerciseBoundary::operator()(double tau) const {
+    if (!early_exercise_) {
+        return 0.0;
+    }
+    if (tau < 0.0 || tau > expiry_ * (1.0 + 1e-12)) {
+        throw std::invalid_argument("Boundary time must lie within [0, T]");
+    }
+    return std::exp(logBoundaryAt(coefficients_, 2.0 * std::sqrt(tau / expiry_) - 1.0));
+}
+
+double ExerciseBoundary::price(double S, double K, OptionType type) const {
+    if (S <= 0.0 || K <= 0.0) {
+        throw std::invalid_argument("Stock price and strike must be positive");
+    }
+    if (type == OptionType::Call) {
+        return BlackScholes::callPrice(S, K, rate_, expiry_, volatility_);
+    }
+
+    const double european = BlackScholes::putPrice(S, K, rate_, expiry_, volatility_);
+    if (!early_exercise_) {
+        return std::max(european, K - S);
+    }
+
+    const double log_moneyness = std::log(S / K);
+    if (log_moneyness <= logBoundaryAt(coefficients_, 1.0)) {
+        return K - S;
+    }
+
+    double premium = 0.0;
+    for (size_t j = 0; j < pricing_weight_.size(); ++j) {
+        const double log_ratio = log_moneyness - pricing_log_boundary_[j];
+        premium += pricing_weight_[j] * BlackScholes::N(-(log_ratio + pricing_drift_[j]) * pricing_inv_vol_[j]);
+    }
+
+    return std::max(european + K * premium, K - S);
+}
+
+double ExerciseBoundary::getRate() const { return rate_; }
+
+double ExerciseBoundary::getTimeToExpiry() const { return expiry_; }
+
+double ExerciseBoundary::getVolatility() const { return volatility_; }
+
+double americanOptionPrice(double S, double K, double r, double T, double sigma,
+                           OptionType type, const CollocationSettings& settings) {
+    BlackScholes::validateInputs(S, K, r, T, sigma);
+    validateSettings(settings);
+
+    // No dividends: early exercise of a call is never optimal
+    if (type == OptionType::Call) {
+        return BlackScholes::callPrice(S, K, r, T, sigma);
+    }
+    return ExerciseBoundary(r, T, sigma, settings).price(S, K, type);
+}
+
+std::vector<double> americanOptionPrices(double S,
+                                         const std::vector<double>& strikes,
+                                         const std::vector<OptionType>& types,
+                                         double r, double T, double sigma,
+                                         const CollocationSettings& settings) {
+    if (strikes.size() != types.size()) {
+        throw std::invalid_argument("Strikes and option types must have the same length");
+    }
+    for (double K : strikes) {
+        BlackScholes::validateInputs(S, K, r, T, sigma);
+    }
+    validateSettings(settings);
+
+    std::vector<double> prices(strikes.size());
+    if (std::find(types.begin(), types.end(), OptionType::Put) == types.end()) {
+        for (size_t k = 0; k < strikes.size(); ++k) {
+            prices[k] = BlackScholes::callPrice(S, strikes[k], r, T, sigma);
+        }
+        return prices;
+    }
+
+    const ExerciseBoundary boundary(r, T, sigma, settings);
+    for (size_t k = 0; k < strikes.size(); ++k) {
+        prices[k] = boundary.price(S, strikes[k], types[k]);
+    }
+    return prices;
+}
+
+} // namespace AndersenLakeOffengeld
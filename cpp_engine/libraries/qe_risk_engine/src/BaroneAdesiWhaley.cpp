@@ -0,0 +1,106 @@
+#include "BaroneAdesiWhaley.h"
+#include "BlackScholes.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace BaroneAdesiWhaley {
+
+namespace {
+
+void validateInputs(double S, double K, double r, double T, double sigma) {
+    BlackScholes::validateInputs(S, K, r, T, sigma);
+}
+
+// Without dividends early exercise only pays for puts, and only when r > 0
+bool hasEarlyExercise(double r, double T, double sigma, OptionType type) {
+    return type == OptionType::Put && r > 0.0 && T > 0.0 && sigma > 0.0;
+}
+
+// Exponent of the early exercise premium A * (S / S**)^q
+double putExponent(double r, double T, double sigma) {
+    const double M = 2.0 * r / (sigma * sigma);
+    const double k = 1.0 - std::exp(-r * T);
+    return 0.5 * (-(M - 1.0) - std::sqrt((M - 1.0) * (M - 1.0) + 4.0 * M / k));
+}
+
+} // namespace
+
+double criticalPrice(double K, double r, double T, double sigma, OptionType type) {
+    validateInputs(K, K, r, T, sigma);
+
+    if (!hasEarlyExercise(r, T, sigma, type)) {
+        return type == OptionType::Put ? 0.0 : std::numeric_limits<double>::infinity();
+    }
+
+    const double sqrt_T = std::sqrt(T);
+    const double M = 2.0 * r / (sigma * sigma);
+    const double q = putExponent(r, T, sigma);
+
+    // Seed from the perpetual boundary (Barone-Adesi & Whaley, eq. 30)
+    const double q_inf = 0.5 * (-(M - 1.0) - std::sqrt((M - 1.0) * (M - 1.0) + 4.0 * M));
+    const double S_inf = K / (1.0 - 1.0 / q_inf);
+    const double h = (r * T - 2.0 * sigma * sqrt_T) * K / (K - S_inf);
+    double S_star = S_inf + (K - S_inf) * std::exp(h);
+
+    // Newton on K - S = p(S) - (1 - N(-d1)) S / q
+    for (int i = 0; i < 100; ++i) {
+        const double d1 = (std::log(S_star / K) + (r + 0.5 * sigma * sigma) * T) / (sigma * sqrt_T);
+        const double N_minus_d1 = BlackScholes::N(-d1);
+        const double rhs = BlackScholes::putPrice(S_star, K, r, T, sigma) -
+                           (1.0 - N_minus_d1) * S_star / q;
+        const double lhs = K - S_star;
+        if (std::abs(lhs - rhs) / K < 1e-10) {
+            break;
+        }
+        const double slope = -N_minus_d1 * (1.0 - 1.0 / q) -
+                             (1.0 + BlackScholes::nPrime(d1) / (sigma * sqrt_T)) / q;
+        S_star = (K - rhs + slope * S_star) / (1.0 + slope);
+        S_star = std::min(std::max(S_star, 1e-8 * K), K);
+    }
+
+    return S_star;
+}
+
+QuadraticApproximation::QuadraticApproximation(double K, double r, double T, double sigma,
+                                               OptionType type)
+    : strike_(K), rate_(r), expiry_(T), volatility_(sigma), type_(type),
+      early_exercise_(hasEarlyExercise(r, T, sigma, type)),
+      critical_price_(BaroneAdesiWhaley::criticalPrice(K, r, T, sigma, type)),
+      exponent_(0.0), coefficient_(0.0) {
+    if (!early_exercise_) {
+        return;
+    }
+    exponent_ = putExponent(r, T, sigma);
+    const double d1 = (std::log(critical_price_ / K) + (r + 0.5 * sigma * sigma) * T) /
+                      (sigma * std::sqrt(T));
+    coefficient_ = -(critical_price_ / exponent_) * (1.0 - BlackScholes::N(-d1));
+}
+
+double QuadraticApproximation::price(double S) const {
+    if (S <= 0.0) {
+        throw std::invalid_argument("Spot price must be positive");
+    }
+    if (type_ == OptionType::Call) {
+        return BlackScholes::callPrice(S, strike_, rate_, expiry_, volatility_);
+    }
+    const double european = BlackScholes::putPrice(S, strike_, rate_, expiry_, volatility_);
+    if (!early_exercise_) {
+        return std::max(european, strike_ - S);
+    }
+    if (S <= critical_price_) {
+        return strike_ - S;
+    }
+    return european + coefficient_ * std::pow(S / critical_price_, exponent_);
+}
+
+double QuadraticApproximation::criticalPrice() const { return critical_price_; }
+
+double americanOptionPrice(double S, double K, double r, double T, double sigma,
+                           OptionType type) {
+    validateInputs(S, K, r, T, sigma);
+    return QuadraticApproximation(K, r, T, sigma, type).price(S);
+}
+
+} // namespace BaroneAdesiWhaley
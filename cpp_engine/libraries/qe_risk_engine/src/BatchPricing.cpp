@@ -0,0 +1,365 @@
+#include "BatchPricing.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <exception>
+#include <limits>
+#include <map>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+namespace BatchPricing {
+
+namespace {
+
+// Elements are handed out in blocks, so threads that draw cheap
+// (Black-Scholes) elements keep taking work while others run lattices
+const size_t kBlockSize = 1024;
+
+const char* const kAssetId = "batch";
+
+void validate(const OptionArrays& options) {
+    if (options.size == 0) {
+        return;
+    }
+    if (!options.spot || !options.strike || !options.expiry || !options.rate ||
+        !options.volatility || !options.type) {
+        throw std::invalid_argument("Batch pricing requires spot, strike, expiry, rate, volatility and type");
+    }
+}
+
+bool validType(const OptionArrays& options, size_t i) {
+    return options.type[i] == 0 || options.type[i] == 1;
+}
+
+OptionType optionType(const OptionArrays& options, size_t i) {
+    return options.type[i] == 0 ? OptionType::Call : OptionType::Put;
+}
+
+int32_t modelCode(const OptionArrays& options, size_t i) {
+    return options.model ? options.model[i] : 0;
+}
+
+bool validModel(int32_t model_code) {
+    return model_code >= 0 && model_code <= static_cast<int32_t>(PricingModel::BaroneAdesiWhaley);
+}
+
+// Models without an American variant fall back to the binomial tree
+bool americanBinomial(PricingModel model) {
+    return model != PricingModel::FiniteDifference && model != PricingModel::AndersenLakeOffengeld &&
+           model != PricingModel::BaroneAdesiWhaley;
+}
+
+MarketData marketData(const OptionArrays& options, size_t i) {
+    MarketData md;
+    md.asset_id = kAssetId;
+    md.spot_price = options.spot[i];
+    md.risk_free_rate = options.rate[i];
+    md.volatility = options.volatility[i];
+    md.dividend_yield = options.dividend ? options.dividend[i] : 0.0;
+    return md;
+}
+
+// Prices element i through the same Instrument the per-object API would use
+template <typename Visit>
+void visitElement(const OptionArrays& options, size_t i, Visit visit) {
+    if (!validType(options, i)) {
+        throw std::invalid_argument("Option type must be 0 (call) or 1 (put)");
+    }
+    const int32_t model_code = modelCode(options, i);
+    if (!validModel(model_code)) {
+        throw std::invalid_argument("Unknown pricing model");
+    }
+    const OptionType option_type = optionType(options, i);
+    const PricingModel model = static_cast<PricingModel>(model_code);
+    const MarketData md = marketData(options, i);
+
+    if (options.american && options.american[i]) {
+        AmericanOption option(option_type, options.strike[i], options.expiry[i], kAssetId);
+        if (!americanBinomial(model)) {
+            option.setPricingModel(model);
+        }
+        visit(option, md);
+        return;
+    }
+
+    if (model == PricingModel::AndersenLakeOffengeld || model == PricingModel::BaroneAdesiWhaley) {
+        throw std::invalid_argument("Pricing model requires an American option");
+    }
+    EuropeanOption option(option_type, options.strike[i], options.expiry[i], kAssetId, model);
+    if (model == PricingModel::MertonJumpDiffusion) {
+        option.setJumpParameters(kDefaultJumpIntensity, kDefaultJumpMean, kDefaultJumpVolatility);
+    }
+    visit(option, md);
+}
+
+// Elements that share one valuation: binomial American or jump-diffusion
+// European options on the same spot, rate, volatility, dividend and expiry (a strike
+// ladder of one expiry in an option chain). A chain is valued with a single
+// priceBatch/greeksBatch call, which gives the same results as pricing its
+// members one by one; everything else is priced element-wise.
+enum class ChainKind { American, JumpDiffusion };
+
+struct Chain {
+    ChainKind kind;
+    std::vector<size_t> elements;
+};
+
+const char* chainName(ChainKind kind) {
+    return kind == ChainKind::American ? "Binomial chain" : "MertonJumpDiffusion chain";
+}
+
+struct Plan {
+    std::vector<size_t> singles;
+    std::vector<Chain> chains;
+};
+
+Plan plan(const OptionArrays& options) {
+    using Key = std::tuple<ChainKind, double, double, double, double, double>;
+    std::map<Key, size_t> index;
+    std::vector<Chain> candidates;
+    std::vector<size_t> singles;
+
+    for (size_t i = 0; i < options.size; ++i) {
+        const int32_t model_code = modelCode(options, i);
+        const bool american = options.american && options.american[i];
+        const double dividend = options.dividend ? options.dividend[i] : 0.0;
+        const bool finite = std::isfinite(options.spot[i]) && std::isfinite(options.rate[i]) &&
+                            std::isfinite(options.volatility[i]) && std::isfinite(options.expiry[i]) &&
+                            std::isfinite(dividend);
+        if (!finite || !validType(options, i) || !validModel(model_code)) {
+            singles.push_back(i);
+            continue;
+        }
+        const PricingModel model = static_cast<PricingModel>(model_code);
+        ChainKind kind;
+        if (american && americanBinomial(model)) {
+            kind = ChainKind::American;
+        } else if (!american && model == PricingModel::MertonJumpDiffusion) {
+            kind = ChainKind::JumpDiffusion;
+        } else {
+            singles.push_back(i);
+            continue;
+        }
+        const Key key(kind, options.spot[i], options.rate[i], options.volatility[i], dividend,
+                      options.expiry[i]);
+        const auto found = index.emplace(key, candidates.size());
+        if (found.second) {
+            candidates.push_back({kind, {}});
+        }
+        candidates[found.first->second].elements.push_back(i);
+    }
+
+    Plan result;
+    for (Chain& chain : candidates) {
+        if (chain.elements.size() == 1) {
+            singles.push_back(chain.elements.front());
+        } else {
+            result.chains.push_back(std::move(chain));
+        }
+    }
+    std::sort(singles.begin(), singles.end());
+    result.singles = std::move(singles);
+    return result;
+}
+
+// One batch call over the chain's members; throws if any member cannot be
+// priced, in which case the caller falls back to element-wise valuation
+template <typename Result>
+std::vector<Result> valueChain(
+    const OptionArrays& options, const Chain& chain,
+    std::vector<Result> (*american)(const std::vector<const AmericanOption*>&, const MarketData&),
+    std::vector<Result> (*european)(const std::vector<const EuropeanOption*>&, const MarketData&)) {
+    const MarketData md = marketData(options, chain.elements.front());
+
+    if (chain.kind == ChainKind::American) {
+        std::vector<AmericanOption> members;
+        std::vector<const AmericanOption*> pointers;
+        members.reserve(chain.elements.size());
+        for (size_t i : chain.elements) {
+            members.emplace_back(optionType(options, i), options.strike[i], options.expiry[i], kAssetId);
+        }
+        for (const AmericanOption& member : members) {
+            pointers.push_back(&member);
+        }
+        return american(pointers, md);
+    }
+
+    std::vector<EuropeanOption> members;
+    std::vector<const EuropeanOption*> pointers;
+    members.reserve(chain.elements.size());
+    for (size_t i : chain.elements) {
+        members.emplace_back(optionType(options, i), options.strike[i], options.expiry[i], kAssetId,
+                             PricingModel::MertonJumpDiffusion);
+        members.back().setJumpParameters(kDefaultJumpIntensity, kDefaultJumpMean, kDefaultJumpVolatility);
+    }
+    for (const EuropeanOption& member : members) {
+        pointers.push_back(&member);
+    }
+    return european(pointers, md);
+}
+
+// Runs price_range(begin, end) over [0, size) in blocks of `block_size` on
+// up to `threads` threads and returns the summed failure counts. A trace gets
+// each worker's start-up delay as "queue_wait" and, given a `span` name,
+// every block.
+template <typename PriceRange>
+size_t run(size_t size, size_t block_size, unsigned threads, TraceRecorder* trace, const char* span,
+           PriceRange price_range) {
+    if (threads == 0) {
+        threads = std::thread::hardware_concurrency();
+    }
+    const size_t blocks = (size + block_size - 1) / block_size;
+    const size_t workers = std::min<size_t>(std::max(threads, 1u), blocks);
+    if (workers <= 1) {
+        TraceSpan block_span(span && size > 0 ? trace : nullptr, span, "batch", "elements",
+                             static_cast<long long>(size));
+        return size == 0 ? 0 : price_range(0, size);
+    }
+
+    std::atomic<size_t> next_block(0);
+    std::atomic<size_t> failures(0);
+    std::vector<std::exception_ptr> errors(workers);
+    std::vector<std::thread> pool;
+    pool.reserve(workers);
+    const TraceRecorder::Clock::time_point queued = trace ? TraceRecorder::Clock::now()
+                                                          : TraceRecorder::Clock::time_point();
+    for (size_t w = 0; w < workers; ++w) {
+        pool.emplace_back([&, w]() {
+            if (trace) {
+                trace->record("queue_wait", "batch", queued, TraceRecorder::Clock::now());
+            }
+            try {
+                size_t failed = 0;
+                for (size_t block = next_block++; block < blocks; block = next_block++) {
+                    const size_t begin = block * block_size;
+                    const size_t end = std::min(size, begin + block_size);
+                    TraceSpan block_span(span ? trace : nullptr, span, "batch", "elements",
+                                         static_cast<long long>(end - begin));
+                    failed += price_range(begin, end);
+                }
+                failures += failed;
+            } catch (...) {
+                errors[w] = std::current_exception();
+            }
+        });
+    }
+    for (std::thread& thread : pool) {
+        thread.join();
+    }
+    for (const std::exception_ptr& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+    return failures;
+}
+
+} // namespace
+
+size_t price(const OptionArrays& options, double* prices, unsigned threads, TraceRecorder* trace) {
+    validate(options);
+    if (options.size > 0 && !prices) {
+        throw std::invalid_argument("Batch pricing requires an output array");
+    }
+
+    const auto price_element = [&](size_t i) -> size_t {
+        try {
+            visitElement(options, i, [&](const Instrument& option, const MarketData& md) {
+                prices[i] = option.price(md);
+            });
+            return 0;
+        } catch (const std::exception&) {
+            prices[i] = std::numeric_limits<double>::quiet_NaN();
+            return 1;
+        }
+    };
+
+    const Plan work = plan(options);
+    size_t failures = run(work.singles.size(), kBlockSize, threads, trace, "block", [&](size_t begin, size_t end) {
+        size_t failed = 0;
+        for (size_t k = begin; k < end; ++k) {
+            failed += price_element(work.singles[k]);
+        }
+        return failed;
+    });
+    failures += run(work.chains.size(), 1, threads, trace, nullptr, [&](size_t begin, size_t end) {
+        size_t failed = 0;
+        for (size_t c = begin; c < end; ++c) {
+            const Chain& chain = work.chains[c];
+            TraceSpan chain_span(trace, chainName(chain.kind), "batch", "options",
+                                 static_cast<long long>(chain.elements.size()));
+            try {
+                const std::vector<double> results =
+                    valueChain<double>(options, chain, &AmericanOption::priceBatch, &EuropeanOption::priceBatch);
+                for (size_t k = 0; k < chain.elements.size(); ++k) {
+                    prices[chain.elements[k]] = results[k];
+                }
+            } catch (const std::exception&) {
+                for (size_t i : chain.elements) {
+                    failed += price_element(i);
+                }
+            }
+        }
+        return failed;
+    });
+    return failures;
+}
+
+size_t greeks(const OptionArrays& options, const GreekArrays& out, unsigned threads, TraceRecorder* trace) {
+    validate(options);
+
+    const auto store = [&](size_t i, const InstrumentGreeks& result) {
+        if (out.price) out.price[i] = result.price;
+        if (out.delta) out.delta[i] = result.delta;
+        if (out.gamma) out.gamma[i] = result.gamma;
+        if (out.vega) out.vega[i] = result.vega;
+        if (out.theta) out.theta[i] = result.theta;
+    };
+    const auto value_element = [&](size_t i) -> size_t {
+        try {
+            visitElement(options, i, [&](const Instrument& option, const MarketData& md) {
+                store(i, option.greeks(md));
+            });
+            return 0;
+        } catch (const std::exception&) {
+            const double nan = std::numeric_limits<double>::quiet_NaN();
+            store(i, {nan, nan, nan, nan, nan});
+            return 1;
+        }
+    };
+
+    const Plan work = plan(options);
+    size_t failures = run(work.singles.size(), kBlockSize, threads, trace, "block", [&](size_t begin, size_t end) {
+        size_t failed = 0;
+        for (size_t k = begin; k < end; ++k) {
+            failed += value_element(work.singles[k]);
+        }
+        return failed;
+    });
+    failures += run(work.chains.size(), 1, threads, trace, nullptr, [&](size_t begin, size_t end) {
+        size_t failed = 0;
+        for (size_t c = begin; c < end; ++c) {
+            const Chain& chain = work.chains[c];
+            TraceSpan chain_span(trace, chainName(chain.kind), "batch", "options",
+                                 static_cast<long long>(chain.elements.size()));
+            try {
+                const std::vector<InstrumentGreeks> results = valueChain<InstrumentGreeks>(
+                    options, chain, &AmericanOption::greeksBatch, &EuropeanOption::greeksBatch);
+                for (size_t k = 0; k < chain.elements.size(); ++k) {
+                    store(chain.elements[k], results[k]);
+                }
+            } catch (const std::exception&) {
+                for (size_t i : chain.elements) {
+                    failed += value_element(i);
+                }
+            }
+        }
+        return failed;
+    });
+    return failures;
+}
+
+} // namespace BatchPricing
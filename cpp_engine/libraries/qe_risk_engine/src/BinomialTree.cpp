@@ -129,6 +129,96 @@ double americanOptionPrice(
     return prices[0];
 }
 
+std::vector<double> americanOptionPrices(
+    double S, const std::vector<double>& strikes,
+    const std::vector<OptionType>& types,
+    double r, double T, double sigma, int steps
+) {
+    if (strikes.size() != types.size()) {
+        throw std::invalid_argument("Strikes and option types must have the same length");
+    }
+    if (S <= 0.0) {
+        throw std::invalid_argument("Stock price and strike must be positive");
+    }
+    for (double K : strikes) {
+        if (K <= 0.0) {
+            throw std::invalid_argument("Stock price and strike must be positive");
+        }
+    }
+    if (T < 0.0) {
+        throw std::invalid_argument("Time to expiry cannot be negative");
+    }
+    if (sigma < 0.0) {
+        throw std::invalid_argument("Volatility cannot be negative");
+    }
+    if (steps < 1) {
+        throw std::invalid_argument("Number of steps must be positive");
+    }
+
+    const size_t n = strikes.size();
+
+    // Payoff sign per strike: +1 for calls, -1 for puts, so that
+    // max(0, phi * (spot - K)) covers both without branching in the loops.
+    std::vector<double> phi(n);
+    for (size_t k = 0; k < n; ++k) {
+        phi[k] = (types[k] == OptionType::Call) ? 1.0 : -1.0;
+    }
+
+    std::vector<double> results(n);
+
+    if (T == 0.0) {
+        for (size_t k = 0; k < n; ++k) {
+            results[k] = std::max(0.0, phi[k] * (S - strikes[k]));
+        }
+        return results;
+    }
+
+    if (n == 0) {
+        return results;
+    }
+
+    const double dt = T / steps;
+    const double u = std::exp(sigma * std::sqrt(dt));
+    const double d = 1.0 / u;
+    const double p = (std::exp(r * dt) - d) / (u - d);
+    const double discount = std::exp(-r * dt);
+
+    if (p < 0.0 || p > 1.0) {
+        throw std::runtime_error("Invalid probability in binomial tree");
+    }
+
+    const double q = 1.0 - p;
+    const double* K = strikes.data();
+    const double* sign = phi.data();
+
+    // values[i * n + k] holds the option value of strike k at node i.
+    std::vector<double> values((steps + 1) * n);
+
+    for (int i = 0; i <= steps; ++i) {
+        const double spot = S * std::pow(u, steps - i) * std::pow(d, i);
+        double* row = values.data() + i * n;
+        for (size_t k = 0; k < n; ++k) {
+            row[k] = std::max(0.0, sign[k] * (spot - K[k]));
+        }
+    }
+
+    for (int step = steps - 1; step >= 0; --step) {
+        for (int i = 0; i <= step; ++i) {
+            const double spot = S * std::pow(u, step - i) * std::pow(d, i);
+            double* row = values.data() + i * n;
+            const double* next = row + n;
+            for (size_t k = 0; k < n; ++k) {
+                const double hold_value = discount * (p * row[k] + q * next[k]);
+                const double exercise_value = std::max(0.0, sign[k] * (spot - K[k]));
+                row[k] = std::max(hold_value, exercise_value);
+            }
+        }
+    }
+
+    std::copy(values.begin(), values.begin() + n, results.begin());
+    return results;
+}
+
 std::vector<std::vector<TreeNode>> buildTree(
     double S, double K, double r, double T, double sigma,
     OptionType type, int steps, bool is_american
@@ -0,0 +1,402 @@
+#include "FiniteDifference.h"
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+
+namespace FiniteDifference {
+
+namespace {
+
+double payoff(double spot, double K, OptionType type) {
+    if (type == OptionType::Call) {
+        return std::max(0.0, spot - K);
+    } else {
+        return std::max(0.0, K - spot);
+    }
+}
+
+// Constant-coefficient tridiagonal system l*v[j-1] + m*v[j] + u*v[j+1] = d[j].
+// The elimination factors depend only on the matrix, so they are computed once
+// per time-stepping phase and each step only sweeps the right-hand side.
+class TridiagonalSolver {
+public:
+    TridiagonalSolver(double lower, double diag, double upper, size_t n, bool eliminate_downward)
+        : lower_(lower), upper_(upper), downward_(eliminate_downward),
+          factor_(n), inv_den_(n), rhs_(n) {
+        if (n == 0) {
+            return;
+        }
+        if (!downward_) {
+            // Standard Thomas: eliminate upward in j, substitute downward
+            inv_den_[0] = 1.0 / diag;
+            factor_[0] = upper * inv_den_[0];
+            for (size_t j = 1; j < n; ++j) {
+                inv_den_[j] = 1.0 / (diag - lower * factor_[j - 1]);
+                factor_[j] = upper * inv_den_[j];
+            }
+        } else {
+            // Reversed Thomas: eliminate downward in j, substitute upward
+            inv_den_[n - 1] = 1.0 / diag;
+            factor_[n - 1] = lower * inv_den_[n - 1];
+            for (size_t j = n - 1; j-- > 0;) {
+                inv_den_[j] = 1.0 / (diag - upper * factor_[j + 1]);
+                factor_[j] = lower * inv_den_[j];
+            }
+        }
+    }
+
+    // Solves into v. With an obstacle the substitution projects each value
+    // onto v >= obstacle as it goes (Brennan-Schwartz); this is exact when the
+    // exercise region is on the side where the substitution starts.
+    void solve(const double* d, double* v, const double* obstacle) {
+        const size_t n = rhs_.size();
+        if (n == 0) {
+            return;
+        }
+        if (!downward_) {
+            rhs_[0] = d[0] * inv_den_[0];
+            for (size_t j = 1; j < n; ++j) {
+                rhs_[j] = (d[j] - lower_ * rhs_[j - 1]) * inv_den_[j];
+            }
+            v[n - 1] = rhs_[n - 1];
+            if (obstacle) {
+                v[n - 1] = std::max(v[n - 1], obstacle[n - 1]);
+            }
+            for (size_t j = n - 1; j-- > 0;) {
+                v[j] = rhs_[j] - factor_[j] * v[j + 1];
+                if (obstacle) {
+                    v[j] = std::max(v[j], obstacle[j]);
+                }
+            }
+        } else {
+            rhs_[n - 1] = d[n - 1] * inv_den_[n - 1];
+            for (size_t j = n - 1; j-- > 0;) {
+                rhs_[j] = (d[j] - upper_ * rhs_[j + 1]) * inv_den_[j];
+            }
+            v[0] = rhs_[0];
+            if (obstacle) {
+                v[0] = std::max(v[0], obstacle[0]);
+            }
+            for (size_t j = 1; j < n; ++j) {
+                v[j] = rhs_[j] - factor_[j] * v[j - 1];
+                if (obstacle) {
+                    v[j] = std::max(v[j], obstacle[j]);
+                }
+            }
+        }
+    }
+
+private:
+    double lower_;
+    double upper_;
+    bool downward_;
+    std::vector<double> factor_;
+    std::vector<double> inv_den_;
+    std::vector<double> rhs_;
+};
+
+// Average of the payoff over [x - dx/2, x + dx/2] in log-spot. Used for the
+// node(s) next to the strike so the kink does not spoil second-order accuracy.
+double cellAveragedPayoff(double x, double dx, double K, OptionType type) {
+    const double lo = x - 0.5 * dx;
+    const double hi = x + 0.5 * dx;
+    const double x_strike = std::log(K);
+    double integral = 0.0;
+    if (type == OptionType::Call) {
+        const double from = std::max(lo, x_strike);
+        if (from < hi) {
+            integral = (std::exp(hi) - std::exp(from)) - K * (hi - from);
+        }
+    } else {
+        const double to = std::min(hi, x_strike);
+        if (to > lo) {
+            integral = K * (to - lo) - (std::exp(to) - std::exp(lo));
+        }
+    }
+    return std::max(0.0, integral / dx);
+}
+
+} // namespace
+
+void validateSettings(const GridSettings& settings) {
+    if (settings.space_steps < 4 || settings.space_steps > 100000) {
+        throw std::invalid_argument("Finite difference space steps must be between 4 and 100000");
+    }
+    if (settings.time_steps < 1 || settings.time_steps > 100000) {
+        throw std::invalid_argument("Finite difference time steps must be between 1 and 100000");
+    }
+    if (!(settings.std_devs > 0.0) || std::isinf(settings.std_devs)) {
+        throw std::invalid_argument("Finite difference grid width must be positive");
+    }
+    if (settings.rannacher_steps < 0) {
+        throw std::invalid_argument("Rannacher steps cannot be negative");
+    }
+}
+
+SolutionSlice::SolutionSlice(
+    double x_min, double dx, std::vector<double> values,
+    double K, double r, double T, OptionType type, bool is_american
+) : x_min_(x_min), dx_(dx), values_(std::move(values)),
+    strike_(K), rate_(r), expiry_(T), type_(type), is_american_(is_american) {
+}
+
+const std::vector<double>& SolutionSlice::values() const {
+    return values_;
+}
+
+double SolutionSlice::minSpot() const {
+    return std::exp(x_min_);
+}
+
+double SolutionSlice::maxSpot() const {
+    return std::exp(x_min_ + dx_ * (values_.size() - 1));
+}
+
+bool SolutionSlice::contains(double spot) const {
+    if (values_.size() < 3 || spot <= 0.0) {
+        return false;
+    }
+    const double x = std::log(spot);
+    return x >= x_min_ && x <= x_min_ + dx_ * (values_.size() - 1);
+}
+
+double SolutionSlice::boundaryValue(double spot) const {
+    const double discounted_strike = strike_ * std::exp(-rate_ * expiry_);
+    if (type_ == OptionType::Call) {
+        if (spot < minSpot()) {
+            return 0.0;
+        }
+        double value = spot - discounted_strike;
+        if (is_american_) {
+            value = std::max(value, spot - strike_);
+        }
+        return std::max(0.0, value);
+    } else {
+        if (spot > maxSpot()) {
+            return 0.0;
+        }
+        double value = discounted_strike - spot;
+        if (is_american_) {
+            value = std::max(value, strike_ - spot);
+        }
+        return std::max(0.0, value);
+    }
+}
+
+void SolutionSlice::localFit(double x, double& v, double& v_x, double& v_xx) const {
+    const long last = static_cast<long>(values_.size()) - 1;
+    long i = std::lround((x - x_min_) / dx_);
+    i = std::max(1L, std::min(last - 1, i));
+
+    const double t = (x - (x_min_ + i * dx_)) / dx_;
+    const double first = 0.5 * (values_[i + 1] - values_[i - 1]);
+    const double second = values_[i + 1] - 2.0 * values_[i] + values_[i - 1];
+
+    v = values_[i] + t * first + 0.5 * t * t * second;
+    v_x = (first + t * second) / dx_;
+    v_xx = second / (dx_ * dx_);
+}
+
+double SolutionSlice::price(double spot) const {
+    if (spot <= 0.0 || std::isnan(spot) || std::isinf(spot)) {
+        throw std::invalid_argument("Spot price must be positive");
+    }
+    if (!contains(spot)) {
+        return boundaryValue(spot);
+    }
+
+    double v, v_x, v_xx;
+    localFit(std::log(spot), v, v_x, v_xx);
+    return std::max(0.0, v);
+}
+
+double SolutionSlice::delta(double spot) const {
+    if (spot <= 0.0 || std::isnan(spot) || std::isinf(spot)) {
+        throw std::invalid_argument("Spot price must be positive");
+    }
+    if (!contains(spot)) {
+        if (type_ == OptionType::Call) {
+            return spot < minSpot() ? 0.0 : 1.0;
+        } else {
+            return spot > maxSpot() ? 0.0 : -1.0;
+        }
+    }
+
+    double v, v_x, v_xx;
+    localFit(std::log(spot), v, v_x, v_xx);
+    return v_x / spot;
+}
+
+double SolutionSlice::gamma(double spot) const {
+    if (spot <= 0.0 || std::isnan(spot) || std::isinf(spot)) {
+        throw std::invalid_argument("Spot price must be positive");
+    }
+    if (!contains(spot)) {
+        return 0.0;
+    }
+
+    double v, v_x, v_xx;
+    localFit(std::log(spot), v, v_x, v_xx);
+    // Vanilla payoffs are convex in spot; deep in the money the grid
+    // curvature is pure rounding noise and can dip just below zero.
+    return std::max(0.0, (v_xx - v_x) / (spot * spot));
+}
+
+SolutionSlice solve(
+    double S, double K, double r, double T, double sigma,
+    OptionType type, bool is_american, const GridSettings& settings
+) {
+    if (S <= 0.0 || K <= 0.0) {
+        throw std::invalid_argument("Stock price and strike must be positive");
+    }
+    if (T < 0.0) {
+        throw std::invalid_argument("Time to expiry cannot be negative");
+    }
+    if (sigma < 0.0) {
+        throw std::invalid_argument("Volatility cannot be negative");
+    }
+    if (std::isnan(S) || std::isinf(S) || std::isnan(r) || std::isinf(r) ||
+        std::isnan(T) || std::isinf(T) || std::isnan(sigma) || std::isinf(sigma)) {
+        throw std::invalid_argument("Invalid finite difference inputs");
+    }
+    validateSettings(settings);
+
+    // Keep the spot on the centre node so the price needs no interpolation
+    const int M = settings.space_steps + (settings.space_steps % 2);
+    const int centre = M / 2;
+
+    const double x_spot = std::log(S);
+    const double width = sigma * std::sqrt(T);
+
+    // Degenerate cases follow the Black-Scholes convention: intrinsic value
+    if (T == 0.0 || width < 1e-12) {
+        const double half_width = 0.5;
+        const double dx = 2.0 * half_width / M;
+        const double x_min = x_spot - half_width;
+        std::vector<double> values(M + 1);
+        for (int j = 0; j <= M; ++j) {
+            values[j] = payoff(std::exp(x_min + j * dx), K, type);
+        }
+        values[centre] = payoff(S, K, type);
+        return SolutionSlice(x_min, dx, std::move(values), K, r, 0.0, type, is_american);
+    }
+
+    const double half_width = settings.std_devs * width;
+    const double dx = 2.0 * half_width / M;
+    const double x_min = x_spot - half_width;
+
+    std::vector<double> spots(M + 1);
+    std::vector<double> obstacle(M + 1);
+    for (int j = 0; j <= M; ++j) {
+        spots[j] = std::exp(x_min + j * dx);
+        obstacle[j] = payoff(spots[j], K, type);
+    }
+    spots[centre] = S;
+    obstacle[centre] = payoff(S, K, type);
+
+    std::vector<double> values = obstacle;
+    const double x_strike = std::log(K);
+    for (int j = 0; j <= M; ++j) {
+        const double x = x_min + j * dx;
+        if (std::abs(x - x_strike) < dx) {
+            values[j] = cellAveragedPayoff(x, dx, K, type);
+        }
+    }
+    std::vector<double> next(M + 1);
+    std::vector<double> rhs(M - 1);
+
+    // L V = a V[j-1] + b V[j] + c V[j+1] for the log-spot Black-Scholes operator
+    const double nu = r - 0.5 * sigma * sigma;
+    const double alpha = 0.5 * sigma * sigma / (dx * dx);
+    const double beta = 0.5 * nu / dx;
+    const double a = alpha - beta;
+    const double b = -2.0 * alpha - r;
+    const double c = alpha + beta;
+
+    auto boundaries = [&](double tau, double& low, double& high) {
+        const double discounted_strike = K * std::exp(-r * tau);
+        if (type == OptionType::Call) {
+            low = 0.0;
+            high = std::max(0.0, spots[M] - discounted_strike);
+            if (is_american) {
+                high = std::max(high, spots[M] - K);
+            }
+        } else {
+            low = std::max(0.0, discounted_strike - spots[0]);
+            if (is_american) {
+                low = std::max(low, K - spots[0]);
+            }
+            high = 0.0;
+        }
+    };
+
+    // Puts exercise below the boundary, so substitute from the low-spot end
+    const bool eliminate_downward = (type == OptionType::Put);
+    const double* exercise = is_american ? obstacle.data() + 1 : nullptr;
+
+    auto step = [&](TridiagonalSolver& solver, double theta, double h, double tau_new) {
+        const double explicit_weight = (1.0 - theta) * h;
+        for (int j = 1; j < M; ++j) {
+            rhs[j - 1] = values[j] + explicit_weight *
+                (a * values[j - 1] + b * values[j] + c * values[j + 1]);
+        }
+
+        double low, high;
+        boundaries(tau_new, low, high);
+        rhs[0] += theta * h * a * low;
+        rhs[M - 2] += theta * h * c * high;
+
+        solver.solve(rhs.data(), next.data() + 1, exercise);
+        next[0] = low;
+        next[M] = high;
+        values.swap(next);
+    };
+
+    const int N = settings.time_steps;
+    const double dt = T / N;
+    const int rannacher = std::min(settings.rannacher_steps, N);
+    double tau = 0.0;
+
+    if (rannacher > 0) {
+        const double h = 0.5 * dt;
+        TridiagonalSolver implicit(-h * a, 1.0 - h * b, -h * c, M - 1, eliminate_downward);
+        for (int n = 0; n < 2 * rannacher; ++n) {
+            tau = (n + 1 == 2 * rannacher) ? rannacher * dt : tau + h;
+            step(implicit, 1.0, h, tau);
+        }
+    }
+
+    if (rannacher < N) {
+        const double h = dt;
+        TridiagonalSolver crank_nicolson(-0.5 * h * a, 1.0 - 0.5 * h * b, -0.5 * h * c,
+                                         M - 1, eliminate_downward);
+        for (int n = rannacher; n < N; ++n) {
+            tau = (n + 1 == N) ? T : (n + 1) * dt;
+            step(crank_nicolson, 0.5, h, tau);
+        }
+    }
+
+    for (double v : values) {
+        if (std::isnan(v) || std::isinf(v)) {
+            throw std::runtime_error("Finite difference solution is not finite");
+        }
+    }
+
+    return SolutionSlice(x_min, dx, std::move(values), K, r, T, type, is_american);
+}
+
+double europeanOptionPrice(
+    double S, double K, double r, double T, double sigma,
+    OptionType type, const GridSettings& settings
+) {
+    return solve(S, K, r, T, sigma, type, false, settings).price(S);
+}
+
+double americanOptionPrice(
+    double S, double K, double r, double T, double sigma,
+    OptionType type, const GridSettings& settings
+) {
+    return solve(S, K, r, T, sigma, type, true, settings).price(S);
+}
+
+}
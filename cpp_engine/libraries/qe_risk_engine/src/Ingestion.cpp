@@ -0,0 +1,661 @@
+#include "Ingestion.h"
+#include "Json.h"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+namespace Ingestion {
+
+namespace {
+
+// Below this a chunk is not worth a thread
+const size_t kMinChunkBytes = 64 * 1024;
+
+std::string lowercase(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return text;
+}
+
+std::string trim(const char* begin, const char* end) {
+    while (begin != end && std::isspace(static_cast<unsigned char>(*begin))) {
+        ++begin;
+    }
+    while (end != begin && std::isspace(static_cast<unsigned char>(end[-1]))) {
+        --end;
+    }
+    return std::string(begin, end);
+}
+
+bool isBlank(const char* begin, const char* end) {
+    for (; begin != end; ++begin) {
+        if (!std::isspace(static_cast<unsigned char>(*begin))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Row views: the same validation runs over CSV fields and JSON members
+
+class CsvRow {
+public:
+    CsvRow(const std::unordered_map<std::string, size_t>& columns, const std::vector<std::string>& fields)
+        : columns_(columns), fields_(fields) {
+    }
+
+    bool has(const std::string& name) const {
+        return field(name) != nullptr;
+    }
+
+    std::string text(const std::string& name) const {
+        const std::string* value = field(name);
+        return value ? *value : std::string();
+    }
+
+    double number(const std::string& name) const {
+        const std::string& value = *field(name);
+        char* end = nullptr;
+        errno = 0;
+        const double result = std::strtod(value.c_str(), &end);
+        if (end == value.c_str() || *end != '\0' || errno == ERANGE || !std::isfinite(result)) {
+            throw std::invalid_argument(name + " must be a number");
+        }
+        return result;
+    }
+
+    long long integer(const std::string& name) const {
+        const std::string& value = *field(name);
+        char* end = nullptr;
+        errno = 0;
+        const long long result = std::strtoll(value.c_str(), &end, 10);
+        if (end == value.c_str() || *end != '\0' || errno == ERANGE) {
+            throw std::invalid_argument(name + " must be an integer");
+        }
+        return result;
+    }
+
+private:
+    const std::unordered_map<std::string, size_t>& columns_;
+    const std::vector<std::string>& fields_;
+
+    // Empty cells count as absent
+    const std::string* field(const std::string& name) const {
+        auto it = columns_.find(name);
+        if (it == columns_.end() || fields_[it->second].empty()) {
+            return nullptr;
+        }
+        return &fields_[it->second];
+    }
+};
+
+class JsonRow {
+public:
+    explicit JsonRow(const Json::Value& object) : object_(object) {
+    }
+
+    bool has(const std::string& name) const {
+        return member(name) != nullptr;
+    }
+
+    std::string text(const std::string& name) const {
+        const Json::Value* value = member(name);
+        if (!value) {
+            return std::string();
+        }
+        if (!value->isString()) {
+            throw std::invalid_argument(name + " must be a string");
+        }
+        return value->asString();
+    }
+
+    double number(const std::string& name) const {
+        const Json::Value* value = member(name);
+        if (!value->isNumber() || !std::isfinite(value->asNumber())) {
+            throw std::invalid_argument(name + " must be a number");
+        }
+        return value->asNumber();
+    }
+
+    long long integer(const std::string& name) const {
+        const Json::Value* value = member(name);
+        if (!value->isInteger() || std::abs(value->asNumber()) > 9.0e18) {
+            throw std::invalid_argument(name + " must be an integer");
+        }
+        return static_cast<long long>(value->asNumber());
+    }
+
+private:
+    const Json::Value& object_;
+
+    // Flat names, with the API's nested jump_parameters and fd_grid as fallbacks
+    const Json::Value* member(const std::string& name) const {
+        const Json::Value* value = object_.find(name);
+        if (!value) {
+            static const std::pair<const char*, std::pair<const char*, const char*>> kNested[] = {
+                {"jump_lambda", {"jump_parameters", "lambda"}},
+                {"jump_mean", {"jump_parameters", "mean"}},
+                {"jump_vol", {"jump_parameters", "vol"}},
+                {"fd_space_steps", {"fd_grid", "space_steps"}},
+                {"fd_time_steps", {"fd_grid", "time_steps"}},
+            };
+            for (const auto& nested : kNested) {
+                if (name == nested.first) {
+                    const Json::Value* parent = object_.find(nested.second.first);
+                    value = parent ? parent->find(nested.second.second) : nullptr;
+                    break;
+                }
+            }
+        }
+        return (value && !value->isNull()) ? value : nullptr;
+    }
+};
+
+// ---------------------------------------------------------------------------
+// Row validation, mirroring the API's validate_portfolio_item/create_option
+
+template <typename Row>
+int intField(const Row& row, const std::string& name) {
+    const long long value = row.integer(name);
+    if (value < INT_MIN || value > INT_MAX) {
+        throw std::invalid_argument(name + " is out of range");
+    }
+    return static_cast<int>(value);
+}
+
+template <typename Row>
+Position buildPosition(const Row& row) {
+    for (const char* field : {"type", "strike", "expiry", "asset_id", "quantity"}) {
+        if (!row.has(field)) {
+            throw std::invalid_argument(std::string("missing required field '") + field + "'");
+        }
+    }
+
+    const std::string style = row.has("style") ? lowercase(row.text("style")) : "european";
+    if (style != "european" && style != "american") {
+        throw std::invalid_argument("style must be 'european' or 'american'");
+    }
+
+    const std::string type = lowercase(row.text("type"));
+    if (type != "call" && type != "put") {
+        throw std::invalid_argument("type must be 'call' or 'put'");
+    }
+    const OptionType option_type = type == "call" ? OptionType::Call : OptionType::Put;
+
+    const double strike = row.number("strike");
+    if (strike <= 0.0) {
+        throw std::invalid_argument("strike must be a positive number");
+    }
+    const double expiry = row.number("expiry");
+    if (expiry <= 0.0) {
+        throw std::invalid_argument("expiry must be a positive number");
+    }
+
+    Position position;
+    position.quantity = intField(row, "quantity");
+
+    const std::string asset_id = row.text("asset_id");
+    const std::string trimmed = trim(asset_id.data(), asset_id.data() + asset_id.size());
+    if (trimmed.empty()) {
+        throw std::invalid_argument("asset_id must be a non-empty string");
+    }
+
+    const bool american = style == "american";
+    const std::string model = row.has("pricing_model") ? lowercase(row.text("pricing_model"))
+                                                       : (american ? "binomial" : "blackscholes");
+    if (model != "blackscholes" && model != "binomial" && model != "jumpdiffusion" &&
+        model != "finitedifference" && model != "andersenlakeoffengeld" && model != "baroneadesiwhaley") {
+        throw std::invalid_argument(
+            "pricing_model must be 'blackscholes', 'binomial', 'jumpdiffusion', 'finitedifference', "
+            "'andersenlakeoffengeld', or 'baroneadesiwhaley'"
+        );
+    }
+    if (!american && (model == "andersenlakeoffengeld" || model == "baroneadesiwhaley")) {
+        throw std::invalid_argument("pricing_model '" + model + "' requires style 'american'");
+    }
+
+    const bool has_grid = row.has("fd_space_steps") || row.has("fd_time_steps");
+    const int binomial_steps = row.has("binomial_steps") ? intField(row, "binomial_steps") : 100;
+
+    if (american) {
+        // Models without an American variant fall back to the binomial tree
+        auto option = std::make_unique<AmericanOption>(option_type, strike, expiry, trimmed, binomial_steps);
+        if (model == "finitedifference") {
+            option->setPricingModel(PricingModel::FiniteDifference);
+            if (has_grid) {
+                option->setFiniteDifferenceGrid(
+                    row.has("fd_space_steps") ? intField(row, "fd_space_steps") : option->getFiniteDifferenceSpaceSteps(),
+                    row.has("fd_time_steps") ? intField(row, "fd_time_steps") : option->getFiniteDifferenceTimeSteps()
+                );
+            }
+        } else if (model == "andersenlakeoffengeld") {
+            option->setPricingModel(PricingModel::AndersenLakeOffengeld);
+        } else if (model == "baroneadesiwhaley") {
+            option->setPricingModel(PricingModel::BaroneAdesiWhaley);
+        }
+        position.instrument = std::move(option);
+        return position;
+    }
+
+    PricingModel pricing_model = PricingModel::BlackScholes;
+    if (model == "binomial") {
+        pricing_model = PricingModel::Binomial;
+    } else if (model == "jumpdiffusion") {
+        pricing_model = PricingModel::MertonJumpDiffusion;
+    } else if (model == "finitedifference") {
+        pricing_model = PricingModel::FiniteDifference;
+    }
+
+    auto option = std::make_unique<EuropeanOption>(option_type, strike, expiry, trimmed, pricing_model);
+    if (pricing_model == PricingModel::Binomial) {
+        option->setBinomialSteps(binomial_steps);
+    } else if (pricing_model == PricingModel::MertonJumpDiffusion) {
+        option->setJumpParameters(
+            row.has("jump_lambda") ? row.number("jump_lambda") : 2.0,
+            row.has("jump_mean") ? row.number("jump_mean") : -0.05,
+            row.has("jump_vol") ? row.number("jump_vol") : 0.15
+        );
+    } else if (pricing_model == PricingModel::FiniteDifference && has_grid) {
+        option->setFiniteDifferenceGrid(
+            row.has("fd_space_steps") ? intField(row, "fd_space_steps") : option->getFiniteDifferenceSpaceSteps(),
+            row.has("fd_time_steps") ? intField(row, "fd_time_steps") : option->getFiniteDifferenceTimeSteps()
+        );
+    }
+    position.instrument = std::move(option);
+    return position;
+}
+
+template <typename Row>
+MarketData buildMarketData(const Row& row) {
+    if (!row.has("asset_id")) {
+        throw std::invalid_argument("missing required field 'asset_id'");
+    }
+    const std::string asset_id = row.text("asset_id");
+    const std::string trimmed = trim(asset_id.data(), asset_id.data() + asset_id.size());
+    if (trimmed.empty()) {
+        throw std::invalid_argument("asset_id must be a non-empty string");
+    }
+    for (const char* field : {"spot", "rate", "vol"}) {
+        if (!row.has(field)) {
+            throw std::invalid_argument(
+                "Market data for '" + trimmed + "': missing required field '" + field + "'"
+            );
+        }
+    }
+
+    const double spot = row.number("spot");
+    if (spot <= 0.0) {
+        throw std::invalid_argument("Market data for '" + trimmed + "': spot must be a positive number");
+    }
+    const double rate = row.number("rate");
+    const double vol = row.number("vol");
+    if (vol < 0.0) {
+        throw std::invalid_argument("Market data for '" + trimmed + "': vol must be a non-negative number");
+    }
+    const double dividend = row.has("dividend") ? row.number("dividend") : 0.0;
+    if (dividend < 0.0) {
+        throw std::invalid_argument("Market data for '" + trimmed + "': dividend must be a non-negative number");
+    }
+    return MarketData(trimmed, spot, rate, vol, dividend);
+}
+
+// ---------------------------------------------------------------------------
+// Line parsers
+
+// Splits one CSV record; "" inside quotes is a literal quote
+std::vector<std::string> splitCsv(const char* begin, const char* end) {
+    std::vector<std::string> fields;
+    const char* pos = begin;
+    while (true) {
+        while (pos != end && (*pos == ' ' || *pos == '\t')) {
+            ++pos;
+        }
+        std::string field;
+        if (pos != end && *pos == '"') {
+            ++pos;
+            while (true) {
+                if (pos == end) {
+                    throw std::invalid_argument("unterminated quoted field");
+                }
+                if (*pos == '"') {
+                    if (pos + 1 != end && pos[1] == '"') {
+                        field += '"';
+                        pos += 2;
+                        continue;
+                    }
+                    ++pos;
+                    break;
+                }
+                field += *pos++;
+            }
+            while (pos != end && (*pos == ' ' || *pos == '\t' || *pos == '\r')) {
+                ++pos;
+            }
+            if (pos != end && *pos != ',') {
+                throw std::invalid_argument("unexpected characters after quoted field");
+            }
+        } else {
+            const char* start = pos;
+            while (pos != end && *pos != ',') {
+                ++pos;
+            }
+            field = trim(start, pos);
+        }
+        fields.push_back(std::move(field));
+        if (pos == end) {
+            return fields;
+        }
+        ++pos;
+    }
+}
+
+struct CsvHeader {
+    std::unordered_map<std::string, size_t> columns;
+    size_t width = 0;
+};
+
+template <typename Item, typename Build>
+Item parseCsvLine(const CsvHeader& header, const char* begin, const char* end, Build build) {
+    const std::vector<std::string> fields = splitCsv(begin, end);
+    if (fields.size() != header.width) {
+        throw std::invalid_argument(
+            "expected " + std::to_string(header.width) + " fields, found " + std::to_string(fields.size())
+        );
+    }
+    return build(CsvRow(header.columns, fields));
+}
+
+template <typename Item, typename Build>
+Item parseJsonLine(const char* begin, const char* end, Build build) {
+    const Json::Value value = Json::parse(begin, end);
+    if (!value.isObject()) {
+        throw std::invalid_argument("row must be a JSON object");
+    }
+    return build(JsonRow(value));
+}
+
+// ---------------------------------------------------------------------------
+// Chunked parallel driver
+
+template <typename Item>
+struct ChunkResult {
+    std::vector<std::pair<size_t, Item>> rows;      // line, item
+    std::vector<RowError> errors;
+    size_t lines = 0;
+    size_t rows_read = 0;
+};
+
+// Parses [begin, end) line by line. Line numbers are relative to the chunk
+// until the caller offsets them.
+template <typename Item, typename ParseLine>
+void parseChunk(const char* begin, const char* end, ParseLine& parse_line, ChunkResult<Item>& result) {
+    const char* line = begin;
+    while (line != end) {
+        const char* newline = static_cast<const char*>(std::memchr(line, '\n', end - line));
+        const char* line_end = newline ? newline : end;
+        ++result.lines;
+        if (!isBlank(line, line_end)) {
+            ++result.rows_read;
+            try {
+                result.rows.emplace_back(result.lines, parse_line(line, line_end));
+            } catch (const std::invalid_argument& e) {
+                result.errors.push_back({result.lines, e.what()});
+            }
+        }
+        line = newline ? newline + 1 : end;
+    }
+}
+
+unsigned resolveThreads(unsigned threads) {
+    if (threads == 0) {
+        threads = std::thread::hardware_concurrency();
+    }
+    return std::max(threads, 1u);
+}
+
+// Splits [begin, end) at line boundaries into at most `threads` chunks and
+// parses them concurrently; `first_line` is the line number of `begin`
+template <typename Item, typename ParseLine>
+std::vector<ChunkResult<Item>> parseParallel(
+    const char* begin, const char* end, size_t first_line, unsigned threads, ParseLine parse_line
+) {
+    const size_t bytes = static_cast<size_t>(end - begin);
+    const size_t max_chunks = std::max<size_t>(1, bytes / kMinChunkBytes);
+    const size_t chunk_count = std::min<size_t>(resolveThreads(threads), max_chunks);
+
+    std::vector<std::pair<const char*, const char*>> chunks;
+    const char* start = begin;
+    for (size_t c = 1; c <= chunk_count && start != end; ++c) {
+        const char* stop = end;
+        if (c < chunk_count) {
+            const char* target = begin + bytes * c / chunk_count;
+            if (target < start) {
+                target = start;
+            }
+            const char* newline = static_cast<const char*>(std::memchr(target, '\n', end - target));
+            stop = newline ? newline + 1 : end;
+        }
+        chunks.emplace_back(start, stop);
+        start = stop;
+    }
+
+    std::vector<ChunkResult<Item>> results(chunks.size());
+    if (chunks.size() <= 1) {
+        for (size_t c = 0; c < chunks.size(); ++c) {
+            parseChunk(chunks[c].first, chunks[c].second, parse_line, results[c]);
+        }
+    } else {
+        std::vector<std::exception_ptr> failures(chunks.size());
+        std::vector<std::thread> workers;
+        workers.reserve(chunks.size());
+        for (size_t c = 0; c < chunks.size(); ++c) {
+            workers.emplace_back([&, c]() {
+                try {
+                    parseChunk(chunks[c].first, chunks[c].second, parse_line, results[c]);
+                } catch (...) {
+                    failures[c] = std::current_exception();
+                }
+            });
+        }
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+        for (const std::exception_ptr& failure : failures) {
+            if (failure) {
+                std::rethrow_exception(failure);
+            }
+        }
+    }
+
+    size_t line_offset = first_line - 1;
+    for (ChunkResult<Item>& result : results) {
+        for (auto& row : result.rows) {
+            row.first += line_offset;
+        }
+        for (RowError& error : result.errors) {
+            error.line += line_offset;
+        }
+        line_offset += result.lines;
+    }
+    return results;
+}
+
+// Reads the CSV header (the first non-blank line) and returns where the data starts
+const char* readCsvHeader(const char* begin, const char* end, size_t& line,
+                          const std::vector<std::string>& required, CsvHeader& header) {
+    line = 1;
+    const char* pos = begin;
+    while (pos != end) {
+        const char* newline = static_cast<const char*>(std::memchr(pos, '\n', end - pos));
+        const char* line_end = newline ? newline : end;
+        const char* next = newline ? newline + 1 : end;
+        if (!isBlank(pos, line_end)) {
+            std::vector<std::string> names = splitCsv(pos, line_end);
+            for (size_t i = 0; i < names.size(); ++i) {
+                if (!header.columns.emplace(lowercase(names[i]), i).second) {
+                    throw std::invalid_argument("CSV header has duplicate column '" + names[i] + "'");
+                }
+            }
+            header.width = names.size();
+            for (const std::string& name : required) {
+                if (!header.columns.count(name)) {
+                    throw std::invalid_argument("CSV header is missing required column '" + name + "'");
+                }
+            }
+            ++line;
+            return next;
+        }
+        ++line;
+        pos = next;
+    }
+    throw std::invalid_argument("CSV input has no header row");
+}
+
+template <typename Item, typename Build>
+std::vector<ChunkResult<Item>> parseRows(
+    const std::string& text, Format format, unsigned threads,
+    const std::vector<std::string>& required, Build build
+) {
+    const char* begin = text.data();
+    const char* end = begin + text.size();
+
+    if (format == Format::JsonLines) {
+        return parseParallel<Item>(begin, end, 1, threads, [&](const char* b, const char* e) {
+            return parseJsonLine<Item>(b, e, build);
+        });
+    }
+
+    CsvHeader header;
+    size_t first_line = 1;
+    const char* data = readCsvHeader(begin, end, first_line, required, header);
+    return parseParallel<Item>(data, end, first_line, threads, [&](const char* b, const char* e) {
+        return parseCsvLine<Item>(header, b, e, build);
+    });
+}
+
+void sortErrors(std::vector<RowError>& errors) {
+    std::stable_sort(errors.begin(), errors.end(),
+                     [](const RowError& a, const RowError& b) { return a.line < b.line; });
+}
+
+std::string readFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("Cannot open input file " + path);
+    }
+    std::ostringstream contents;
+    contents << in.rdbuf();
+    if (in.bad()) {
+        throw std::runtime_error("Cannot read input file " + path);
+    }
+    return contents.str();
+}
+
+} // namespace
+
+PortfolioData parsePortfolio(const std::string& text, Format format, unsigned threads) {
+    auto chunks = parseRows<Position>(
+        text, format, threads, {"type", "strike", "expiry", "asset_id", "quantity"},
+        [](const auto& row) { return buildPosition(row); }
+    );
+
+    PortfolioData data;
+    size_t total = 0;
+    for (const auto& chunk : chunks) {
+        total += chunk.rows.size();
+    }
+    data.portfolio.reserve(total);
+
+    // Added serially in input order, so handles and netting match a
+    // single-threaded load
+    for (auto& chunk : chunks) {
+        data.rows_read += chunk.rows_read;
+        for (auto& [line, position] : chunk.rows) {
+            try {
+                data.portfolio.addInstrument(std::move(position.instrument), position.quantity);
+            } catch (const std::invalid_argument& e) {
+                data.errors.push_back({line, e.what()});
+            }
+        }
+        data.errors.insert(data.errors.end(), chunk.errors.begin(), chunk.errors.end());
+    }
+    sortErrors(data.errors);
+    return data;
+}
+
+MarketDataSet parseMarketData(const std::string& text, Format format, unsigned threads) {
+    auto chunks = parseRows<MarketData>(
+        text, format, threads, {"asset_id", "spot", "rate", "vol"},
+        [](const auto& row) { return buildMarketData(row); }
+    );
+
+    MarketDataSet data;
+    for (auto& chunk : chunks) {
+        data.rows_read += chunk.rows_read;
+        for (auto& [line, md] : chunk.rows) {
+            const std::string asset_id = md.asset_id;
+            if (!data.market_data.emplace(asset_id, std::move(md)).second) {
+                data.errors.push_back({line, "duplicate market data for '" + asset_id + "'"});
+            }
+        }
+        data.errors.insert(data.errors.end(), chunk.errors.begin(), chunk.errors.end());
+    }
+    sortErrors(data.errors);
+    return data;
+}
+
+Position positionFromJson(const Json::Value& item) {
+    if (!item.isObject()) {
+        throw std::invalid_argument("row must be a JSON object");
+    }
+    return buildPosition(JsonRow(item));
+}
+
+MarketData marketDataFromJson(const std::string& asset_id, const Json::Value& record) {
+    if (!record.isObject()) {
+        throw std::invalid_argument("Market data for '" + asset_id + "' must be an object");
+    }
+    Json::Value::Object members = record.asObject();
+    members.erase(std::remove_if(members.begin(), members.end(),
+                                 [](const auto& member) { return member.first == "asset_id"; }),
+                  members.end());
+    members.emplace_back("asset_id", Json::Value::string(asset_id));
+    const Json::Value row = Json::Value::object(std::move(members));
+    return buildMarketData(JsonRow(row));
+}
+
+Format formatFromPath(const std::string& path) {
+    const size_t dot = path.find_last_of('.');
+    const std::string extension = dot == std::string::npos ? "" : lowercase(path.substr(dot));
+    if (extension == ".csv") {
+        return Format::Csv;
+    }
+    if (extension == ".jsonl" || extension == ".ndjson") {
+        return Format::JsonLines;
+    }
+    throw std::invalid_argument("Unsupported input file extension for " + path);
+}
+
+PortfolioData loadPortfolio(const std::string& path, unsigned threads) {
+    const Format format = formatFromPath(path);
+    return parsePortfolio(readFile(path), format, threads);
+}
+
+MarketDataSet loadMarketData(const std::string& path, unsigned threads) {
+    const Format format = formatFromPath(path);
+    return parseMarketData(readFile(path), format, threads);
+}
+
+} // namespace Ingestion
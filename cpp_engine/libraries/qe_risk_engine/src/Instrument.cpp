@@ -1,18 +1,35 @@
 #include "Instrument.h"
+#include "AndersenLakeOffengeld.h"
+#include "BaroneAdesiWhaley.h"
 #include "BinomialTree.h"
 #include "BlackScholes.h"
+#include "FiniteDifference.h"
 #include "JumpDiffusion.h"
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <limits>
 
 
+InstrumentGreeks Instrument::greeks(const MarketData &md) const {
+  InstrumentGreeks result;
+  result.price = price(md);
+  result.delta = delta(md);
+  result.gamma = gamma(md);
+  result.vega = vega(md);
+  result.theta = theta(md);
+  return result;
+}
+
 EuropeanOption::EuropeanOption(OptionType type, double strike,
                                double time_to_expiry, std::string asset_id)
     : option_type_(type), strike_price_(strike),
       time_to_expiry_years_(time_to_expiry), underlying_asset_id_(asset_id),
       pricing_model_(PricingModel::BlackScholes), binomial_steps_(100),
-      jump_intensity_(0.0), jump_mean_(0.0), jump_volatility_(0.0) {
+      jump_intensity_(0.0), jump_mean_(0.0), jump_volatility_(0.0),
+      fd_space_steps_(FiniteDifference::GridSettings().space_steps),
+      fd_time_steps_(FiniteDifference::GridSettings().time_steps) {
   validateParameters();
 }
 
@@ -22,7 +39,9 @@ EuropeanOption::EuropeanOption(OptionType type, double strike,
     : option_type_(type), strike_price_(strike),
       time_to_expiry_years_(time_to_expiry), underlying_asset_id_(asset_id),
       pricing_model_(model), binomial_steps_(100), jump_intensity_(0.0),
-      jump_mean_(0.0), jump_volatility_(0.0) {
+      jump_mean_(0.0), jump_volatility_(0.0),
+      fd_space_steps_(FiniteDifference::GridSettings().space_steps),
+      fd_time_steps_(FiniteDifference::GridSettings().time_steps) {
   validateParameters();
 }
 
@@ -75,6 +94,77 @@ std::string EuropeanOption::getInstrumentType() const {
   return "EuropeanOption";
 }
 
+namespace {
+
+// Fields are written as the hex of their bit patterns, so only bit-identical
+// terms share a key; the free-form asset id goes last so that it cannot be
+// confused with the fixed-width fields before it. Built by hand rather than
+// through a stream, since every row added to a portfolio needs its key.
+class ContractKey {
+public:
+  ContractKey(const std::string &instrument_type, OptionType type,
+              double strike, double expiry, PricingModel model) {
+    key_.reserve(128);
+    key_ += instrument_type;
+    add(static_cast<int>(type));
+    add(strike);
+    add(expiry);
+    add(static_cast<int>(model));
+  }
+
+  void add(double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    appendHex(bits, 16);
+  }
+
+  void add(int value) { appendHex(static_cast<uint32_t>(value), 8); }
+
+  std::string finish(const std::string &asset_id) {
+    key_ += '|';
+    key_ += asset_id;
+    return std::move(key_);
+  }
+
+private:
+  std::string key_;
+
+  void appendHex(uint64_t bits, int digits) {
+    static const char kDigits[] = "0123456789abcdef";
+    char buffer[17];
+    buffer[0] = '|';
+    for (int i = digits; i > 0; --i) {
+      buffer[i] = kDigits[bits & 0xF];
+      bits >>= 4;
+    }
+    key_.append(buffer, digits + 1);
+  }
+};
+
+} // namespace
+
+std::string EuropeanOption::getContractKey() const {
+  ContractKey key(getInstrumentType(), option_type_, strike_price_,
+                  time_to_expiry_years_, pricing_model_);
+  switch (pricing_model_) {
+  case PricingModel::Binomial:
+    key.add(binomial_steps_);
+    break;
+  case PricingModel::MertonJumpDiffusion:
+    key.add(jump_intensity_);
+    key.add(jump_mean_);
+    key.add(jump_volatility_);
+    break;
+  case PricingModel::FiniteDifference:
+    key.add(fd_space_steps_);
+    key.add(fd_time_steps_);
+    break;
+  default:
+    break;
+  }
+  return key.finish(underlying_asset_id_);
+}
+
 void EuropeanOption::setPricingModel(PricingModel model) {
   pricing_model_ = model;
 }
@@ -105,6 +195,45 @@ void EuropeanOption::setJumpParameters(double lambda, double jump_mean,
 
 double EuropeanOption::getJumpIntensity() const { return jump_intensity_; }
 
+double EuropeanOption::getJumpMean() const { return jump_mean_; }
+
+double EuropeanOption::getJumpVolatility() const { return jump_volatility_; }
+
+namespace {
+
+FiniteDifference::GridSettings makeGridSettings(int space_steps,
+                                                int time_steps) {
+  FiniteDifference::GridSettings settings;
+  settings.space_steps = space_steps;
+  settings.time_steps = time_steps;
+  return settings;
+}
+
+} // namespace
+
+void EuropeanOption::setFiniteDifferenceGrid(int space_steps, int time_steps) {
+  FiniteDifference::validateSettings(makeGridSettings(space_steps, time_steps));
+  fd_space_steps_ = space_steps;
+  fd_time_steps_ = time_steps;
+}
+
+int EuropeanOption::getFiniteDifferenceSpaceSteps() const {
+  return fd_space_steps_;
+}
+
+int EuropeanOption::getFiniteDifferenceTimeSteps() const {
+  return fd_time_steps_;
+}
+
+FiniteDifference::SolutionSlice
+EuropeanOption::solveFiniteDifference(const MarketData &md) const {
+  validateMarketData(md);
+  return FiniteDifference::solve(
+      md.spot_price, strike_price_, md.risk_free_rate, time_to_expiry_years_,
+      md.volatility, option_type_, false,
+      makeGridSettings(fd_space_steps_, fd_time_steps_));
+}
+
 OptionType EuropeanOption::getOptionType() const { return option_type_; }
 
 double EuropeanOption::getStrike() const { return strike_price_; }
@@ -136,6 +265,14 @@ double EuropeanOption::priceJumpDiffusion(const MarketData &md) const {
       jump_volatility_);
 }
 
+InstrumentGreeks
+EuropeanOption::greeksJumpDiffusion(const MarketData &md) const {
+  return JumpDiffusion::mertonOptionGreeks(
+      md.spot_price, strike_price_, md.risk_free_rate, time_to_expiry_years_,
+      md.volatility, option_type_, jump_intensity_, jump_mean_,
+      jump_volatility_);
+}
+
 double EuropeanOption::price(const MarketData &md) const {
   validateMarketData(md);
 
@@ -151,6 +288,9 @@ double EuropeanOption::price(const MarketData &md) const {
   case PricingModel::MertonJumpDiffusion:
     result = priceJumpDiffusion(md);
     break;
+  case PricingModel::FiniteDifference:
+    result = solveFiniteDifference(md).price(md.spot_price);
+    break;
   default:
     throw std::runtime_error("Unknown pricing model");
   }
@@ -195,6 +335,10 @@ double EuropeanOption::delta(const MarketData &md) const {
 
   if (pricing_model_ == PricingModel::BlackScholes) {
     result = deltaBlackScholes(md);
+  } else if (pricing_model_ == PricingModel::FiniteDifference) {
+    result = solveFiniteDifference(md).delta(md.spot_price);
+  } else if (pricing_model_ == PricingModel::MertonJumpDiffusion) {
+    result = greeksJumpDiffusion(md).delta;
   } else {
     result = deltaNumerical(md);
   }
@@ -215,6 +359,10 @@ double EuropeanOption::gamma(const MarketData &md) const {
     result =
         BlackScholes::gamma(md.spot_price, strike_price_, md.risk_free_rate,
                             time_to_expiry_years_, md.volatility);
+  } else if (pricing_model_ == PricingModel::FiniteDifference) {
+    result = solveFiniteDifference(md).gamma(md.spot_price);
+  } else if (pricing_model_ == PricingModel::MertonJumpDiffusion) {
+    result = greeksJumpDiffusion(md).gamma;
   } else {
     const double bump = md.spot_price * 0.01;
 
@@ -244,6 +392,8 @@ double EuropeanOption::vega(const MarketData &md) const {
   if (pricing_model_ == PricingModel::BlackScholes) {
     result = BlackScholes::vega(md.spot_price, strike_price_, md.risk_free_rate,
                                 time_to_expiry_years_, md.volatility);
+  } else if (pricing_model_ == PricingModel::MertonJumpDiffusion) {
+    result = greeksJumpDiffusion(md).vega;
   } else {
     const double bump = 0.01;
 
@@ -280,6 +430,8 @@ double EuropeanOption::theta(const MarketData &md) const {
                                       md.risk_free_rate, time_to_expiry_years_,
                                       md.volatility);
     }
+  } else if (pricing_model_ == PricingModel::MertonJumpDiffusion) {
+    result = greeksJumpDiffusion(md).theta;
   } else {
     const double bump = 1.0 / 365.0;
 
@@ -304,14 +456,146 @@ double EuropeanOption::theta(const MarketData &md) const {
   return result;
 }
 
+InstrumentGreeks EuropeanOption::greeks(const MarketData &md) const {
+  if (pricing_model_ == PricingModel::MertonJumpDiffusion) {
+    validateMarketData(md);
+    InstrumentGreeks result = greeksJumpDiffusion(md);
+    if (std::isnan(result.price) || std::isinf(result.price) ||
+        result.price < 0.0) {
+      throw std::runtime_error("Invalid option price calculated");
+    }
+    if (std::isnan(result.delta) || std::isinf(result.delta) ||
+        std::isnan(result.gamma) || std::isinf(result.gamma) ||
+        std::isnan(result.vega) || std::isinf(result.vega) ||
+        std::isnan(result.theta) || std::isinf(result.theta)) {
+      throw std::runtime_error("Invalid greeks calculated");
+    }
+    return result;
+  }
+
+  if (pricing_model_ == PricingModel::FiniteDifference) {
+    const FiniteDifference::SolutionSlice slice = solveFiniteDifference(md);
+    InstrumentGreeks result;
+    result.price = slice.price(md.spot_price);
+    result.delta = slice.delta(md.spot_price);
+    result.gamma = slice.gamma(md.spot_price);
+    result.vega = vega(md);
+    result.theta = theta(md);
+    return result;
+  }
+
+  return Instrument::greeks(md);
+}
+
 std::string EuropeanOption::getAssetId() const { return underlying_asset_id_; }
 
+namespace {
+
+void validateJumpDiffusionBatch(
+    const std::vector<const EuropeanOption *> &options) {
+  if (options.empty()) {
+    return;
+  }
+  const EuropeanOption *first = options.front();
+  for (const EuropeanOption *option : options) {
+    if (!option) {
+      throw std::invalid_argument("European option batch contains null option");
+    }
+    if (option->getPricingModel() != PricingModel::MertonJumpDiffusion) {
+      throw std::invalid_argument(
+          "European option batch requires jump diffusion pricing");
+    }
+    if (option->getTimeToExpiry() != first->getTimeToExpiry() ||
+        option->getJumpIntensity() != first->getJumpIntensity() ||
+        option->getJumpMean() != first->getJumpMean() ||
+        option->getJumpVolatility() != first->getJumpVolatility()) {
+      throw std::invalid_argument(
+          "European option batch requires identical expiry and jump parameters");
+    }
+  }
+}
+
+void splitChain(const std::vector<const EuropeanOption *> &options,
+                std::vector<double> &strikes, std::vector<OptionType> &types) {
+  strikes.reserve(options.size());
+  types.reserve(options.size());
+  for (const EuropeanOption *option : options) {
+    strikes.push_back(option->getStrike());
+    types.push_back(option->getOptionType());
+  }
+}
+
+} // namespace
+
+std::vector<double>
+EuropeanOption::priceBatch(const std::vector<const EuropeanOption *> &options,
+                           const MarketData &md) {
+  validateJumpDiffusionBatch(options);
+  if (options.empty()) {
+    return {};
+  }
+  const EuropeanOption &first = *options.front();
+  first.validateMarketData(md);
+
+  std::vector<double> strikes;
+  std::vector<OptionType> types;
+  splitChain(options, strikes, types);
+
+  std::vector<double> results = JumpDiffusion::mertonOptionPrices(
+      md.spot_price, strikes, types, md.risk_free_rate,
+      first.time_to_expiry_years_, md.volatility, first.jump_intensity_,
+      first.jump_mean_, first.jump_volatility_);
+
+  for (double result : results) {
+    if (std::isnan(result) || std::isinf(result) || result < 0.0) {
+      throw std::runtime_error("Invalid option price calculated");
+    }
+  }
+
+  return results;
+}
+
+std::vector<InstrumentGreeks>
+EuropeanOption::greeksBatch(const std::vector<const EuropeanOption *> &options,
+                            const MarketData &md) {
+  validateJumpDiffusionBatch(options);
+  if (options.empty()) {
+    return {};
+  }
+  const EuropeanOption &first = *options.front();
+  first.validateMarketData(md);
+
+  std::vector<double> strikes;
+  std::vector<OptionType> types;
+  splitChain(options, strikes, types);
+
+  std::vector<InstrumentGreeks> results = JumpDiffusion::mertonOptionGreeks(
+      md.spot_price, strikes, types, md.risk_free_rate,
+      first.time_to_expiry_years_, md.volatility, first.jump_intensity_,
+      first.jump_mean_, first.jump_volatility_);
+
+  for (const InstrumentGreeks &g : results) {
+    if (std::isnan(g.price) || std::isinf(g.price) || g.price < 0.0) {
+      throw std::runtime_error("Invalid option price calculated");
+    }
+    if (std::isnan(g.delta) || std::isinf(g.delta) || std::isnan(g.gamma) ||
+        std::isinf(g.gamma) || std::isnan(g.vega) || std::isinf(g.vega) ||
+        std::isnan(g.theta) || std::isinf(g.theta)) {
+      throw std::runtime_error("Invalid greeks calculated");
+    }
+  }
+
+  return results;
+}
+
 AmericanOption::AmericanOption(OptionType type, double strike,
                                double time_to_expiry, std::string asset_id,
                                int binomial_steps)
     : option_type_(type), strike_price_(strike),
       time_to_expiry_years_(time_to_expiry), underlying_asset_id_(asset_id),
-      binomial_steps_(binomial_steps) {
+      binomial_steps_(binomial_steps), pricing_model_(PricingModel::Binomial),
+      fd_space_steps_(FiniteDifference::GridSettings().space_steps),
+      fd_time_steps_(FiniteDifference::GridSettings().time_steps) {
   validateParameters();
 }
 
@@ -352,6 +636,23 @@ std::string AmericanOption::getInstrumentType() const {
   return "AmericanOption";
 }
 
+std::string AmericanOption::getContractKey() const {
+  ContractKey key(getInstrumentType(), option_type_, strike_price_,
+                  time_to_expiry_years_, pricing_model_);
+  switch (pricing_model_) {
+  case PricingModel::Binomial:
+    key.add(binomial_steps_);
+    break;
+  case PricingModel::FiniteDifference:
+    key.add(fd_space_steps_);
+    key.add(fd_time_steps_);
+    break;
+  default:
+    break;
+  }
+  return key.finish(underlying_asset_id_);
+}
+
 void AmericanOption::setBinomialSteps(int steps) {
   if (steps < 1 || steps > 10000) {
     throw std::invalid_argument("Binomial steps must be between 1 and 10000");
@@ -361,6 +662,83 @@ void AmericanOption::setBinomialSteps(int steps) {
 
 int AmericanOption::getBinomialSteps() const { return binomial_steps_; }
 
+void AmericanOption::setPricingModel(PricingModel model) {
+  if (model != PricingModel::Binomial &&
+      model != PricingModel::FiniteDifference &&
+      model != PricingModel::AndersenLakeOffengeld &&
+      model != PricingModel::BaroneAdesiWhaley) {
+    throw std::invalid_argument(
+        "American options support Binomial, FiniteDifference, "
+        "AndersenLakeOffengeld and BaroneAdesiWhaley pricing");
+  }
+  pricing_model_ = model;
+}
+
+PricingModel AmericanOption::getPricingModel() const { return pricing_model_; }
+
+void AmericanOption::setFiniteDifferenceGrid(int space_steps, int time_steps) {
+  FiniteDifference::validateSettings(makeGridSettings(space_steps, time_steps));
+  fd_space_steps_ = space_steps;
+  fd_time_steps_ = time_steps;
+}
+
+int AmericanOption::getFiniteDifferenceSpaceSteps() const {
+  return fd_space_steps_;
+}
+
+int AmericanOption::getFiniteDifferenceTimeSteps() const {
+  return fd_time_steps_;
+}
+
+FiniteDifference::SolutionSlice
+AmericanOption::solveFiniteDifference(const MarketData &md) const {
+  validateMarketData(md);
+  return FiniteDifference::solve(
+      md.spot_price, strike_price_, md.risk_free_rate, time_to_expiry_years_,
+      md.volatility, option_type_, true,
+      makeGridSettings(fd_space_steps_, fd_time_steps_));
+}
+
+AndersenLakeOffengeld::ExerciseBoundary
+AmericanOption::exerciseBoundary(const MarketData &md) const {
+  validateMarketData(md);
+  return AndersenLakeOffengeld::ExerciseBoundary(
+      md.risk_free_rate, time_to_expiry_years_, md.volatility);
+}
+
+BaroneAdesiWhaley::QuadraticApproximation
+AmericanOption::quadraticApproximation(const MarketData &md) const {
+  validateMarketData(md);
+  return BaroneAdesiWhaley::QuadraticApproximation(
+      strike_price_, md.risk_free_rate, time_to_expiry_years_, md.volatility,
+      option_type_);
+}
+
+std::function<double(double)>
+AmericanOption::spotPricer(const MarketData &md) const {
+  switch (pricing_model_) {
+  case PricingModel::AndersenLakeOffengeld: {
+    auto boundary = std::make_shared<AndersenLakeOffengeld::ExerciseBoundary>(
+        exerciseBoundary(md));
+    return [this, boundary](double spot) {
+      return boundary->price(spot, strike_price_, option_type_);
+    };
+  }
+  case PricingModel::BaroneAdesiWhaley: {
+    auto approximation =
+        std::make_shared<BaroneAdesiWhaley::QuadraticApproximation>(
+            quadraticApproximation(md));
+    return [approximation](double spot) { return approximation->price(spot); };
+  }
+  default:
+    return [this, md](double spot) {
+      MarketData shifted = md;
+      shifted.spot_price = spot;
+      return price(shifted);
+    };
+  }
+}
+
 double AmericanOption::calculateIntrinsicValue(double spot_price) const {
   if (option_type_ == OptionType::Call) {
     return std::max(0.0, spot_price - strike_price_);
@@ -372,9 +750,27 @@ double AmericanOption::calculateIntrinsicValue(double spot_price) const {
 double AmericanOption::price(const MarketData &md) const {
   validateMarketData(md);
 
-  double result = BinomialTree::americanOptionPrice(
-      md.spot_price, strike_price_, md.risk_free_rate, time_to_expiry_years_,
-      md.volatility, option_type_, binomial_steps_);
+  double result = 0.0;
+
+  switch (pricing_model_) {
+  case PricingModel::FiniteDifference:
+    result = solveFiniteDifference(md).price(md.spot_price);
+    break;
+  case PricingModel::AndersenLakeOffengeld:
+    result = exerciseBoundary(md).price(md.spot_price, strike_price_,
+                                        option_type_);
+    break;
+  case PricingModel::BaroneAdesiWhaley:
+    result = BaroneAdesiWhaley::americanOptionPrice(
+        md.spot_price, strike_price_, md.risk_free_rate, time_to_expiry_years_,
+        md.volatility, option_type_);
+    break;
+  default:
+    result = BinomialTree::americanOptionPrice(
+        md.spot_price, strike_price_, md.risk_free_rate, time_to_expiry_years_,
+        md.volatility, option_type_, binomial_steps_);
+    break;
+  }
 
   if (std::isnan(result) || std::isinf(result) || result < 0.0) {
     throw std::runtime_error("Invalid American option price calculated");
@@ -386,15 +782,19 @@ double AmericanOption::price(const MarketData &md) const {
 double AmericanOption::delta(const MarketData &md) const {
   validateMarketData(md);
 
-  const double bump = md.spot_price * 0.01;
+  if (pricing_model_ == PricingModel::FiniteDifference) {
+    double result = solveFiniteDifference(md).delta(md.spot_price);
+    if (std::isnan(result) || std::isinf(result)) {
+      throw std::runtime_error("Invalid delta calculated");
+    }
+    return result;
+  }
 
-  MarketData md_up = md;
-  MarketData md_down = md;
-  md_up.spot_price = md.spot_price + bump;
-  md_down.spot_price = md.spot_price - bump;
+  const auto price_at = spotPricer(md);
+  const double bump = md.spot_price * 0.01;
 
-  double price_up = price(md_up);
-  double price_down = price(md_down);
+  double price_up = price_at(md.spot_price + bump);
+  double price_down = price_at(md.spot_price - bump);
 
   double result = (price_up - price_down) / (2.0 * bump);
 
@@ -408,15 +808,25 @@ double AmericanOption::delta(const MarketData &md) const {
 double AmericanOption::gamma(const MarketData &md) const {
   validateMarketData(md);
 
-  const double bump = md.spot_price * 0.01;
+  if (pricing_model_ == PricingModel::FiniteDifference) {
+    double result = solveFiniteDifference(md).gamma(md.spot_price);
+    if (std::isnan(result) || std::isinf(result)) {
+      throw std::runtime_error("Invalid gamma calculated");
+    }
+    return result;
+  }
 
-  MarketData md_up = md;
-  MarketData md_down = md;
-  md_up.spot_price = md.spot_price + bump;
-  md_down.spot_price = md.spot_price - bump;
+  // Same nested bumps as delta(md_up) - delta(md_down)
+  const auto price_at = spotPricer(md);
+  auto delta_at = [&price_at](double spot) {
+    const double bump = spot * 0.01;
+    return (price_at(spot + bump) - price_at(spot - bump)) / (2.0 * bump);
+  };
 
-  double delta_up = delta(md_up);
-  double delta_down = delta(md_down);
+  const double bump = md.spot_price * 0.01;
+
+  double delta_up = delta_at(md.spot_price + bump);
+  double delta_down = delta_at(md.spot_price - bump);
 
   double result = (delta_up - delta_down) / (2.0 * bump);
 
@@ -474,4 +884,215 @@ double AmericanOption::theta(const MarketData &md) const {
   return result;
 }
 
-std::string AmericanOption::getAssetId() const { return underlying_asset_id_; }
\ No newline at end of file
+InstrumentGreeks AmericanOption::greeks(const MarketData &md) const {
+  if (pricing_model_ == PricingModel::FiniteDifference) {
+    const FiniteDifference::SolutionSlice slice = solveFiniteDifference(md);
+    InstrumentGreeks result;
+    result.price = slice.price(md.spot_price);
+    result.delta = slice.delta(md.spot_price);
+    result.gamma = slice.gamma(md.spot_price);
+    result.vega = vega(md);
+    result.theta = theta(md);
+    return result;
+  }
+
+  return Instrument::greeks(md);
+}
+
+std::string AmericanOption::getAssetId() const { return underlying_asset_id_; }
+
+OptionType AmericanOption::getOptionType() const { return option_type_; }
+
+double AmericanOption::getStrike() const { return strike_price_; }
+
+double AmericanOption::getTimeToExpiry() const { return time_to_expiry_years_; }
+
+namespace {
+
+void validateAmericanBatch(const std::vector<const AmericanOption *> &options) {
+  if (options.empty()) {
+    return;
+  }
+  const AmericanOption *first = options.front();
+  for (const AmericanOption *option : options) {
+    if (!option) {
+      throw std::invalid_argument("American option batch contains null option");
+    }
+    if (option->getPricingModel() != first->getPricingModel() ||
+        (option->getPricingModel() != PricingModel::Binomial &&
+         option->getPricingModel() != PricingModel::AndersenLakeOffengeld)) {
+      throw std::invalid_argument("American option batch requires binomial or "
+                                  "AndersenLakeOffengeld pricing throughout");
+    }
+    if (option->getTimeToExpiry() != first->getTimeToExpiry() ||
+        (option->getPricingModel() == PricingModel::Binomial &&
+         option->getBinomialSteps() != first->getBinomialSteps())) {
+      throw std::invalid_argument(
+          "American option batch requires identical expiry and binomial steps");
+    }
+  }
+}
+
+} // namespace
+
+std::vector<double>
+AmericanOption::priceLattice(const std::vector<const AmericanOption *> &options,
+                             const MarketData &md, double time_to_expiry) {
+  std::vector<double> strikes;
+  std::vector<OptionType> types;
+  strikes.reserve(options.size());
+  types.reserve(options.size());
+  for (const AmericanOption *option : options) {
+    strikes.push_back(option->strike_price_);
+    types.push_back(option->option_type_);
+  }
+
+  std::vector<double> results = BinomialTree::americanOptionPrices(
+      md.spot_price, strikes, types, md.risk_free_rate, time_to_expiry,
+      md.volatility, options.front()->binomial_steps_);
+
+  for (double result : results) {
+    if (std::isnan(result) || std::isinf(result) || result < 0.0) {
+      throw std::runtime_error("Invalid American option price calculated");
+    }
+  }
+
+  return results;
+}
+
+std::vector<double> AmericanOption::priceOnBoundary(
+    const std::vector<const AmericanOption *> &options,
+    const AndersenLakeOffengeld::ExerciseBoundary &boundary, double spot) {
+  std::vector<double> results;
+  results.reserve(options.size());
+  for (const AmericanOption *option : options) {
+    const double result =
+        boundary.price(spot, option->strike_price_, option->option_type_);
+    if (std::isnan(result) || std::isinf(result) || result < 0.0) {
+      throw std::runtime_error("Invalid American option price calculated");
+    }
+    results.push_back(result);
+  }
+  return results;
+}
+
+std::vector<double>
+AmericanOption::priceBatch(const std::vector<const AmericanOption *> &options,
+                           const MarketData &md) {
+  validateAmericanBatch(options);
+  if (options.empty()) {
+    return {};
+  }
+  options.front()->validateMarketData(md);
+
+  if (options.front()->pricing_model_ == PricingModel::AndersenLakeOffengeld) {
+    return priceOnBoundary(options, options.front()->exerciseBoundary(md),
+                           md.spot_price);
+  }
+  return priceLattice(options, md, options.front()->time_to_expiry_years_);
+}
+
+std::vector<InstrumentGreeks>
+AmericanOption::greeksBatch(const std::vector<const AmericanOption *> &options,
+                            const MarketData &md) {
+  validateAmericanBatch(options);
+  if (options.empty()) {
+    return {};
+  }
+  options.front()->validateMarketData(md);
+
+  const size_t n = options.size();
+  const double T = options.front()->time_to_expiry_years_;
+
+  // Same bump scheme as the single-option finite differences below, so the
+  // batch path reproduces delta()/gamma()/vega()/theta() exactly. A lattice
+  // is built per market state; a collocation boundary does not depend on
+  // spot, so the spot bumps all share the base one.
+  const bool collocation =
+      options.front()->pricing_model_ == PricingModel::AndersenLakeOffengeld;
+  auto pricesIn = [&](const MarketData &state, double expiry) {
+    if (!collocation) {
+      return priceLattice(options, state, expiry);
+    }
+    return priceOnBoundary(
+        options,
+        AndersenLakeOffengeld::ExerciseBoundary(state.risk_free_rate, expiry,
+                                                state.volatility),
+        state.spot_price);
+  };
+  std::unique_ptr<AndersenLakeOffengeld::ExerciseBoundary> boundary;
+  if (collocation) {
+    boundary = std::make_unique<AndersenLakeOffengeld::ExerciseBoundary>(
+        options.front()->exerciseBoundary(md));
+  }
+  auto priceAtSpot = [&](double spot) {
+    MarketData shifted = md;
+    shifted.spot_price = spot;
+    options.front()->validateMarketData(shifted);
+    if (boundary) {
+      return priceOnBoundary(options, *boundary, spot);
+    }
+    return priceLattice(options, shifted, T);
+  };
+  auto priceAtVol = [&](double vol) {
+    MarketData shifted = md;
+    shifted.volatility = vol;
+    return pricesIn(shifted, T);
+  };
+
+  const double spot = md.spot_price;
+  const double bump = spot * 0.01;
+  const double spot_up = spot + bump;
+  const double spot_down = spot - bump;
+  const double bump_up = spot_up * 0.01;
+  const double bump_down = spot_down * 0.01;
+
+  const std::vector<double> base = priceAtSpot(spot);
+  const std::vector<double> up = priceAtSpot(spot_up);
+  const std::vector<double> down = priceAtSpot(spot_down);
+  const std::vector<double> up_up = priceAtSpot(spot_up + bump_up);
+  const std::vector<double> up_down = priceAtSpot(spot_up - bump_up);
+  const std::vector<double> down_up = priceAtSpot(spot_down + bump_down);
+  const std::vector<double> down_down = priceAtSpot(spot_down - bump_down);
+
+  const double vol_bump = 0.01;
+  const std::vector<double> vol_up = priceAtVol(md.volatility + vol_bump);
+  const std::vector<double> vol_down =
+      priceAtVol(std::max(0.0, md.volatility - vol_bump));
+
+  const double theta_bump = 1.0 / 365.0;
+  std::vector<double> decayed;
+  if (T >= theta_bump) {
+    decayed = pricesIn(md, std::max(0.0, T - theta_bump));
+  }
+
+  std::vector<InstrumentGreeks> results(n);
+  for (size_t k = 0; k < n; ++k) {
+    InstrumentGreeks &g = results[k];
+    g.price = base[k];
+
+    g.delta = (up[k] - down[k]) / (2.0 * bump);
+    if (std::isnan(g.delta) || std::isinf(g.delta)) {
+      throw std::runtime_error("Invalid delta calculated");
+    }
+
+    const double delta_up = (up_up[k] - up_down[k]) / (2.0 * bump_up);
+    const double delta_down = (down_up[k] - down_down[k]) / (2.0 * bump_down);
+    g.gamma = (delta_up - delta_down) / (2.0 * bump);
+    if (std::isnan(g.gamma) || std::isinf(g.gamma)) {
+      throw std::runtime_error("Invalid gamma calculated");
+    }
+
+    g.vega = (vol_up[k] - vol_down[k]) / (2.0 * vol_bump);
+    if (std::isnan(g.vega) || std::isinf(g.vega)) {
+      throw std::runtime_error("Invalid vega calculated");
+    }
+
+    g.theta = decayed.empty() ? 0.0 : (decayed[k] - base[k]) / theta_bump;
+    if (std::isnan(g.theta) || std::isinf(g.theta)) {
+      throw std::runtime_error("Invalid theta calculated");
+    }
+  }
+
+  return results;
+}
\ No newline at end of file
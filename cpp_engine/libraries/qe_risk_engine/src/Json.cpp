@@ -0,0 +1,505 @@
+#include "Json.h"
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+
+namespace Json {
+
+Value::Value()
+    : type_(Type::Null),
+      boolean_(false),
+      integer_(false),
+      number_(0.0) {
+}
+
+Value Value::boolean(bool value) {
+    Value v;
+    v.type_ = Type::Boolean;
+    v.boolean_ = value;
+    return v;
+}
+
+Value Value::number(double value, bool integer) {
+    Value v;
+    v.type_ = Type::Number;
+    v.number_ = value;
+    v.integer_ = integer;
+    return v;
+}
+
+Value Value::string(std::string value) {
+    Value v;
+    v.type_ = Type::String;
+    v.string_ = std::move(value);
+    return v;
+}
+
+Value Value::array(Array values) {
+    Value v;
+    v.type_ = Type::Array;
+    v.array_ = std::move(values);
+    return v;
+}
+
+Value Value::object(Object members) {
+    Value v;
+    v.type_ = Type::Object;
+    v.object_ = std::move(members);
+    return v;
+}
+
+Value::Type Value::type() const {
+    return type_;
+}
+
+bool Value::isNull() const {
+    return type_ == Type::Null;
+}
+
+bool Value::isBoolean() const {
+    return type_ == Type::Boolean;
+}
+
+bool Value::isNumber() const {
+    return type_ == Type::Number;
+}
+
+bool Value::isString() const {
+    return type_ == Type::String;
+}
+
+bool Value::isArray() const {
+    return type_ == Type::Array;
+}
+
+bool Value::isObject() const {
+    return type_ == Type::Object;
+}
+
+bool Value::isInteger() const {
+    return type_ == Type::Number && integer_;
+}
+
+bool Value::asBoolean() const {
+    if (type_ != Type::Boolean) {
+        throw std::invalid_argument("JSON value is not a boolean");
+    }
+    return boolean_;
+}
+
+double Value::asNumber() const {
+    if (type_ != Type::Number) {
+        throw std::invalid_argument("JSON value is not a number");
+    }
+    return number_;
+}
+
+const std::string& Value::asString() const {
+    if (type_ != Type::String) {
+        throw std::invalid_argument("JSON value is not a string");
+    }
+    return string_;
+}
+
+const Value::Array& Value::asArray() const {
+    if (type_ != Type::Array) {
+        throw std::invalid_argument("JSON value is not an array");
+    }
+    return array_;
+}
+
+const Value::Object& Value::asObject() const {
+    if (type_ != Type::Object) {
+        throw std::invalid_argument("JSON value is not an object");
+    }
+    return object_;
+}
+
+const Value* Value::find(const std::string& key) const {
+    if (type_ != Type::Object) {
+        return nullptr;
+    }
+    for (const auto& member : object_) {
+        if (member.first == key) {
+            return &member.second;
+        }
+    }
+    return nullptr;
+}
+
+namespace {
+
+const int kMaxDepth = 64;
+
+class Parser {
+public:
+    Parser(const char* begin, const char* end)
+        : begin_(begin), pos_(begin), end_(end) {
+    }
+
+    Value document() {
+        Value value = parseValue(0);
+        skipWhitespace();
+        if (pos_ != end_) {
+            fail("unexpected trailing characters");
+        }
+        return value;
+    }
+
+private:
+    const char* begin_;
+    const char* pos_;
+    const char* end_;
+
+    [[noreturn]] void fail(const std::string& reason) const {
+        throw std::invalid_argument(
+            "Invalid JSON at offset " + std::to_string(pos_ - begin_) + ": " + reason
+        );
+    }
+
+    void skipWhitespace() {
+        while (pos_ != end_ && (*pos_ == ' ' || *pos_ == '\t' || *pos_ == '\n' || *pos_ == '\r')) {
+            ++pos_;
+        }
+    }
+
+    void expectLiteral(const char* literal) {
+        for (const char* c = literal; *c; ++c, ++pos_) {
+            if (pos_ == end_ || *pos_ != *c) {
+                fail(std::string("expected '") + literal + "'");
+            }
+        }
+    }
+
+    Value parseValue(int depth) {
+        if (depth > kMaxDepth) {
+            fail("nesting too deep");
+        }
+        skipWhitespace();
+        if (pos_ == end_) {
+            fail("unexpected end of input");
+        }
+        switch (*pos_) {
+        case '{':
+            return parseObject(depth);
+        case '[':
+            return parseArray(depth);
+        case '"':
+            return Value::string(parseString());
+        case 't':
+            expectLiteral("true");
+            return Value::boolean(true);
+        case 'f':
+            expectLiteral("false");
+            return Value::boolean(false);
+        case 'n':
+            expectLiteral("null");
+            return Value();
+        default:
+            return parseNumber();
+        }
+    }
+
+    Value parseObject(int depth) {
+        ++pos_;
+        Value::Object members;
+        skipWhitespace();
+        if (pos_ != end_ && *pos_ == '}') {
+            ++pos_;
+            return Value::object(std::move(members));
+        }
+        while (true) {
+            skipWhitespace();
+            if (pos_ == end_ || *pos_ != '"') {
+                fail("expected a member name");
+            }
+            std::string key = parseString();
+            skipWhitespace();
+            if (pos_ == end_ || *pos_ != ':') {
+                fail("expected ':'");
+            }
+            ++pos_;
+            members.emplace_back(std::move(key), parseValue(depth + 1));
+            skipWhitespace();
+            if (pos_ != end_ && *pos_ == ',') {
+                ++pos_;
+                continue;
+            }
+            if (pos_ != end_ && *pos_ == '}') {
+                ++pos_;
+                return Value::object(std::move(members));
+            }
+            fail("expected ',' or '}'");
+        }
+    }
+
+    Value parseArray(int depth) {
+        ++pos_;
+        Value::Array values;
+        skipWhitespace();
+        if (pos_ != end_ && *pos_ == ']') {
+            ++pos_;
+            return Value::array(std::move(values));
+        }
+        while (true) {
+            values.push_back(parseValue(depth + 1));
+            skipWhitespace();
+            if (pos_ != end_ && *pos_ == ',') {
+                ++pos_;
+                continue;
+            }
+            if (pos_ != end_ && *pos_ == ']') {
+                ++pos_;
+                return Value::array(std::move(values));
+            }
+            fail("expected ',' or ']'");
+        }
+    }
+
+    unsigned parseHex4() {
+        unsigned code = 0;
+        for (int i = 0; i < 4; ++i, ++pos_) {
+            if (pos_ == end_) {
+                fail("truncated \\u escape");
+            }
+            const char c = *pos_;
+            code <<= 4;
+            if (c >= '0' && c <= '9') {
+                code |= c - '0';
+            } else if (c >= 'a' && c <= 'f') {
+                code |= c - 'a' + 10;
+            } else if (c >= 'A' && c <= 'F') {
+                code |= c - 'A' + 10;
+            } else {
+                fail("bad \\u escape");
+            }
+        }
+        return code;
+    }
+
+    static void appendUtf8(std::string& out, unsigned code) {
+        if (code < 0x80) {
+            out += static_cast<char>(code);
+        } else if (code < 0x800) {
+            out += static_cast<char>(0xC0 | (code >> 6));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        } else if (code < 0x10000) {
+            out += static_cast<char>(0xE0 | (code >> 12));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        } else {
+            out += static_cast<char>(0xF0 | (code >> 18));
+            out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        }
+    }
+
+    std::string parseString() {
+        ++pos_;
+        std::string out;
+        while (true) {
+            if (pos_ == end_) {
+                fail("unterminated string");
+            }
+            const char c = *pos_++;
+            if (c == '"') {
+                return out;
+            }
+            if (static_cast<unsigned char>(c) < 0x20) {
+                fail("control character in string");
+            }
+            if (c != '\\') {
+                out += c;
+                continue;
+            }
+            if (pos_ == end_) {
+                fail("unterminated string");
+            }
+            switch (*pos_++) {
+            case '"': out += '"'; break;
+            case '\\': out += '\\'; break;
+            case '/': out += '/'; break;
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'n': out += '\n'; break;
+            case 'r': out += '\r'; break;
+            case 't': out += '\t'; break;
+            case 'u': {
+                unsigned code = parseHex4();
+                if (code >= 0xD800 && code < 0xDC00) {
+                    if (end_ - pos_ < 2 || pos_[0] != '\\' || pos_[1] != 'u') {
+                        fail("unpaired surrogate");
+                    }
+                    pos_ += 2;
+                    const unsigned low = parseHex4();
+                    if (low < 0xDC00 || low >= 0xE000) {
+                        fail("unpaired surrogate");
+                    }
+                    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                }
+                appendUtf8(out, code);
+                break;
+            }
+            default:
+                --pos_;
+                fail("bad escape");
+            }
+        }
+    }
+
+    Value parseNumber() {
+        const char* start = pos_;
+        bool integer = true;
+        if (pos_ != end_ && *pos_ == '-') {
+            ++pos_;
+        }
+        if (pos_ == end_ || !std::isdigit(static_cast<unsigned char>(*pos_))) {
+            fail("unexpected character");
+        }
+        if (*pos_ == '0') {
+            ++pos_;
+        } else {
+            while (pos_ != end_ && std::isdigit(static_cast<unsigned char>(*pos_))) {
+                ++pos_;
+            }
+        }
+        if (pos_ != end_ && *pos_ == '.') {
+            integer = false;
+            ++pos_;
+            if (pos_ == end_ || !std::isdigit(static_cast<unsigned char>(*pos_))) {
+                fail("expected digits after '.'");
+            }
+            while (pos_ != end_ && std::isdigit(static_cast<unsigned char>(*pos_))) {
+                ++pos_;
+            }
+        }
+        if (pos_ != end_ && (*pos_ == 'e' || *pos_ == 'E')) {
+            integer = false;
+            ++pos_;
+            if (pos_ != end_ && (*pos_ == '+' || *pos_ == '-')) {
+                ++pos_;
+            }
+            if (pos_ == end_ || !std::isdigit(static_cast<unsigned char>(*pos_))) {
+                fail("expected exponent digits");
+            }
+            while (pos_ != end_ && std::isdigit(static_cast<unsigned char>(*pos_))) {
+                ++pos_;
+            }
+        }
+        // The grammar above guarantees strtod consumes exactly [start, pos_)
+        const std::string text(start, pos_);
+        return Value::number(std::strtod(text.c_str(), nullptr), integer);
+    }
+};
+
+void writeString(const std::string& text, std::string& out) {
+    static const char kHex[] = "0123456789abcdef";
+    out += '"';
+    for (char c : text) {
+        switch (c) {
+        case '"': out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\b': out += "\\b"; break;
+        case '\f': out += "\\f"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                out += "\\u00";
+                out += kHex[(c >> 4) & 0xF];
+                out += kHex[c & 0xF];
+            } else {
+                out += c;
+            }
+        }
+    }
+    out += '"';
+}
+
+void writeNumber(double value, bool integer, std::string& out) {
+    if (!std::isfinite(value)) {
+        out += "null";
+        return;
+    }
+    char buffer[32];
+    if (integer && std::abs(value) < 1e18) {
+        std::snprintf(buffer, sizeof(buffer), "%lld", static_cast<long long>(value));
+        out += buffer;
+        return;
+    }
+    // Shortest of %.15g..%.17g that round-trips
+    for (int precision = 15; precision <= 17; ++precision) {
+        std::snprintf(buffer, sizeof(buffer), "%.*g", precision, value);
+        if (precision == 17 || std::strtod(buffer, nullptr) == value) {
+            break;
+        }
+    }
+    out += buffer;
+}
+
+void writeValue(const Value& value, std::string& out) {
+    switch (value.type()) {
+    case Value::Type::Null:
+        out += "null";
+        break;
+    case Value::Type::Boolean:
+        out += value.asBoolean() ? "true" : "false";
+        break;
+    case Value::Type::Number:
+        writeNumber(value.asNumber(), value.isInteger(), out);
+        break;
+    case Value::Type::String:
+        writeString(value.asString(), out);
+        break;
+    case Value::Type::Array: {
+        out += '[';
+        bool first = true;
+        for (const Value& element : value.asArray()) {
+            if (!first) {
+                out += ',';
+            }
+            first = false;
+            writeValue(element, out);
+        }
+        out += ']';
+        break;
+    }
+    case Value::Type::Object: {
+        out += '{';
+        bool first = true;
+        for (const auto& member : value.asObject()) {
+            if (!first) {
+                out += ',';
+            }
+            first = false;
+            writeString(member.first, out);
+            out += ':';
+            writeValue(member.second, out);
+        }
+        out += '}';
+        break;
+    }
+    }
+}
+
+} // namespace
+
+Value parse(const char* begin, const char* end) {
+    return Parser(begin, end).document();
+}
+
+Value parse(const std::string& text) {
+    return parse(text.data(), text.data() + text.size());
+}
+
+std::string write(const Value& value) {
+    std::string out;
+    writeValue(value, out);
+    return out;
+}
+
+} // namespace Json
@@ -6,34 +6,22 @@
 
 namespace JumpDiffusion {
 
-double poissonProbability(int n, double lambda_t) {
-    if (lambda_t < 0.0) {
-        throw std::invalid_argument("Lambda * T must be non-negative");
-    }
-    if (n < 0) {
-        throw std::invalid_argument("Number of jumps cannot be negative");
-    }
-    
-    if (lambda_t == 0.0) {
-        return n == 0 ? 1.0 : 0.0;
-    }
-    
-    double log_prob = n * std::log(lambda_t) - lambda_t;
-    for (int i = 2; i <= n; ++i) {
-        log_prob -= std::log(static_cast<double>(i));
-    }
-    
-    return std::exp(log_prob);
-}
+namespace {
 
-double mertonCallPrice(
-    double S, double K, double r, double T, double sigma,
-    double lambda, double jump_mean, double jump_vol,
-    int max_jumps
+const double kSeriesTolerance = 1e-12;
+
+void validateInputs(
+    double S, const std::vector<double>& strikes, double T, double sigma,
+    double lambda, double jump_vol, int max_jumps
 ) {
-    if (S <= 0.0 || K <= 0.0) {
+    if (S <= 0.0) {
         throw std::invalid_argument("Stock price and strike must be positive");
     }
+    for (double K : strikes) {
+        if (K <= 0.0) {
+            throw std::invalid_argument("Stock price and strike must be positive");
+        }
+    }
     if (T < 0.0) {
         throw std::invalid_argument("Time to expiry cannot be negative");
     }
@@ -43,104 +31,163 @@ double mertonCallPrice(
     if (lambda < 0.0) {
         throw std::invalid_argument("Jump intensity must be non-negative");
     }
-    
-    if (T == 0.0) {
-        return std::max(0.0, S - K);
-    }
-    
-    const double k = std::exp(jump_mean + 0.5 * jump_vol * jump_vol) - 1.0;
-    // const double lambda_prime = lambda * (1.0 + k);
-    
-    double option_value = 0.0;
-    double sum_prob = 0.0;
-    
-    for (int n = 0; n <= max_jumps; ++n) {
-        const double prob = poissonProbability(n, lambda * T);
-        
-        if (prob < 1e-10) {
-            break;
-        }
-        
-        sum_prob += prob;
-        
-        const double sigma_n = std::sqrt(
-            sigma * sigma + n * jump_vol * jump_vol / T
-        );
-        
-        const double r_n = r - lambda * k + n * (jump_mean + 0.5 * jump_vol * jump_vol) / T;
-        
-        const double bs_price = BlackScholes::callPrice(S, K, r_n, T, sigma_n);
-        
-        option_value += prob * bs_price;
-        
-        if (sum_prob > 0.9999 && prob < 1e-8) {
-            break;
-        }
-    }
-    
-    if (std::isnan(option_value) || std::isinf(option_value)) {
-        throw std::runtime_error("Invalid Merton jump diffusion price");
+    if (max_jumps < 0) {
+        throw std::invalid_argument("Number of jumps cannot be negative");
     }
-    
-    return option_value;
 }
 
-double mertonPutPrice(
-    double S, double K, double r, double T, double sigma,
-    double lambda, double jump_mean, double jump_vol,
-    int max_jumps
+// Merton (1976): conditional on n jumps the log-price is Gaussian with total
+// variance sigma^2 T + n jump_vol^2 and drift (r - lambda k) T + n (jump_mean
+// + jump_vol^2 / 2), and n is Poisson with mean lambda (1 + k) T. Calls are
+// summed over n with the weights updated recursively, and puts follow from
+// put-call parity, so the tail of every term is bounded by S * (1 - sum of
+// weights so far).
+std::vector<InstrumentGreeks> mertonSeries(
+    double S, const std::vector<double>& strikes, const std::vector<OptionType>& types,
+    double r, double T, double sigma, double lambda, double jump_mean, double jump_vol,
+    int max_jumps, bool with_greeks
 ) {
-    if (S <= 0.0 || K <= 0.0) {
-        throw std::invalid_argument("Stock price and strike must be positive");
+    validateInputs(S, strikes, T, sigma, lambda, jump_vol, max_jumps);
+    if (types.size() != strikes.size()) {
+        throw std::invalid_argument("Strikes and option types must have the same length");
     }
-    if (T < 0.0) {
-        throw std::invalid_argument("Time to expiry cannot be negative");
+
+    const size_t count = strikes.size();
+    std::vector<InstrumentGreeks> results(count);
+
+    if (T == 0.0) {
+        for (size_t i = 0; i < count; ++i) {
+            const bool call = types[i] == OptionType::Call;
+            results[i].price = call ? std::max(0.0, S - strikes[i]) : std::max(0.0, strikes[i] - S);
+            results[i].delta = call ? (S > strikes[i] ? 1.0 : 0.0) : (S < strikes[i] ? -1.0 : 0.0);
+        }
+        return results;
     }
-    if (sigma < 0.0 || jump_vol < 0.0) {
-        throw std::invalid_argument("Volatilities cannot be negative");
+
+    const double jump_drift = jump_mean + 0.5 * jump_vol * jump_vol;
+    const double k = std::exp(jump_drift) - 1.0;
+    const double jump_rate = lambda * (1.0 + k);
+    const double mean_jumps = jump_rate * T;
+    const double base_drift = (r - lambda * k) * T;
+    const double log_S = std::log(S);
+
+    double weight = std::exp(-mean_jumps);
+    if (weight == 0.0) {
+        throw std::invalid_argument("Jump intensity too large for the Merton series");
     }
-    if (lambda < 0.0) {
-        throw std::invalid_argument("Jump intensity must be non-negative");
+
+    std::vector<double> log_K(count);
+    for (size_t i = 0; i < count; ++i) {
+        log_K[i] = std::log(strikes[i]);
     }
-    
-    if (T == 0.0) {
-        return std::max(0.0, K - S);
-    }
-    
-    const double k = std::exp(jump_mean + 0.5 * jump_vol * jump_vol) - 1.0;
-    
-    double option_value = 0.0;
-    double sum_prob = 0.0;
-    
+
+    // Per strike: call price and d(call)/dT accumulated over the series
+    std::vector<double> call_T(count, 0.0);
+    double cumulative_weight = 0.0;
+
     for (int n = 0; n <= max_jumps; ++n) {
-        const double prob = poissonProbability(n, lambda * T);
-        
-        if (prob < 1e-10) {
-            break;
+        const double variance = sigma * sigma * T + n * jump_vol * jump_vol;
+        const double std_dev = std::sqrt(variance);
+        const double drift = base_drift + n * jump_drift;
+        const double discount = std::exp(-drift);
+        const double weight_T = weight * (n / T - jump_rate);
+
+        for (size_t i = 0; i < count; ++i) {
+            const double K_discounted = strikes[i] * discount;
+            InstrumentGreeks& g = results[i];
+
+            if (std_dev > 0.0) {
+                const double d1 = (log_S - log_K[i] + drift + 0.5 * variance) / std_dev;
+                const double N_d1 = BlackScholes::N(d1);
+                const double N_d2 = BlackScholes::N(d1 - std_dev);
+                const double call = S * N_d1 - K_discounted * N_d2;
+                g.price += weight * call;
+
+                if (with_greeks) {
+                    const double pdf = BlackScholes::nPrime(d1);
+                    g.delta += weight * N_d1;
+                    g.gamma += weight * pdf / (S * std_dev);
+                    g.vega += weight * S * pdf * sigma * T / std_dev;
+                    call_T[i] += weight * (K_discounted * N_d2 * (r - lambda * k) +
+                                           S * pdf * sigma * sigma / (2.0 * std_dev)) +
+                                 weight_T * call;
+                }
+            } else {
+                const bool in_the_money = S > K_discounted;
+                const double call = in_the_money ? S - K_discounted : 0.0;
+                g.price += weight * call;
+
+                if (with_greeks) {
+                    g.delta += in_the_money ? weight : 0.0;
+                    call_T[i] += (in_the_money ? weight * K_discounted * (r - lambda * k) : 0.0) +
+                                 weight_T * call;
+                }
+            }
         }
-        
-        sum_prob += prob;
-        
-        const double sigma_n = std::sqrt(
-            sigma * sigma + n * jump_vol * jump_vol / T
-        );
-        
-        const double r_n = r - lambda * k + n * (jump_mean + 0.5 * jump_vol * jump_vol) / T;
-        
-        const double bs_price = BlackScholes::putPrice(S, K, r_n, T, sigma_n);
-        
-        option_value += prob * bs_price;
-        
-        if (sum_prob > 0.9999 && prob < 1e-8) {
+
+        cumulative_weight += weight;
+        if (1.0 - cumulative_weight <= kSeriesTolerance) {
             break;
         }
+        weight *= mean_jumps / (n + 1);
+    }
+
+    const double rate_discount = std::exp(-r * T);
+    for (size_t i = 0; i < count; ++i) {
+        InstrumentGreeks& g = results[i];
+        double value_T = call_T[i];
+
+        if (types[i] == OptionType::Put) {
+            const double K_discounted = strikes[i] * rate_discount;
+            g.price = std::max(0.0, g.price - S + K_discounted);
+            g.delta -= 1.0;
+            value_T -= r * K_discounted;
+        }
+        if (with_greeks) {
+            g.theta = -value_T / 365.0;
+        }
+
+        if (std::isnan(g.price) || std::isinf(g.price)) {
+            throw std::runtime_error("Invalid Merton jump diffusion price");
+        }
+    }
+
+    return results;
+}
+
+} // namespace
+
+double poissonProbability(int n, double lambda_t) {
+    if (lambda_t < 0.0) {
+        throw std::invalid_argument("Lambda * T must be non-negative");
     }
-    
-    if (std::isnan(option_value) || std::isinf(option_value)) {
-        throw std::runtime_error("Invalid Merton jump diffusion price");
+    if (n < 0) {
+        throw std::invalid_argument("Number of jumps cannot be negative");
     }
-    
-    return option_value;
+
+    if (lambda_t == 0.0) {
+        return n == 0 ? 1.0 : 0.0;
+    }
+
+    return std::exp(n * std::log(lambda_t) - lambda_t - std::lgamma(n + 1.0));
+}
+
+double mertonCallPrice(
+    double S, double K, double r, double T, double sigma,
+    double lambda, double jump_mean, double jump_vol,
+    int max_jumps
+) {
+    return mertonSeries(S, {K}, {OptionType::Call}, r, T, sigma, lambda, jump_mean,
+                        jump_vol, max_jumps, false).front().price;
+}
+
+double mertonPutPrice(
+    double S, double K, double r, double T, double sigma,
+    double lambda, double jump_mean, double jump_vol,
+    int max_jumps
+) {
+    return mertonSeries(S, {K}, {OptionType::Put}, r, T, sigma, lambda, jump_mean,
+                        jump_vol, max_jumps, false).front().price;
 }
 
 double mertonOptionPrice(
@@ -148,11 +195,41 @@ double mertonOptionPrice(
     OptionType type, double lambda, double jump_mean, double jump_vol,
     int max_jumps
 ) {
-    if (type == OptionType::Call) {
-        return mertonCallPrice(S, K, r, T, sigma, lambda, jump_mean, jump_vol, max_jumps);
-    } else {
-        return mertonPutPrice(S, K, r, T, sigma, lambda, jump_mean, jump_vol, max_jumps);
-    }
+    return mertonSeries(S, {K}, {type}, r, T, sigma, lambda, jump_mean,
+                        jump_vol, max_jumps, false).front().price;
+}
+
+InstrumentGreeks mertonOptionGreeks(
+    double S, double K, double r, double T, double sigma,
+    OptionType type, double lambda, double jump_mean, double jump_vol,
+    int max_jumps
+) {
+    return mertonSeries(S, {K}, {type}, r, T, sigma, lambda, jump_mean,
+                        jump_vol, max_jumps, true).front();
+}
+
+std::vector<double> mertonOptionPrices(
+    double S, const std::vector<double>& strikes, const std::vector<OptionType>& types,
+    double r, double T, double sigma, double lambda, double jump_mean, double jump_vol,
+    int max_jumps
+) {
+    const std::vector<InstrumentGreeks> results = mertonSeries(
+        S, strikes, types, r, T, sigma, lambda, jump_mean, jump_vol, max_jumps, false);
+    std::vector<double> prices;
+    prices.reserve(results.size());
+    for (const auto& g : results) {
+        prices.push_back(g.price);
+    }
+    return prices;
+}
+
+std::vector<InstrumentGreeks> mertonOptionGreeks(
+    double S, const std::vector<double>& strikes, const std::vector<OptionType>& types,
+    double r, double T, double sigma, double lambda, double jump_mean, double jump_vol,
+    int max_jumps
+) {
+    return mertonSeries(S, strikes, types, r, T, sigma, lambda, jump_mean, jump_vol,
+                        max_jumps, true);
 }
 
 }
@@ -1,48 +1,243 @@
 #include "MarketData.h"
+#include <algorithm>
+#include <functional>
+#include <utility>
 
-void MarketDataManager::addMarketData(const std::string& asset_id, const MarketData& md) {
+MarketDataSnapshot::MarketDataSnapshot()
+    : version_(0),
+      size_(0),
+      shards_(kShardCount, std::make_shared<const Shard>()) {
+}
+
+size_t MarketDataSnapshot::shardIndex(const std::string& asset_id) {
+    return std::hash<std::string>()(asset_id) % kShardCount;
+}
+
+const MarketDataSnapshot::Entry* MarketDataSnapshot::findEntry(const std::string& asset_id) const {
+    const Shard& shard = *shards_[shardIndex(asset_id)];
+    auto it = shard.entries.find(asset_id);
+    return it == shard.entries.end() ? nullptr : &it->second;
+}
+
+MarketData MarketDataSnapshot::getMarketData(const std::string& asset_id) const {
     if (asset_id.empty()) {
         throw std::invalid_argument("Asset ID cannot be empty");
     }
     
-    md.validate();
+    const Entry* entry = findEntry(asset_id);
+    if (!entry || !entry->present) {
+        throw std::runtime_error("Market data for " + asset_id + " not found");
+    }
     
-    if (market_data_map_.find(asset_id) != market_data_map_.end()) {
-        throw std::runtime_error("Market data for " + asset_id + " already exists. Use updateMarketData instead.");
+    return entry->market_data;
+}
+
+bool MarketDataSnapshot::hasMarketData(const std::string& asset_id) const {
+    const Entry* entry = findEntry(asset_id);
+    return entry && entry->present;
+}
+
+size_t MarketDataSnapshot::size() const {
+    return size_;
+}
+
+std::map<std::string, MarketData> MarketDataSnapshot::getAllMarketData() const {
+    std::map<std::string, MarketData> all;
+    for (const auto& shard : shards_) {
+        for (const auto& [asset_id, entry] : shard->entries) {
+            if (entry.present) {
+                all.emplace(asset_id, entry.market_data);
+            }
+        }
+    }
+    return all;
+}
+
+uint64_t MarketDataSnapshot::getVersion() const {
+    return version_;
+}
+
+uint64_t MarketDataSnapshot::getAssetVersion(const std::string& asset_id) const {
+    const Entry* entry = findEntry(asset_id);
+    return entry ? entry->version : 0;
+}
+
+std::vector<std::string> MarketDataSnapshot::getChangedAssets(uint64_t since_version) const {
+    std::vector<std::pair<uint64_t, const std::string*>> changes;
+    for (const auto& shard : shards_) {
+        if (shard->max_version <= since_version) {
+            continue;
+        }
+        for (const auto& [asset_id, entry] : shard->entries) {
+            if (entry.version > since_version) {
+                changes.emplace_back(entry.version, &asset_id);
+            }
+        }
     }
+    std::sort(changes.begin(), changes.end());
     
-    market_data_map_[asset_id] = md;
+    std::vector<std::string> changed;
+    changed.reserve(changes.size());
+    for (const auto& change : changes) {
+        changed.push_back(*change.second);
+    }
+    return changed;
 }
 
-void MarketDataManager::updateMarketData(const std::string& asset_id, const MarketData& md) {
+// Copy-on-write of the one shard holding asset_id; md == nullptr removes it
+void MarketDataSnapshot::writeEntry(const std::string& asset_id, const MarketData* md) {
+    const size_t index = shardIndex(asset_id);
+    auto shard = std::make_shared<Shard>(*shards_[index]);
+    Entry& entry = shard->entries[asset_id];
+    if (md) {
+        size_ += entry.present ? 0 : 1;
+        entry.market_data = *md;
+        entry.present = true;
+    } else {
+        size_ -= entry.present ? 1 : 0;
+        entry.market_data = MarketData();
+        entry.present = false;
+    }
+    entry.version = ++version_;
+    shard->max_version = version_;
+    if (!md && shard->oldest_tombstone == 0) {
+        shard->oldest_tombstone = version_;
+    }
+    shards_[index] = std::move(shard);
+}
+
+// Tombstones every present asset, copying each non-empty shard once
+void MarketDataSnapshot::removeAll() {
+    for (auto& current : shards_) {
+        if (current->max_version == 0) {
+            continue;
+        }
+        std::shared_ptr<Shard> shard;
+        for (const auto& [asset_id, entry] : current->entries) {
+            if (!entry.present) {
+                continue;
+            }
+            if (!shard) {
+                shard = std::make_shared<Shard>(*current);
+            }
+            Entry& cleared = shard->entries[asset_id];
+            cleared.market_data = MarketData();
+            cleared.present = false;
+            cleared.version = ++version_;
+            shard->max_version = version_;
+            if (shard->oldest_tombstone == 0) {
+                shard->oldest_tombstone = version_;
+            }
+        }
+        if (shard) {
+            current = std::move(shard);
+        }
+    }
+    size_ = 0;
+}
+
+// Drops tombstones no snapshot at or after horizon needs to report
+void MarketDataSnapshot::purgeTombstones(uint64_t horizon) {
+    for (auto& current : shards_) {
+        if (current->oldest_tombstone == 0 || current->oldest_tombstone > horizon) {
+            continue;
+        }
+        auto shard = std::make_shared<Shard>(*current);
+        shard->oldest_tombstone = 0;
+        for (auto it = shard->entries.begin(); it != shard->entries.end();) {
+            const Entry& entry = it->second;
+            if (entry.present) {
+                ++it;
+            } else if (entry.version <= horizon) {
+                it = shard->entries.erase(it);
+            } else {
+                if (shard->oldest_tombstone == 0 || entry.version < shard->oldest_tombstone) {
+                    shard->oldest_tombstone = entry.version;
+                }
+                ++it;
+            }
+        }
+        current = std::move(shard);
+    }
+}
+
+MarketDataManager::MarketDataManager()
+    : snapshot_(std::make_shared<const MarketDataSnapshot>()),
+      published_{snapshot_},
+      compact_at_(2) {
+}
+
+MarketDataManager::MarketDataManager(const MarketDataManager& other)
+    : snapshot_(other.snapshot()),
+      published_{snapshot_},
+      compact_at_(2) {
+}
+
+MarketDataManager& MarketDataManager::operator=(const MarketDataManager& other) {
+    if (this == &other) {
+        return *this;
+    }
+    
+    std::shared_ptr<const MarketDataSnapshot> copied = other.snapshot();
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    // Versions restart from the source's, so earlier snapshots of this
+    // manager no longer order against the new ones
+    published_.assign(1, copied);
+    compact_at_ = 2;
+    std::atomic_store(&snapshot_, std::move(copied));
+    return *this;
+}
+
+void MarketDataManager::addMarketData(const std::string& asset_id, const MarketData& md) {
     if (asset_id.empty()) {
         throw std::invalid_argument("Asset ID cannot be empty");
     }
     
     md.validate();
     
-    if (market_data_map_.find(asset_id) == market_data_map_.end()) {
-        throw std::runtime_error("Market data for " + asset_id + " does not exist. Use addMarketData instead.");
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    auto next = beginWrite();
+    if (next->hasMarketData(asset_id)) {
+        throw std::runtime_error("Market data for " + asset_id + " already exists. Use updateMarketData instead.");
     }
     
-    market_data_map_[asset_id] = md;
+    next->writeEntry(asset_id, &md);
+    publish(std::move(next));
 }
 
-MarketData MarketDataManager::getMarketData(const std::string& asset_id) const {
+void MarketDataManager::updateMarketData(const std::string& asset_id, const MarketData& md) {
     if (asset_id.empty()) {
         throw std::invalid_argument("Asset ID cannot be empty");
     }
     
-    auto it = market_data_map_.find(asset_id);
-    if (it == market_data_map_.end()) {
-        throw std::runtime_error("Market data for " + asset_id + " not found");
+    md.validate();
+    
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    const MarketDataSnapshot::Entry* current = snapshot_->findEntry(asset_id);
+    if (!current || !current->present) {
+        throw std::runtime_error("Market data for " + asset_id + " does not exist. Use addMarketData instead.");
     }
     
-    return it->second;
+    // Re-posting the same values is not a change; keep the version so
+    // sessions polling getChangedAssets() have nothing to reprice.
+    const MarketData& old = current->market_data;
+    if (old.asset_id == md.asset_id && old.spot_price == md.spot_price &&
+        old.risk_free_rate == md.risk_free_rate && old.volatility == md.volatility &&
+        old.dividend_yield == md.dividend_yield) {
+        return;
+    }
+    
+    auto next = beginWrite();
+    next->writeEntry(asset_id, &md);
+    publish(std::move(next));
+}
+
+MarketData MarketDataManager::getMarketData(const std::string& asset_id) const {
+    return snapshot()->getMarketData(asset_id);
 }
 
 bool MarketDataManager::hasMarketData(const std::string& asset_id) const {
-    return market_data_map_.find(asset_id) != market_data_map_.end();
+    return snapshot()->hasMarketData(asset_id);
 }
 
 void MarketDataManager::removeMarketData(const std::string& asset_id) {
@@ -50,22 +245,75 @@ void MarketDataManager::removeMarketData(const std::string& asset_id) {
         throw std::invalid_argument("Asset ID cannot be empty");
     }
     
-    auto it = market_data_map_.find(asset_id);
-    if (it == market_data_map_.end()) {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    auto next = beginWrite();
+    if (!next->hasMarketData(asset_id)) {
         throw std::runtime_error("Market data for " + asset_id + " not found");
     }
     
-    market_data_map_.erase(it);
+    next->writeEntry(asset_id, nullptr);
+    publish(std::move(next));
 }
 
 void MarketDataManager::clear() {
-    market_data_map_.clear();
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    auto next = beginWrite();
+    next->removeAll();
+    publish(std::move(next));
 }
 
 size_t MarketDataManager::size() const {
-    return market_data_map_.size();
+    return snapshot()->size();
 }
 
 std::map<std::string, MarketData> MarketDataManager::getAllMarketData() const {
-    return market_data_map_;
+    return snapshot()->getAllMarketData();
+}
+
+uint64_t MarketDataManager::getVersion() const {
+    return snapshot()->getVersion();
+}
+
+uint64_t MarketDataManager::getAssetVersion(const std::string& asset_id) const {
+    return snapshot()->getAssetVersion(asset_id);
+}
+
+std::vector<std::string> MarketDataManager::getChangedAssets(uint64_t since_version) const {
+    return snapshot()->getChangedAssets(since_version);
+}
+
+std::shared_ptr<const MarketDataSnapshot> MarketDataManager::snapshot() const {
+    return std::atomic_load(&snapshot_);
+}
+
+std::shared_ptr<MarketDataSnapshot> MarketDataManager::beginWrite() const {
+    // Only writers replace snapshot_, and they hold write_mutex_
+    return std::make_shared<MarketDataSnapshot>(*snapshot_);
+}
+
+void MarketDataManager::publish(std::shared_ptr<MarketDataSnapshot> next) {
+    // Tombstones written by this update are newer than every live snapshot,
+    // so only older ones can go
+    next->purgeTombstones(oldestLiveVersion());
+    std::shared_ptr<const MarketDataSnapshot> published = std::move(next);
+    published_.push_back(published);
+    std::atomic_store(&snapshot_, std::move(published));
+}
+
+uint64_t MarketDataManager::oldestLiveVersion() {
+    if (published_.size() >= compact_at_) {
+        published_.erase(std::remove_if(published_.begin(), published_.end(),
+                                        [](const auto& weak) { return weak.expired(); }),
+                         published_.end());
+        compact_at_ = std::max<size_t>(2, 2 * published_.size());
+    }
+    
+    // published_ is in version order, and snapshot_ keeps the newest alive
+    // while the writer lock is held, so this stops at the latest there
+    for (;;) {
+        if (auto oldest = published_.front().lock()) {
+            return oldest->getVersion();
+        }
+        published_.pop_front();
+    }
 }
\ No newline at end of file
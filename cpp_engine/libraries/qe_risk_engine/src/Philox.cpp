@@ -0,0 +1,166 @@
+#include "Philox.h"
+#include <algorithm>
+#include <cmath>
+
+namespace Philox {
+
+namespace {
+
+const uint32_t kMultiplier0 = 0xD2511F53u;
+const uint32_t kMultiplier1 = 0xCD9E8D57u;
+const uint32_t kWeyl0 = 0x9E3779B9u;
+const uint32_t kWeyl1 = 0xBB67AE85u;
+
+Counter round(const Counter& counter, const Key& key) {
+    const uint64_t product0 = static_cast<uint64_t>(kMultiplier0) * counter[0];
+    const uint64_t product1 = static_cast<uint64_t>(kMultiplier1) * counter[2];
+    return {static_cast<uint32_t>(product1 >> 32) ^ counter[1] ^ key[0],
+            static_cast<uint32_t>(product1),
+            static_cast<uint32_t>(product0 >> 32) ^ counter[3] ^ key[1],
+            static_cast<uint32_t>(product0)};
+}
+
+// 53 bits of the block, centred in their interval so 0 and 1 never occur
+double toUniform(uint32_t high, uint32_t low) {
+    const uint64_t bits = ((static_cast<uint64_t>(high) << 32) | low) >> 11;
+    return (static_cast<double>(bits) + 0.5) * 0x1.0p-53;
+}
+
+// Counters per pass of the bulk generators
+const size_t kChunk = 64;
+
+// Uniforms of up to kChunk paths into out[0, kChunk); the unused entries
+// are padding. Counters are kept as four arrays of words and every loop
+// runs over the whole chunk, so each round is one fixed-length, branch-free
+// loop the compiler vectorizes.
+void uniformChunk(uint64_t seed, const uint64_t* paths, size_t n, uint32_t asset, uint32_t factor,
+                  double* out) {
+    uint32_t word0[kChunk], word1[kChunk], word2[kChunk], word3[kChunk];
+    for (size_t i = 0; i < kChunk; ++i) {
+        const uint64_t path = i < n ? paths[i] : 0;
+        word0[i] = static_cast<uint32_t>(path);
+        word1[i] = static_cast<uint32_t>(path >> 32);
+        word2[i] = asset;
+        word3[i] = factor;
+    }
+    Key key = {static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32)};
+    for (int r = 0; r < 10; ++r) {
+        for (size_t i = 0; i < kChunk; ++i) {
+            const uint64_t product0 = static_cast<uint64_t>(kMultiplier0) * word0[i];
+            const uint64_t product1 = static_cast<uint64_t>(kMultiplier1) * word2[i];
+            word0[i] = static_cast<uint32_t>(product1 >> 32) ^ word1[i] ^ key[0];
+            word1[i] = static_cast<uint32_t>(product1);
+            word2[i] = static_cast<uint32_t>(product0 >> 32) ^ word3[i] ^ key[1];
+            word3[i] = static_cast<uint32_t>(product0);
+        }
+        key[0] += kWeyl0;
+        key[1] += kWeyl1;
+    }
+    for (size_t i = 0; i < kChunk; ++i) {
+        out[i] = toUniform(word0[i], word1[i]);
+    }
+}
+
+// AS 241 (Wichura 1988, PPND16): rational approximations with relative
+// error about 1e-16, central for |p - 0.5| <= 0.425 and in two tail ranges
+const double kCentralHalfWidth = 0.425;
+
+double centralQuantile(double q) {
+    const double r = 0.180625 - q * q;
+    return q * (((((((2.5090809287301226727e+3 * r + 3.3430575583588128105e+4) * r +
+                     6.7265770927008700853e+4) * r + 4.5921953931549871457e+4) * r +
+                   1.3731693765509461125e+4) * r + 1.9715909503065514427e+3) * r +
+                 1.3314166789178437745e+2) * r + 3.3871328727963666080e+0) /
+           (((((((5.2264952788528545610e+3 * r + 2.8729085735721942674e+4) * r +
+                 3.9307895800092710610e+4) * r + 2.1213794301586595867e+4) * r +
+               5.3941960214247511077e+3) * r + 6.8718700749205790830e+2) * r +
+             4.2313330701600911252e+1) * r + 1.0);
+}
+
+// p in (0, 1) outside the central range; 1 - p is exact for p > 0.5
+double tailQuantile(double p) {
+    const double q = p - 0.5;
+    double r = std::sqrt(-std::log(q < 0.0 ? p : 1.0 - p));
+    double x;
+    if (r <= 5.0) {
+        r -= 1.6;
+        x = (((((((7.74545014278341407640e-4 * r + 2.27238449892691845833e-2) * r +
+                  2.41780725177450611770e-1) * r + 1.27045825245236838258e+0) * r +
+                3.64784832476320460504e+0) * r + 5.76949722146069140550e+0) * r +
+              4.63033784615654529590e+0) * r + 1.42343711074968357734e+0) /
+            (((((((1.05075007164441684324e-9 * r + 5.47593808499534494600e-4) * r +
+                  1.51986665636164571966e-2) * r + 1.48103976427480074590e-1) * r +
+                6.89767334985100004550e-1) * r + 1.67638483018380384940e+0) * r +
+              2.05319162663775882187e+0) * r + 1.0);
+    } else {
+        r -= 5.0;
+        x = (((((((2.01033439929228813265e-7 * r + 2.71155556874348757815e-5) * r +
+                  1.24266094738807843860e-3) * r + 2.65321895265761230930e-2) * r +
+                2.96560571828504891230e-1) * r + 1.78482653991729133580e+0) * r +
+              5.46378491116411436990e+0) * r + 6.65790464350110377720e+0) /
+            (((((((2.04426310338993978564e-15 * r + 1.42151175831644588870e-7) * r +
+                  1.84631831751005468180e-5) * r + 7.86869131145613259100e-4) * r +
+                1.48753612908506148525e-2) * r + 1.36929880922735805310e-1) * r +
+              5.99832206555887937690e-1) * r + 1.0);
+    }
+    return q < 0.0 ? -x : x;
+}
+
+} // namespace
+
+Counter block(Counter counter, Key key) {
+    for (int r = 0; r < 9; ++r) {
+        counter = round(counter, key);
+        key[0] += kWeyl0;
+        key[1] += kWeyl1;
+    }
+    return round(counter, key);
+}
+
+double uniform(uint64_t seed, uint64_t path, uint32_t asset, uint32_t factor) {
+    const Counter draw = block({static_cast<uint32_t>(path), static_cast<uint32_t>(path >> 32), asset, factor},
+                               {static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32)});
+    return toUniform(draw[0], draw[1]);
+}
+
+double normal(uint64_t seed, uint64_t path, uint32_t asset, uint32_t factor) {
+    return inverseNormal(uniform(seed, path, asset, factor));
+}
+
+double inverseNormal(double p) {
+    if (!(p > 0.0 && p < 1.0)) {
+        return p == 0.0 ? -INFINITY : p == 1.0 ? INFINITY : NAN;
+    }
+    const double q = p - 0.5;
+    return std::abs(q) <= kCentralHalfWidth ? centralQuantile(q) : tailQuantile(p);
+}
+
+void fillUniforms(uint64_t seed, const uint64_t* paths, size_t count, uint32_t asset, uint32_t factor,
+                  double* out) {
+    double chunk[kChunk];
+    for (size_t begin = 0; begin < count; begin += kChunk) {
+        const size_t n = std::min(kChunk, count - begin);
+        uniformChunk(seed, paths + begin, n, asset, factor, chunk);
+        std::copy(chunk, chunk + n, out + begin);
+    }
+}
+
+void fillNormals(uint64_t seed, const uint64_t* paths, size_t count, uint32_t asset, uint32_t factor,
+                 double* out) {
+    // The central rational is evaluated for every draw, then the ~15% in the
+    // tails are replaced; uniforms never reach 0 or 1
+    double chunk[kChunk];
+    double central[kChunk];
+    for (size_t begin = 0; begin < count; begin += kChunk) {
+        const size_t n = std::min(kChunk, count - begin);
+        uniformChunk(seed, paths + begin, n, asset, factor, chunk);
+        for (size_t i = 0; i < kChunk; ++i) {
+            central[i] = centralQuantile(chunk[i] - 0.5);
+        }
+        for (size_t i = 0; i < n; ++i) {
+            out[begin + i] = std::abs(chunk[i] - 0.5) <= kCentralHalfWidth ? central[i] : tailQuantile(chunk[i]);
+        }
+    }
+}
+
+} // namespace Philox
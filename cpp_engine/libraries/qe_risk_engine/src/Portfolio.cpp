@@ -1,9 +1,10 @@
 #include "Portfolio.h"
+#include "PortfolioFile.h"
 #include <algorithm>
 #include <sstream>
 #include <climits>
 
-void Portfolio::addInstrument(std::unique_ptr<Instrument> instrument, int quantity)
+PositionHandle Portfolio::addInstrument(std::unique_ptr<Instrument> instrument, int quantity)
 {
     if (!instrument)
     {
@@ -28,9 +29,18 @@ void Portfolio::addInstrument(std::unique_ptr<Instrument> instrument, int quanti
         instruments.reserve(instruments.size() * 2);
     }
 
+    std::string key = instrument->getContractKey();
+
     try
     {
+        const PositionHandle handle = next_handle;
         instruments.emplace_back(std::move(instrument), quantity);
+        row_links.push_back({handle, 0, 0, 0});
+        handle_rows.emplace(handle, instruments.size() - 1);
+        ++next_handle;
+        indexRow(instruments.size() - 1, std::move(key));
+        ++version;
+        return handle;
     }
     catch (const std::bad_alloc &e)
     {
@@ -61,6 +71,13 @@ void Portfolio::clear()
 {
     instruments.clear();
     instruments.shrink_to_fit();
+    row_links.clear();
+    row_links.shrink_to_fit();
+    netted_positions.clear();
+    contract_index.clear();
+    asset_index.clear();
+    std::unordered_map<PositionHandle, size_t>().swap(handle_rows);
+    ++version;
 }
 
 void Portfolio::reserve(size_t capacity)
@@ -68,6 +85,8 @@ void Portfolio::reserve(size_t capacity)
     try
     {
         instruments.reserve(capacity);
+        row_links.reserve(capacity);
+        handle_rows.reserve(capacity);
     }
     catch (const std::bad_alloc &e)
     {
@@ -82,32 +101,293 @@ int Portfolio::getTotalQuantityForAsset(const std::string &asset_id) const
         throw std::invalid_argument("Asset ID cannot be empty");
     }
 
-    int total = 0;
-    for (const auto &[instr, qty] : instruments)
+    auto it = asset_index.find(asset_id);
+    if (it == asset_index.end())
     {
-        if (instr && instr->getAssetId() == asset_id)
-        {
-            if ((qty > 0 && total > INT_MAX - qty) ||
-                (qty < 0 && total < INT_MIN - qty))
-            {
-                throw std::overflow_error("Quantity overflow for asset " + asset_id);
-            }
-            total += qty;
-        }
+        return 0;
+    }
+
+    const long long total = it->second.net_quantity;
+    if (total > INT_MAX || total < INT_MIN)
+    {
+        throw std::overflow_error("Quantity overflow for asset " + asset_id);
     }
-    return total;
+    return static_cast<int>(total);
+}
+
+const std::vector<size_t> &Portfolio::getRowsForAsset(const std::string &asset_id) const
+{
+    static const std::vector<size_t> no_rows;
+    auto it = asset_index.find(asset_id);
+    return it == asset_index.end() ? no_rows : it->second.rows;
+}
+
+std::map<std::string, long long> Portfolio::getNetPositions() const
+{
+    std::map<std::string, long long> net_positions;
+    for (const auto &[asset_id, asset] : asset_index)
+    {
+        net_positions.emplace(asset_id, asset.net_quantity);
+    }
+    return net_positions;
 }
 
 void Portfolio::removeInstrument(size_t index)
 {
     validateIndex(index);
+    handle_rows.erase(row_links[index].handle);
     instruments.erase(instruments.begin() + index);
+    row_links.erase(row_links.begin() + index);
+    rebuildIndexes();
+    ++version;
+}
+
+void Portfolio::removePosition(PositionHandle handle)
+{
+    const size_t row = getIndex(handle);
+    unlinkRow(row);
+    handle_rows.erase(handle);
+
+    const size_t last = instruments.size() - 1;
+    if (row != last)
+    {
+        moveRow(last, row);
+    }
+    instruments.pop_back();
+    row_links.pop_back();
+    ++version;
+}
+
+PositionHandle Portfolio::getHandle(size_t index) const
+{
+    validateIndex(index);
+    return row_links[index].handle;
+}
+
+size_t Portfolio::getIndex(PositionHandle handle) const
+{
+    auto it = handle_rows.find(handle);
+    if (it == handle_rows.end())
+    {
+        throw std::out_of_range("Unknown position handle " + std::to_string(handle));
+    }
+    return it->second;
 }
 
 void Portfolio::updateQuantity(size_t index, int new_quantity)
 {
     validateIndex(index);
+    const long long change = static_cast<long long>(new_quantity) - instruments[index].second;
+    netted_positions[row_links[index].netted_index].quantity += change;
+    asset_index.at(instruments[index].first->getAssetId()).net_quantity += change;
     instruments[index].second = new_quantity;
+    ++version;
+}
+
+uint64_t Portfolio::getVersion() const
+{
+    return version;
+}
+
+void Portfolio::saveBinary(const std::string &path) const
+{
+    PortfolioFile::save(*this, path);
+}
+
+void Portfolio::loadBinary(const std::string &path)
+{
+    // Handles of the old rows must not resolve to the new ones, so numbering
+    // carries on from ours, and the version has to move so cached results
+    // are invalidated
+    Portfolio loaded;
+    loaded.next_handle = next_handle;
+    PortfolioFile::load(path, loaded);
+    const uint64_t next_version = version + 1;
+    *this = std::move(loaded);
+    version = next_version;
+}
+
+const std::vector<NettedPosition> &Portfolio::getNettedPositions() const
+{
+    return netted_positions;
+}
+
+void Portfolio::indexRow(size_t row, std::string key)
+{
+    RowLinks &links = row_links[row];
+    const int quantity = instruments[row].second;
+
+    auto [it, inserted] = contract_index.try_emplace(std::move(key), netted_positions.size());
+    if (inserted)
+    {
+        netted_positions.push_back({row, 0, {}});
+    }
+    NettedPosition &position = netted_positions[it->second];
+    position.quantity += quantity;
+    links.netted_index = it->second;
+    links.netted_slot = position.rows.size();
+    position.rows.push_back(row);
+
+    AssetPositions &asset = asset_index[instruments[row].first->getAssetId()];
+    asset.net_quantity += quantity;
+    links.asset_slot = asset.rows.size();
+    asset.rows.push_back(row);
+}
+
+void Portfolio::unlinkRow(size_t row)
+{
+    const RowLinks links = row_links[row];
+    const int quantity = instruments[row].second;
+
+    auto asset_it = asset_index.find(instruments[row].first->getAssetId());
+    AssetPositions &asset = asset_it->second;
+    asset.net_quantity -= quantity;
+    asset.rows[links.asset_slot] = asset.rows.back();
+    row_links[asset.rows.back()].asset_slot = links.asset_slot;
+    asset.rows.pop_back();
+    if (asset.rows.empty())
+    {
+        asset_index.erase(asset_it);
+    }
+
+    NettedPosition &position = netted_positions[links.netted_index];
+    position.quantity -= quantity;
+    position.rows[links.netted_slot] = position.rows.back();
+    row_links[position.rows.back()].netted_slot = links.netted_slot;
+    position.rows.pop_back();
+    if (!position.rows.empty())
+    {
+        if (position.instrument_index == row)
+        {
+            position.instrument_index = position.rows.front();
+        }
+        return;
+    }
+
+    // The contract is gone; the last netted position takes its slot
+    contract_index.erase(instruments[row].first->getContractKey());
+    const size_t last = netted_positions.size() - 1;
+    if (links.netted_index != last)
+    {
+        NettedPosition &moved = netted_positions[links.netted_index];
+        moved = std::move(netted_positions[last]);
+        contract_index[instruments[moved.instrument_index].first->getContractKey()] = links.netted_index;
+        for (size_t moved_row : moved.rows)
+        {
+            row_links[moved_row].netted_index = links.netted_index;
+        }
+    }
+    netted_positions.pop_back();
+}
+
+void Portfolio::moveRow(size_t from, size_t to)
+{
+    instruments[to] = std::move(instruments[from]);
+    row_links[to] = row_links[from];
+
+    const RowLinks &links = row_links[to];
+    asset_index.at(instruments[to].first->getAssetId()).rows[links.asset_slot] = to;
+    NettedPosition &position = netted_positions[links.netted_index];
+    position.rows[links.netted_slot] = to;
+    if (position.instrument_index == from)
+    {
+        position.instrument_index = to;
+    }
+    handle_rows[links.handle] = to;
+}
+
+void Portfolio::rebuildIndexes()
+{
+    netted_positions.clear();
+    contract_index.clear();
+    asset_index.clear();
+    for (size_t row = 0; row < instruments.size(); ++row)
+    {
+        handle_rows[row_links[row].handle] = row;
+        indexRow(row, instruments[row].first->getContractKey());
+    }
+}
+
+void Portfolio::adoptRows(std::vector<std::pair<std::unique_ptr<Instrument>, int>> rows,
+                          const std::vector<std::string> &asset_ids,
+                          const std::vector<uint32_t> &row_assets,
+                          const std::vector<uint32_t> &row_contracts, size_t contracts)
+{
+    if (!empty())
+    {
+        throw std::logic_error("adoptRows needs an empty portfolio");
+    }
+    const size_t count = rows.size();
+    instruments = std::move(rows);
+    row_links.resize(count);
+    handle_rows.reserve(count);
+
+    std::vector<AssetPositions> assets(asset_ids.size());
+    {
+        std::vector<size_t> asset_rows(asset_ids.size(), 0);
+        for (uint32_t asset : row_assets)
+        {
+            ++asset_rows[asset];
+        }
+        for (size_t a = 0; a < assets.size(); ++a)
+        {
+            assets[a].rows.reserve(asset_rows[a]);
+        }
+    }
+
+    std::vector<size_t> contract_rows(contracts, 0);
+    for (uint32_t contract : row_contracts)
+    {
+        ++contract_rows[contract];
+    }
+
+    // Netted position of each contract number, looked up by key only the
+    // first time the number is seen
+    const size_t unseen = SIZE_MAX;
+    std::vector<size_t> contract_netted(contracts, unseen);
+    netted_positions.reserve(contracts);
+    contract_index.reserve(contracts);
+
+    for (size_t row = 0; row < count; ++row)
+    {
+        RowLinks &links = row_links[row];
+        const int quantity = instruments[row].second;
+        links.handle = next_handle++;
+        handle_rows.emplace(links.handle, row);
+
+        size_t &netted = contract_netted[row_contracts[row]];
+        if (netted == unseen)
+        {
+            auto [it, inserted] = contract_index.try_emplace(instruments[row].first->getContractKey(),
+                                                             netted_positions.size());
+            if (inserted)
+            {
+                netted_positions.push_back({row, 0, {}});
+                netted_positions.back().rows.reserve(contract_rows[row_contracts[row]]);
+            }
+            netted = it->second;
+        }
+        NettedPosition &position = netted_positions[netted];
+        position.quantity += quantity;
+        links.netted_index = netted;
+        links.netted_slot = position.rows.size();
+        position.rows.push_back(row);
+
+        AssetPositions &asset = assets[row_assets[row]];
+        asset.net_quantity += quantity;
+        links.asset_slot = asset.rows.size();
+        asset.rows.push_back(row);
+    }
+
+    asset_index.reserve(assets.size());
+    for (size_t a = 0; a < assets.size(); ++a)
+    {
+        if (!assets[a].rows.empty())
+        {
+            asset_index.emplace(asset_ids[a], std::move(assets[a]));
+        }
+    }
+    ++version;
 }
 
 void Portfolio::validateIndex(size_t index) const
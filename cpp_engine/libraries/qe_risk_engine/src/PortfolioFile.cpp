@@ -0,0 +1,473 @@
+#include "PortfolioFile.h"
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define QE_HAVE_MMAP 1
+#endif
+
+namespace PortfolioFile {
+
+namespace {
+
+enum Column {
+    Strike,
+    Expiry,
+    JumpIntensity,
+    JumpMean,
+    JumpVolatility,
+    Quantity,
+    AssetIndex,
+    BinomialSteps,
+    FdSpaceSteps,
+    FdTimeSteps,
+    Style,
+    Type,
+    Model,
+    kColumnCount
+};
+
+const size_t kColumnWidth[kColumnCount] = {8, 8, 8, 8, 8, 4, 4, 4, 4, 4, 1, 1, 1};
+
+enum InstrumentStyle : uint8_t { European = 0, American = 1 };
+
+const char kMagic[4] = {'Q', 'E', 'P', 'F'};
+
+struct Header {
+    char magic[4];
+    uint32_t version;
+    uint64_t row_count;
+    uint64_t asset_count;
+    uint64_t asset_offsets;     // asset_count + 1 uint64 offsets into asset_names
+    uint64_t asset_names;
+    uint64_t columns[kColumnCount];
+    uint64_t file_size;
+    uint64_t checksum;
+};
+
+static_assert(sizeof(Header) % 8 == 0, "Header must keep sections 8-byte aligned");
+
+uint64_t padded(uint64_t bytes) {
+    return (bytes + 7) & ~uint64_t(7);
+}
+
+void requireLittleEndian() {
+    const uint16_t probe = 1;
+    if (*reinterpret_cast<const unsigned char*>(&probe) != 1) {
+        throw std::runtime_error("Binary portfolio files require a little-endian host");
+    }
+}
+
+// Four independent multiply-xorshift lanes over 64-bit words, so the
+// checksum runs at memory speed rather than at one multiply latency per word
+uint64_t checksum(const char* data, size_t bytes) {
+    uint64_t lanes[4] = {
+        0x9E3779B97F4A7C15ULL, 0xC2B2AE3D27D4EB4FULL,
+        0x165667B19E3779F9ULL, 0xD6E8FEB86659FD93ULL
+    };
+    const size_t words = bytes / 8;
+    size_t i = 0;
+    for (; i + 4 <= words; i += 4) {
+        for (int lane = 0; lane < 4; ++lane) {
+            uint64_t word;
+            std::memcpy(&word, data + 8 * (i + lane), 8);
+            lanes[lane] = (lanes[lane] ^ word) * 0xFF51AFD7ED558CCDULL;
+            lanes[lane] ^= lanes[lane] >> 29;
+        }
+    }
+    for (; i < words; ++i) {
+        uint64_t word;
+        std::memcpy(&word, data + 8 * i, 8);
+        lanes[0] = (lanes[0] ^ word) * 0xFF51AFD7ED558CCDULL;
+        lanes[0] ^= lanes[0] >> 29;
+    }
+    uint64_t hash = bytes;
+    for (uint64_t lane : lanes) {
+        hash = (hash ^ lane) * 0xC4CEB9FE1A85EC53ULL;
+        hash ^= hash >> 33;
+    }
+    return hash;
+}
+
+template <typename T>
+T readAt(const char* column, size_t row) {
+    T value;
+    std::memcpy(&value, column + row * sizeof(T), sizeof(T));
+    return value;
+}
+
+template <typename T>
+void writeAt(char* column, size_t row, T value) {
+    std::memcpy(column + row * sizeof(T), &value, sizeof(T));
+}
+
+// Read-only view of a whole file: mmap where available, a heap copy otherwise
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path) {
+#ifdef QE_HAVE_MMAP
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Cannot open portfolio file " + path);
+        }
+        struct stat info;
+        if (::fstat(fd, &info) != 0) {
+            ::close(fd);
+            throw std::runtime_error("Cannot read portfolio file " + path);
+        }
+        size_ = static_cast<size_t>(info.st_size);
+        if (size_ > 0) {
+            void* mapped = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped != MAP_FAILED) {
+                mapping_ = mapped;
+                data_ = static_cast<const char*>(mapped);
+                ::madvise(mapped, size_, MADV_SEQUENTIAL);
+            }
+        }
+        ::close(fd);
+        if (mapping_ || size_ == 0) {
+            return;
+        }
+#endif
+        std::ifstream in(path, std::ios::binary | std::ios::ate);
+        if (!in) {
+            throw std::runtime_error("Cannot open portfolio file " + path);
+        }
+        size_ = static_cast<size_t>(in.tellg());
+        buffer_.resize(size_);
+        in.seekg(0);
+        if (!in.read(buffer_.data(), static_cast<std::streamsize>(size_))) {
+            throw std::runtime_error("Cannot read portfolio file " + path);
+        }
+        data_ = buffer_.data();
+    }
+
+    ~MappedFile() {
+#ifdef QE_HAVE_MMAP
+        if (mapping_) {
+            ::munmap(mapping_, size_);
+        }
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    void* mapping_ = nullptr;
+    std::vector<char> buffer_;
+};
+
+void corrupt(const std::string& path, const std::string& reason) {
+    throw std::runtime_error("Corrupt portfolio file " + path + ": " + reason);
+}
+
+// The fields Instrument::getContractKey() encodes, as the same bit patterns,
+// with those the pricing model ignores zeroed: rows with equal columns hold
+// the same contract, so the key string is built once per contract
+struct ContractColumns {
+    uint64_t strike = 0;
+    uint64_t expiry = 0;
+    uint64_t jump_intensity = 0;
+    uint64_t jump_mean = 0;
+    uint64_t jump_volatility = 0;
+    int32_t steps = 0;
+    int32_t space_steps = 0;
+    int32_t time_steps = 0;
+    uint32_t asset = 0;
+    uint8_t style = 0;
+    uint8_t type = 0;
+    uint8_t model = 0;
+
+    bool operator==(const ContractColumns& other) const {
+        return strike == other.strike && expiry == other.expiry &&
+               jump_intensity == other.jump_intensity && jump_mean == other.jump_mean &&
+               jump_volatility == other.jump_volatility && steps == other.steps &&
+               space_steps == other.space_steps && time_steps == other.time_steps &&
+               asset == other.asset && style == other.style && type == other.type &&
+               model == other.model;
+    }
+};
+
+struct ContractColumnsHash {
+    size_t operator()(const ContractColumns& c) const {
+        const uint64_t words[] = {
+            c.strike, c.expiry, c.jump_intensity, c.jump_mean, c.jump_volatility,
+            (uint64_t(uint32_t(c.steps)) << 32) | uint32_t(c.space_steps),
+            (uint64_t(uint32_t(c.time_steps)) << 32) | c.asset,
+            (uint64_t(c.style) << 16) | (uint64_t(c.type) << 8) | c.model
+        };
+        uint64_t hash = 0x9E3779B97F4A7C15ULL;
+        for (uint64_t word : words) {
+            hash = (hash ^ word) * 0xFF51AFD7ED558CCDULL;
+            hash ^= hash >> 29;
+        }
+        return static_cast<size_t>(hash);
+    }
+};
+
+} // namespace
+
+void save(const Portfolio& portfolio, const std::string& path) {
+    requireLittleEndian();
+
+    const auto& instruments = portfolio.getInstruments();
+    const size_t rows = instruments.size();
+
+    std::vector<std::string> asset_ids;
+    std::unordered_map<std::string, uint32_t> asset_lookup;
+    std::vector<uint32_t> row_assets(rows);
+    for (size_t row = 0; row < rows; ++row) {
+        const std::string asset_id = instruments[row].first->getAssetId();
+        auto [it, inserted] = asset_lookup.emplace(asset_id, static_cast<uint32_t>(asset_ids.size()));
+        if (inserted) {
+            asset_ids.push_back(asset_id);
+        }
+        row_assets[row] = it->second;
+    }
+
+    Header header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kFormatVersion;
+    header.row_count = rows;
+    header.asset_count = asset_ids.size();
+
+    uint64_t names_bytes = 0;
+    for (const auto& asset_id : asset_ids) {
+        names_bytes += asset_id.size();
+    }
+    uint64_t offset = sizeof(Header);
+    header.asset_offsets = offset;
+    offset += 8 * (asset_ids.size() + 1);
+    header.asset_names = offset;
+    offset += padded(names_bytes);
+    for (int column = 0; column < kColumnCount; ++column) {
+        header.columns[column] = offset;
+        offset += padded(kColumnWidth[column] * rows);
+    }
+    header.file_size = offset;
+
+    std::vector<char> file(offset, 0);
+    char* base = file.data();
+
+    uint64_t name_offset = 0;
+    for (size_t a = 0; a < asset_ids.size(); ++a) {
+        writeAt<uint64_t>(base + header.asset_offsets, a, name_offset);
+        std::memcpy(base + header.asset_names + name_offset, asset_ids[a].data(), asset_ids[a].size());
+        name_offset += asset_ids[a].size();
+    }
+    writeAt<uint64_t>(base + header.asset_offsets, asset_ids.size(), name_offset);
+
+    auto column = [&](Column c) { return base + header.columns[c]; };
+    for (size_t row = 0; row < rows; ++row) {
+        const Instrument* instrument = instruments[row].first.get();
+        double strike, expiry, intensity = 0.0, jump_mean = 0.0, jump_vol = 0.0;
+        int steps, space_steps, time_steps;
+        OptionType type;
+        PricingModel model;
+        uint8_t style;
+
+        if (const auto* european = dynamic_cast<const EuropeanOption*>(instrument)) {
+            style = European;
+            type = european->getOptionType();
+            strike = european->getStrike();
+            expiry = european->getTimeToExpiry();
+            model = european->getPricingModel();
+            steps = european->getBinomialSteps();
+            intensity = european->getJumpIntensity();
+            jump_mean = european->getJumpMean();
+            jump_vol = european->getJumpVolatility();
+            space_steps = european->getFiniteDifferenceSpaceSteps();
+            time_steps = european->getFiniteDifferenceTimeSteps();
+        } else if (const auto* american = dynamic_cast<const AmericanOption*>(instrument)) {
+            style = American;
+            type = american->getOptionType();
+            strike = american->getStrike();
+            expiry = american->getTimeToExpiry();
+            model = american->getPricingModel();
+            steps = american->getBinomialSteps();
+            space_steps = american->getFiniteDifferenceSpaceSteps();
+            time_steps = american->getFiniteDifferenceTimeSteps();
+        } else {
+            throw std::runtime_error("Cannot save instrument of type " + instrument->getInstrumentType());
+        }
+
+        writeAt<double>(column(Strike), row, strike);
+        writeAt<double>(column(Expiry), row, expiry);
+        writeAt<double>(column(JumpIntensity), row, intensity);
+        writeAt<double>(column(JumpMean), row, jump_mean);
+        writeAt<double>(column(JumpVolatility), row, jump_vol);
+        writeAt<int32_t>(column(Quantity), row, instruments[row].second);
+        writeAt<uint32_t>(column(AssetIndex), row, row_assets[row]);
+        writeAt<int32_t>(column(BinomialSteps), row, steps);
+        writeAt<int32_t>(column(FdSpaceSteps), row, space_steps);
+        writeAt<int32_t>(column(FdTimeSteps), row, time_steps);
+        writeAt<uint8_t>(column(Style), row, style);
+        writeAt<uint8_t>(column(Type), row, static_cast<uint8_t>(type));
+        writeAt<uint8_t>(column(Model), row, static_cast<uint8_t>(model));
+    }
+
+    header.checksum = checksum(base + sizeof(Header), offset - sizeof(Header));
+    std::memcpy(base, &header, sizeof(Header));
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out || !out.write(base, static_cast<std::streamsize>(offset))) {
+        throw std::runtime_error("Cannot write portfolio file " + path);
+    }
+}
+
+void load(const std::string& path, Portfolio& portfolio) {
+    requireLittleEndian();
+    if (!portfolio.empty()) {
+        throw std::invalid_argument("Portfolio must be empty before loading " + path);
+    }
+
+    const MappedFile file(path);
+    const char* base = file.data();
+
+    Header header;
+    if (file.size() < sizeof(Header)) {
+        corrupt(path, "truncated header");
+    }
+    std::memcpy(&header, base, sizeof(Header));
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) {
+        throw std::runtime_error(path + " is not a binary portfolio file");
+    }
+    if (header.version != kFormatVersion) {
+        throw std::runtime_error("Unsupported portfolio file version " + std::to_string(header.version));
+    }
+    if (header.file_size != file.size()) {
+        corrupt(path, "size does not match header");
+    }
+
+    const uint64_t rows = header.row_count;
+    const uint64_t assets = header.asset_count;
+    auto within = [&](uint64_t offset, uint64_t bytes) {
+        return offset % 8 == 0 && offset >= sizeof(Header) && offset <= file.size() &&
+               bytes <= file.size() - offset;
+    };
+    if (rows > file.size() || assets > file.size() ||
+        !within(header.asset_offsets, 8 * (assets + 1))) {
+        corrupt(path, "section out of bounds");
+    }
+    for (int column = 0; column < kColumnCount; ++column) {
+        if (!within(header.columns[column], kColumnWidth[column] * rows)) {
+            corrupt(path, "section out of bounds");
+        }
+    }
+    if (checksum(base + sizeof(Header), file.size() - sizeof(Header)) != header.checksum) {
+        corrupt(path, "checksum mismatch");
+    }
+
+    std::vector<std::string> asset_ids(assets);
+    std::unordered_set<std::string_view> seen_assets;
+    seen_assets.reserve(assets);
+    const uint64_t names_bytes = readAt<uint64_t>(base + header.asset_offsets, assets);
+    if (!within(header.asset_names, names_bytes)) {
+        corrupt(path, "section out of bounds");
+    }
+    for (uint64_t a = 0; a < assets; ++a) {
+        const uint64_t begin = readAt<uint64_t>(base + header.asset_offsets, a);
+        const uint64_t end = readAt<uint64_t>(base + header.asset_offsets, a + 1);
+        if (begin > end || end > names_bytes) {
+            corrupt(path, "bad asset table");
+        }
+        asset_ids[a].assign(base + header.asset_names + begin, end - begin);
+        if (!seen_assets.insert(asset_ids[a]).second) {
+            corrupt(path, "duplicate asset id " + asset_ids[a]);
+        }
+    }
+
+    // Rows are grouped by contract straight from the columns in a first
+    // pass, kept apart from object construction so the contract table stays
+    // in cache. The built rows are handed to the portfolio in one piece; it
+    // then indexes each asset and contract once rather than per row.
+    auto column = [&](Column c) { return base + header.columns[c]; };
+    std::vector<uint32_t> row_assets(rows);
+    std::vector<uint32_t> row_contracts(rows);
+    std::unordered_map<ContractColumns, uint32_t, ContractColumnsHash> contracts;
+    for (uint64_t row = 0; row < rows; ++row) {
+        const uint32_t asset = readAt<uint32_t>(column(AssetIndex), row);
+        const uint8_t style = readAt<uint8_t>(column(Style), row);
+        const uint8_t type = readAt<uint8_t>(column(Type), row);
+        const uint8_t model = readAt<uint8_t>(column(Model), row);
+        if (asset >= assets || style > American || type > 1 ||
+            model > static_cast<uint8_t>(PricingModel::BaroneAdesiWhaley)) {
+            corrupt(path, "bad value in row " + std::to_string(row));
+        }
+
+        ContractColumns contract;
+        contract.strike = readAt<uint64_t>(column(Strike), row);
+        contract.expiry = readAt<uint64_t>(column(Expiry), row);
+        contract.asset = asset;
+        contract.style = style;
+        contract.type = type;
+        contract.model = model;
+        switch (static_cast<PricingModel>(model)) {
+        case PricingModel::Binomial:
+            contract.steps = readAt<int32_t>(column(BinomialSteps), row);
+            break;
+        case PricingModel::FiniteDifference:
+            contract.space_steps = readAt<int32_t>(column(FdSpaceSteps), row);
+            contract.time_steps = readAt<int32_t>(column(FdTimeSteps), row);
+            break;
+        case PricingModel::MertonJumpDiffusion:
+            if (style == European) {
+                contract.jump_intensity = readAt<uint64_t>(column(JumpIntensity), row);
+                contract.jump_mean = readAt<uint64_t>(column(JumpMean), row);
+                contract.jump_volatility = readAt<uint64_t>(column(JumpVolatility), row);
+            }
+            break;
+        default:
+            break;
+        }
+        row_assets[row] = asset;
+        row_contracts[row] = contracts.try_emplace(contract, static_cast<uint32_t>(contracts.size())).first->second;
+    }
+
+    std::vector<std::pair<std::unique_ptr<Instrument>, int>> built;
+    built.reserve(rows);
+    for (uint64_t row = 0; row < rows; ++row) {
+        const std::string& asset_id = asset_ids[row_assets[row]];
+        const OptionType type = static_cast<OptionType>(readAt<uint8_t>(column(Type), row));
+        const PricingModel model = static_cast<PricingModel>(readAt<uint8_t>(column(Model), row));
+        const double strike = readAt<double>(column(Strike), row);
+        const double expiry = readAt<double>(column(Expiry), row);
+        const int steps = readAt<int32_t>(column(BinomialSteps), row);
+        const int space_steps = readAt<int32_t>(column(FdSpaceSteps), row);
+        const int time_steps = readAt<int32_t>(column(FdTimeSteps), row);
+        const int quantity = readAt<int32_t>(column(Quantity), row);
+
+        if (readAt<uint8_t>(column(Style), row) == European) {
+            auto option = std::make_unique<EuropeanOption>(type, strike, expiry, asset_id, model);
+            option->setBinomialSteps(steps);
+            option->setFiniteDifferenceGrid(space_steps, time_steps);
+            option->setJumpParameters(readAt<double>(column(JumpIntensity), row),
+                                      readAt<double>(column(JumpMean), row),
+                                      readAt<double>(column(JumpVolatility), row));
+            built.emplace_back(std::move(option), quantity);
+        } else {
+            auto option = std::make_unique<AmericanOption>(type, strike, expiry, asset_id, steps);
+            option->setPricingModel(model);
+            option->setFiniteDifferenceGrid(space_steps, time_steps);
+            built.emplace_back(std::move(option), quantity);
+        }
+    }
+    portfolio.adoptRows(std::move(built), asset_ids, row_assets, row_contracts, contracts.size());
+}
+
+} // namespace PortfolioFile
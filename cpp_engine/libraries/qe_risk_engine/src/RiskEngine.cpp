@@ -1,71 +1,257 @@
 #include "RiskEngine.h"
+#include "AllocationCounter.h"
+#include "AndersenLakeOffengeld.h"
+#include "BaroneAdesiWhaley.h"
+#include "FiniteDifference.h"
+#include "Philox.h"
 #include <numeric>
 #include <random>
 #include <algorithm>
 #include <vector>
 #include <cmath>
+#include <chrono>
+#include <ctime>
 #include <sstream>
 #include <limits>
+#include <tuple>
 
-RiskEngine::RiskEngine() 
+RiskConfig::RiskConfig()
     : var_simulations_(10000),
       time_horizon_days_(1.0),
       random_seed_(0),
-      use_fixed_seed_(false) {
+      use_fixed_seed_(false),
+      fast_american_revaluation_(false),
+      jump_diffusion_scenarios_(false),
+      diagnostics_(false),
+      random_generator_(RandomGenerator::MersenneTwister) {
 }
 
-RiskEngine::RiskEngine(int var_simulations)
-    : var_simulations_(var_simulations),
-      time_horizon_days_(1.0),
-      random_seed_(0),
-      use_fixed_seed_(false) {
-    validateParameters();
-}
-
-void RiskEngine::setVaRSimulations(int simulations) {
+RiskConfig RiskConfig::withVaRSimulations(int simulations) const {
     if (simulations <= 0) {
         throw std::invalid_argument("VaR simulations must be positive");
     }
     if (simulations > 1000000) {
         throw std::invalid_argument("VaR simulations cannot exceed 1,000,000");
     }
-    var_simulations_ = simulations;
+    RiskConfig config = *this;
+    config.var_simulations_ = simulations;
+    return config;
 }
 
-int RiskEngine::getVaRSimulations() const {
-    return var_simulations_;
-}
-
-void RiskEngine::setVaRTimeHorizonDays(double days) {
+RiskConfig RiskConfig::withVaRTimeHorizonDays(double days) const {
     if (days <= 0.0) {
         throw std::invalid_argument("Time horizon must be positive");
     }
     if (days > 252.0) {
         throw std::invalid_argument("Time horizon cannot exceed 252 trading days");
     }
-    time_horizon_days_ = days;
+    RiskConfig config = *this;
+    config.time_horizon_days_ = days;
+    return config;
 }
 
-double RiskEngine::getVaRTimeHorizonDays() const {
+RiskConfig RiskConfig::withRandomSeed(unsigned int seed) const {
+    RiskConfig config = *this;
+    config.random_seed_ = seed;
+    config.use_fixed_seed_ = true;
+    return config;
+}
+
+RiskConfig RiskConfig::withoutFixedSeed() const {
+    RiskConfig config = *this;
+    config.use_fixed_seed_ = false;
+    return config;
+}
+
+RiskConfig RiskConfig::withFastAmericanRevaluation(bool enabled) const {
+    RiskConfig config = *this;
+    config.fast_american_revaluation_ = enabled;
+    return config;
+}
+
+RiskConfig RiskConfig::withJumpDiffusionScenarios(bool enabled) const {
+    RiskConfig config = *this;
+    config.jump_diffusion_scenarios_ = enabled;
+    return config;
+}
+
+RiskConfig RiskConfig::withDiagnostics(bool enabled) const {
+    RiskConfig config = *this;
+    config.diagnostics_ = enabled;
+    return config;
+}
+
+RiskConfig RiskConfig::withRandomGenerator(RandomGenerator generator) const {
+    RiskConfig config = *this;
+    config.random_generator_ = generator;
+    return config;
+}
+
+RiskConfig RiskConfig::withTrace(std::shared_ptr<TraceRecorder> trace) const {
+    RiskConfig config = *this;
+    config.trace_ = std::move(trace);
+    return config;
+}
+
+int RiskConfig::getVaRSimulations() const {
+    return var_simulations_;
+}
+
+double RiskConfig::getVaRTimeHorizonDays() const {
     return time_horizon_days_;
 }
 
+unsigned int RiskConfig::getRandomSeed() const {
+    return random_seed_;
+}
+
+bool RiskConfig::getUseFixedSeed() const {
+    return use_fixed_seed_;
+}
+
+bool RiskConfig::getFastAmericanRevaluation() const {
+    return fast_american_revaluation_;
+}
+
+bool RiskConfig::getJumpDiffusionScenarios() const {
+    return jump_diffusion_scenarios_;
+}
+
+bool RiskConfig::getDiagnostics() const {
+    return diagnostics_;
+}
+
+RandomGenerator RiskConfig::getRandomGenerator() const {
+    return random_generator_;
+}
+
+TraceRecorder* RiskConfig::getTrace() const {
+    return trace_.get();
+}
+
+void RiskRunControl::cancel() {
+    cancelled_ = true;
+}
+
+bool RiskRunControl::isCancelled() const {
+    return cancelled_;
+}
+
+int RiskRunControl::getCompletedSimulations() const {
+    return completed_;
+}
+
+int RiskRunControl::getTotalSimulations() const {
+    return total_;
+}
+
+double RiskRunControl::getProgress() const {
+    const int total = total_;
+    return total > 0 ? static_cast<double>(completed_) / total : 0.0;
+}
+
+bool RiskRunControl::hasGreeks() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return has_greeks_;
+}
+
+bool RiskRunControl::hasPartialVaR() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return has_partial_var_;
+}
+
+PortfolioRiskResult RiskRunControl::getPartialResult() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return partial_;
+}
+
+void RiskRunControl::start(int total_simulations) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    partial_.reset();
+    has_greeks_ = false;
+    has_partial_var_ = false;
+    completed_ = 0;
+    total_ = total_simulations;
+}
+
+void RiskRunControl::publishGreeks(const PortfolioRiskResult& result) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    partial_ = result;
+    has_greeks_ = true;
+}
+
+void RiskRunControl::publishMetrics(const RiskMetrics& metrics) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    partial_.value_at_risk_95 = metrics.var_95;
+    partial_.value_at_risk_99 = metrics.var_99;
+    partial_.expected_shortfall_95 = metrics.es_95;
+    partial_.expected_shortfall_99 = metrics.es_99;
+    has_partial_var_ = true;
+}
+
+void RiskRunControl::throwIfCancelled() const {
+    if (cancelled_) {
+        throw RiskCalculationCancelled();
+    }
+}
+
+RiskEngine::RiskEngine() {
+}
+
+RiskEngine::RiskEngine(int var_simulations)
+    : config_(RiskConfig().withVaRSimulations(var_simulations)) {
+}
+
+RiskEngine::RiskEngine(const RiskConfig& config)
+    : config_(config) {
+}
+
+const RiskConfig& RiskEngine::getConfig() const {
+    return config_;
+}
+
+void RiskEngine::setConfig(const RiskConfig& config) {
+    config_ = config;
+}
+
+void RiskEngine::setVaRSimulations(int simulations) {
+    config_ = config_.withVaRSimulations(simulations);
+}
+
+int RiskEngine::getVaRSimulations() const {
+    return config_.getVaRSimulations();
+}
+
+void RiskEngine::setVaRTimeHorizonDays(double days) {
+    config_ = config_.withVaRTimeHorizonDays(days);
+}
+
+double RiskEngine::getVaRTimeHorizonDays() const {
+    return config_.getVaRTimeHorizonDays();
+}
+
 void RiskEngine::setRandomSeed(unsigned int seed) {
-    random_seed_ = seed;
-    use_fixed_seed_ = true;
+    config_ = config_.withRandomSeed(seed);
 }
 
 void RiskEngine::setUseFixedSeed(bool use_fixed) {
-    use_fixed_seed_ = use_fixed;
+    config_ = use_fixed ? config_.withRandomSeed(config_.getRandomSeed()) : config_.withoutFixedSeed();
 }
 
-void RiskEngine::validateParameters() const {
-    if (var_simulations_ <= 0 || var_simulations_ > 1000000) {
-        throw std::invalid_argument("Invalid VaR simulations parameter");
-    }
-    if (time_horizon_days_ <= 0.0 || time_horizon_days_ > 252.0) {
-        throw std::invalid_argument("Invalid time horizon parameter");
-    }
+void RiskEngine::setFastAmericanRevaluation(bool enabled) {
+    config_ = config_.withFastAmericanRevaluation(enabled);
+}
+
+bool RiskEngine::getFastAmericanRevaluation() const {
+    return config_.getFastAmericanRevaluation();
+}
+
+void RiskEngine::setJumpDiffusionScenarios(bool enabled) {
+    config_ = config_.withJumpDiffusionScenarios(enabled);
+}
+
+bool RiskEngine::getJumpDiffusionScenarios() const {
+    return config_.getJumpDiffusionScenarios();
 }
 
 void RiskEngine::validateMarketData(
@@ -116,7 +302,7 @@ void RiskEngine::validateMarketData(
 
 double RiskEngine::calculateSingleInstrumentMetric(
     const std::unique_ptr<Instrument>& instrument,
-    int quantity,
+    double quantity,
     const MarketData& md,
     const std::string& metric_name
 ) const {
@@ -158,24 +344,407 @@ double RiskEngine::calculateSingleInstrumentMetric(
     return result;
 }
 
+namespace {
+
+bool usesFiniteDifference(const Instrument& instrument) {
+    if (const auto* european = dynamic_cast<const EuropeanOption*>(&instrument)) {
+        return european->getPricingModel() == PricingModel::FiniteDifference;
+    }
+    if (const auto* american = dynamic_cast<const AmericanOption*>(&instrument)) {
+        return american->getPricingModel() == PricingModel::FiniteDifference;
+    }
+    return false;
+}
+
+FiniteDifference::SolutionSlice solveFiniteDifference(
+    const Instrument& instrument, const MarketData& md
+) {
+    if (const auto* european = dynamic_cast<const EuropeanOption*>(&instrument)) {
+        return european->solveFiniteDifference(md);
+    }
+    return dynamic_cast<const AmericanOption&>(instrument).solveFiniteDifference(md);
+}
+
+double cpuSeconds() {
+#if defined(CLOCK_THREAD_CPUTIME_ID)
+    timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return static_cast<double>(now.tv_sec) + 1e-9 * static_cast<double>(now.tv_nsec);
+#else
+    return static_cast<double>(std::clock()) / CLOCKS_PER_SEC;
+#endif
+}
+
+// Charges elapsed wall and CPU time, and heap allocations when they are
+// counted, to named phases of a RiskDiagnostics and records each lap as a
+// trace span; every call is a no-op with neither
+class PhaseClock {
+public:
+    PhaseClock(RiskDiagnostics* diagnostics, TraceRecorder* trace) : diagnostics_(diagnostics), trace_(trace) {
+        if (diagnostics_ || trace_) {
+            wall_ = std::chrono::steady_clock::now();
+        }
+        if (diagnostics_) {
+            cpu_ = cpuSeconds();
+            if (AllocationCounter::installed()) {
+                diagnostics_->allocations_counted = true;
+                allocs_ = AllocationCounter::current();
+            }
+        }
+    }
+    
+    // Adds the time since the previous lap to `phase`; `first_path` tags
+    // the span of a VaR path block
+    void lap(const char* phase, long long first_path = -1) {
+        if (!diagnostics_ && !trace_) {
+            return;
+        }
+        const auto wall = std::chrono::steady_clock::now();
+        const AllocationCounter::Counts allocs = AllocationCounter::current();
+        if (trace_) {
+            trace_->record(phase, "phase", wall_, wall, first_path < 0 ? nullptr : "first_path", first_path);
+        }
+        if (diagnostics_) {
+            const double cpu = cpuSeconds();
+            auto& phases = diagnostics_->phases;
+            auto it = std::find_if(phases.begin(), phases.end(),
+                                   [&](const RiskPhaseTiming& timing) { return timing.phase == phase; });
+            if (it == phases.end()) {
+                it = phases.insert(phases.end(), RiskPhaseTiming{phase, 0.0, 0.0});
+            }
+            it->wall_seconds += std::chrono::duration<double>(wall - wall_).count();
+            it->cpu_seconds += cpu - cpu_;
+            cpu_ = cpu;
+            if (diagnostics_->allocations_counted) {
+                const long long count = allocs.allocations - allocs_.allocations;
+                const long long bytes = allocs.bytes - allocs_.bytes;
+                it->allocations += count;
+                it->allocated_bytes += bytes;
+                diagnostics_->allocations += count;
+                diagnostics_->allocated_bytes += bytes;
+                // Allocations made by this bookkeeping belong to no phase
+                allocs_ = AllocationCounter::current();
+            }
+        }
+        wall_ = wall;
+    }
+
+private:
+    RiskDiagnostics* diagnostics_;
+    TraceRecorder* trace_;
+    std::chrono::steady_clock::time_point wall_;
+    double cpu_ = 0.0;
+    AllocationCounter::Counts allocs_;
+};
+
+const char* pricingModelName(PricingModel model) {
+    switch (model) {
+        case PricingModel::BlackScholes: return "BlackScholes";
+        case PricingModel::Binomial: return "Binomial";
+        case PricingModel::MertonJumpDiffusion: return "MertonJumpDiffusion";
+        case PricingModel::FiniteDifference: return "FiniteDifference";
+        case PricingModel::AndersenLakeOffengeld: return "AndersenLakeOffengeld";
+        case PricingModel::BaroneAdesiWhaley: return "BaroneAdesiWhaley";
+    }
+    return "Unknown";
+}
+
+std::string pricingModelName(const Instrument& instrument) {
+    if (const auto* european = dynamic_cast<const EuropeanOption*>(&instrument)) {
+        return pricingModelName(european->getPricingModel());
+    }
+    if (const auto* american = dynamic_cast<const AmericanOption*>(&instrument)) {
+        return pricingModelName(american->getPricingModel());
+    }
+    return instrument.getInstrumentType();
+}
+
+// Trace events keep their names by pointer, so instruments without a
+// pricing model share one literal
+const char* traceName(const Instrument& instrument) {
+    if (const auto* european = dynamic_cast<const EuropeanOption*>(&instrument)) {
+        return pricingModelName(european->getPricingModel());
+    }
+    if (const auto* american = dynamic_cast<const AmericanOption*>(&instrument)) {
+        return pricingModelName(american->getPricingModel());
+    }
+    return "Instrument";
+}
+
+// VaR and expected shortfall of a P&L sample; sorts it in place
+RiskMetrics tailMetrics(std::vector<double>& pnl_distribution) {
+    // Sort the P&L distribution (ascending order: worst losses first)
+    std::sort(pnl_distribution.begin(), pnl_distribution.end());
+    return VaRShard::tailMetrics(pnl_distribution, static_cast<long long>(pnl_distribution.size()));
+}
+
+// Philox draw of one path and asset for each use
+const uint32_t kDiffusionFactor = 0;
+const uint32_t kJumpCountFactor = 1;
+const uint32_t kJumpSizeFactor = 2;
+
+void requireReplayable(const RiskConfig& config, const std::string& what) {
+    if (config.getRandomGenerator() != RandomGenerator::Philox || !config.getUseFixedSeed()) {
+        throw std::invalid_argument(what + " requires the Philox generator and a fixed seed");
+    }
+}
+
+}
+
+// Replay and shard hooks into calculateRiskMetrics: simulate `paths`, or
+// `path_count` paths from `first_path`, instead of 0..n-1, and keep each
+// path's P&L (and spots) in simulation order. With `flat_at_zero_value` a
+// book worth zero stops before simulating, as a plain run does, and sets
+// `zero_value` instead of filling `pnl`.
+struct RiskEngine::ScenarioCapture {
+    const std::vector<long long>* paths = nullptr;
+    long long first_path = 0;
+    int path_count = -1;
+    bool keep_spots = false;
+    bool flat_at_zero_value = false;
+    bool zero_value = false;
+    std::vector<double> pnl;
+    std::vector<double> spots;  // path-major, one per asset
+    std::vector<std::string> asset_ids;
+};
+
+std::vector<RiskEngine::AssetJumps> RiskEngine::collectAssetJumps(
+    const Portfolio& portfolio,
+    const std::map<std::string, size_t>& asset_index,
+    double dt
+) const {
+    std::vector<AssetJumps> jumps;
+    std::map<size_t, size_t> jump_index;
+    
+    for (const auto& [instrument, quantity] : portfolio.getInstruments()) {
+        const auto* european = dynamic_cast<const EuropeanOption*>(instrument.get());
+        if (!european || european->getPricingModel() != PricingModel::MertonJumpDiffusion ||
+            european->getJumpIntensity() == 0.0) {
+            continue;
+        }
+        
+        const size_t a = asset_index.at(european->getAssetId());
+        auto it = jump_index.find(a);
+        if (it != jump_index.end()) {
+            const AssetJumps& existing = jumps[it->second];
+            if (existing.intensity != european->getJumpIntensity() ||
+                existing.mean != european->getJumpMean() ||
+                existing.volatility != european->getJumpVolatility()) {
+                throw std::invalid_argument(
+                    "Conflicting jump parameters for asset " + european->getAssetId()
+                );
+            }
+            continue;
+        }
+        
+        AssetJumps jump;
+        jump.asset = a;
+        jump.intensity = european->getJumpIntensity();
+        jump.mean = european->getJumpMean();
+        jump.volatility = european->getJumpVolatility();
+        jump.compensator = jump.intensity * dt *
+            (std::exp(jump.mean + 0.5 * jump.volatility * jump.volatility) - 1.0);
+        
+        // Poisson(intensity * dt) CDF up to where the tail is negligible
+        const double mean_jumps = jump.intensity * dt;
+        double probability = std::exp(-mean_jumps);
+        double cumulative = probability;
+        jump.cdf.push_back(cumulative);
+        for (int n = 1; 1.0 - cumulative > 1e-15 && n < 1000; ++n) {
+            probability *= mean_jumps / n;
+            cumulative += probability;
+            jump.cdf.push_back(cumulative);
+        }
+        
+        jump_index.emplace(a, jumps.size());
+        jumps.push_back(std::move(jump));
+    }
+    
+    return jumps;
+}
+
+RiskEngine::PricingPlan RiskEngine::buildPricingPlan(
+    const Portfolio& portfolio, bool approximate_americans
+) const {
+    PricingPlan plan;
+    const auto& instruments = portfolio.getInstruments();
+    plan.quantities.assign(instruments.size(), 0.0);
+    
+    std::map<std::tuple<std::string, double, int>, size_t> group_index;
+    std::vector<std::vector<size_t>> group_members;
+    std::map<std::tuple<std::string, double, double, double, double>, size_t> jump_index;
+    
+    // Each distinct contract is priced once at its netted quantity; contracts
+    // that net to zero drop out entirely.
+    for (const NettedPosition& position : portfolio.getNettedPositions()) {
+        if (position.quantity == 0) {
+            continue;
+        }
+        const size_t i = position.instrument_index;
+        plan.quantities[i] = static_cast<double>(position.quantity);
+        
+        const auto* american = dynamic_cast<const AmericanOption*>(instruments[i].first.get());
+        const auto* european = dynamic_cast<const EuropeanOption*>(instruments[i].first.get());
+        
+        if (european && european->getPricingModel() == PricingModel::MertonJumpDiffusion) {
+            const auto key = std::make_tuple(
+                european->getAssetId(), european->getTimeToExpiry(), european->getJumpIntensity(),
+                european->getJumpMean(), european->getJumpVolatility()
+            );
+            auto it = jump_index.find(key);
+            if (it == jump_index.end()) {
+                it = jump_index.emplace(key, plan.jump_diffusion_groups.size()).first;
+                plan.jump_diffusion_groups.push_back({european->getAssetId(), {}, {}, {}});
+            }
+            plan.jump_diffusion_groups[it->second].options.push_back(european);
+            plan.jump_diffusion_groups[it->second].quantities.push_back(plan.quantities[i]);
+            plan.jump_diffusion_groups[it->second].positions.push_back(i);
+            continue;
+        }
+        
+        if (american && approximate_americans) {
+            plan.approximated_positions.push_back(i);
+            continue;
+        }
+        
+        if (usesFiniteDifference(*instruments[i].first)) {
+            plan.grid_positions.push_back(i);
+            continue;
+        }
+        
+        if (american && american->getPricingModel() == PricingModel::AndersenLakeOffengeld) {
+            plan.collocation_positions.push_back(i);
+            continue;
+        }
+        
+        if (!american || american->getPricingModel() != PricingModel::Binomial) {
+            plan.single_positions.push_back(i);
+            continue;
+        }
+        
+        const auto key = std::make_tuple(
+            american->getAssetId(), american->getTimeToExpiry(), american->getBinomialSteps()
+        );
+        auto it = group_index.find(key);
+        if (it == group_index.end()) {
+            it = group_index.emplace(key, group_members.size()).first;
+            group_members.emplace_back();
+        }
+        group_members[it->second].push_back(i);
+    }
+    
+    for (const auto& members : group_members) {
+        // A lone option gains nothing from the shared lattice
+        if (members.size() < 2) {
+            plan.single_positions.push_back(members.front());
+            continue;
+        }
+        
+        AmericanOptionGroup group;
+        group.asset_id = instruments[members.front()].first->getAssetId();
+        for (size_t i : members) {
+            group.options.push_back(static_cast<const AmericanOption*>(instruments[i].first.get()));
+            group.quantities.push_back(plan.quantities[i]);
+            group.positions.push_back(i);
+        }
+        plan.american_groups.push_back(std::move(group));
+    }
+    
+    std::sort(plan.single_positions.begin(), plan.single_positions.end());
+    std::sort(plan.grid_positions.begin(), plan.grid_positions.end());
+    std::sort(plan.collocation_positions.begin(), plan.collocation_positions.end());
+    std::sort(plan.approximated_positions.begin(), plan.approximated_positions.end());
+    
+    return plan;
+}
+
 PortfolioRiskResult RiskEngine::calculatePortfolioRisk(
     const Portfolio& portfolio, 
     const std::map<std::string, MarketData>& market_data_map
-) {
-    validateParameters();
-    
+) const {
+    return calculatePortfolioRisk(portfolio, market_data_map, config_);
+}
+
+PortfolioRiskResult RiskEngine::calculatePortfolioRisk(
+    const Portfolio& portfolio, 
+    const std::map<std::string, MarketData>& market_data_map,
+    const RiskConfig& config
+) const {
+    return calculatePortfolioRisk(portfolio, market_data_map, config, nullptr);
+}
+
+PortfolioRiskResult RiskEngine::calculatePortfolioRisk(
+    const Portfolio& portfolio, 
+    const std::map<std::string, MarketData>& market_data_map,
+    const RiskConfig& config,
+    RiskRunControl& control
+) const {
+    return calculatePortfolioRisk(portfolio, market_data_map, config, &control);
+}
+
+PortfolioRiskResult RiskEngine::calculatePortfolioRisk(
+    const Portfolio& portfolio, 
+    const std::map<std::string, MarketData>& market_data_map,
+    const RiskConfig& config,
+    RiskRunControl* control
+) const {
     PortfolioRiskResult result;
     result.reset();
     
+    RiskDiagnostics* diagnostics = config.getDiagnostics() ? &result.diagnostics : nullptr;
+    if (diagnostics) {
+        diagnostics->enabled = true;
+    }
+    TraceRecorder* trace = config.getTrace();
+    TraceSpan run_span(trace, "calculatePortfolioRisk", "risk", "positions",
+                       static_cast<long long>(portfolio.size()));
+    PhaseClock clock(diagnostics, trace);
+    
+    if (control) {
+        control->start(config.getVaRSimulations());
+        control->throwIfCancelled();
+    }
+    
     if (portfolio.empty()) {
         return result;
     }
     
     validateMarketData(portfolio, market_data_map);
+    clock.lap("validation");
     
     const auto& instruments = portfolio.getInstruments();
+    const PricingPlan plan = buildPricingPlan(portfolio);
+    clock.lap("pricing_plan");
     
-    for (const auto& [instrument, quantity] : instruments) {
+    // Greeks time per position, recorded only with diagnostics or a trace;
+    // grouped positions share their group's time and trace span
+    std::vector<PositionTiming> position_timings;
+    auto timed = [&](const size_t* first, const size_t* last, const auto& work) {
+        if (!diagnostics && !trace) {
+            work();
+            return;
+        }
+        const auto start = std::chrono::steady_clock::now();
+        work();
+        const auto end = std::chrono::steady_clock::now();
+        if (trace) {
+            trace->record(traceName(*instruments[*first].first), "greeks", start, end, "positions",
+                          static_cast<long long>(last - first));
+        }
+        if (!diagnostics) {
+            return;
+        }
+        const double seconds = std::chrono::duration<double>(end - start).count();
+        for (const size_t* index = first; index != last; ++index) {
+            const Instrument& instrument = *instruments[*index].first;
+            position_timings.push_back({*index, instrument.getAssetId(), pricingModelName(instrument),
+                                        seconds / static_cast<double>(last - first)});
+        }
+    };
+    
+    auto addInstrumentGreeks = [&](size_t index) {
+        const auto& instrument = instruments[index].first;
+        const double quantity = plan.quantities[index];
         std::string asset_id = instrument->getAssetId();
         const MarketData& md = market_data_map.at(asset_id);
         
@@ -184,18 +753,140 @@ PortfolioRiskResult RiskEngine::calculatePortfolioRisk(
         result.total_gamma += calculateSingleInstrumentMetric(instrument, quantity, md, "gamma");
         result.total_vega += calculateSingleInstrumentMetric(instrument, quantity, md, "vega");
         result.total_theta += calculateSingleInstrumentMetric(instrument, quantity, md, "theta");
+    };
+    
+    for (size_t index : plan.single_positions) {
+        timed(&index, &index + 1, [&]() { addInstrumentGreeks(index); });
+    }
+    
+    auto addGridGreeks = [&](size_t index) {
+        const auto& instrument = instruments[index].first;
+        const double quantity = plan.quantities[index];
+        const MarketData& md = market_data_map.at(instrument->getAssetId());
+        
+        double price, delta, gamma;
+        try {
+            const FiniteDifference::SolutionSlice slice = solveFiniteDifference(*instrument, md);
+            price = slice.price(md.spot_price);
+            delta = slice.delta(md.spot_price);
+            gamma = slice.gamma(md.spot_price);
+        } catch (const std::exception& e) {
+            throw std::runtime_error(
+                std::string("Failed to calculate greeks for ") + instrument->getAssetId() + ": " + e.what()
+            );
+        }
+        
+        if (std::isnan(price) || std::isinf(price) || std::isnan(delta) || std::isinf(delta) ||
+            std::isnan(gamma) || std::isinf(gamma)) {
+            throw std::runtime_error("Invalid greeks value for " + instrument->getAssetId());
+        }
+        
+        result.total_pv += price * quantity;
+        result.total_delta += delta * quantity;
+        result.total_gamma += gamma * quantity;
+        result.total_vega += calculateSingleInstrumentMetric(instrument, quantity, md, "vega");
+        result.total_theta += calculateSingleInstrumentMetric(instrument, quantity, md, "theta");
+    };
+    
+    for (size_t index : plan.grid_positions) {
+        timed(&index, &index + 1, [&]() { addGridGreeks(index); });
+    }
+    
+    auto addGroupGreeks = [&](const std::string& asset_id, const std::vector<double>& quantities,
+                              const auto& computeGreeks) {
+        const MarketData& md = market_data_map.at(asset_id);
+        
+        std::vector<InstrumentGreeks> greeks;
+        try {
+            greeks = computeGreeks(md);
+        } catch (const std::exception& e) {
+            throw std::runtime_error(
+                std::string("Failed to calculate greeks for ") + asset_id + ": " + e.what()
+            );
+        }
+        
+        for (size_t k = 0; k < greeks.size(); ++k) {
+            const double quantity = quantities[k];
+            result.total_pv += greeks[k].price * quantity;
+            result.total_delta += greeks[k].delta * quantity;
+            result.total_gamma += greeks[k].gamma * quantity;
+            result.total_vega += greeks[k].vega * quantity;
+            result.total_theta += greeks[k].theta * quantity;
+        }
+    };
+    
+    for (const auto& group : plan.american_groups) {
+        timed(group.positions.data(), group.positions.data() + group.positions.size(), [&]() {
+            addGroupGreeks(group.asset_id, group.quantities, [&](const MarketData& md) {
+                return AmericanOption::greeksBatch(group.options, md);
+            });
+        });
+    }
+    
+    for (const auto& group : plan.jump_diffusion_groups) {
+        timed(group.positions.data(), group.positions.data() + group.positions.size(), [&]() {
+            addGroupGreeks(group.asset_id, group.quantities, [&](const MarketData& md) {
+                return EuropeanOption::greeksBatch(group.options, md);
+            });
+        });
+    }
+    
+    // Collocation Americans on one asset and expiry share their exercise
+    // boundaries (base, bumped volatility, decayed expiry) across strikes,
+    // as in the VaR scenarios
+    std::map<std::pair<std::string, double>, AmericanOptionGroup> collocation_groups;
+    for (size_t index : plan.collocation_positions) {
+        const auto* option = static_cast<const AmericanOption*>(instruments[index].first.get());
+        AmericanOptionGroup& group =
+            collocation_groups[std::make_pair(option->getAssetId(), option->getTimeToExpiry())];
+        group.asset_id = option->getAssetId();
+        group.options.push_back(option);
+        group.quantities.push_back(plan.quantities[index]);
+        group.positions.push_back(index);
+    }
+    for (const auto& [key, group] : collocation_groups) {
+        timed(group.positions.data(), group.positions.data() + group.positions.size(), [&]() {
+            addGroupGreeks(group.asset_id, group.quantities, [&](const MarketData& md) {
+                return AmericanOption::greeksBatch(group.options, md);
+            });
+        });
     }
     
     if (!result.isValid()) {
         throw std::runtime_error("Portfolio risk calculation produced invalid results");
     }
     
+    if (diagnostics) {
+        const size_t kept = std::min(position_timings.size(), RiskDiagnostics::kSlowestPositions);
+        std::partial_sort(position_timings.begin(), position_timings.begin() + kept, position_timings.end(),
+                          [](const PositionTiming& a, const PositionTiming& b) { return a.seconds > b.seconds; });
+        position_timings.resize(kept);
+        diagnostics->slowest_positions = std::move(position_timings);
+    }
+    clock.lap("greeks");
+    
+    if (control) {
+        control->publishGreeks(result);
+    }
+    
     try {
-        RiskMetrics metrics = calculateRiskMetrics(portfolio, market_data_map);
+        PricingPlan approximated_plan;
+        if (config.getFastAmericanRevaluation()) {
+            approximated_plan = buildPricingPlan(portfolio, true);
+            clock.lap("pricing_plan");
+        }
+        RiskMetrics metrics = calculateRiskMetrics(
+            portfolio, market_data_map, config.getFastAmericanRevaluation() ? approximated_plan : plan,
+            config, control, diagnostics, trace);
         result.value_at_risk_95 = metrics.var_95;
         result.value_at_risk_99 = metrics.var_99;
         result.expected_shortfall_95 = metrics.es_95;
         result.expected_shortfall_99 = metrics.es_99;
+        if (control) {
+            control->completed_ = config.getVaRSimulations();
+        }
+    } catch (const RiskCalculationCancelled&) {
+        throw;
     } catch (const std::exception& e) {
         throw std::runtime_error(std::string("Risk metrics calculation failed: ") + e.what());
     }
@@ -205,123 +896,499 @@ PortfolioRiskResult RiskEngine::calculatePortfolioRisk(
 
 RiskMetrics RiskEngine::calculateRiskMetrics(
     const Portfolio& portfolio, 
-    const std::map<std::string, MarketData>& market_data_map
-) {
+    const std::map<std::string, MarketData>& market_data_map,
+    const PricingPlan& plan,
+    const RiskConfig& config,
+    RiskRunControl* control,
+    RiskDiagnostics* diagnostics,
+    TraceRecorder* trace,
+    ScenarioCapture* capture
+) const {
     RiskMetrics metrics;
+    // A replay simulates the listed paths, in that order
+    const std::vector<long long>* paths = capture ? capture->paths : nullptr;
+    const int var_simulations = paths ? static_cast<int>(paths->size())
+        : capture && capture->path_count >= 0 ? capture->path_count
+        : config.getVaRSimulations();
+    const long long first_path = capture ? capture->first_path : 0;
+    PhaseClock clock(diagnostics, trace);
     
-    // Calculate initial portfolio value
-    double initial_portfolio_value = 0.0;
     const auto& instruments = portfolio.getInstruments();
     
+    // Underlyings in asset id order, so the shocks do not depend on the order
+    // of the rows; each simulation draws one shock per underlying so every
+    // position on an asset sees the same spot.
+    std::map<std::string, size_t> asset_index;
     for (const auto& [instrument, quantity] : instruments) {
-        const MarketData& md = market_data_map.at(instrument->getAssetId());
-        double price = instrument->price(md);
+        asset_index.emplace(instrument->getAssetId(), 0);
+    }
+    std::vector<const MarketData*> assets;
+    assets.reserve(asset_index.size());
+    for (auto& [asset_id, index] : asset_index) {
+        index = assets.size();
+        assets.push_back(&market_data_map.at(asset_id));
+    }
+    auto indexOf = [&](const std::string& asset_id) {
+        return asset_index.at(asset_id);
+    };
+    
+    std::vector<size_t> single_assets;
+    single_assets.reserve(plan.single_positions.size());
+    for (size_t index : plan.single_positions) {
+        single_assets.push_back(indexOf(instruments[index].first->getAssetId()));
+    }
+    
+    std::vector<size_t> group_assets;
+    group_assets.reserve(plan.american_groups.size());
+    for (const auto& group : plan.american_groups) {
+        group_assets.push_back(indexOf(group.asset_id));
+    }
+    
+    std::vector<size_t> jump_assets;
+    jump_assets.reserve(plan.jump_diffusion_groups.size());
+    for (const auto& group : plan.jump_diffusion_groups) {
+        jump_assets.push_back(indexOf(group.asset_id));
+    }
+    
+    // Only the spot moves between scenarios, so each PDE is solved once here
+    // and every scenario is an interpolation on the t = 0 slice.
+    std::vector<size_t> grid_assets;
+    std::vector<FiniteDifference::SolutionSlice> grid_slices;
+    grid_assets.reserve(plan.grid_positions.size());
+    grid_slices.reserve(plan.grid_positions.size());
+    for (size_t index : plan.grid_positions) {
+        const auto& instrument = instruments[index].first;
+        const size_t a = indexOf(instrument->getAssetId());
+        grid_assets.push_back(a);
+        grid_slices.push_back(solveFiniteDifference(*instrument, *assets[a]));
+    }
+    
+    // Exercise boundaries are shared by every strike on the same asset and
+    // expiry; BAW critical prices are solved once per option.
+    std::vector<size_t> collocation_assets;
+    std::vector<const AmericanOption*> collocation_options;
+    std::vector<const AndersenLakeOffengeld::ExerciseBoundary*> collocation_boundaries;
+    std::map<std::pair<size_t, double>, AndersenLakeOffengeld::ExerciseBoundary> boundaries;
+    for (size_t index : plan.collocation_positions) {
+        const auto* option = static_cast<const AmericanOption*>(instruments[index].first.get());
+        const size_t a = indexOf(option->getAssetId());
+        const auto key = std::make_pair(a, option->getTimeToExpiry());
+        auto it = boundaries.find(key);
+        if (it == boundaries.end()) {
+            it = boundaries.emplace(key, option->exerciseBoundary(*assets[a])).first;
+        }
+        collocation_assets.push_back(a);
+        collocation_options.push_back(option);
+        collocation_boundaries.push_back(&it->second);
+    }
+    
+    std::vector<size_t> approximated_assets;
+    std::vector<BaroneAdesiWhaley::QuadraticApproximation> approximations;
+    approximations.reserve(plan.approximated_positions.size());
+    for (size_t index : plan.approximated_positions) {
+        const auto* option = static_cast<const AmericanOption*>(instruments[index].first.get());
+        const size_t a = indexOf(option->getAssetId());
+        approximated_assets.push_back(a);
+        approximations.push_back(option->quadraticApproximation(*assets[a]));
+    }
+    
+    auto revalue = [&](const std::vector<MarketData>& asset_md, const char* error_message) {
+        double value = 0.0;
+        
+        for (size_t j = 0; j < plan.single_positions.size(); ++j) {
+            const size_t index = plan.single_positions[j];
+            const double quantity = plan.quantities[index];
+            double price = instruments[index].first->price(asset_md[single_assets[j]]);
+            
+            if (std::isnan(price) || std::isinf(price)) {
+                throw std::runtime_error(error_message);
+            }
+            
+            value += price * quantity;
+        }
         
-        if (std::isnan(price) || std::isinf(price)) {
-            throw std::runtime_error("Invalid price in risk metrics calculation");
+        for (size_t j = 0; j < plan.grid_positions.size(); ++j) {
+            const double quantity = plan.quantities[plan.grid_positions[j]];
+            double price = grid_slices[j].price(asset_md[grid_assets[j]].spot_price);
+            
+            if (std::isnan(price) || std::isinf(price)) {
+                throw std::runtime_error(error_message);
+            }
+            
+            value += price * quantity;
+        }
+        
+        for (size_t j = 0; j < plan.collocation_positions.size(); ++j) {
+            const double quantity = plan.quantities[plan.collocation_positions[j]];
+            const AmericanOption* option = collocation_options[j];
+            double price = collocation_boundaries[j]->price(
+                asset_md[collocation_assets[j]].spot_price, option->getStrike(), option->getOptionType());
+            
+            if (std::isnan(price) || std::isinf(price)) {
+                throw std::runtime_error(error_message);
+            }
+            
+            value += price * quantity;
+        }
+        
+        for (size_t j = 0; j < plan.approximated_positions.size(); ++j) {
+            const double quantity = plan.quantities[plan.approximated_positions[j]];
+            double price = approximations[j].price(asset_md[approximated_assets[j]].spot_price);
+            
+            if (std::isnan(price) || std::isinf(price)) {
+                throw std::runtime_error(error_message);
+            }
+            
+            value += price * quantity;
+        }
+        
+        for (size_t g = 0; g < plan.american_groups.size(); ++g) {
+            const auto& group = plan.american_groups[g];
+            const std::vector<double> prices =
+                AmericanOption::priceBatch(group.options, asset_md[group_assets[g]]);
+            
+            for (size_t k = 0; k < prices.size(); ++k) {
+                if (std::isnan(prices[k]) || std::isinf(prices[k])) {
+                    throw std::runtime_error(error_message);
+                }
+                value += prices[k] * group.quantities[k];
+            }
+        }
+        
+        for (size_t g = 0; g < plan.jump_diffusion_groups.size(); ++g) {
+            const auto& group = plan.jump_diffusion_groups[g];
+            const std::vector<double> prices =
+                EuropeanOption::priceBatch(group.options, asset_md[jump_assets[g]]);
+            
+            for (size_t k = 0; k < prices.size(); ++k) {
+                if (std::isnan(prices[k]) || std::isinf(prices[k])) {
+                    throw std::runtime_error(error_message);
+                }
+                value += prices[k] * group.quantities[k];
+            }
         }
         
-        initial_portfolio_value += price * quantity;
+        return value;
+    };
+    
+    std::vector<MarketData> simulated_md;
+    simulated_md.reserve(assets.size());
+    for (const MarketData* md : assets) {
+        simulated_md.push_back(*md);
     }
     
-    if (std::abs(initial_portfolio_value) < 1e-10) {
+    // Revaluations per revalue() call, counted up front so the scenario loop
+    // carries no bookkeeping
+    std::map<std::string, long long> revaluations_per_call;
+    if (diagnostics) {
+        for (size_t index : plan.single_positions) {
+            ++revaluations_per_call[pricingModelName(*instruments[index].first)];
+        }
+        revaluations_per_call["FiniteDifference"] += static_cast<long long>(plan.grid_positions.size());
+        revaluations_per_call["AndersenLakeOffengeld"] += static_cast<long long>(plan.collocation_positions.size());
+        revaluations_per_call["BaroneAdesiWhaley"] += static_cast<long long>(plan.approximated_positions.size());
+        for (const auto& group : plan.american_groups) {
+            revaluations_per_call["Binomial"] += static_cast<long long>(group.options.size());
+        }
+        for (const auto& group : plan.jump_diffusion_groups) {
+            revaluations_per_call["MertonJumpDiffusion"] += static_cast<long long>(group.options.size());
+        }
+    }
+    auto recordRevaluations = [&](long long calls) {
+        if (!diagnostics) {
+            return;
+        }
+        for (const auto& [model, count] : revaluations_per_call) {
+            if (count > 0) {
+                diagnostics->revaluations[model] += count * calls;
+            }
+        }
+    };
+    
+    // Calculate initial portfolio value
+    const double initial_portfolio_value =
+        revalue(simulated_md, "Invalid price in risk metrics calculation");
+    
+    if (std::abs(initial_portfolio_value) < 1e-10 && (!capture || capture->flat_at_zero_value)) {
+        if (capture) {
+            capture->zero_value = true;
+        }
+        recordRevaluations(1);
+        clock.lap("scenario_setup");
         return metrics;  // Return zeros for empty portfolio
     }
     
     // Run Monte Carlo simulations
     std::vector<double> pnl_distribution;
-    pnl_distribution.reserve(var_simulations_);
+    pnl_distribution.reserve(var_simulations);
     
+    std::random_device rd;
     std::mt19937 generator;
-    if (use_fixed_seed_) {
-        generator.seed(random_seed_);
+    if (config.getUseFixedSeed()) {
+        generator.seed(config.getRandomSeed());
     } else {
-        std::random_device rd;
         generator.seed(rd());
     }
     
+    // Philox shocks are addressed by path index instead of drawn in turn
+    const bool philox = config.getRandomGenerator() == RandomGenerator::Philox;
+    uint64_t philox_seed = config.getRandomSeed();
+    if (philox && !config.getUseFixedSeed()) {
+        philox_seed = (static_cast<uint64_t>(rd()) << 32) | rd();
+    }
+    auto pathIndex = [&](int block_start, int p) -> long long {
+        return paths ? (*paths)[static_cast<size_t>(block_start + p)] : first_path + block_start + p;
+    };
+    
     std::normal_distribution<double> distribution(0.0, 1.0);
-    const double dt = time_horizon_days_ / 252.0;
+    const double dt = config.getVaRTimeHorizonDays() / 252.0;
     const double sqrt_dt = std::sqrt(dt);
     
-    for (int i = 0; i < var_simulations_; ++i) {
-        double simulated_portfolio_value = 0.0;
+    std::vector<double> log_drift(assets.size());
+    std::vector<double> log_vol(assets.size());
+    for (size_t a = 0; a < assets.size(); ++a) {
+        const MarketData& md = *assets[a];
+        log_drift[a] = (md.risk_free_rate - 0.5 * md.volatility * md.volatility) * dt;
+        log_vol[a] = md.volatility * sqrt_dt;
+    }
+    
+    // Jumps come from their own stream so the diffusion shocks, and hence the
+    // GBM scenarios, are the same with jump scenarios on or off.
+    std::vector<AssetJumps> jumps;
+    if (config.getJumpDiffusionScenarios()) {
+        jumps = collectAssetJumps(portfolio, asset_index, dt);
+        for (const auto& jump : jumps) {
+            log_drift[jump.asset] -= jump.compensator;
+        }
+    }
+    std::mt19937 jump_generator;
+    if (!jumps.empty() && !philox) {
+        if (config.getUseFixedSeed()) {
+            std::seed_seq sequence{config.getRandomSeed(), 1u};
+            jump_generator.seed(sequence);
+        } else {
+            jump_generator.seed(rd());
+        }
+    }
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    std::normal_distribution<double> jump_size(0.0, 1.0);
+    
+    // Scenarios are drawn a block of paths at a time: the normal shocks in
+    // path order, then one Poisson count per path and jump asset by inversion
+    // of a tabulated CDF, then jump sizes only for the few paths that jumped.
+    // Philox fills each asset's shocks and jump uniforms for the whole block
+    // in one bulk call before any revaluation.
+    const int block_size = 256;
+    std::vector<double> log_returns(static_cast<size_t>(block_size) * assets.size());
+    std::vector<uint64_t> block_paths(philox ? block_size : 0);
+    std::vector<double> block_draws(philox ? block_size : 0);
+    clock.lap("scenario_setup");
+    
+    // A controlled run publishes an interim estimate each tenth of the paths
+    const int checkpoint_interval = std::max(block_size, var_simulations / 10);
+    int next_checkpoint = checkpoint_interval;
+    
+    for (int block_start = 0; block_start < var_simulations; block_start += block_size) {
+        if (control) {
+            control->throwIfCancelled();
+            control->completed_ = block_start;
+            if (block_start >= next_checkpoint) {
+                std::vector<double> sample(pnl_distribution);
+                control->publishMetrics(tailMetrics(sample));
+                next_checkpoint += checkpoint_interval;
+                clock.lap("tail_metrics");
+            }
+        }
         
-        for (const auto& [instrument, quantity] : instruments) {
-            const std::string& asset_id = instrument->getAssetId();
-            const MarketData& md = market_data_map.at(asset_id);
-            
-            const double random_shock = distribution(generator);
-            const double drift = (md.risk_free_rate - 0.5 * md.volatility * md.volatility) * dt;
-            const double diffusion = md.volatility * sqrt_dt * random_shock;
-            const double simulated_spot = md.spot_price * std::exp(drift + diffusion);
-            
-            if (std::isnan(simulated_spot) || std::isinf(simulated_spot) || simulated_spot <= 0.0) {
-                throw std::runtime_error("Invalid simulated spot price in risk metrics calculation");
+        const int paths_in_block = std::min(block_size, var_simulations - block_start);
+        const size_t draws = static_cast<size_t>(paths_in_block) * assets.size();
+        
+        if (philox) {
+            for (int p = 0; p < paths_in_block; ++p) {
+                block_paths[p] = static_cast<uint64_t>(pathIndex(block_start, p));
             }
-            
-            MarketData simulated_md = md;
-            simulated_md.spot_price = simulated_spot;
-            
-            double simulated_price = instrument->price(simulated_md);
-            
-            if (std::isnan(simulated_price) || std::isinf(simulated_price)) {
-                throw std::runtime_error("Invalid simulated price in risk metrics calculation");
+            for (size_t a = 0; a < assets.size(); ++a) {
+                Philox::fillNormals(philox_seed, block_paths.data(), static_cast<size_t>(paths_in_block),
+                                    static_cast<uint32_t>(a), kDiffusionFactor, block_draws.data());
+                for (int p = 0; p < paths_in_block; ++p) {
+                    log_returns[static_cast<size_t>(p) * assets.size() + a] =
+                        log_drift[a] + log_vol[a] * block_draws[p];
+                }
+            }
+        } else {
+            for (size_t d = 0; d < draws; ++d) {
+                log_returns[d] = distribution(generator);
+            }
+            for (int p = 0; p < paths_in_block; ++p) {
+                double* row = &log_returns[static_cast<size_t>(p) * assets.size()];
+                for (size_t a = 0; a < assets.size(); ++a) {
+                    row[a] = log_drift[a] + log_vol[a] * row[a];
+                }
             }
-            
-            simulated_portfolio_value += simulated_price * quantity;
         }
         
-        if (std::isnan(simulated_portfolio_value) || std::isinf(simulated_portfolio_value)) {
-            throw std::runtime_error("Invalid simulated portfolio value");
+        for (const auto& jump : jumps) {
+            const uint32_t jump_asset = static_cast<uint32_t>(jump.asset);
+            if (philox) {
+                Philox::fillUniforms(philox_seed, block_paths.data(), static_cast<size_t>(paths_in_block),
+                                     jump_asset, kJumpCountFactor, block_draws.data());
+            }
+            for (int p = 0; p < paths_in_block; ++p) {
+                const double u = philox ? block_draws[p] : uniform(jump_generator);
+                int count = 0;
+                while (count + 1 < static_cast<int>(jump.cdf.size()) && u > jump.cdf[count]) {
+                    ++count;
+                }
+                if (count > 0) {
+                    log_returns[static_cast<size_t>(p) * assets.size() + jump.asset] +=
+                        count * jump.mean + std::sqrt(static_cast<double>(count)) * jump.volatility *
+                        (philox ? Philox::normal(philox_seed, pathIndex(block_start, p), jump_asset, kJumpSizeFactor)
+                                : jump_size(jump_generator));
+                }
+            }
         }
+        clock.lap("scenario_generation", block_start);
         
-        pnl_distribution.push_back(simulated_portfolio_value - initial_portfolio_value);
+        for (int p = 0; p < paths_in_block; ++p) {
+            const double* row = &log_returns[static_cast<size_t>(p) * assets.size()];
+            for (size_t a = 0; a < assets.size(); ++a) {
+                const double simulated_spot = assets[a]->spot_price * std::exp(row[a]);
+                
+                if (std::isnan(simulated_spot) || std::isinf(simulated_spot) || simulated_spot <= 0.0) {
+                    throw std::runtime_error("Invalid simulated spot price in risk metrics calculation");
+                }
+                
+                simulated_md[a].spot_price = simulated_spot;
+                if (capture && capture->keep_spots) {
+                    capture->spots.push_back(simulated_spot);
+                }
+            }
+            
+            const double simulated_portfolio_value =
+                revalue(simulated_md, "Invalid simulated price in risk metrics calculation");
+            
+            if (std::isnan(simulated_portfolio_value) || std::isinf(simulated_portfolio_value)) {
+                throw std::runtime_error("Invalid simulated portfolio value");
+            }
+            
+            pnl_distribution.push_back(simulated_portfolio_value - initial_portfolio_value);
+        }
+        clock.lap("revaluation", block_start);
     }
     
     if (pnl_distribution.empty()) {
         throw std::runtime_error("Risk metrics calculation produced no results");
     }
     
-    // Sort the P&L distribution (ascending order: worst losses first)
-    std::sort(pnl_distribution.begin(), pnl_distribution.end());
-    
-    // Calculate VaR at 95% confidence level
-    const int index_95 = static_cast<int>((1.0 - 0.95) * var_simulations_);
-    if (index_95 < 0 || index_95 >= var_simulations_) {
-        throw std::runtime_error("Invalid VaR 95% index calculation");
+    recordRevaluations(1 + static_cast<long long>(pnl_distribution.size()));
+    if (capture) {
+        capture->pnl = std::move(pnl_distribution);
+        capture->asset_ids.resize(assets.size());
+        for (const auto& [asset_id, a] : asset_index) {
+            capture->asset_ids[a] = asset_id;
+        }
+        return metrics;
     }
-    metrics.var_95 = -pnl_distribution[index_95];
-    
-    // Calculate VaR at 99% confidence level
-    const int index_99 = static_cast<int>((1.0 - 0.99) * var_simulations_);
-    if (index_99 < 0 || index_99 >= var_simulations_) {
-        throw std::runtime_error("Invalid VaR 99% index calculation");
+    metrics = tailMetrics(pnl_distribution);
+    clock.lap("tail_metrics");
+    return metrics;
+}
+
+std::vector<RiskScenario> RiskEngine::replayScenarios(
+    const Portfolio& portfolio,
+    const std::map<std::string, MarketData>& market_data_map,
+    const RiskConfig& config,
+    const std::vector<long long>& paths
+) const {
+    requireReplayable(config, "Scenario replay");
+    for (long long path : paths) {
+        if (path < 0) {
+            throw std::invalid_argument("Scenario path indices must be non-negative");
+        }
+    }
+    if (portfolio.empty() || paths.empty()) {
+        return {};
     }
-    metrics.var_99 = -pnl_distribution[index_99];
+    validateMarketData(portfolio, market_data_map);
     
-    // Calculate Expected Shortfall (CVaR) at 95%
-    // ES is the average of losses beyond VaR
-    double sum_95 = 0.0;
-    int count_95 = 0;
-    for (int i = 0; i <= index_95; ++i) {
-        sum_95 += pnl_distribution[i];
-        count_95++;
+    ScenarioCapture capture;
+    capture.paths = &paths;
+    capture.keep_spots = true;
+    calculateRiskMetrics(portfolio, market_data_map,
+                         buildPricingPlan(portfolio, config.getFastAmericanRevaluation()), config,
+                         nullptr, nullptr, nullptr, &capture);
+    
+    const size_t asset_count = capture.asset_ids.size();
+    std::vector<RiskScenario> scenarios(paths.size());
+    for (size_t i = 0; i < paths.size(); ++i) {
+        scenarios[i].path = paths[i];
+        scenarios[i].pnl = capture.pnl[i];
+        for (size_t a = 0; a < asset_count; ++a) {
+            scenarios[i].spots.emplace_back(capture.asset_ids[a], capture.spots[i * asset_count + a]);
+        }
     }
-    if (count_95 > 0) {
-        metrics.es_95 = -sum_95 / count_95;
+    return scenarios;
+}
+
+std::vector<RiskScenario> RiskEngine::worstScenarios(
+    const Portfolio& portfolio,
+    const std::map<std::string, MarketData>& market_data_map,
+    const RiskConfig& config,
+    size_t count
+) const {
+    requireReplayable(config, "Scenario replay");
+    if (portfolio.empty() || count == 0) {
+        return {};
     }
+    validateMarketData(portfolio, market_data_map);
+    
+    // One pass keeps every path's P&L; only the worst are then replayed
+    ScenarioCapture capture;
+    calculateRiskMetrics(portfolio, market_data_map,
+                         buildPricingPlan(portfolio, config.getFastAmericanRevaluation()), config,
+                         nullptr, nullptr, nullptr, &capture);
     
-    // Calculate Expected Shortfall (CVaR) at 99%
-    double sum_99 = 0.0;
-    int count_99 = 0;
-    for (int i = 0; i <= index_99; ++i) {
-        sum_99 += pnl_distribution[i];
-        count_99++;
+    std::vector<long long> order(capture.pnl.size());
+    std::iota(order.begin(), order.end(), 0LL);
+    const size_t kept = std::min(count, order.size());
+    std::partial_sort(order.begin(), order.begin() + kept, order.end(), [&](long long a, long long b) {
+        return capture.pnl[a] < capture.pnl[b] || (capture.pnl[a] == capture.pnl[b] && a < b);
+    });
+    order.resize(kept);
+    return replayScenarios(portfolio, market_data_map, config, order);
+}
+
+VaRShard RiskEngine::calculateVaRShard(
+    const Portfolio& portfolio,
+    const std::map<std::string, MarketData>& market_data_map,
+    const RiskConfig& config,
+    long long total_paths,
+    long long first_path,
+    long long last_path
+) const {
+    requireReplayable(config, "A VaR shard");
+    if (total_paths <= 0 || total_paths > kMaxShardedSimulations) {
+        throw std::invalid_argument("A sharded VaR run must have between 1 and 100,000,000 paths");
     }
-    if (count_99 > 0) {
-        metrics.es_99 = -sum_99 / count_99;
+    if (first_path < 0 || first_path >= last_path || last_path > total_paths) {
+        throw std::invalid_argument("VaR shard must cover a non-empty range of paths within the run");
     }
+    if (portfolio.empty()) {
+        return VaRShard::of(total_paths, first_path, std::vector<double>(last_path - first_path, 0.0));
+    }
+    validateMarketData(portfolio, market_data_map);
     
-    return metrics;
+    // A book worth zero reports zero VaR from a single run, so its shards
+    // carry flat P&L and merge to the same answer
+    ScenarioCapture capture;
+    capture.first_path = first_path;
+    capture.path_count = static_cast<int>(last_path - first_path);
+    capture.flat_at_zero_value = true;
+    calculateRiskMetrics(portfolio, market_data_map,
+                         buildPricingPlan(portfolio, config.getFastAmericanRevaluation()), config,
+                         nullptr, nullptr, nullptr, &capture);
+    if (capture.zero_value) {
+        return VaRShard::of(total_paths, first_path, std::vector<double>(last_path - first_path, 0.0));
+    }
+    return VaRShard::of(total_paths, first_path, std::move(capture.pnl));
 }
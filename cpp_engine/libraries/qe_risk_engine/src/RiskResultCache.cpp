@@ -0,0 +1,298 @@
+#include "RiskResultCache.h"
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+
+namespace ContentHash {
+
+namespace {
+
+const uint64_t kOffsetBasis = 14695981039346656037ULL;
+const uint64_t kPrime = 1099511628211ULL;
+
+class Hasher {
+public:
+    void addBytes(const void* data, size_t size) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            hash_ = (hash_ ^ bytes[i]) * kPrime;
+        }
+    }
+    
+    // Fixed-width little-endian, independent of the host byte order
+    void add(uint64_t value) {
+        unsigned char bytes[8];
+        for (int i = 0; i < 8; ++i) {
+            bytes[i] = static_cast<unsigned char>(value >> (8 * i));
+        }
+        addBytes(bytes, sizeof(bytes));
+    }
+    
+    void add(double value) {
+        // +0.0 and -0.0 compare equal and price identically
+        if (value == 0.0) {
+            value = 0.0;
+        }
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        add(bits);
+    }
+    
+    void add(const std::string& value) {
+        add(static_cast<uint64_t>(value.size()));
+        addBytes(value.data(), value.size());
+    }
+    
+    uint64_t digest() const { return hash_; }
+
+private:
+    uint64_t hash_ = kOffsetBasis;
+};
+
+} // namespace
+
+uint64_t hashPortfolio(const Portfolio& portfolio) {
+    // The engine prices netted contracts, so rows that reorder, split or
+    // cancel out of the same book describe the same risk
+    const auto& instruments = portfolio.getInstruments();
+    std::vector<std::pair<std::string, long long>> contracts;
+    contracts.reserve(portfolio.getNettedPositions().size());
+    for (const NettedPosition& position : portfolio.getNettedPositions()) {
+        if (position.quantity != 0) {
+            contracts.emplace_back(instruments[position.instrument_index].first->getContractKey(),
+                                   position.quantity);
+        }
+    }
+    std::sort(contracts.begin(), contracts.end());
+    
+    Hasher hasher;
+    hasher.add(static_cast<uint64_t>(contracts.size()));
+    for (const auto& [key, quantity] : contracts) {
+        hasher.add(key);
+        hasher.add(static_cast<uint64_t>(static_cast<int64_t>(quantity)));
+    }
+    return hasher.digest();
+}
+
+uint64_t hashMarketData(const std::map<std::string, MarketData>& market_data_map) {
+    // std::map iterates in key order, so insertion order does not matter
+    Hasher hasher;
+    hasher.add(static_cast<uint64_t>(market_data_map.size()));
+    for (const auto& entry : market_data_map) {
+        const MarketData& md = entry.second;
+        hasher.add(entry.first);
+        hasher.add(md.spot_price);
+        hasher.add(md.risk_free_rate);
+        hasher.add(md.volatility);
+        hasher.add(md.dividend_yield);
+    }
+    return hasher.digest();
+}
+
+uint64_t hashConfig(const RiskConfig& config) {
+    Hasher hasher;
+    hasher.add(static_cast<uint64_t>(config.getVaRSimulations()));
+    hasher.add(config.getVaRTimeHorizonDays());
+    hasher.add(static_cast<uint64_t>(config.getUseFixedSeed()));
+    hasher.add(static_cast<uint64_t>(config.getUseFixedSeed() ? config.getRandomSeed() : 0));
+    hasher.add(static_cast<uint64_t>(config.getFastAmericanRevaluation()));
+    hasher.add(static_cast<uint64_t>(config.getJumpDiffusionScenarios()));
+    hasher.add(static_cast<uint64_t>(config.getDiagnostics()));
+    hasher.add(static_cast<uint64_t>(config.getRandomGenerator()));
+    return hasher.digest();
+}
+
+} // namespace ContentHash
+
+RiskCacheKey RiskCacheKey::of(
+    const Portfolio& portfolio,
+    const std::map<std::string, MarketData>& market_data_map,
+    const RiskConfig& config
+) {
+    RiskCacheKey key;
+    key.portfolio = ContentHash::hashPortfolio(portfolio);
+    key.market_data = ContentHash::hashMarketData(market_data_map);
+    key.config = ContentHash::hashConfig(config);
+    return key;
+}
+
+std::string RiskCacheKey::toString() const {
+    std::ostringstream out;
+    out << std::hex << std::setfill('0') << std::setw(16) << portfolio << std::setw(16)
+        << market_data << std::setw(16) << config;
+    return out.str();
+}
+
+const size_t RiskResultCache::kEntryBytes =
+    sizeof(RiskCacheKey) + sizeof(PortfolioRiskResult) + 6 * sizeof(void*) + sizeof(size_t);
+
+RiskResultCache::RiskResultCache(size_t budget_bytes)
+    : budget_bytes_(budget_bytes),
+      hits_(0),
+      misses_(0),
+      evictions_(0),
+      coalesced_(0) {
+    if (budget_bytes < kEntryBytes) {
+        throw std::invalid_argument("Cache budget must hold at least one entry");
+    }
+}
+
+bool RiskResultCache::isCacheable(const RiskConfig& config) {
+    return config.getUseFixedSeed() && !config.getDiagnostics();
+}
+
+bool RiskResultCache::findLocked(const RiskCacheKey& key, PortfolioRiskResult& result) {
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+        return false;
+    }
+    entries_.splice(entries_.begin(), entries_, it->second);
+    result = it->second->second;
+    ++hits_;
+    return true;
+}
+
+bool RiskResultCache::lookup(const RiskCacheKey& key, PortfolioRiskResult& result) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (findLocked(key, result)) {
+        return true;
+    }
+    ++misses_;
+    return false;
+}
+
+void RiskResultCache::insert(const RiskCacheKey& key, const PortfolioRiskResult& result) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+        it->second->second = result;
+        entries_.splice(entries_.begin(), entries_, it->second);
+        return;
+    }
+    
+    entries_.emplace_front(key, result);
+    index_[key] = entries_.begin();
+    while (entries_.size() * kEntryBytes > budget_bytes_) {
+        index_.erase(entries_.back().first);
+        entries_.pop_back();
+        ++evictions_;
+    }
+}
+
+PortfolioRiskResult RiskResultCache::calculate(
+    const RiskEngine& engine,
+    const Portfolio& portfolio,
+    const std::map<std::string, MarketData>& market_data_map,
+    const RiskConfig& config,
+    Source* source
+) {
+    // Diagnostics describe one run, so such runs are neither cached nor shared
+    if (config.getDiagnostics()) {
+        if (source) {
+            *source = Source::Computed;
+        }
+        return engine.calculatePortfolioRisk(portfolio, market_data_map, config);
+    }
+    
+    const bool cacheable = isCacheable(config);
+    const RiskCacheKey key = RiskCacheKey::of(portfolio, market_data_map, config);
+    PortfolioRiskResult result;
+    std::promise<PortfolioRiskResult> promise;
+    {
+        // The cache and the flights are checked under one lock: a run that
+        // finishes between two separate checks would otherwise be missed by
+        // both, and its work repeated
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (cacheable && findLocked(key, result)) {
+            lock.unlock();
+            if (source) {
+                *source = Source::Cached;
+            }
+            return result;
+        }
+        auto it = in_flight_.find(key);
+        if (it != in_flight_.end()) {
+            std::shared_future<PortfolioRiskResult> running = it->second;
+            ++coalesced_;
+            lock.unlock();
+            if (source) {
+                *source = Source::Coalesced;
+            }
+            return running.get();
+        }
+        in_flight_.emplace(key, promise.get_future().share());
+        if (cacheable) {
+            ++misses_;
+        }
+    }
+    
+    try {
+        result = engine.calculatePortfolioRisk(portfolio, market_data_map, config);
+    } catch (...) {
+        promise.set_exception(std::current_exception());
+        std::lock_guard<std::mutex> lock(mutex_);
+        in_flight_.erase(key);
+        throw;
+    }
+    
+    // Cached before the flight is retired, so a later caller finds one or
+    // the other
+    if (cacheable) {
+        insert(key, result);
+    }
+    promise.set_value(result);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        in_flight_.erase(key);
+    }
+    if (source) {
+        *source = Source::Computed;
+    }
+    return result;
+}
+
+void RiskResultCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+    index_.clear();
+}
+
+size_t RiskResultCache::getHits() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return hits_;
+}
+
+size_t RiskResultCache::getMisses() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return misses_;
+}
+
+size_t RiskResultCache::getEvictions() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return evictions_;
+}
+
+size_t RiskResultCache::getCoalesced() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return coalesced_;
+}
+
+size_t RiskResultCache::getInFlight() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return in_flight_.size();
+}
+
+size_t RiskResultCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+size_t RiskResultCache::getBytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size() * kEntryBytes;
+}
+
+size_t RiskResultCache::getBudgetBytes() const {
+    return budget_bytes_;
+}
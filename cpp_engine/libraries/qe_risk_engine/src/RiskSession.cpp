@@ -0,0 +1,332 @@
+#include "RiskSession.h"
+#include <cmath>
+#include <map>
+#include <stdexcept>
+#include <tuple>
+
+namespace {
+
+void addGreeks(PortfolioRiskResult& total, const InstrumentGreeks& greeks, double quantity) {
+    total.total_pv += greeks.price * quantity;
+    total.total_delta += greeks.delta * quantity;
+    total.total_gamma += greeks.gamma * quantity;
+    total.total_vega += greeks.vega * quantity;
+    total.total_theta += greeks.theta * quantity;
+}
+
+void addSubtotal(PortfolioRiskResult& total, const PortfolioRiskResult& subtotal) {
+    total.total_pv += subtotal.total_pv;
+    total.total_delta += subtotal.total_delta;
+    total.total_gamma += subtotal.total_gamma;
+    total.total_vega += subtotal.total_vega;
+    total.total_theta += subtotal.total_theta;
+}
+
+// Rows of one asset waiting for prices
+struct PendingRows {
+    std::vector<PositionHandle> handles;
+    std::vector<const Instrument*> instruments;
+    std::vector<double> quantities;
+    std::vector<InstrumentGreeks> greeks;
+};
+
+} // namespace
+
+RiskSession::RiskSession(const Portfolio& portfolio, const MarketDataManager& market_data)
+    : portfolio_(portfolio),
+      market_data_(market_data),
+      initialized_(false),
+      portfolio_version_(0),
+      market_version_(0),
+      pass_(0),
+      last_repriced_(0) {
+}
+
+const PortfolioRiskResult& RiskSession::refresh() {
+    // One pinned snapshot per refresh, so every asset is priced from the same
+    // market state even while ticks keep arriving
+    const std::shared_ptr<const MarketDataSnapshot> snapshot = market_data_.snapshot();
+    const uint64_t market_version = snapshot->getVersion();
+
+    if (!initialized_) {
+        rebuild(*snapshot);
+        market_version_ = market_version;
+        priced_snapshot_ = snapshot;
+        return result_;
+    }
+
+    last_repriced_ = 0;
+    const bool portfolio_changed = portfolio_.getVersion() != portfolio_version_;
+    if (!portfolio_changed && market_version == market_version_) {
+        return result_;
+    }
+
+    // Diff the rows against the cache: new handles are priced, changed
+    // quantities rescaled, and handles no longer present removed
+    const auto& instruments = portfolio_.getInstruments();
+    std::map<std::string, PendingRows> added;
+    std::vector<std::pair<PositionHandle, double>> rescaled;
+    std::vector<PositionHandle> removed;
+    if (portfolio_changed) {
+        ++pass_;
+        size_t kept = 0;
+        for (size_t row = 0; row < instruments.size(); ++row) {
+            const PositionHandle handle = portfolio_.getHandle(row);
+            const double quantity = static_cast<double>(instruments[row].second);
+            auto it = rows_.find(handle);
+            if (it == rows_.end()) {
+                PendingRows& pending = added[instruments[row].first->getAssetId()];
+                pending.handles.push_back(handle);
+                pending.instruments.push_back(instruments[row].first.get());
+                pending.quantities.push_back(quantity);
+                continue;
+            }
+            it->second.seen = pass_;
+            ++kept;
+            if (it->second.quantity != quantity) {
+                rescaled.emplace_back(handle, quantity);
+            }
+        }
+
+        // Nothing survived: the book was replaced wholesale
+        if (kept == 0 && !rows_.empty()) {
+            rebuild(*snapshot);
+            market_version_ = market_version;
+            priced_snapshot_ = snapshot;
+            return result_;
+        }
+        if (kept < rows_.size()) {
+            for (const auto& [handle, cached] : rows_) {
+                if (cached.seen != pass_) {
+                    removed.push_back(handle);
+                }
+            }
+        }
+    }
+
+    // Reprice the kept rows of every changed asset and the added rows before
+    // touching the cache, so a failure leaves the previous state intact.
+    std::map<std::string, PendingRows> repriced;
+    if (market_version != market_version_) {
+        for (const std::string& asset_id : snapshot->getChangedAssets(market_version_)) {
+            auto it = asset_index_.find(asset_id);
+            if (it == asset_index_.end()) {
+                continue;
+            }
+            PendingRows pending;
+            for (PositionHandle handle : assets_[it->second].rows) {
+                const CachedRow& cached = rows_.at(handle);
+                if (!portfolio_changed || cached.seen == pass_) {
+                    pending.handles.push_back(handle);
+                    pending.instruments.push_back(cached.instrument);
+                }
+            }
+            if (!pending.handles.empty()) {
+                repriced.emplace(asset_id, std::move(pending));
+            }
+        }
+    }
+    for (auto* group : {&repriced, &added}) {
+        for (auto& [asset_id, pending] : *group) {
+            pending.greeks = priceInstruments(asset_id, pending.instruments, *snapshot);
+        }
+    }
+
+    std::vector<bool> touched(assets_.size(), false);
+    for (PositionHandle handle : removed) {
+        const CachedRow& cached = rows_.at(handle);
+        std::vector<PositionHandle>& book_rows = assets_[cached.asset].rows;
+        for (size_t slot = 0; slot < book_rows.size(); ++slot) {
+            if (book_rows[slot] == handle) {
+                book_rows[slot] = book_rows.back();
+                book_rows.pop_back();
+                break;
+            }
+        }
+        touched[cached.asset] = true;
+        rows_.erase(handle);
+    }
+    for (const auto& [handle, quantity] : rescaled) {
+        CachedRow& cached = rows_.at(handle);
+        cached.quantity = quantity;
+        touched[cached.asset] = true;
+        // A row also repriced below is counted there
+        if (repriced.find(assets_[cached.asset].asset_id) == repriced.end()) {
+            ++last_repriced_;
+        }
+    }
+    for (const auto& [asset_id, pending] : repriced) {
+        for (size_t k = 0; k < pending.handles.size(); ++k) {
+            rows_.at(pending.handles[k]).unit = pending.greeks[k];
+        }
+        touched[asset_index_.at(asset_id)] = true;
+        last_repriced_ += pending.handles.size();
+    }
+    for (const auto& [asset_id, pending] : added) {
+        const size_t asset = bookFor(asset_id);
+        touched.resize(assets_.size(), false);
+        for (size_t k = 0; k < pending.handles.size(); ++k) {
+            rows_.emplace(pending.handles[k], CachedRow{pending.instruments[k], asset, pending.quantities[k],
+                                                        pending.greeks[k], pass_});
+            assets_[asset].rows.push_back(pending.handles[k]);
+        }
+        touched[asset] = true;
+        last_repriced_ += pending.handles.size();
+    }
+    last_repriced_ += removed.size();
+
+    for (size_t asset = 0; asset < assets_.size(); ++asset) {
+        if (touched[asset]) {
+            resum(assets_[asset]);
+        }
+    }
+    resumTotals();
+    if (!result_.isValid()) {
+        throw std::runtime_error("Portfolio risk calculation produced invalid results");
+    }
+
+    portfolio_version_ = portfolio_.getVersion();
+    market_version_ = market_version;
+    priced_snapshot_ = snapshot;
+    return result_;
+}
+
+const PortfolioRiskResult& RiskSession::getResult() const {
+    return result_;
+}
+
+PortfolioRiskResult RiskSession::getAssetSubtotal(const std::string& asset_id) const {
+    auto it = asset_index_.find(asset_id);
+    if (it == asset_index_.end()) {
+        return PortfolioRiskResult();
+    }
+    return assets_[it->second].subtotal;
+}
+
+size_t RiskSession::getLastRepricedPositions() const {
+    return last_repriced_;
+}
+
+void RiskSession::rebuild(const MarketDataSnapshot& snapshot) {
+    const auto& instruments = portfolio_.getInstruments();
+
+    std::map<std::string, PendingRows> pending_by_asset;
+    for (size_t row = 0; row < instruments.size(); ++row) {
+        PendingRows& pending = pending_by_asset[instruments[row].first->getAssetId()];
+        pending.handles.push_back(portfolio_.getHandle(row));
+        pending.instruments.push_back(instruments[row].first.get());
+        pending.quantities.push_back(static_cast<double>(instruments[row].second));
+    }
+    for (auto& [asset_id, pending] : pending_by_asset) {
+        pending.greeks = priceInstruments(asset_id, pending.instruments, snapshot);
+    }
+
+    ++pass_;
+    rows_.clear();
+    assets_.clear();
+    asset_index_.clear();
+    rows_.reserve(instruments.size());
+    for (const auto& [asset_id, pending] : pending_by_asset) {
+        const size_t asset = bookFor(asset_id);
+        for (size_t k = 0; k < pending.handles.size(); ++k) {
+            rows_.emplace(pending.handles[k], CachedRow{pending.instruments[k], asset, pending.quantities[k],
+                                                        pending.greeks[k], pass_});
+        }
+        assets_[asset].rows = pending.handles;
+        resum(assets_[asset]);
+    }
+    resumTotals();
+
+    if (!result_.isValid()) {
+        throw std::runtime_error("Portfolio risk calculation produced invalid results");
+    }
+
+    last_repriced_ = instruments.size();
+    portfolio_version_ = portfolio_.getVersion();
+    initialized_ = true;
+}
+
+size_t RiskSession::bookFor(const std::string& asset_id) {
+    auto [it, inserted] = asset_index_.emplace(asset_id, assets_.size());
+    if (inserted) {
+        assets_.push_back({asset_id, {}, PortfolioRiskResult()});
+    }
+    return it->second;
+}
+
+// Subtotals and totals are summed afresh from the cache rather than patched
+// by differences, so rounding never accumulates across refreshes
+void RiskSession::resum(AssetBook& book) const {
+    PortfolioRiskResult subtotal;
+    for (PositionHandle handle : book.rows) {
+        const CachedRow& cached = rows_.at(handle);
+        addGreeks(subtotal, cached.unit, cached.quantity);
+    }
+    book.subtotal = subtotal;
+}
+
+void RiskSession::resumTotals() {
+    PortfolioRiskResult result;
+    for (const AssetBook& book : assets_) {
+        addSubtotal(result, book.subtotal);
+    }
+    result_ = result;
+}
+
+std::vector<InstrumentGreeks> RiskSession::priceInstruments(
+    const std::string& asset_id,
+    const std::vector<const Instrument*>& instruments,
+    const MarketDataSnapshot& snapshot
+) const {
+    std::vector<InstrumentGreeks> greeks(instruments.size());
+
+    try {
+        const MarketData md = snapshot.getMarketData(asset_id);
+
+        // Rows holding the same contract are priced once
+        std::map<std::string, size_t> contracts;
+        std::vector<size_t> source(instruments.size());
+        std::vector<size_t> unique;
+        for (size_t k = 0; k < instruments.size(); ++k) {
+            auto [it, inserted] = contracts.emplace(instruments[k]->getContractKey(), k);
+            source[k] = it->second;
+            if (inserted) {
+                unique.push_back(k);
+            }
+        }
+
+        // Binomial Americans sharing expiry and steps reuse one lattice
+        std::map<std::tuple<double, int>, std::vector<size_t>> lattices;
+        for (size_t k : unique) {
+            const auto* american = dynamic_cast<const AmericanOption*>(instruments[k]);
+            if (american && american->getPricingModel() == PricingModel::Binomial) {
+                lattices[std::make_tuple(american->getTimeToExpiry(), american->getBinomialSteps())]
+                    .push_back(k);
+                continue;
+            }
+            greeks[k] = instruments[k]->greeks(md);
+        }
+
+        for (const auto& [key, members] : lattices) {
+            std::vector<const AmericanOption*> options;
+            options.reserve(members.size());
+            for (size_t k : members) {
+                options.push_back(static_cast<const AmericanOption*>(instruments[k]));
+            }
+            const std::vector<InstrumentGreeks> batch = AmericanOption::greeksBatch(options, md);
+            for (size_t m = 0; m < batch.size(); ++m) {
+                greeks[members[m]] = batch[m];
+            }
+        }
+
+        for (size_t k = 0; k < instruments.size(); ++k) {
+            greeks[k] = greeks[source[k]];
+        }
+    } catch (const std::exception& e) {
+        throw std::runtime_error(
+            std::string("Failed to calculate greeks for ") + asset_id + ": " + e.what()
+        );
+    }
+
+    return greeks;
+}
\ No newline at end of file
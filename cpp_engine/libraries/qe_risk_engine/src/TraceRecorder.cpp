@@ -0,0 +1,181 @@
+#include "TraceRecorder.h"
+#include "Json.h"
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+namespace {
+
+std::atomic<uint64_t> next_recorder_id(1);
+
+struct Event {
+    const char* name;
+    const char* category;
+    const char* arg_name;
+    long long arg;
+    int64_t start_ns;
+    int64_t duration_ns;
+};
+
+} // namespace
+
+struct TraceRecorder::ThreadBuffer {
+    std::thread::id thread;
+    int tid;
+    std::mutex mutex;
+    std::vector<Event> events;
+    size_t next = 0;
+    size_t written = 0;
+
+    ThreadBuffer(std::thread::id owner, int track, size_t capacity)
+        : thread(owner), tid(track), events(capacity) {
+    }
+};
+
+TraceRecorder::TraceRecorder(size_t events_per_thread)
+    : id_(next_recorder_id++),
+      events_per_thread_(events_per_thread),
+      origin_(Clock::now()) {
+    if (events_per_thread == 0) {
+        throw std::invalid_argument("Trace buffer must hold at least one event");
+    }
+}
+
+TraceRecorder::~TraceRecorder() = default;
+
+TraceRecorder::ThreadBuffer& TraceRecorder::threadBuffer() {
+    // The calling thread's buffer in the recorder it last recorded to; ids
+    // are never reused, so a recorder at a freed one's address cannot match
+    struct Cached {
+        uint64_t recorder = 0;
+        ThreadBuffer* buffer = nullptr;
+    };
+    thread_local Cached cached;
+    if (cached.recorder == id_) {
+        return *cached.buffer;
+    }
+
+    const std::thread::id self = std::this_thread::get_id();
+    std::lock_guard<std::mutex> lock(threads_mutex_);
+    auto it = std::find_if(threads_.begin(), threads_.end(),
+                           [&](const std::unique_ptr<ThreadBuffer>& buffer) { return buffer->thread == self; });
+    if (it == threads_.end()) {
+        threads_.push_back(std::make_unique<ThreadBuffer>(self, static_cast<int>(threads_.size()) + 1,
+                                                          events_per_thread_));
+        it = threads_.end() - 1;
+    }
+    cached = {id_, it->get()};
+    return **it;
+}
+
+void TraceRecorder::record(const char* name, const char* category, Clock::time_point start,
+                           Clock::time_point end, const char* arg_name, long long arg) {
+    const int64_t start_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(start - origin_).count();
+    const int64_t duration_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+
+    ThreadBuffer& buffer = threadBuffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    buffer.events[buffer.next] = {name, category, arg_name, arg, start_ns, duration_ns};
+    buffer.next = (buffer.next + 1) % buffer.events.size();
+    ++buffer.written;
+}
+
+std::string TraceRecorder::toJson() const {
+    Json::Value::Array events;
+    size_t dropped = 0;
+    {
+        std::lock_guard<std::mutex> lock(threads_mutex_);
+        for (const auto& buffer : threads_) {
+            events.push_back(Json::Value::object({
+                {"name", Json::Value::string("thread_name")},
+                {"ph", Json::Value::string("M")},
+                {"pid", Json::Value::number(1, true)},
+                {"tid", Json::Value::number(buffer->tid, true)},
+                {"args", Json::Value::object({
+                    {"name", Json::Value::string("thread " + std::to_string(buffer->tid))},
+                })},
+            }));
+
+            std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+            const size_t capacity = buffer->events.size();
+            const size_t held = std::min(buffer->written, capacity);
+            dropped += buffer->written - held;
+            // Oldest first: a full ring starts at the next slot to overwrite
+            const size_t first = buffer->written > capacity ? buffer->next : 0;
+            for (size_t k = 0; k < held; ++k) {
+                const Event& event = buffer->events[(first + k) % capacity];
+                Json::Value::Object members = {
+                    {"name", Json::Value::string(event.name)},
+                    {"cat", Json::Value::string(event.category)},
+                    {"ph", Json::Value::string("X")},
+                    {"ts", Json::Value::number(static_cast<double>(event.start_ns) / 1000.0)},
+                    {"dur", Json::Value::number(static_cast<double>(event.duration_ns) / 1000.0)},
+                    {"pid", Json::Value::number(1, true)},
+                    {"tid", Json::Value::number(buffer->tid, true)},
+                };
+                if (event.arg_name) {
+                    members.emplace_back("args", Json::Value::object({
+                        {event.arg_name, Json::Value::number(static_cast<double>(event.arg), true)},
+                    }));
+                }
+                events.push_back(Json::Value::object(std::move(members)));
+            }
+        }
+    }
+
+    return Json::write(Json::Value::object({
+        {"traceEvents", Json::Value::array(std::move(events))},
+        {"displayTimeUnit", Json::Value::string("ms")},
+        {"otherData", Json::Value::object({
+            {"dropped_events", Json::Value::number(static_cast<double>(dropped), true)},
+        })},
+    }));
+}
+
+void TraceRecorder::write(const std::string& path) const {
+    const std::string text = toJson();
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        throw std::runtime_error("Cannot open trace file " + path);
+    }
+    file << text;
+    if (!file) {
+        throw std::runtime_error("Failed to write trace file " + path);
+    }
+}
+
+void TraceRecorder::clear() {
+    std::lock_guard<std::mutex> lock(threads_mutex_);
+    for (const auto& buffer : threads_) {
+        std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+        buffer->next = 0;
+        buffer->written = 0;
+    }
+}
+
+size_t TraceRecorder::size() const {
+    std::lock_guard<std::mutex> lock(threads_mutex_);
+    size_t held = 0;
+    for (const auto& buffer : threads_) {
+        std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+        held += std::min(buffer->written, buffer->events.size());
+    }
+    return held;
+}
+
+size_t TraceRecorder::getDropped() const {
+    std::lock_guard<std::mutex> lock(threads_mutex_);
+    size_t dropped = 0;
+    for (const auto& buffer : threads_) {
+        std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+        dropped += buffer->written - std::min(buffer->written, buffer->events.size());
+    }
+    return dropped;
+}
+
+size_t TraceRecorder::getEventsPerThread() const {
+    return events_per_thread_;
+}
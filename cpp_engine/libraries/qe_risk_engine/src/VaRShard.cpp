@@ -0,0 +1,225 @@
+#include "RiskEngine.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace {
+
+const char kMagic[4] = {'Q', 'E', 'V', 'S'};
+const uint32_t kVersion = 1;
+
+void putWord(std::string& out, uint64_t word) {
+    for (int byte = 0; byte < 8; ++byte) {
+        out.push_back(static_cast<char>((word >> (8 * byte)) & 0xff));
+    }
+}
+
+void putDouble(std::string& out, double value) {
+    uint64_t word;
+    std::memcpy(&word, &value, sizeof(word));
+    putWord(out, word);
+}
+
+// Reads little-endian words off the front of a serialized shard
+class Reader {
+public:
+    explicit Reader(const std::string& bytes) : bytes_(bytes), offset_(0) {}
+    
+    uint64_t word() {
+        if (bytes_.size() - offset_ < 8) {
+            throw std::invalid_argument("Malformed VaR shard: truncated");
+        }
+        uint64_t value = 0;
+        for (int byte = 0; byte < 8; ++byte) {
+            value |= static_cast<uint64_t>(static_cast<unsigned char>(bytes_[offset_ + byte])) << (8 * byte);
+        }
+        offset_ += 8;
+        return value;
+    }
+    
+    double number() {
+        const uint64_t bits = word();
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+    
+    size_t remaining() const {
+        return bytes_.size() - offset_;
+    }
+
+private:
+    const std::string& bytes_;
+    size_t offset_;
+};
+
+// Keeps the `count` smallest values, ascending
+void keepSmallest(std::vector<double>& values, size_t count) {
+    count = std::min(count, values.size());
+    std::partial_sort(values.begin(), values.begin() + count, values.end());
+    values.resize(count);
+}
+
+} // namespace
+
+size_t VaRShard::tailSize(long long total_paths) {
+    if (total_paths <= 0) {
+        return 0;
+    }
+    const long long size = static_cast<long long>((1.0 - 0.95) * total_paths) + 1;
+    return static_cast<size_t>(std::min(size, total_paths));
+}
+
+VaRShard VaRShard::of(long long total_paths, long long first_path, std::vector<double> pnl) {
+    const long long last_path = first_path + static_cast<long long>(pnl.size());
+    if (first_path < 0 || last_path > total_paths) {
+        throw std::invalid_argument("VaR shard paths must lie within the run");
+    }
+    
+    VaRShard shard;
+    shard.total_paths = total_paths;
+    shard.first_path = first_path;
+    shard.last_path = last_path;
+    for (double value : pnl) {
+        shard.sum += value;
+        shard.sum_squares += value * value;
+    }
+    keepSmallest(pnl, tailSize(total_paths));
+    shard.tail = std::move(pnl);
+    return shard;
+}
+
+VaRShard VaRShard::merge(std::vector<VaRShard> shards) {
+    if (shards.empty()) {
+        throw std::invalid_argument("No VaR shards to merge");
+    }
+    std::sort(shards.begin(), shards.end(),
+              [](const VaRShard& a, const VaRShard& b) { return a.first_path < b.first_path; });
+    
+    VaRShard merged = std::move(shards.front());
+    for (size_t i = 1; i < shards.size(); ++i) {
+        VaRShard& shard = shards[i];
+        if (shard.total_paths != merged.total_paths) {
+            throw std::invalid_argument("VaR shards belong to runs of different sizes");
+        }
+        if (shard.first_path != merged.last_path) {
+            throw std::invalid_argument("VaR shards must tile a range of paths without gaps or overlaps");
+        }
+        merged.last_path = shard.last_path;
+        merged.sum += shard.sum;
+        merged.sum_squares += shard.sum_squares;
+        merged.tail.insert(merged.tail.end(), shard.tail.begin(), shard.tail.end());
+        keepSmallest(merged.tail, tailSize(merged.total_paths));
+    }
+    return merged;
+}
+
+RiskMetrics VaRShard::tailMetrics(const std::vector<double>& ascending, long long simulations) {
+    RiskMetrics metrics;
+    
+    const long long index_95 = static_cast<long long>((1.0 - 0.95) * simulations);
+    if (index_95 < 0 || index_95 >= simulations) {
+        throw std::runtime_error("Invalid VaR 95% index calculation");
+    }
+    const long long index_99 = static_cast<long long>((1.0 - 0.99) * simulations);
+    if (index_99 < 0 || index_99 >= simulations) {
+        throw std::runtime_error("Invalid VaR 99% index calculation");
+    }
+    if (static_cast<long long>(ascending.size()) <= index_95) {
+        throw std::invalid_argument("VaR tail holds too few values");
+    }
+    metrics.var_95 = -ascending[index_95];
+    metrics.var_99 = -ascending[index_99];
+    
+    // ES is the average of the losses at and beyond VaR
+    double sum_95 = 0.0;
+    for (long long i = 0; i <= index_95; ++i) {
+        sum_95 += ascending[i];
+    }
+    metrics.es_95 = -sum_95 / static_cast<double>(index_95 + 1);
+    
+    double sum_99 = 0.0;
+    for (long long i = 0; i <= index_99; ++i) {
+        sum_99 += ascending[i];
+    }
+    metrics.es_99 = -sum_99 / static_cast<double>(index_99 + 1);
+    
+    return metrics;
+}
+
+long long VaRShard::size() const {
+    return last_path - first_path;
+}
+
+bool VaRShard::isComplete() const {
+    return total_paths > 0 && first_path == 0 && last_path == total_paths;
+}
+
+double VaRShard::mean() const {
+    return size() > 0 ? sum / static_cast<double>(size()) : 0.0;
+}
+
+double VaRShard::standardDeviation() const {
+    if (size() <= 0) {
+        return 0.0;
+    }
+    const double average = mean();
+    return std::sqrt(std::max(0.0, sum_squares / static_cast<double>(size()) - average * average));
+}
+
+RiskMetrics VaRShard::metrics() const {
+    if (!isComplete()) {
+        throw std::invalid_argument("VaR shard covers paths " + std::to_string(first_path) + " to " +
+                                    std::to_string(last_path) + " of " + std::to_string(total_paths) +
+                                    "; merge every shard of the run first");
+    }
+    return tailMetrics(tail, total_paths);
+}
+
+std::string VaRShard::serialize() const {
+    std::string out(kMagic, sizeof(kMagic));
+    out.reserve(sizeof(kMagic) + 8 * (7 + tail.size()));
+    putWord(out, kVersion);
+    putWord(out, static_cast<uint64_t>(total_paths));
+    putWord(out, static_cast<uint64_t>(first_path));
+    putWord(out, static_cast<uint64_t>(last_path));
+    putDouble(out, sum);
+    putDouble(out, sum_squares);
+    putWord(out, tail.size());
+    for (double value : tail) {
+        putDouble(out, value);
+    }
+    return out;
+}
+
+VaRShard VaRShard::deserialize(const std::string& bytes) {
+    if (bytes.size() < sizeof(kMagic) || std::memcmp(bytes.data(), kMagic, sizeof(kMagic)) != 0) {
+        throw std::invalid_argument("Malformed VaR shard: bad header");
+    }
+    const std::string body = bytes.substr(sizeof(kMagic));
+    Reader reader(body);
+    if (reader.word() != kVersion) {
+        throw std::invalid_argument("Malformed VaR shard: unsupported version");
+    }
+    
+    VaRShard shard;
+    shard.total_paths = static_cast<long long>(reader.word());
+    shard.first_path = static_cast<long long>(reader.word());
+    shard.last_path = static_cast<long long>(reader.word());
+    shard.sum = reader.number();
+    shard.sum_squares = reader.number();
+    const uint64_t count = reader.word();
+    if (count != reader.remaining() / 8 || reader.remaining() % 8 != 0 ||
+        count > tailSize(shard.total_paths) || shard.first_path < 0 ||
+        shard.first_path > shard.last_path || shard.last_path > shard.total_paths) {
+        throw std::invalid_argument("Malformed VaR shard: inconsistent sizes");
+    }
+    shard.tail.resize(count);
+    for (double& value : shard.tail) {
+        value = reader.number();
+    }
+    return shard;
+}
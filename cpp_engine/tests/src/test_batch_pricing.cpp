@@ -0,0 +1,234 @@
+#include "BatchPricing.h"
+#include "Instrument.h"
+#include "simple_test.h"
+#include <cmath>
+#include <memory>
+#include <vector>
+
+struct Batch {
+  std::vector<double> spot, strike, expiry, rate, vol;
+  std::vector<int32_t> type, model;
+  std::vector<uint8_t> american;
+
+  void add(double s, double k, double t, double r, double v, OptionType ot,
+           PricingModel pm, bool am) {
+    spot.push_back(s);
+    strike.push_back(k);
+    expiry.push_back(t);
+    rate.push_back(r);
+    vol.push_back(v);
+    type.push_back(static_cast<int32_t>(ot));
+    model.push_back(static_cast<int32_t>(pm));
+    american.push_back(am ? 1 : 0);
+  }
+
+  BatchPricing::OptionArrays arrays() const {
+    BatchPricing::OptionArrays a;
+    a.size = spot.size();
+    a.spot = spot.data();
+    a.strike = strike.data();
+    a.expiry = expiry.data();
+    a.rate = rate.data();
+    a.volatility = vol.data();
+    a.type = type.data();
+    a.model = model.data();
+    a.american = american.data();
+    return a;
+  }
+};
+
+MarketData createMarketData(double spot, double rate, double vol) {
+  MarketData md;
+  md.asset_id = "TEST";
+  md.spot_price = spot;
+  md.risk_free_rate = rate;
+  md.volatility = vol;
+  return md;
+}
+
+void test_matches_instruments(TestSuite &suite) {
+  suite.run_test("Batch results match per-instrument pricing", [&]() {
+    Batch batch;
+    batch.add(100, 100, 0.5, 0.05, 0.2, OptionType::Call, PricingModel::BlackScholes, false);
+    batch.add(100, 100, 0.5, 0.03, 0.3, OptionType::Put, PricingModel::Binomial, false);
+    batch.add(95, 100, 0.75, 0.05, 0.25, OptionType::Call, PricingModel::MertonJumpDiffusion, false);
+    batch.add(100, 105, 0.5, 0.05, 0.2, OptionType::Put, PricingModel::BlackScholes, true);
+    batch.add(100, 105, 0.5, 0.05, 0.2, OptionType::Put, PricingModel::BaroneAdesiWhaley, true);
+
+    std::vector<double> prices(5);
+    std::vector<double> price(5), delta(5), gamma(5), vega(5), theta(5);
+    BatchPricing::GreekArrays out{price.data(), delta.data(), gamma.data(),
+                                  vega.data(), theta.data()};
+    suite.assert_equal(0, BatchPricing::price(batch.arrays(), prices.data()), 0.0,
+                       "No failures");
+    BatchPricing::greeks(batch.arrays(), out);
+
+    EuropeanOption bs(OptionType::Call, 100, 0.5, "TEST");
+    EuropeanOption binomial(OptionType::Put, 100, 0.5, "TEST", PricingModel::Binomial);
+    EuropeanOption jump(OptionType::Call, 100, 0.75, "TEST", PricingModel::MertonJumpDiffusion);
+    jump.setJumpParameters(2.0, -0.05, 0.15);
+    AmericanOption tree(OptionType::Put, 105, 0.5, "TEST");
+    AmericanOption baw(OptionType::Put, 105, 0.5, "TEST");
+    baw.setPricingModel(PricingModel::BaroneAdesiWhaley);
+
+    const std::vector<const Instrument *> expected = {&bs, &binomial, &jump, &tree, &baw};
+    const std::vector<MarketData> markets = {
+        createMarketData(100, 0.05, 0.2), createMarketData(100, 0.03, 0.3),
+        createMarketData(95, 0.05, 0.25), createMarketData(100, 0.05, 0.2),
+        createMarketData(100, 0.05, 0.2)};
+    for (size_t i = 0; i < expected.size(); ++i) {
+      const InstrumentGreeks g = expected[i]->greeks(markets[i]);
+      suite.assert_equal(expected[i]->price(markets[i]), prices[i], 0.0, "Price");
+      suite.assert_equal(g.price, price[i], 0.0, "Greeks price");
+      suite.assert_equal(g.delta, delta[i], 0.0, "Delta");
+      suite.assert_equal(g.gamma, gamma[i], 0.0, "Gamma");
+      suite.assert_equal(g.vega, vega[i], 0.0, "Vega");
+      suite.assert_equal(g.theta, theta[i], 0.0, "Theta");
+    }
+  });
+}
+
+void test_invalid_elements(TestSuite &suite) {
+  suite.run_test("Invalid elements become NaN without failing the batch", [&]() {
+    Batch batch;
+    batch.add(100, 100, 0.5, 0.05, 0.2, OptionType::Call, PricingModel::BlackScholes, false);
+    batch.add(-5, 100, 0.5, 0.05, 0.2, OptionType::Call, PricingModel::BlackScholes, false);
+    batch.add(100, 100, 0.5, 0.05, 0.2, OptionType::Put, PricingModel::AndersenLakeOffengeld, false);
+    batch.type.push_back(7);
+    batch.spot.push_back(100);
+    batch.strike.push_back(100);
+    batch.expiry.push_back(0.5);
+    batch.rate.push_back(0.05);
+    batch.vol.push_back(0.2);
+    batch.model.push_back(0);
+    batch.american.push_back(0);
+
+    std::vector<double> prices(4);
+    suite.assert_equal(3, BatchPricing::price(batch.arrays(), prices.data()), 0.0,
+                       "Failure count");
+    suite.assert_equal(0, std::isnan(prices[0]), 0.0, "Valid element priced");
+    suite.assert_equal(1, std::isnan(prices[1]) && std::isnan(prices[2]) && std::isnan(prices[3]),
+                       0.0, "Invalid elements are NaN");
+  });
+}
+
+void test_threaded_matches_serial(TestSuite &suite) {
+  suite.run_test("Threaded batch matches single-threaded batch", [&]() {
+    Batch batch;
+    for (int i = 0; i < 10000; ++i) {
+      const PricingModel model = i % 50 == 0 ? PricingModel::Binomial : PricingModel::BlackScholes;
+      batch.add(80 + i % 40, 100, 0.1 + (i % 20) * 0.1, 0.05, 0.1 + (i % 7) * 0.05,
+                i % 2 ? OptionType::Call : OptionType::Put, model, i % 100 == 0);
+    }
+    std::vector<double> serial(10000), parallel(10000);
+    BatchPricing::price(batch.arrays(), serial.data(), 1);
+    BatchPricing::price(batch.arrays(), parallel.data(), 4);
+    for (size_t i = 0; i < serial.size(); ++i) {
+      suite.assert_equal(serial[i], parallel[i], 0.0, "Element " + std::to_string(i));
+    }
+  });
+}
+
+void test_chains_match_instruments(TestSuite &suite) {
+  suite.run_test("Chained strikes match per-instrument pricing", [&]() {
+    Batch batch;
+    const std::vector<double> strikes = {80, 90, 100, 110, 120};
+    for (double k : strikes) {
+      batch.add(100, k, 1.0, 0.05, 0.25, OptionType::Put, PricingModel::Binomial, true);
+      batch.add(100, k, 0.5, 0.05, 0.25, OptionType::Call, PricingModel::MertonJumpDiffusion, false);
+    }
+    // A bad strike inside a chain only fails that element
+    batch.add(100, -1, 1.0, 0.05, 0.25, OptionType::Call, PricingModel::Binomial, true);
+
+    const size_t n = batch.spot.size();
+    std::vector<double> prices(n), price(n), delta(n), gamma(n), vega(n), theta(n);
+    BatchPricing::GreekArrays out{price.data(), delta.data(), gamma.data(),
+                                  vega.data(), theta.data()};
+    suite.assert_equal(1, BatchPricing::price(batch.arrays(), prices.data(), 2), 0.0,
+                       "Price failures");
+    suite.assert_equal(1, BatchPricing::greeks(batch.arrays(), out, 2), 0.0, "Greeks failures");
+    suite.assert_equal(1, std::isnan(prices[n - 1]) && std::isnan(delta[n - 1]), 0.0,
+                       "Bad element is NaN");
+
+    const MarketData md = createMarketData(100, 0.05, 0.25);
+    for (size_t s = 0; s < strikes.size(); ++s) {
+      AmericanOption tree(OptionType::Put, strikes[s], 1.0, "TEST");
+      EuropeanOption jump(OptionType::Call, strikes[s], 0.5, "TEST", PricingModel::MertonJumpDiffusion);
+      jump.setJumpParameters(2.0, -0.05, 0.15);
+      const std::vector<const Instrument *> expected = {&tree, &jump};
+      for (size_t j = 0; j < expected.size(); ++j) {
+        const size_t i = 2 * s + j;
+        const InstrumentGreeks g = expected[j]->greeks(md);
+        suite.assert_equal(expected[j]->price(md), prices[i], 0.0, "Price");
+        suite.assert_equal(g.price, price[i], 0.0, "Greeks price");
+        suite.assert_equal(g.delta, delta[i], 0.0, "Delta");
+        suite.assert_equal(g.gamma, gamma[i], 0.0, "Gamma");
+        suite.assert_equal(g.vega, vega[i], 0.0, "Vega");
+        suite.assert_equal(g.theta, theta[i], 0.0, "Theta");
+      }
+    }
+  });
+}
+
+void test_dividend_column(TestSuite &suite) {
+  suite.run_test("Dividend column matches per-instrument pricing", [&]() {
+    Batch batch;
+    std::vector<double> dividend;
+    const std::vector<double> yields = {0.0, 0.03};
+    for (double q : yields) {
+      for (double k : {90.0, 100.0, 110.0}) {
+        batch.add(100, k, 1.0, 0.05, 0.25, OptionType::Call, PricingModel::BlackScholes, false);
+        batch.add(100, k, 1.0, 0.05, 0.25, OptionType::Call, PricingModel::Binomial, true);
+        batch.add(100, k, 1.0, 0.05, 0.25, OptionType::Put, PricingModel::MertonJumpDiffusion, false);
+        dividend.insert(dividend.end(), 3, q);
+      }
+    }
+    BatchPricing::OptionArrays arrays = batch.arrays();
+    arrays.dividend = dividend.data();
+
+    const size_t n = batch.spot.size();
+    std::vector<double> prices(n), price(n), delta(n), gamma(n), vega(n), theta(n);
+    BatchPricing::GreekArrays out{price.data(), delta.data(), gamma.data(),
+                                  vega.data(), theta.data()};
+    suite.assert_equal(0, BatchPricing::price(arrays, prices.data(), 2), 0.0, "Price failures");
+    suite.assert_equal(0, BatchPricing::greeks(arrays, out, 2), 0.0, "Greeks failures");
+
+    for (size_t i = 0; i < n; ++i) {
+      const MarketData md("TEST", 100, 0.05, 0.25, dividend[i]);
+      std::unique_ptr<Instrument> expected;
+      if (batch.american[i]) {
+        expected = std::make_unique<AmericanOption>(OptionType::Call, batch.strike[i], 1.0, "TEST");
+      } else {
+        auto european = std::make_unique<EuropeanOption>(
+            static_cast<OptionType>(batch.type[i]), batch.strike[i], 1.0, "TEST",
+            static_cast<PricingModel>(batch.model[i]));
+        if (batch.model[i] == static_cast<int32_t>(PricingModel::MertonJumpDiffusion)) {
+          european->setJumpParameters(2.0, -0.05, 0.15);
+        }
+        expected = std::move(european);
+      }
+      const InstrumentGreeks g = expected->greeks(md);
+      suite.assert_equal(expected->price(md), prices[i], 0.0, "Price");
+      suite.assert_equal(g.delta, delta[i], 0.0, "Delta");
+      suite.assert_equal(g.theta, theta[i], 0.0, "Theta");
+    }
+  });
+}
+
+int main() {
+  TestSuite suite;
+
+  std::cout << "\n" << std::string(60, '=') << std::endl;
+  std::cout << "  Batch Pricing Test Suite" << std::endl;
+  std::cout << std::string(60, '=') << "\n" << std::endl;
+
+  test_matches_instruments(suite);
+  test_invalid_elements(suite);
+  test_threaded_matches_serial(suite);
+  test_chains_match_instruments(suite);
+  test_dividend_column(suite);
+
+  suite.print_summary();
+
+  return suite.all_passed() ? 0 : 1;
+}
@@ -0,0 +1,235 @@
+#include "Ingestion.h"
+#include "Json.h"
+#include "simple_test.h"
+#include <sstream>
+#include <stdexcept>
+
+void test_csv_portfolio(TestSuite &suite) {
+  suite.run_test("CSV portfolio rows build instruments", [&]() {
+    const std::string csv =
+        "Type, Strike, Expiry, Asset_ID, Quantity, Style, Pricing_Model\r\n"
+        "call,100,0.5,AAPL,10,,\r\n"
+        "\r\n"
+        "put,95,1.0,\" AAPL \",-5,american,\r\n"
+        "put,105,0.5,MSFT,3,european,jumpdiffusion\r\n";
+
+    Ingestion::PortfolioData data =
+        Ingestion::parsePortfolio(csv, Ingestion::Format::Csv);
+
+    suite.assert_equal(3, data.rows_read, 0.0, "Rows read");
+    suite.assert_equal(0, data.errors.size(), 0.0, "No errors");
+    suite.assert_equal(3, data.portfolio.size(), 0.0, "Rows loaded");
+    suite.assert_equal(5, data.portfolio.getTotalQuantityForAsset("AAPL"), 0.0,
+                       "Asset id trimmed and netted");
+
+    const auto &instruments = data.portfolio.getInstruments();
+    const auto *american =
+        dynamic_cast<const AmericanOption *>(instruments[1].first.get());
+    if (!american || american->getPricingModel() != PricingModel::Binomial) {
+      throw std::runtime_error("American row should default to the binomial tree");
+    }
+    const auto *jump =
+        dynamic_cast<const EuropeanOption *>(instruments[2].first.get());
+    if (!jump || jump->getPricingModel() != PricingModel::MertonJumpDiffusion) {
+      throw std::runtime_error("Expected a jump-diffusion European option");
+    }
+    suite.assert_equal(2.0, jump->getJumpIntensity(), 0.0, "Default jump intensity");
+  });
+}
+
+void test_json_lines_portfolio(TestSuite &suite) {
+  suite.run_test("JSON-lines rows accept nested parameters", [&]() {
+    const std::string jsonl =
+        "{\"type\": \"call\", \"strike\": 100, \"expiry\": 0.5, \"asset_id\": "
+        "\"AAPL\", \"quantity\": 10, \"pricing_model\": \"jumpdiffusion\", "
+        "\"jump_parameters\": {\"lambda\": 1.5, \"mean\": -0.1, \"vol\": 0.2}}\n"
+        "{\"type\": \"put\", \"strike\": 90, \"expiry\": 1, \"asset_id\": "
+        "\"MSFT\", \"quantity\": -2, \"style\": \"American\", "
+        "\"pricing_model\": \"finitedifference\", \"fd_grid\": {\"space_steps\": 150}}\n";
+
+    Ingestion::PortfolioData data =
+        Ingestion::parsePortfolio(jsonl, Ingestion::Format::JsonLines);
+
+    suite.assert_equal(0, data.errors.size(), 0.0, "No errors");
+    const auto &instruments = data.portfolio.getInstruments();
+    const auto *jump =
+        dynamic_cast<const EuropeanOption *>(instruments[0].first.get());
+    suite.assert_equal(1.5, jump->getJumpIntensity(), 0.0, "Jump intensity");
+    suite.assert_equal(-0.1, jump->getJumpMean(), 0.0, "Jump mean");
+    const auto *fd =
+        dynamic_cast<const AmericanOption *>(instruments[1].first.get());
+    suite.assert_equal(150, fd->getFiniteDifferenceSpaceSteps(), 0.0,
+                       "FD space steps");
+    suite.assert_equal(-2, data.portfolio.getTotalQuantityForAsset("MSFT"), 0.0,
+                       "MSFT quantity");
+  });
+}
+
+void test_row_errors(TestSuite &suite) {
+  suite.run_test("Invalid rows are reported with line numbers", [&]() {
+    const std::string jsonl =
+        "{\"type\": \"call\", \"strike\": 100, \"expiry\": 0.5, \"asset_id\": \"AAPL\", \"quantity\": 1}\n"
+        "{\"type\": \"call\", \"strike\": -1, \"expiry\": 0.5, \"asset_id\": \"AAPL\", \"quantity\": 1}\n"
+        "\n"
+        "{\"type\": \"call\", \"strike\": 100, \"expiry\": 0.5, \"asset_id\": \"AAPL\", \"quantity\": 1.5}\n"
+        "{\"type\": \"call\", \"strike\": 100\n"
+        "{\"type\": \"call\", \"strike\": 100, \"expiry\": 0.5, \"asset_id\": \"AAPL\", "
+        "\"quantity\": 1, \"pricing_model\": \"baroneadesiwhaley\"}\n";
+
+    Ingestion::PortfolioData data =
+        Ingestion::parsePortfolio(jsonl, Ingestion::Format::JsonLines);
+
+    suite.assert_equal(5, data.rows_read, 0.0, "Rows read");
+    suite.assert_equal(1, data.portfolio.size(), 0.0, "Valid rows loaded");
+    suite.assert_equal(4, data.errors.size(), 0.0, "Invalid rows reported");
+    suite.assert_equal(2, data.errors[0].line, 0.0, "Strike error line");
+    suite.assert_equal(4, data.errors[1].line, 0.0, "Quantity error line");
+    suite.assert_equal(5, data.errors[2].line, 0.0, "Syntax error line");
+    suite.assert_equal(6, data.errors[3].line, 0.0, "Model error line");
+    if (data.errors[0].message != "strike must be a positive number" ||
+        data.errors[1].message != "quantity must be an integer" ||
+        data.errors[3].message != "pricing_model 'baroneadesiwhaley' requires style 'american'") {
+      throw std::runtime_error("Unexpected error message");
+    }
+
+    bool threw = false;
+    try {
+      Ingestion::parsePortfolio("type,strike,expiry,asset_id\n", Ingestion::Format::Csv);
+    } catch (const std::invalid_argument &) {
+      threw = true;
+    }
+    suite.assert_equal(1, threw, 0.0, "Missing CSV column rejected");
+  });
+}
+
+void test_parallel_matches_serial(TestSuite &suite) {
+  suite.run_test("Threaded parse matches single-threaded parse", [&]() {
+    std::ostringstream csv;
+    csv << "type,strike,expiry,asset_id,quantity,style\n";
+    for (int i = 0; i < 20000; ++i) {
+      if (i % 997 == 0) {
+        csv << "call,abc,0.5,BAD,1,european\n";
+        continue;
+      }
+      csv << (i % 2 ? "call" : "put") << "," << 80 + i % 40 << "," << 0.25 + (i % 4) * 0.25
+          << ",SYM" << i % 50 << "," << (i % 7) - 3 << "," << (i % 5 ? "european" : "american")
+          << "\n";
+    }
+
+    const Ingestion::PortfolioData serial =
+        Ingestion::parsePortfolio(csv.str(), Ingestion::Format::Csv, 1);
+    const Ingestion::PortfolioData parallel =
+        Ingestion::parsePortfolio(csv.str(), Ingestion::Format::Csv, 4);
+
+    suite.assert_equal(serial.portfolio.size(), parallel.portfolio.size(), 0.0, "Row count");
+    suite.assert_equal(serial.errors.size(), parallel.errors.size(), 0.0, "Error count");
+    for (size_t i = 0; i < serial.errors.size(); ++i) {
+      suite.assert_equal(serial.errors[i].line, parallel.errors[i].line, 0.0, "Error line");
+    }
+    suite.assert_equal(serial.portfolio.getNettedPositions().size(),
+                       parallel.portfolio.getNettedPositions().size(), 0.0,
+                       "Netted positions");
+    const auto &a = serial.portfolio.getInstruments();
+    const auto &b = parallel.portfolio.getInstruments();
+    for (size_t i = 0; i < a.size(); ++i) {
+      if (a[i].first->getContractKey() != b[i].first->getContractKey() ||
+          a[i].second != b[i].second) {
+        throw std::runtime_error("Row " + std::to_string(i) + " differs");
+      }
+    }
+  });
+}
+
+void test_market_data(TestSuite &suite) {
+  suite.run_test("Market data rows build the asset map", [&]() {
+    const std::string csv = "asset_id,spot,rate,vol,dividend\n"
+                            "AAPL,150,0.05,0.25,0.01\n"
+                            "MSFT,300,0.05,0.3,\n"
+                            "AAPL,151,0.05,0.25,\n"
+                            "GOOG,-1,0.05,0.3,\n";
+
+    Ingestion::MarketDataSet data =
+        Ingestion::parseMarketData(csv, Ingestion::Format::Csv);
+
+    suite.assert_equal(4, data.rows_read, 0.0, "Rows read");
+    suite.assert_equal(2, data.market_data.size(), 0.0, "Assets loaded");
+    suite.assert_equal(150.0, data.market_data.at("AAPL").spot_price, 0.0,
+                       "First AAPL row wins");
+    suite.assert_equal(0.01, data.market_data.at("AAPL").dividend_yield, 0.0,
+                       "Dividend");
+    suite.assert_equal(2, data.errors.size(), 0.0, "Duplicate and bad spot");
+    suite.assert_equal(4, data.errors[0].line, 0.0, "Duplicate line");
+    suite.assert_equal(5, data.errors[1].line, 0.0, "Bad spot line");
+  });
+}
+
+void test_json_parser(TestSuite &suite) {
+  suite.run_test("JSON parser handles escapes and rejects bad input", [&]() {
+    const Json::Value value = Json::parse(
+        "{\"s\": \"a\\\"b\\u00e9\\ud83d\\ude00\", \"n\": -1.5e2, \"i\": 42, "
+        "\"a\": [true, null]}");
+    if (value.find("s")->asString() != "a\"b\xc3\xa9\xf0\x9f\x98\x80") {
+      throw std::runtime_error("String escapes decoded incorrectly");
+    }
+    suite.assert_equal(-150.0, value.find("n")->asNumber(), 0.0, "Exponent");
+    suite.assert_equal(0, value.find("n")->isInteger(), 0.0, "Fraction is not integer");
+    suite.assert_equal(1, value.find("i")->isInteger(), 0.0, "Integer");
+    suite.assert_equal(2, value.find("a")->asArray().size(), 0.0, "Array size");
+
+    int rejected = 0;
+    for (const char *bad : {"{\"a\": 01}", "[1,]", "{\"a\" 1}", "\"\\x\"", "[1] 2", "-"}) {
+      try {
+        Json::parse(bad);
+      } catch (const std::invalid_argument &) {
+        ++rejected;
+      }
+    }
+    suite.assert_equal(6, rejected, 0.0, "Malformed documents rejected");
+  });
+}
+
+void test_json_records(TestSuite &suite) {
+  suite.run_test("Request records build positions and round-trip as JSON", [&]() {
+    const Json::Value item = Json::parse(
+        "{\"type\": \"put\", \"strike\": 95, \"expiry\": 1, \"asset_id\": \"MSFT\", "
+        "\"quantity\": -3, \"style\": \"american\"}");
+    const Ingestion::Position position = Ingestion::positionFromJson(item);
+    suite.assert_equal(-3, position.quantity, 0.0, "Quantity");
+    if (position.instrument->getInstrumentType() != "AmericanOption") {
+      throw std::runtime_error("Expected an American option");
+    }
+
+    const MarketData md = Ingestion::marketDataFromJson(
+        "MSFT", Json::parse("{\"spot\": 300, \"rate\": 0.05, \"vol\": 0.3}"));
+    suite.assert_equal(300.0, md.spot_price, 0.0, "Spot");
+    if (md.asset_id != "MSFT") {
+      throw std::runtime_error("Asset id should come from the key");
+    }
+
+    const std::string text =
+        "{\"a\":[1,0.1,-2.5e-300,true,null],\"s\":\"q\\\"\\n\\u0001\"}";
+    if (Json::write(Json::parse(text)) != text) {
+      throw std::runtime_error("Round trip changed " + Json::write(Json::parse(text)));
+    }
+  });
+}
+
+int main() {
+  TestSuite suite;
+
+  std::cout << "\n" << std::string(60, '=') << std::endl;
+  std::cout << "  Ingestion Test Suite" << std::endl;
+  std::cout << std::string(60, '=') << "\n" << std::endl;
+
+  test_csv_portfolio(suite);
+  test_json_lines_portfolio(suite);
+  test_row_errors(suite);
+  test_parallel_matches_serial(suite);
+  test_market_data(suite);
+  test_json_parser(suite);
+  test_json_records(suite);
+
+  suite.print_summary();
+
+  return suite.all_passed() ? 0 : 1;
+}
@@ -0,0 +1,103 @@
+#include "Philox.h"
+#include "simple_test.h"
+#include <cmath>
+#include <vector>
+
+void test_known_answers(TestSuite &suite) {
+  suite.run_test("Philox4x32-10 matches the Random123 known answers", [&]() {
+    const std::vector<std::pair<Philox::Counter, Philox::Key>> inputs = {
+        {{0, 0, 0, 0}, {0, 0}},
+        {{0xffffffffu, 0xffffffffu, 0xffffffffu, 0xffffffffu}, {0xffffffffu, 0xffffffffu}},
+        {{0x243f6a88u, 0x85a308d3u, 0x13198a2eu, 0x03707344u}, {0xa4093822u, 0x299f31d0u}},
+    };
+    const std::vector<Philox::Counter> expected = {
+        {0x6627e8d5u, 0xe169c58du, 0xbc57ac4cu, 0x9b00dbd8u},
+        {0x408f276du, 0x41c83b0eu, 0xa20bc7c6u, 0x6d5451fdu},
+        {0xd16cfe09u, 0x94fdccebu, 0x5001e420u, 0x24126ea1u},
+    };
+    for (size_t i = 0; i < inputs.size(); ++i) {
+      const Philox::Counter output = Philox::block(inputs[i].first, inputs[i].second);
+      for (size_t w = 0; w < 4; ++w) {
+        suite.assert_equal(expected[i][w], output[w], 0.0, "Known answer word");
+      }
+    }
+  });
+}
+
+void test_inverse_normal(TestSuite &suite) {
+  suite.run_test("Inverse normal inverts the normal CDF", [&]() {
+    for (double x = -7.0; x <= 5.0; x += 0.25) {
+      const double p = 0.5 * std::erfc(-x / std::sqrt(2.0));
+      suite.assert_equal(x, Philox::inverseNormal(p), 1e-9, "Quantile of CDF");
+    }
+    suite.assert_equal(0.0, Philox::inverseNormal(0.5), 1e-15, "Median");
+    // Lower-tail probabilities are exact doubles, so the quantile is too
+    for (double x = -8.0; x <= 0.0; x += 0.25) {
+      const double p = 0.5 * std::erfc(-x / std::sqrt(2.0));
+      suite.assert_equal(x, Philox::inverseNormal(p), 1e-13, "Lower-tail quantile");
+    }
+  });
+}
+
+void test_addressable_draws(TestSuite &suite) {
+  suite.run_test("Draws depend only on their address", [&]() {
+    const double forward = Philox::normal(42, 123456789012LL, 3, 0);
+    for (long long path = 0; path < 1000; ++path) {
+      Philox::normal(42, path, 3, 0);
+    }
+    suite.assert_equal(forward, Philox::normal(42, 123456789012LL, 3, 0), 0.0, "Same address, same draw");
+    suite.assert_equal(1, Philox::normal(42, 7, 3, 0) != Philox::normal(42, 7, 3, 1), 0.0,
+                       "Factors are independent streams");
+    suite.assert_equal(1, Philox::normal(42, 7, 3, 0) != Philox::normal(43, 7, 3, 0), 0.0,
+                       "Seeds differ");
+
+    const int n = 200000;
+    double sum = 0.0, sum_squares = 0.0;
+    for (int path = 0; path < n; ++path) {
+      const double z = Philox::normal(1, path, 0, 0);
+      sum += z;
+      sum_squares += z * z;
+    }
+    suite.assert_equal(0.0, sum / n, 0.01, "Mean");
+    suite.assert_equal(1.0, sum_squares / n, 0.01, "Variance");
+  });
+}
+
+void test_bulk_draws(TestSuite &suite) {
+  suite.run_test("Bulk draws equal the addressed draws", [&]() {
+    // A partial chunk, and path indices above 32 bits
+    std::vector<uint64_t> paths;
+    for (uint64_t path = 0; path < 1000; ++path) {
+      paths.push_back(path % 7 == 0 ? path + (5ULL << 32) : path * 31);
+    }
+    std::vector<double> uniforms(paths.size());
+    std::vector<double> normals(paths.size());
+    Philox::fillUniforms(99, paths.data(), paths.size(), 4, 2, uniforms.data());
+    Philox::fillNormals(99, paths.data(), paths.size(), 4, 2, normals.data());
+
+    int tails = 0;
+    for (size_t i = 0; i < paths.size(); ++i) {
+      suite.assert_equal(Philox::uniform(99, paths[i], 4, 2), uniforms[i], 0.0, "Bulk uniform");
+      suite.assert_equal(Philox::normal(99, paths[i], 4, 2), normals[i], 0.0, "Bulk normal");
+      tails += std::abs(uniforms[i] - 0.5) > 0.425;
+    }
+    suite.assert_equal(1, tails > 0, 0.0, "Tail branch exercised");
+  });
+}
+
+int main() {
+  TestSuite suite;
+
+  std::cout << "\n" << std::string(60, '=') << std::endl;
+  std::cout << "  Philox Test Suite" << std::endl;
+  std::cout << std::string(60, '=') << "\n" << std::endl;
+
+  test_known_answers(suite);
+  test_inverse_normal(suite);
+  test_addressable_draws(suite);
+  test_bulk_draws(suite);
+
+  suite.print_summary();
+
+  return suite.all_passed() ? 0 : 1;
+}
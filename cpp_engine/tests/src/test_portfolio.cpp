@@ -2,7 +2,12 @@
 #include "MarketData.h"
 #include "Portfolio.h"
 #include "simple_test.h"
+#include <map>
 #include <memory>
+#include <climits>
+#include <cstdio>
+#include <fstream>
+#include <random>
 
 
 void test_empty_portfolio(TestSuite &suite) {
@@ -199,6 +204,25 @@ void test_same_asset_multiple_instruments(TestSuite &suite) {
       }
     }
   });
+
+  suite.run_test("Net positions past int range stay per asset", [&]() {
+    Portfolio portfolio;
+    portfolio.addInstrument(
+        std::make_unique<EuropeanOption>(OptionType::Call, 95.0, 1.0, "AAPL"),
+        INT_MAX);
+    portfolio.addInstrument(
+        std::make_unique<EuropeanOption>(OptionType::Call, 100.0, 1.0, "AAPL"),
+        INT_MAX);
+    portfolio.addInstrument(
+        std::make_unique<EuropeanOption>(OptionType::Put, 50.0, 1.0, "MSFT"),
+        7);
+
+    const auto net_positions = portfolio.getNetPositions();
+    suite.assert_equal(2.0 * INT_MAX, static_cast<double>(net_positions.at("AAPL")),
+                       0.0, "AAPL net in 64 bits");
+    suite.assert_equal(7, static_cast<double>(net_positions.at("MSFT")), 0.0,
+                       "MSFT unaffected");
+  });
 }
 
 void test_instrument_ownership(TestSuite &suite) {
@@ -296,6 +320,306 @@ void test_portfolio_ordering(TestSuite &suite) {
   });
 }
 
+void test_position_netting(TestSuite &suite) {
+  suite.run_test("Identical contracts net into one position", [&]() {
+    Portfolio portfolio;
+    portfolio.addInstrument(
+        std::make_unique<EuropeanOption>(OptionType::Call, 100.0, 1.0, "AAPL"),
+        10);
+    portfolio.addInstrument(
+        std::make_unique<EuropeanOption>(OptionType::Put, 100.0, 1.0, "AAPL"),
+        5);
+    portfolio.addInstrument(
+        std::make_unique<EuropeanOption>(OptionType::Call, 100.0, 1.0, "AAPL"),
+        -3);
+    // Binomial steps do not affect a Black-Scholes contract
+    auto same = std::make_unique<EuropeanOption>(OptionType::Call, 100.0, 1.0,
+                                                 "AAPL");
+    same->setBinomialSteps(500);
+    portfolio.addInstrument(std::move(same), 4);
+    portfolio.addInstrument(
+        std::make_unique<EuropeanOption>(OptionType::Call, 100.0, 1.0, "AAPL",
+                                         PricingModel::Binomial),
+        7);
+
+    const auto &netted = portfolio.getNettedPositions();
+    suite.assert_equal(3, static_cast<double>(netted.size()), 1e-10,
+                       "Distinct contracts");
+    suite.assert_equal(11, static_cast<double>(netted[0].quantity), 1e-10,
+                       "Netted call quantity");
+    suite.assert_equal(3, static_cast<double>(netted[0].rows.size()), 1e-10,
+                       "Rows behind the call");
+    suite.assert_equal(5, static_cast<double>(portfolio.size()), 1e-10,
+                       "Rows kept for reporting");
+
+    portfolio.updateQuantity(2, 1);
+    suite.assert_equal(15, static_cast<double>(netted[0].quantity), 1e-10,
+                       "After quantity update");
+
+    // Rows shift down and the call is now first seen at row 1
+    portfolio.removeInstrument(0);
+    const NettedPosition &call = portfolio.getNettedPositions()[1];
+    suite.assert_equal(5, static_cast<double>(call.quantity), 1e-10,
+                       "After removal");
+    suite.assert_equal(1, static_cast<double>(call.instrument_index), 1e-10,
+                       "Representative row after removal");
+
+    portfolio.clear();
+    if (!portfolio.getNettedPositions().empty()) {
+      throw std::runtime_error("Cleared portfolio should have no positions");
+    }
+  });
+}
+
+// Recomputes every index by scanning the rows and compares
+void checkIndexes(TestSuite &suite, const Portfolio &portfolio,
+                  const std::map<PositionHandle, const Instrument *> &live) {
+  const auto &instruments = portfolio.getInstruments();
+  std::map<std::string, long long> asset_totals;
+  std::map<std::string, long long> contract_totals;
+  for (const auto &[instrument, quantity] : instruments) {
+    asset_totals[instrument->getAssetId()] += quantity;
+    contract_totals[instrument->getContractKey()] += quantity;
+  }
+
+  for (const auto &[asset_id, total] : asset_totals) {
+    suite.assert_equal(static_cast<double>(total),
+                       portfolio.getTotalQuantityForAsset(asset_id), 0.0,
+                       "Net quantity for " + asset_id);
+    for (size_t row : portfolio.getRowsForAsset(asset_id)) {
+      if (instruments[row].first->getAssetId() != asset_id) {
+        throw std::runtime_error("Asset index points at the wrong row");
+      }
+    }
+  }
+  suite.assert_equal(static_cast<double>(asset_totals.size()),
+                     static_cast<double>(portfolio.getNetPositions().size()),
+                     0.0, "Assets indexed");
+
+  const auto &netted = portfolio.getNettedPositions();
+  suite.assert_equal(static_cast<double>(contract_totals.size()),
+                     static_cast<double>(netted.size()), 0.0,
+                     "Contracts netted");
+  for (const NettedPosition &position : netted) {
+    const std::string key =
+        instruments[position.instrument_index].first->getContractKey();
+    suite.assert_equal(static_cast<double>(contract_totals[key]),
+                       static_cast<double>(position.quantity), 0.0,
+                       "Netted quantity");
+  }
+
+  for (const auto &[handle, instrument] : live) {
+    if (instruments[portfolio.getIndex(handle)].first.get() != instrument) {
+      throw std::runtime_error("Handle resolves to the wrong row");
+    }
+  }
+}
+
+void test_position_handles(TestSuite &suite) {
+  suite.run_test("Handles and asset index survive edits", [&]() {
+    const std::vector<std::string> assets = {"AAPL", "MSFT", "GOOG", "AMZN"};
+    std::mt19937 generator(7);
+    Portfolio portfolio;
+    std::map<PositionHandle, const Instrument *> live;
+
+    auto add = [&]() {
+      auto option = std::make_unique<EuropeanOption>(
+          generator() % 2 ? OptionType::Call : OptionType::Put,
+          90.0 + 10.0 * (generator() % 3), 1.0, assets[generator() % 4]);
+      const Instrument *raw = option.get();
+      const int quantity = static_cast<int>(generator() % 21) - 10;
+      live[portfolio.addInstrument(std::move(option), quantity)] = raw;
+    };
+
+    for (int i = 0; i < 200; ++i) {
+      add();
+    }
+    for (int step = 0; step < 300; ++step) {
+      const size_t row = generator() % portfolio.size();
+      switch (generator() % 4) {
+      case 0: {
+        const PositionHandle handle = portfolio.getHandle(row);
+        portfolio.removePosition(handle);
+        live.erase(handle);
+        break;
+      }
+      case 1:
+        live.erase(portfolio.getHandle(row));
+        portfolio.removeInstrument(row);
+        break;
+      case 2:
+        portfolio.updateQuantity(row, static_cast<int>(generator() % 41) - 20);
+        break;
+      default:
+        add();
+      }
+      checkIndexes(suite, portfolio, live);
+    }
+
+    const PositionHandle removed = live.begin()->first;
+    portfolio.removePosition(removed);
+    bool threw = false;
+    try {
+      portfolio.getIndex(removed);
+    } catch (const std::out_of_range &) {
+      threw = true;
+    }
+    if (!threw) {
+      throw std::runtime_error("Removed handle should no longer resolve");
+    }
+  });
+}
+
+void test_binary_round_trip(TestSuite &suite) {
+  suite.run_test("Binary file round-trips every contract field", [&]() {
+    const std::string path = "test_portfolio_round_trip.qepf";
+    Portfolio portfolio;
+    portfolio.addInstrument(
+        std::make_unique<EuropeanOption>(OptionType::Call, 100.0, 1.0, "AAPL"),
+        10);
+    auto merton = std::make_unique<EuropeanOption>(
+        OptionType::Put, 95.5, 0.75, "MSFT", PricingModel::MertonJumpDiffusion);
+    merton->setJumpParameters(0.3, -0.05, 0.12);
+    portfolio.addInstrument(std::move(merton), -4);
+    auto fd = std::make_unique<AmericanOption>(OptionType::Put, 110.0, 0.5,
+                                               "AAPL", 250);
+    fd->setPricingModel(PricingModel::FiniteDifference);
+    fd->setFiniteDifferenceGrid(300, 150);
+    portfolio.addInstrument(std::move(fd), 7);
+    portfolio.addInstrument(
+        std::make_unique<EuropeanOption>(OptionType::Call, 100.0, 1.0, "AAPL"),
+        -2);
+
+    portfolio.saveBinary(path);
+    Portfolio loaded;
+    loaded.addInstrument(
+        std::make_unique<EuropeanOption>(OptionType::Call, 50.0, 1.0, "GOOG"),
+        1);
+    const PositionHandle stale = loaded.getHandle(0);
+    const uint64_t version = loaded.getVersion();
+    loaded.loadBinary(path);
+    std::remove(path.c_str());
+
+    suite.assert_equal(4, static_cast<double>(loaded.size()), 0.0, "Rows");
+    for (size_t row = 0; row < portfolio.size(); ++row) {
+      const auto &expected = portfolio.getInstruments()[row];
+      const auto &actual = loaded.getInstruments()[row];
+      if (expected.first->getContractKey() != actual.first->getContractKey()) {
+        throw std::runtime_error("Contract differs in row " +
+                                 std::to_string(row));
+      }
+      suite.assert_equal(expected.second, actual.second, 0.0, "Quantity");
+    }
+    suite.assert_equal(15, loaded.getTotalQuantityForAsset("AAPL"), 0.0,
+                       "AAPL net quantity");
+    suite.assert_equal(0, loaded.getTotalQuantityForAsset("GOOG"), 0.0,
+                       "Previous contents replaced");
+    if (loaded.getVersion() == version) {
+      throw std::runtime_error("Loading should change the version");
+    }
+    bool threw = false;
+    try {
+      loaded.getIndex(stale);
+    } catch (const std::out_of_range &) {
+      threw = true;
+    }
+    if (!threw) {
+      throw std::runtime_error("Handles from before the load should not resolve");
+    }
+  });
+
+  suite.run_test("Loaded book nets like one built row by row", [&]() {
+    const std::string path = "test_portfolio_netting.qepf";
+    const std::vector<std::string> assets = {"AAPL", "MSFT", "GOOG"};
+    std::mt19937 generator(11);
+    Portfolio portfolio;
+    for (int i = 0; i < 400; ++i) {
+      const OptionType type = generator() % 2 ? OptionType::Call : OptionType::Put;
+      const double strike = 90.0 + 10.0 * (generator() % 3);
+      const std::string &asset_id = assets[generator() % assets.size()];
+      const int quantity = static_cast<int>(generator() % 21) - 10;
+      switch (generator() % 4) {
+      case 0: {
+        // Steps only distinguish binomial contracts
+        auto option = std::make_unique<EuropeanOption>(
+            type, strike, 1.0, asset_id,
+            generator() % 2 ? PricingModel::Binomial : PricingModel::BlackScholes);
+        option->setBinomialSteps(generator() % 2 ? 100 : 150);
+        portfolio.addInstrument(std::move(option), quantity);
+        break;
+      }
+      case 1: {
+        auto option = std::make_unique<EuropeanOption>(
+            type, strike, 0.5, asset_id, PricingModel::MertonJumpDiffusion);
+        option->setJumpParameters(generator() % 2 ? 0.1 : 0.2, -0.05, 0.15);
+        portfolio.addInstrument(std::move(option), quantity);
+        break;
+      }
+      default: {
+        auto option = std::make_unique<AmericanOption>(type, strike, 0.5, asset_id,
+                                                       generator() % 2 ? 100 : 200);
+        if (generator() % 2) {
+          option->setPricingModel(PricingModel::FiniteDifference);
+        }
+        portfolio.addInstrument(std::move(option), quantity);
+      }
+      }
+    }
+    portfolio.saveBinary(path);
+    Portfolio loaded;
+    loaded.loadBinary(path);
+    std::remove(path.c_str());
+
+    suite.assert_equal(static_cast<double>(portfolio.getNettedPositions().size()),
+                       static_cast<double>(loaded.getNettedPositions().size()), 0.0,
+                       "Same contracts");
+    std::map<PositionHandle, const Instrument *> live;
+    for (size_t row = 0; row < loaded.size(); ++row) {
+      live[loaded.getHandle(row)] = loaded.getInstruments()[row].first.get();
+    }
+    checkIndexes(suite, loaded, live);
+
+    // Edits after the load keep the bulk-built indexes consistent
+    for (int step = 0; step < 200; ++step) {
+      const size_t row = generator() % loaded.size();
+      if (step % 2) {
+        const PositionHandle handle = loaded.getHandle(row);
+        loaded.removePosition(handle);
+        live.erase(handle);
+      } else {
+        loaded.updateQuantity(row, static_cast<int>(generator() % 41) - 20);
+      }
+    }
+    checkIndexes(suite, loaded, live);
+  });
+
+  suite.run_test("Corrupted binary file is rejected", [&]() {
+    const std::string path = "test_portfolio_corrupt.qepf";
+    Portfolio portfolio;
+    portfolio.addInstrument(
+        std::make_unique<EuropeanOption>(OptionType::Call, 100.0, 1.0, "AAPL"),
+        10);
+    portfolio.saveBinary(path);
+    {
+      std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+      file.seekp(-1, std::ios::end);
+      file.put('\x7f');
+    }
+
+    Portfolio loaded;
+    bool threw = false;
+    try {
+      loaded.loadBinary(path);
+    } catch (const std::runtime_error &) {
+      threw = true;
+    }
+    std::remove(path.c_str());
+    if (!threw || !loaded.empty()) {
+      throw std::runtime_error("Checksum mismatch should fail the load");
+    }
+  });
+}
+
 int main() {
   TestSuite suite;
 
@@ -313,6 +637,9 @@ int main() {
   test_large_portfolio(suite);
   test_instrument_pricing_in_portfolio(suite);
   test_portfolio_ordering(suite);
+  test_position_netting(suite);
+  test_position_handles(suite);
+  test_binary_round_trip(suite);
 
   suite.print_summary();
 
@@ -0,0 +1,274 @@
+#include "AndersenLakeOffengeld.h"
+#include "BaroneAdesiWhaley.h"
+#include "BinomialTree.h"
+#include "BlackScholes.h"
+#include "FiniteDifference.h"
+#include "Instrument.h"
+#include "JumpDiffusion.h"
+#include "MarketData.h"
+#include "simple_test.h"
+#include <cmath>
+
+
+void test_finite_difference_european(TestSuite &suite) {
+  suite.run_test("FD European prices match Black-Scholes", [&]() {
+    for (double strike : {80.0, 100.0, 120.0}) {
+      double call = FiniteDifference::europeanOptionPrice(
+          100.0, strike, 0.05, 1.0, 0.2, OptionType::Call);
+      double put = FiniteDifference::europeanOptionPrice(
+          100.0, strike, 0.05, 1.0, 0.2, OptionType::Put);
+
+      suite.assert_equal(BlackScholes::callPrice(100.0, strike, 0.05, 1.0, 0.2),
+                         call, 2e-3, "Call");
+      suite.assert_equal(BlackScholes::putPrice(100.0, strike, 0.05, 1.0, 0.2),
+                         put, 2e-3, "Put");
+    }
+  });
+
+  suite.run_test("FD grid Greeks match Black-Scholes", [&]() {
+    FiniteDifference::SolutionSlice slice = FiniteDifference::solve(
+        100.0, 105.0, 0.05, 0.5, 0.25, OptionType::Call, false);
+
+    suite.assert_equal(BlackScholes::callDelta(100.0, 105.0, 0.05, 0.5, 0.25),
+                       slice.delta(100.0), 1e-3, "Delta");
+    suite.assert_equal(BlackScholes::gamma(100.0, 105.0, 0.05, 0.5, 0.25),
+                       slice.gamma(100.0), 1e-4, "Gamma");
+  });
+
+  suite.run_test("FD slice interpolates nearby spots", [&]() {
+    FiniteDifference::SolutionSlice slice = FiniteDifference::solve(
+        100.0, 100.0, 0.05, 1.0, 0.2, OptionType::Put, false);
+
+    for (double spot : {93.7, 98.2, 101.5, 106.3}) {
+      suite.assert_equal(BlackScholes::putPrice(spot, 100.0, 0.05, 1.0, 0.2),
+                         slice.price(spot), 2e-3, "Interpolated price");
+    }
+  });
+
+  suite.run_test("FD gamma of deep ITM options is non-negative", [&]() {
+    MarketData md("AAPL", 100.0, 0.05, 0.2);
+    EuropeanOption put(OptionType::Put, 200.0, 0.05, "AAPL",
+                       PricingModel::FiniteDifference);
+    EuropeanOption call(OptionType::Call, 50.0, 0.05, "AAPL",
+                        PricingModel::FiniteDifference);
+
+    for (const EuropeanOption *option : {&put, &call}) {
+      double gamma = option->gamma(md);
+      if (gamma < 0.0) {
+        throw std::runtime_error("Negative FD gamma");
+      }
+      suite.assert_equal(0.0, gamma, 1e-6, "Gamma near Black-Scholes zero");
+      suite.assert_equal(gamma, option->greeks(md).gamma, 1e-15,
+                         "gamma() agrees with greeks()");
+    }
+  });
+}
+
+void test_finite_difference_american(TestSuite &suite) {
+  suite.run_test("FD American put matches a fine binomial tree", [&]() {
+    FiniteDifference::GridSettings settings;
+    settings.space_steps = 400;
+    settings.time_steps = 400;
+
+    for (double strike : {90.0, 100.0, 110.0}) {
+      double tree = BinomialTree::americanOptionPrice(
+          100.0, strike, 0.05, 1.0, 0.2, OptionType::Put, 5000);
+      double fd = FiniteDifference::americanOptionPrice(
+          100.0, strike, 0.05, 1.0, 0.2, OptionType::Put, settings);
+      suite.assert_equal(tree, fd, 1e-3, "American put");
+    }
+  });
+
+  suite.run_test("FD American put is worth at least intrinsic", [&]() {
+    FiniteDifference::SolutionSlice slice = FiniteDifference::solve(
+        100.0, 120.0, 0.05, 1.0, 0.2, OptionType::Put, true);
+
+    for (double v : slice.values()) {
+      if (std::isnan(v) || v < 0.0) {
+        throw std::runtime_error("Invalid grid value");
+      }
+    }
+    if (slice.price(85.0) < 120.0 - 85.0 - 1e-12) {
+      throw std::runtime_error("Deep ITM American put below intrinsic");
+    }
+  });
+
+  suite.run_test("AmericanOption uses grid Greeks under FiniteDifference",
+                 [&]() {
+    MarketData md("AAPL", 100.0, 0.05, 0.2);
+    AmericanOption binomial(OptionType::Put, 100.0, 1.0, "AAPL", 1000);
+    AmericanOption grid(OptionType::Put, 100.0, 1.0, "AAPL");
+    grid.setPricingModel(PricingModel::FiniteDifference);
+
+    suite.assert_equal(binomial.price(md), grid.price(md), 5e-3, "Price");
+    suite.assert_equal(binomial.delta(md), grid.delta(md), 5e-3, "Delta");
+    suite.assert_equal(binomial.gamma(md), grid.gamma(md), 2e-3, "Gamma");
+
+    bool threw = false;
+    try {
+      grid.setPricingModel(PricingModel::BlackScholes);
+    } catch (const std::invalid_argument &) {
+      threw = true;
+    }
+    if (!threw) {
+      throw std::runtime_error("Black-Scholes should be rejected for American");
+    }
+  });
+}
+
+void test_american_approximations(TestSuite &suite) {
+  suite.run_test("ALO put matches a finely resolved boundary", [&]() {
+    AndersenLakeOffengeld::CollocationSettings fine;
+    fine.collocation_nodes = 48;
+    fine.integration_nodes = 64;
+    fine.iterations = 40;
+    fine.pricing_nodes = 128;
+    for (double sigma : {0.2, 0.4}) {
+      for (double strike : {90.0, 100.0, 110.0}) {
+        double fast = AndersenLakeOffengeld::americanOptionPrice(
+            100.0, strike, 0.05, 1.0, sigma, OptionType::Put);
+        double reference = AndersenLakeOffengeld::americanOptionPrice(
+            100.0, strike, 0.05, 1.0, sigma, OptionType::Put, fine);
+        suite.assert_equal(reference, fast, 1e-7, "ALO put");
+      }
+    }
+  });
+
+  suite.run_test("ALO put matches a fine binomial tree", [&]() {
+    for (double strike : {90.0, 100.0, 110.0}) {
+      double tree = BinomialTree::americanOptionPrice(
+          100.0, strike, 0.05, 1.0, 0.3, OptionType::Put, 4000);
+      double alo = AndersenLakeOffengeld::americanOptionPrice(
+          100.0, strike, 0.05, 1.0, 0.3, OptionType::Put);
+      suite.assert_equal(tree, alo, 1e-3, "American put");
+    }
+  });
+
+  suite.run_test("ALO chain batch matches per-strike prices", [&]() {
+    std::vector<double> strikes = {90.0, 100.0, 110.0, 100.0};
+    std::vector<OptionType> types = {OptionType::Put, OptionType::Put,
+                                     OptionType::Put, OptionType::Call};
+    std::vector<double> prices = AndersenLakeOffengeld::americanOptionPrices(
+        100.0, strikes, types, 0.05, 0.5, 0.25);
+    for (size_t k = 0; k < strikes.size(); ++k) {
+      suite.assert_equal(AndersenLakeOffengeld::americanOptionPrice(
+                             100.0, strikes[k], 0.05, 0.5, 0.25, types[k]),
+                         prices[k], 1e-12, "Chain price");
+    }
+    suite.assert_equal(BlackScholes::callPrice(100.0, 100.0, 0.05, 0.5, 0.25),
+                       prices[3], 1e-12, "Call equals Black-Scholes");
+  });
+
+  suite.run_test("BAW put is within cents of the tree", [&]() {
+    for (double T : {0.25, 1.0}) {
+      for (double strike : {90.0, 100.0, 110.0}) {
+        double tree = BinomialTree::americanOptionPrice(
+            100.0, strike, 0.05, T, 0.2, OptionType::Put, 2000);
+        double baw = BaroneAdesiWhaley::americanOptionPrice(
+            100.0, strike, 0.05, T, 0.2, OptionType::Put);
+        suite.assert_equal(tree, baw, 0.1, "BAW put");
+      }
+    }
+    double deep = BaroneAdesiWhaley::americanOptionPrice(
+        60.0, 100.0, 0.05, 1.0, 0.2, OptionType::Put);
+    suite.assert_equal(40.0, deep, 1e-12, "Exercised below critical price");
+  });
+
+  suite.run_test("AmericanOption prices under ALO and BAW", [&]() {
+    MarketData md("AAPL", 100.0, 0.05, 0.2);
+    AmericanOption tree(OptionType::Put, 100.0, 1.0, "AAPL", 2000);
+    AmericanOption alo(OptionType::Put, 100.0, 1.0, "AAPL");
+    alo.setPricingModel(PricingModel::AndersenLakeOffengeld);
+    AmericanOption baw(OptionType::Put, 100.0, 1.0, "AAPL");
+    baw.setPricingModel(PricingModel::BaroneAdesiWhaley);
+
+    suite.assert_equal(tree.price(md), alo.price(md), 2e-3, "ALO price");
+    suite.assert_equal(tree.delta(md), alo.delta(md), 2e-3, "ALO delta");
+    suite.assert_equal(tree.gamma(md), alo.gamma(md), 2e-3, "ALO gamma");
+    suite.assert_equal(tree.price(md), baw.price(md), 0.05, "BAW price");
+  });
+}
+
+void test_merton_kernel(TestSuite &suite) {
+  suite.run_test("Merton Greeks match bumped prices", [&]() {
+    const double S = 100.0, r = 0.05, T = 0.75, sigma = 0.2;
+    const double lambda = 1.5, jump_mean = -0.1, jump_vol = 0.2;
+    for (double strike : {80.0, 100.0, 120.0}) {
+      for (OptionType type : {OptionType::Call, OptionType::Put}) {
+        auto price = [&](double spot, double expiry, double vol) {
+          return JumpDiffusion::mertonOptionPrice(spot, strike, r, expiry, vol,
+                                                  type, lambda, jump_mean,
+                                                  jump_vol);
+        };
+        InstrumentGreeks g = JumpDiffusion::mertonOptionGreeks(
+            S, strike, r, T, sigma, type, lambda, jump_mean, jump_vol);
+        const double h = 0.1;
+        suite.assert_equal(price(S, T, sigma), g.price, 1e-12, "Price");
+        suite.assert_equal((price(S + h, T, sigma) - price(S - h, T, sigma)) /
+                               (2.0 * h),
+                           g.delta, 1e-5, "Delta");
+        suite.assert_equal((price(S + h, T, sigma) - 2.0 * price(S, T, sigma) +
+                            price(S - h, T, sigma)) / (h * h),
+                           g.gamma, 1e-5, "Gamma");
+        suite.assert_equal((price(S, T, sigma + 1e-5) -
+                            price(S, T, sigma - 1e-5)) / 2e-5,
+                           g.vega, 1e-5, "Vega");
+        suite.assert_equal(-(price(S, T + 1e-5, sigma) -
+                             price(S, T - 1e-5, sigma)) / 2e-5 / 365.0,
+                           g.theta, 1e-7, "Theta");
+      }
+    }
+  });
+
+  suite.run_test("Merton satisfies parity and reduces to Black-Scholes", [&]() {
+    for (double strike : {90.0, 110.0}) {
+      double call = JumpDiffusion::mertonCallPrice(100.0, strike, 0.05, 1.0,
+                                                   0.2, 1.0, -0.1, 0.2);
+      double put = JumpDiffusion::mertonPutPrice(100.0, strike, 0.05, 1.0,
+                                                 0.2, 1.0, -0.1, 0.2);
+      suite.assert_equal(100.0 - strike * std::exp(-0.05), call - put, 1e-10,
+                         "Put-call parity");
+      suite.assert_equal(
+          BlackScholes::callPrice(100.0, strike, 0.05, 1.0, 0.2),
+          JumpDiffusion::mertonCallPrice(100.0, strike, 0.05, 1.0, 0.2, 0.0,
+                                         -0.1, 0.2),
+          1e-12, "No jumps");
+    }
+    // Independent Monte Carlo estimate (4M paths): 13.683 +/- 0.010
+    suite.assert_equal(13.683, JumpDiffusion::mertonCallPrice(
+                                   100.0, 100.0, 0.05, 1.0, 0.2, 1.0, -0.1, 0.2),
+                       0.03, "Reference price");
+  });
+
+  suite.run_test("Merton chain matches per-strike Greeks", [&]() {
+    std::vector<double> strikes = {85.0, 100.0, 115.0};
+    std::vector<OptionType> types = {OptionType::Put, OptionType::Call,
+                                     OptionType::Call};
+    std::vector<InstrumentGreeks> chain = JumpDiffusion::mertonOptionGreeks(
+        100.0, strikes, types, 0.03, 0.5, 0.25, 2.0, -0.05, 0.15);
+    for (size_t k = 0; k < strikes.size(); ++k) {
+      InstrumentGreeks g = JumpDiffusion::mertonOptionGreeks(
+          100.0, strikes[k], 0.03, 0.5, 0.25, types[k], 2.0, -0.05, 0.15);
+      suite.assert_equal(g.price, chain[k].price, 1e-12, "Price");
+      suite.assert_equal(g.delta, chain[k].delta, 1e-12, "Delta");
+      suite.assert_equal(g.theta, chain[k].theta, 1e-12, "Theta");
+    }
+  });
+}
+
+int main() {
+  TestSuite suite;
+
+  std::cout << "\n" << std::string(60, '=') << std::endl;
+  std::cout << "  Pricing Models Test Suite" << std::endl;
+  std::cout << std::string(60, '=') << "\n" << std::endl;
+
+  test_finite_difference_european(suite);
+  test_finite_difference_american(suite);
+  test_american_approximations(suite);
+  test_merton_kernel(suite);
+
+  suite.print_summary();
+
+  return suite.all_passed() ? 0 : 1;
+}
@@ -1,11 +1,15 @@
 #include "Instrument.h"
+#include "Json.h"
 #include "MarketData.h"
 #include "Portfolio.h"
 #include "RiskEngine.h"
+#include "TraceRecorder.h"
 #include "simple_test.h"
 #include <cmath>
 #include <map>
 #include <memory>
+#include <thread>
+#include <vector>
 
 
 // Helper function to create market data
@@ -482,6 +486,700 @@ void test_theta_time_decay(TestSuite &suite) {
   });
 }
 
+void test_american_option_chain(TestSuite &suite) {
+  suite.run_test("American chain batch matches per-option Greeks", [&]() {
+    MarketData md = createMarketData("AAPL", 100.0, 0.05, 0.25);
+
+    std::vector<AmericanOption> chain;
+    for (double strike = 80.0; strike <= 120.0; strike += 5.0) {
+      chain.emplace_back(OptionType::Put, strike, 0.75, "AAPL", 150);
+      chain.emplace_back(OptionType::Call, strike, 0.75, "AAPL", 150);
+    }
+
+    std::vector<const AmericanOption *> options;
+    for (const auto &option : chain) {
+      options.push_back(&option);
+    }
+
+    std::vector<InstrumentGreeks> greeks =
+        AmericanOption::greeksBatch(options, md);
+
+    for (size_t k = 0; k < chain.size(); ++k) {
+      suite.assert_equal(chain[k].price(md), greeks[k].price, 1e-12, "Price");
+      suite.assert_equal(chain[k].delta(md), greeks[k].delta, 1e-12, "Delta");
+      suite.assert_equal(chain[k].gamma(md), greeks[k].gamma, 1e-12, "Gamma");
+      suite.assert_equal(chain[k].vega(md), greeks[k].vega, 1e-12, "Vega");
+      suite.assert_equal(chain[k].theta(md), greeks[k].theta, 1e-12, "Theta");
+    }
+  });
+
+  suite.run_test("Grouped American positions aggregate correctly", [&]() {
+    Portfolio portfolio;
+    std::vector<std::pair<AmericanOption, int>> positions = {
+        {AmericanOption(OptionType::Put, 95.0, 0.5, "AAPL", 100), 3},
+        {AmericanOption(OptionType::Put, 100.0, 0.5, "AAPL", 100), -2},
+        {AmericanOption(OptionType::Call, 105.0, 0.5, "AAPL", 100), 1},
+        {AmericanOption(OptionType::Put, 100.0, 1.0, "AAPL", 100), 1}};
+
+    for (const auto &[option, quantity] : positions) {
+      portfolio.addInstrument(std::make_unique<AmericanOption>(option),
+                              quantity);
+    }
+
+    std::map<std::string, MarketData> market_data_map;
+    market_data_map["AAPL"] = createMarketData("AAPL", 100.0, 0.05, 0.2);
+
+    RiskEngine engine(1000);
+    engine.setRandomSeed(42);
+    PortfolioRiskResult result =
+        engine.calculatePortfolioRisk(portfolio, market_data_map);
+
+    const MarketData &md = market_data_map["AAPL"];
+    double expected_pv = 0.0;
+    double expected_delta = 0.0;
+    double expected_gamma = 0.0;
+    for (const auto &[option, quantity] : positions) {
+      expected_pv += option.price(md) * quantity;
+      expected_delta += option.delta(md) * quantity;
+      expected_gamma += option.gamma(md) * quantity;
+    }
+
+    suite.assert_equal(expected_pv, result.total_pv, 1e-9, "PV");
+    suite.assert_equal(expected_delta, result.total_delta, 1e-9, "Delta");
+    suite.assert_equal(expected_gamma, result.total_gamma, 1e-9, "Gamma");
+
+    if (result.value_at_risk_95 <= 0.0) {
+      throw std::runtime_error("VaR 95% should be positive for net long book");
+    }
+  });
+
+  suite.run_test("Collocation Greeks share boundaries per asset and expiry", [&]() {
+    std::vector<std::pair<AmericanOption, int>> positions;
+    for (double expiry : {0.5, 1.0}) {
+      for (double strike : {90.0, 100.0, 110.0}) {
+        for (OptionType type : {OptionType::Put, OptionType::Call}) {
+          AmericanOption option(type, strike, expiry, "AAPL", 100);
+          option.setPricingModel(PricingModel::AndersenLakeOffengeld);
+          positions.emplace_back(option, type == OptionType::Put ? 4 : -1);
+        }
+      }
+    }
+
+    const MarketData md = createMarketData("AAPL", 100.0, 0.05, 0.25);
+    std::vector<const AmericanOption *> chain;
+    for (const auto &position : positions) {
+      if (position.first.getTimeToExpiry() == 0.5) {
+        chain.push_back(&position.first);
+      }
+    }
+    const std::vector<InstrumentGreeks> greeks =
+        AmericanOption::greeksBatch(chain, md);
+    for (size_t k = 0; k < chain.size(); ++k) {
+      suite.assert_equal(chain[k]->price(md), greeks[k].price, 0.0, "Price");
+      suite.assert_equal(chain[k]->delta(md), greeks[k].delta, 0.0, "Delta");
+      suite.assert_equal(chain[k]->gamma(md), greeks[k].gamma, 0.0, "Gamma");
+      suite.assert_equal(chain[k]->vega(md), greeks[k].vega, 0.0, "Vega");
+      suite.assert_equal(chain[k]->theta(md), greeks[k].theta, 0.0, "Theta");
+    }
+
+    Portfolio portfolio;
+    for (const auto &[option, quantity] : positions) {
+      portfolio.addInstrument(std::make_unique<AmericanOption>(option),
+                              quantity);
+    }
+    std::map<std::string, MarketData> market_data_map;
+    market_data_map["AAPL"] = md;
+    const PortfolioRiskResult result = RiskEngine(500).calculatePortfolioRisk(
+        portfolio, market_data_map);
+
+    InstrumentGreeks expected;
+    for (const auto &[option, quantity] : positions) {
+      const InstrumentGreeks g = option.greeks(md);
+      expected.price += g.price * quantity;
+      expected.delta += g.delta * quantity;
+      expected.gamma += g.gamma * quantity;
+      expected.vega += g.vega * quantity;
+      expected.theta += g.theta * quantity;
+    }
+    suite.assert_equal(expected.price, result.total_pv, 1e-9, "PV");
+    suite.assert_equal(expected.delta, result.total_delta, 1e-9, "Delta");
+    suite.assert_equal(expected.gamma, result.total_gamma, 1e-9, "Gamma");
+    suite.assert_equal(expected.vega, result.total_vega, 1e-9, "Vega");
+    suite.assert_equal(expected.theta, result.total_theta, 1e-9, "Theta");
+  });
+}
+
+void test_finite_difference_positions(TestSuite &suite) {
+  suite.run_test("Finite-difference positions match Black-Scholes risk", [&]() {
+    auto build = [](PricingModel model) {
+      Portfolio portfolio;
+      portfolio.addInstrument(std::make_unique<EuropeanOption>(
+                                  OptionType::Call, 100.0, 1.0, "AAPL", model),
+                              5);
+      portfolio.addInstrument(std::make_unique<EuropeanOption>(
+                                  OptionType::Put, 95.0, 0.5, "AAPL", model),
+                              -3);
+      return portfolio;
+    };
+
+    std::map<std::string, MarketData> market_data_map;
+    market_data_map["AAPL"] = createMarketData("AAPL", 100.0, 0.05, 0.2);
+
+    RiskEngine engine(2000);
+    engine.setRandomSeed(7);
+    PortfolioRiskResult analytic = engine.calculatePortfolioRisk(
+        build(PricingModel::BlackScholes), market_data_map);
+
+    engine.setRandomSeed(7);
+    PortfolioRiskResult grid = engine.calculatePortfolioRisk(
+        build(PricingModel::FiniteDifference), market_data_map);
+
+    suite.assert_equal(analytic.total_pv, grid.total_pv, 0.02, "PV");
+    suite.assert_equal(analytic.total_delta, grid.total_delta, 0.01, "Delta");
+    suite.assert_equal(analytic.total_gamma, grid.total_gamma, 1e-3, "Gamma");
+    suite.assert_equal(analytic.value_at_risk_95, grid.value_at_risk_95, 0.02,
+                       "VaR 95%");
+    suite.assert_equal(analytic.value_at_risk_99, grid.value_at_risk_99, 0.02,
+                       "VaR 99%");
+  });
+}
+
+void test_fast_american_revaluation(TestSuite &suite) {
+  suite.run_test("American VaR tiers agree across pricing models", [&]() {
+    auto build = [](PricingModel model) {
+      Portfolio portfolio;
+      for (double strike : {90.0, 100.0, 110.0}) {
+        auto option = std::make_unique<AmericanOption>(OptionType::Put, strike,
+                                                       0.5, "AAPL", 200);
+        option->setPricingModel(model);
+        portfolio.addInstrument(std::move(option), 10);
+      }
+      return portfolio;
+    };
+
+    std::map<std::string, MarketData> market_data_map;
+    market_data_map["AAPL"] = createMarketData("AAPL", 100.0, 0.05, 0.25);
+
+    RiskEngine engine(2000);
+    engine.setRandomSeed(11);
+    PortfolioRiskResult tree = engine.calculatePortfolioRisk(
+        build(PricingModel::Binomial), market_data_map);
+
+    engine.setRandomSeed(11);
+    PortfolioRiskResult collocation = engine.calculatePortfolioRisk(
+        build(PricingModel::AndersenLakeOffengeld), market_data_map);
+
+    engine.setFastAmericanRevaluation(true);
+    engine.setRandomSeed(11);
+    PortfolioRiskResult fast = engine.calculatePortfolioRisk(
+        build(PricingModel::AndersenLakeOffengeld), market_data_map);
+
+    suite.assert_equal(tree.total_pv, collocation.total_pv, 0.2, "PV");
+    suite.assert_equal(tree.value_at_risk_95, collocation.value_at_risk_95,
+                       0.02 * tree.value_at_risk_95, "Collocation VaR 95%");
+    suite.assert_equal(collocation.total_pv, fast.total_pv, 1e-12,
+                       "Fast tier keeps model PV");
+    suite.assert_equal(collocation.value_at_risk_95, fast.value_at_risk_95,
+                       0.02 * collocation.value_at_risk_95, "BAW VaR 95%");
+  });
+}
+
+void test_jump_diffusion_groups(TestSuite &suite) {
+  suite.run_test("Jump-diffusion chains aggregate per-option Greeks", [&]() {
+    Portfolio portfolio;
+    std::vector<std::pair<EuropeanOption, int>> options;
+    for (double strike : {90.0, 100.0, 110.0}) {
+      EuropeanOption option(OptionType::Call, strike, 0.5, "AAPL",
+                            PricingModel::MertonJumpDiffusion);
+      option.setJumpParameters(2.0, -0.05, 0.15);
+      options.emplace_back(option, strike == 100.0 ? -4 : 3);
+    }
+    EuropeanOption other(OptionType::Put, 100.0, 0.5, "AAPL",
+                         PricingModel::MertonJumpDiffusion);
+    other.setJumpParameters(1.0, -0.1, 0.2);
+    options.emplace_back(other, 2);
+
+    for (const auto &[option, quantity] : options) {
+      portfolio.addInstrument(std::make_unique<EuropeanOption>(option),
+                              quantity);
+    }
+
+    std::map<std::string, MarketData> market_data_map;
+    market_data_map["AAPL"] = createMarketData("AAPL", 100.0, 0.05, 0.2);
+    const MarketData &md = market_data_map["AAPL"];
+
+    RiskEngine engine(1000);
+    PortfolioRiskResult result =
+        engine.calculatePortfolioRisk(portfolio, market_data_map);
+
+    double pv = 0.0, delta = 0.0, gamma = 0.0, vega = 0.0, theta = 0.0;
+    for (const auto &[option, quantity] : options) {
+      pv += option.price(md) * quantity;
+      delta += option.delta(md) * quantity;
+      gamma += option.gamma(md) * quantity;
+      vega += option.vega(md) * quantity;
+      theta += option.theta(md) * quantity;
+    }
+
+    suite.assert_equal(pv, result.total_pv, 1e-9, "PV");
+    suite.assert_equal(delta, result.total_delta, 1e-9, "Delta");
+    suite.assert_equal(gamma, result.total_gamma, 1e-9, "Gamma");
+    suite.assert_equal(vega, result.total_vega, 1e-9, "Vega");
+    suite.assert_equal(theta, result.total_theta, 1e-9, "Theta");
+  });
+}
+
+void test_jump_diffusion_scenarios(TestSuite &suite) {
+  suite.run_test("Jump scenarios leave GBM-only books unchanged", [&]() {
+    Portfolio portfolio;
+    portfolio.addInstrument(
+        std::make_unique<EuropeanOption>(OptionType::Call, 100.0, 1.0, "AAPL"),
+        10);
+
+    std::map<std::string, MarketData> market_data_map;
+    market_data_map["AAPL"] = createMarketData("AAPL", 100.0, 0.05, 0.2);
+
+    RiskEngine engine(1000);
+    engine.setRandomSeed(3);
+    PortfolioRiskResult plain =
+        engine.calculatePortfolioRisk(portfolio, market_data_map);
+
+    engine.setJumpDiffusionScenarios(true);
+    engine.setRandomSeed(3);
+    PortfolioRiskResult jumps =
+        engine.calculatePortfolioRisk(portfolio, market_data_map);
+
+    suite.assert_equal(plain.value_at_risk_99, jumps.value_at_risk_99, 1e-12,
+                       "VaR 99%");
+    suite.assert_equal(plain.expected_shortfall_99,
+                       jumps.expected_shortfall_99, 1e-12, "ES 99%");
+  });
+
+  suite.run_test("Downward jumps fatten the loss tail", [&]() {
+    Portfolio portfolio;
+    auto option = std::make_unique<EuropeanOption>(
+        OptionType::Call, 100.0, 0.5, "AAPL", PricingModel::MertonJumpDiffusion);
+    option->setJumpParameters(25.0, -0.08, 0.05);
+    portfolio.addInstrument(std::move(option), 10);
+
+    std::map<std::string, MarketData> market_data_map;
+    market_data_map["AAPL"] = createMarketData("AAPL", 100.0, 0.05, 0.2);
+
+    RiskEngine engine(5000);
+    engine.setRandomSeed(5);
+    PortfolioRiskResult diffusion =
+        engine.calculatePortfolioRisk(portfolio, market_data_map);
+
+    engine.setJumpDiffusionScenarios(true);
+    engine.setRandomSeed(5);
+    PortfolioRiskResult jumps =
+        engine.calculatePortfolioRisk(portfolio, market_data_map);
+
+    suite.assert_equal(diffusion.total_pv, jumps.total_pv, 1e-12, "PV");
+    if (jumps.expected_shortfall_99 <= 1.2 * diffusion.expected_shortfall_99) {
+      throw std::runtime_error("Jump scenarios should widen the 99% ES");
+    }
+  });
+}
+
+void test_position_netting(TestSuite &suite) {
+  suite.run_test("Netted rows price like one compressed position", [&]() {
+    Portfolio rows;
+    Portfolio compressed;
+    for (int quantity : {4, -1, 3, 2}) {
+      rows.addInstrument(std::make_unique<AmericanOption>(
+                             OptionType::Put, 100.0, 0.5, "AAPL", 200),
+                         quantity);
+      rows.addInstrument(std::make_unique<EuropeanOption>(
+                             OptionType::Call, 105.0, 0.5, "AAPL"),
+                         -quantity);
+    }
+    rows.addInstrument(
+        std::make_unique<EuropeanOption>(OptionType::Call, 95.0, 0.5, "AAPL"),
+        5);
+    rows.addInstrument(
+        std::make_unique<EuropeanOption>(OptionType::Call, 95.0, 0.5, "AAPL"),
+        -5);
+    compressed.addInstrument(std::make_unique<AmericanOption>(
+                                 OptionType::Put, 100.0, 0.5, "AAPL", 200),
+                             8);
+    compressed.addInstrument(
+        std::make_unique<EuropeanOption>(OptionType::Call, 105.0, 0.5, "AAPL"),
+        -8);
+
+    std::map<std::string, MarketData> market_data_map;
+    market_data_map["AAPL"] = createMarketData("AAPL", 100.0, 0.05, 0.25);
+
+    RiskEngine engine(1000);
+    engine.setRandomSeed(9);
+    PortfolioRiskResult netted = engine.calculatePortfolioRisk(rows, market_data_map);
+    engine.setRandomSeed(9);
+    PortfolioRiskResult expected =
+        engine.calculatePortfolioRisk(compressed, market_data_map);
+
+    suite.assert_equal(expected.total_pv, netted.total_pv, 1e-12, "PV");
+    suite.assert_equal(expected.total_delta, netted.total_delta, 1e-12, "Delta");
+    suite.assert_equal(expected.total_theta, netted.total_theta, 1e-12, "Theta");
+    suite.assert_equal(expected.value_at_risk_99, netted.value_at_risk_99, 1e-12,
+                       "VaR 99%");
+  });
+}
+
+void test_shared_engine_with_configs(TestSuite &suite) {
+  suite.run_test("Shared engine runs per-call configs concurrently", [&]() {
+    Portfolio portfolio;
+    portfolio.addInstrument(
+        std::make_unique<EuropeanOption>(OptionType::Call, 100.0, 1.0, "AAPL"), 10);
+    portfolio.addInstrument(
+        std::make_unique<AmericanOption>(OptionType::Put, 100.0, 0.5, "MSFT", 50), -5);
+
+    std::map<std::string, MarketData> market_data_map;
+    market_data_map["AAPL"] = createMarketData("AAPL", 100.0, 0.05, 0.2);
+    market_data_map["MSFT"] = createMarketData("MSFT", 95.0, 0.05, 0.3);
+
+    const RiskConfig base = RiskConfig().withVaRSimulations(2000);
+    const RiskConfig seeded = base.withRandomSeed(7);
+    suite.assert_equal(0, base.getUseFixedSeed(), 0.0, "with* leaves the original unchanged");
+
+    const RiskEngine engine;
+    std::vector<RiskConfig> configs;
+    std::vector<PortfolioRiskResult> expected;
+    for (unsigned seed = 1; seed <= 4; ++seed) {
+      configs.push_back(base.withRandomSeed(seed).withVaRTimeHorizonDays(seed));
+      expected.push_back(
+          engine.calculatePortfolioRisk(portfolio, market_data_map, configs.back()));
+    }
+
+    std::vector<PortfolioRiskResult> results(configs.size());
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < configs.size(); ++i) {
+      threads.emplace_back([&, i]() {
+        results[i] = engine.calculatePortfolioRisk(portfolio, market_data_map, configs[i]);
+      });
+    }
+    for (std::thread &thread : threads) {
+      thread.join();
+    }
+
+    for (size_t i = 0; i < configs.size(); ++i) {
+      suite.assert_equal(expected[i].total_pv, results[i].total_pv, 0.0, "PV");
+      suite.assert_equal(expected[i].value_at_risk_95, results[i].value_at_risk_95, 0.0,
+                         "VaR 95%");
+    }
+    suite.assert_equal(
+        engine.calculatePortfolioRisk(portfolio, market_data_map, seeded).value_at_risk_99,
+        engine.calculatePortfolioRisk(portfolio, market_data_map, seeded).value_at_risk_99,
+        0.0, "Fixed seed is reproducible");
+  });
+}
+
+void test_run_control(TestSuite &suite) {
+  suite.run_test("Run control reports progress and cancels mid-run", [&]() {
+    Portfolio portfolio;
+    portfolio.addInstrument(
+        std::make_unique<EuropeanOption>(OptionType::Call, 100.0, 1.0, "AAPL"), 10);
+
+    std::map<std::string, MarketData> market_data_map;
+    market_data_map["AAPL"] = createMarketData("AAPL", 100.0, 0.05, 0.2);
+
+    const RiskEngine engine;
+    const RiskConfig config = RiskConfig().withVaRSimulations(5000).withRandomSeed(11);
+    RiskRunControl control;
+    const PortfolioRiskResult controlled =
+        engine.calculatePortfolioRisk(portfolio, market_data_map, config, control);
+    const PortfolioRiskResult plain =
+        engine.calculatePortfolioRisk(portfolio, market_data_map, config);
+
+    suite.assert_equal(plain.value_at_risk_95, controlled.value_at_risk_95, 0.0,
+                       "Control does not change the result");
+    suite.assert_equal(1.0, control.getProgress(), 0.0, "Progress complete");
+    suite.assert_equal(1, control.hasGreeks() && control.hasPartialVaR(), 0.0,
+                       "Partial results published");
+    suite.assert_equal(plain.total_delta, control.getPartialResult().total_delta, 0.0,
+                       "Partial greeks");
+
+    RiskRunControl cancelled;
+    bool threw = false;
+    std::thread runner([&]() {
+      try {
+        engine.calculatePortfolioRisk(portfolio, market_data_map,
+                                      config.withVaRSimulations(1000000), cancelled);
+      } catch (const RiskCalculationCancelled &) {
+        threw = true;
+      }
+    });
+    while (cancelled.getCompletedSimulations() == 0) {
+      std::this_thread::yield();
+    }
+    cancelled.cancel();
+    runner.join();
+
+    suite.assert_equal(1, threw, 0.0, "Cancellation thrown");
+    suite.assert_equal(1, cancelled.getCompletedSimulations() < 1000000, 0.0,
+                       "Stopped before the end");
+  });
+}
+
+void test_diagnostics(TestSuite &suite) {
+  suite.run_test("Diagnostics record phases and revaluations without changing results", [&]() {
+    Portfolio portfolio;
+    portfolio.addInstrument(
+        std::make_unique<EuropeanOption>(OptionType::Call, 100.0, 1.0, "AAPL"), 10);
+    portfolio.addInstrument(
+        std::make_unique<AmericanOption>(OptionType::Put, 95.0, 0.5, "AAPL"), 5);
+    portfolio.addInstrument(
+        std::make_unique<AmericanOption>(OptionType::Put, 105.0, 0.5, "AAPL"), -5);
+
+    std::map<std::string, MarketData> market_data_map;
+    market_data_map["AAPL"] = createMarketData("AAPL", 100.0, 0.05, 0.2);
+
+    const RiskEngine engine;
+    const RiskConfig config = RiskConfig().withVaRSimulations(1000).withRandomSeed(3);
+    const PortfolioRiskResult plain = engine.calculatePortfolioRisk(portfolio, market_data_map, config);
+    const PortfolioRiskResult traced =
+        engine.calculatePortfolioRisk(portfolio, market_data_map, config.withDiagnostics(true));
+
+    suite.assert_equal(0, plain.diagnostics.enabled || !plain.diagnostics.phases.empty(), 0.0,
+                       "Off by default");
+    suite.assert_equal(plain.value_at_risk_95, traced.value_at_risk_95, 0.0, "Same VaR");
+    suite.assert_equal(plain.total_pv, traced.total_pv, 0.0, "Same PV");
+
+    const RiskDiagnostics &d = traced.diagnostics;
+    const std::vector<std::string> phases = {"validation", "pricing_plan", "greeks", "scenario_setup",
+                                             "scenario_generation", "revaluation", "tail_metrics"};
+    suite.assert_equal(static_cast<double>(phases.size()), static_cast<double>(d.phases.size()), 0.0,
+                       "Phase count");
+    for (size_t i = 0; i < phases.size() && i < d.phases.size(); ++i) {
+      if (d.phases[i].phase != phases[i] || d.phases[i].wall_seconds < 0.0) {
+        throw std::runtime_error("Unexpected phase " + d.phases[i].phase);
+      }
+    }
+    suite.assert_equal(1001, static_cast<double>(d.revaluations.at("BlackScholes")), 0.0,
+                       "One revaluation per scenario plus the base");
+    suite.assert_equal(2002, static_cast<double>(d.revaluations.at("Binomial")), 0.0,
+                       "Grouped Americans counted per option");
+    suite.assert_equal(3, static_cast<double>(d.slowest_positions.size()), 0.0, "Positions timed");
+    suite.assert_equal(1, d.slowest_positions.front().seconds >= d.slowest_positions.back().seconds, 0.0,
+                       "Slowest first");
+
+    // This executable links the counting hook
+    suite.assert_equal(1, d.allocations_counted, 0.0, "Allocations counted");
+    suite.assert_equal(1, d.allocations > 0 && d.allocated_bytes > 0, 0.0, "Allocations seen");
+    long long allocations = 0;
+    long long bytes = 0;
+    for (const RiskPhaseTiming &timing : d.phases) {
+      allocations += timing.allocations;
+      bytes += timing.allocated_bytes;
+    }
+    suite.assert_equal(static_cast<double>(d.allocations), static_cast<double>(allocations), 0.0,
+                       "Phases sum to the total");
+    suite.assert_equal(static_cast<double>(d.allocated_bytes), static_cast<double>(bytes), 0.0,
+                       "Phase bytes sum to the total");
+    suite.assert_equal(0, plain.diagnostics.allocations_counted, 0.0, "Not counted without diagnostics");
+  });
+}
+
+void test_trace(TestSuite &suite) {
+  suite.run_test("Trace records phases, path blocks and greeks batches", [&]() {
+    Portfolio portfolio;
+    portfolio.addInstrument(
+        std::make_unique<EuropeanOption>(OptionType::Call, 100.0, 1.0, "AAPL"), 10);
+    portfolio.addInstrument(
+        std::make_unique<AmericanOption>(OptionType::Put, 95.0, 0.5, "AAPL"), 5);
+    portfolio.addInstrument(
+        std::make_unique<AmericanOption>(OptionType::Put, 105.0, 0.5, "AAPL"), -5);
+
+    std::map<std::string, MarketData> market_data_map;
+    market_data_map["AAPL"] = createMarketData("AAPL", 100.0, 0.05, 0.2);
+
+    const RiskEngine engine;
+    const RiskConfig config = RiskConfig().withVaRSimulations(1000).withRandomSeed(3);
+    const auto trace = std::make_shared<TraceRecorder>();
+    const PortfolioRiskResult plain = engine.calculatePortfolioRisk(portfolio, market_data_map, config);
+    const PortfolioRiskResult traced =
+        engine.calculatePortfolioRisk(portfolio, market_data_map, config.withTrace(trace));
+    suite.assert_equal(plain.value_at_risk_95, traced.value_at_risk_95, 0.0, "Same VaR");
+
+    std::map<std::string, int> counts;
+    const Json::Value document = Json::parse(trace->toJson());
+    for (const Json::Value &event : document.find("traceEvents")->asArray()) {
+      if (event.find("ph")->asString() == "X") {
+        ++counts[event.find("name")->asString()];
+      }
+    }
+    suite.assert_equal(1, counts["calculatePortfolioRisk"], 0.0, "One run span");
+    suite.assert_equal(4, counts["revaluation"], 0.0, "One span per 256-path block");
+    suite.assert_equal(4, counts["scenario_generation"], 0.0, "Generation per block");
+    suite.assert_equal(1, counts["BlackScholes"], 0.0, "Single position span");
+    suite.assert_equal(1, counts["Binomial"], 0.0, "American group in one span");
+    suite.assert_equal(0, static_cast<double>(trace->getDropped()), 0.0, "Nothing dropped");
+  });
+
+  suite.run_test("Trace ring buffer keeps the newest events", [&]() {
+    TraceRecorder trace(4);
+    const auto now = TraceRecorder::Clock::now();
+    for (int i = 0; i < 10; ++i) {
+      trace.record("event", "test", now, now, "index", i);
+    }
+    suite.assert_equal(4, static_cast<double>(trace.size()), 0.0, "Capacity held");
+    suite.assert_equal(6, static_cast<double>(trace.getDropped()), 0.0, "Oldest overwritten");
+
+    const Json::Value document = Json::parse(trace.toJson());
+    const Json::Value &oldest = document.find("traceEvents")->asArray()[1];
+    suite.assert_equal(6, oldest.find("args")->find("index")->asNumber(), 0.0, "Oldest kept first");
+
+    trace.clear();
+    suite.assert_equal(0, static_cast<double>(trace.size()), 0.0, "Cleared");
+  });
+}
+
+void test_philox_scenarios(TestSuite &suite) {
+  suite.run_test("Philox scenarios replay exactly by path index", [&]() {
+    Portfolio portfolio;
+    portfolio.addInstrument(
+        std::make_unique<EuropeanOption>(OptionType::Call, 100.0, 1.0, "AAPL"), 10);
+    portfolio.addInstrument(
+        std::make_unique<EuropeanOption>(OptionType::Put, 50.0, 0.5, "MSFT"), 20);
+    auto jumpy = std::make_unique<EuropeanOption>(OptionType::Put, 95.0, 0.5, "MSFT",
+                                                  PricingModel::MertonJumpDiffusion);
+    jumpy->setJumpParameters(1.0, -0.1, 0.2);
+    portfolio.addInstrument(std::move(jumpy), 5);
+
+    std::map<std::string, MarketData> market_data_map;
+    market_data_map["AAPL"] = createMarketData("AAPL", 100.0, 0.05, 0.2);
+    market_data_map["MSFT"] = createMarketData("MSFT", 50.0, 0.05, 0.3);
+
+    const RiskEngine engine;
+    const RiskConfig config = RiskConfig()
+                                  .withVaRSimulations(1000)
+                                  .withRandomSeed(11)
+                                  .withJumpDiffusionScenarios(true)
+                                  .withRandomGenerator(RandomGenerator::Philox);
+    const PortfolioRiskResult result = engine.calculatePortfolioRisk(portfolio, market_data_map, config);
+    const PortfolioRiskResult mersenne = engine.calculatePortfolioRisk(
+        portfolio, market_data_map, config.withRandomGenerator(RandomGenerator::MersenneTwister));
+    suite.assert_equal(mersenne.value_at_risk_95, result.value_at_risk_95,
+                       0.25 * mersenne.value_at_risk_95, "Same distribution as Mersenne Twister");
+
+    // VaR99 of 1000 paths is the 11th worst loss
+    const std::vector<RiskScenario> worst = engine.worstScenarios(portfolio, market_data_map, config, 11);
+    suite.assert_equal(11, static_cast<double>(worst.size()), 0.0, "Worst count");
+    suite.assert_equal(-result.value_at_risk_99, worst[10].pnl, 0.0, "Replayed tail matches the run");
+    suite.assert_equal(1, worst[0].pnl <= worst[10].pnl, 0.0, "Worst first");
+    suite.assert_equal(2, static_cast<double>(worst[0].spots.size()), 0.0, "Spot per asset");
+
+    const std::vector<RiskScenario> alone =
+        engine.replayScenarios(portfolio, market_data_map, config, {worst[3].path, 0});
+    suite.assert_equal(worst[3].pnl, alone[0].pnl, 0.0, "Independent of other paths");
+    suite.assert_equal(worst[3].spots[1].second, alone[0].spots[1].second, 0.0, "Same spots");
+
+    bool rejected = false;
+    try {
+      engine.replayScenarios(portfolio, market_data_map, config.withoutFixedSeed(), {0});
+    } catch (const std::invalid_argument &) {
+      rejected = true;
+    }
+    suite.assert_equal(1, rejected, 0.0, "Unseeded runs cannot be replayed");
+  });
+}
+
+void test_var_shards(TestSuite &suite) {
+  suite.run_test("Merged VaR shards reproduce the single run exactly", [&]() {
+    Portfolio portfolio;
+    portfolio.addInstrument(
+        std::make_unique<EuropeanOption>(OptionType::Call, 100.0, 1.0, "AAPL"), 10);
+    portfolio.addInstrument(
+        std::make_unique<EuropeanOption>(OptionType::Put, 50.0, 0.5, "MSFT"), 20);
+
+    std::map<std::string, MarketData> market_data_map;
+    market_data_map["AAPL"] = createMarketData("AAPL", 100.0, 0.05, 0.2);
+    market_data_map["MSFT"] = createMarketData("MSFT", 50.0, 0.05, 0.3);
+
+    const RiskEngine engine;
+    const RiskConfig config = RiskConfig()
+                                  .withVaRSimulations(1000)
+                                  .withRandomSeed(5)
+                                  .withRandomGenerator(RandomGenerator::Philox);
+    const PortfolioRiskResult result = engine.calculatePortfolioRisk(portfolio, market_data_map, config);
+
+    // Shards need not align with the engine's path blocks
+    const VaRShard head = engine.calculateVaRShard(portfolio, market_data_map, config, 1000, 0, 300);
+    const VaRShard tail = engine.calculateVaRShard(portfolio, market_data_map, config, 1000, 300, 1000);
+    suite.assert_equal(0, head.isComplete(), 0.0, "A shard alone is partial");
+
+    const VaRShard merged = VaRShard::merge({VaRShard::deserialize(tail.serialize()), head});
+    suite.assert_equal(1, merged.isComplete(), 0.0, "Merged shards cover the run");
+    const RiskMetrics metrics = merged.metrics();
+    suite.assert_equal(result.value_at_risk_95, metrics.var_95, 0.0, "VaR95 matches");
+    suite.assert_equal(result.value_at_risk_99, metrics.var_99, 0.0, "VaR99 matches");
+    suite.assert_equal(result.expected_shortfall_95, metrics.es_95, 1e-9, "ES95 matches");
+    suite.assert_equal(result.expected_shortfall_99, metrics.es_99, 1e-9, "ES99 matches");
+    suite.assert_equal(static_cast<double>(VaRShard::tailSize(1000)),
+                       static_cast<double>(merged.tail.size()), 0.0, "Tail stays bounded");
+
+    const VaRShard copy = VaRShard::deserialize(head.serialize());
+    suite.assert_equal(head.sum, copy.sum, 0.0, "Round-trip keeps the moments");
+    suite.assert_equal(head.tail.back(), copy.tail.back(), 0.0, "Round-trip keeps the tail");
+
+    bool gap_rejected = false;
+    try {
+      VaRShard::merge({head, engine.calculateVaRShard(portfolio, market_data_map, config, 1000, 400, 1000)});
+    } catch (const std::invalid_argument &) {
+      gap_rejected = true;
+    }
+    suite.assert_equal(1, gap_rejected, 0.0, "Gaps are rejected");
+
+    bool unseeded_rejected = false;
+    try {
+      engine.calculateVaRShard(portfolio, market_data_map, config.withoutFixedSeed(), 1000, 0, 300);
+    } catch (const std::invalid_argument &) {
+      unseeded_rejected = true;
+    }
+    suite.assert_equal(1, unseeded_rejected, 0.0, "Unseeded shards are rejected");
+
+    // Only shards name totals beyond what a single run may hold
+    bool large_run_rejected = false;
+    try {
+      config.withVaRSimulations(2000000);
+    } catch (const std::invalid_argument &) {
+      large_run_rejected = true;
+    }
+    suite.assert_equal(1, large_run_rejected, 0.0, "Single runs stay within 1,000,000 paths");
+    const VaRShard large = engine.calculateVaRShard(portfolio, market_data_map, config, 50000000, 0, 300);
+    suite.assert_equal(50000000.0, static_cast<double>(large.total_paths), 0.0, "Shard total");
+    suite.assert_equal(head.sum, large.sum, 0.0, "Paths do not depend on the total");
+  });
+
+  suite.run_test("Shards of a zero-value book match the single run", [&]() {
+    // Identical legs on two assets cancel exactly today but not under
+    // independent scenario shocks
+    Portfolio portfolio;
+    portfolio.addInstrument(
+        std::make_unique<EuropeanOption>(OptionType::Call, 100.0, 1.0, "AAPL"), 10);
+    portfolio.addInstrument(
+        std::make_unique<EuropeanOption>(OptionType::Call, 100.0, 1.0, "MSFT"), -10);
+
+    std::map<std::string, MarketData> market_data_map;
+    market_data_map["AAPL"] = createMarketData("AAPL", 100.0, 0.05, 0.2);
+    market_data_map["MSFT"] = createMarketData("MSFT", 100.0, 0.05, 0.2);
+
+    const RiskEngine engine;
+    const RiskConfig config = RiskConfig()
+                                  .withVaRSimulations(1000)
+                                  .withRandomSeed(5)
+                                  .withRandomGenerator(RandomGenerator::Philox);
+    const PortfolioRiskResult result = engine.calculatePortfolioRisk(portfolio, market_data_map, config);
+
+    const RiskMetrics metrics = VaRShard::merge({
+        engine.calculateVaRShard(portfolio, market_data_map, config, 1000, 0, 300),
+        engine.calculateVaRShard(portfolio, market_data_map, config, 1000, 300, 1000)}).metrics();
+    suite.assert_equal(result.value_at_risk_95, metrics.var_95, 0.0, "VaR95 matches");
+    suite.assert_equal(result.value_at_risk_99, metrics.var_99, 0.0, "VaR99 matches");
+    suite.assert_equal(result.expected_shortfall_95, metrics.es_95, 0.0, "ES95 matches");
+    suite.assert_equal(result.expected_shortfall_99, metrics.es_99, 0.0, "ES99 matches");
+  });
+}
+
 int main() {
   TestSuite suite;
 
@@ -502,6 +1200,18 @@ int main() {
   test_expected_shortfall_properties(suite);
   test_expected_shortfall_scaling(suite);
   test_theta_time_decay(suite);
+  test_american_option_chain(suite);
+  test_finite_difference_positions(suite);
+  test_fast_american_revaluation(suite);
+  test_jump_diffusion_groups(suite);
+  test_jump_diffusion_scenarios(suite);
+  test_position_netting(suite);
+  test_shared_engine_with_configs(suite);
+  test_run_control(suite);
+  test_diagnostics(suite);
+  test_trace(suite);
+  test_philox_scenarios(suite);
+  test_var_shards(suite);
 
   suite.print_summary();
 
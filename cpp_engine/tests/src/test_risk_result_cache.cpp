@@ -0,0 +1,245 @@
+#include "Instrument.h"
+#include "Portfolio.h"
+#include "RiskEngine.h"
+#include "RiskResultCache.h"
+#include "simple_test.h"
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+MarketData createMarketData(const std::string &asset_id, double spot,
+                            double rate, double vol) {
+  MarketData md;
+  md.asset_id = asset_id;
+  md.spot_price = spot;
+  md.risk_free_rate = rate;
+  md.volatility = vol;
+  return md;
+}
+
+void buildBook(Portfolio &portfolio, int call_quantity) {
+  portfolio.addInstrument(
+      std::make_unique<EuropeanOption>(OptionType::Call, 100.0, 0.5, "AAPL"),
+      call_quantity);
+  portfolio.addInstrument(
+      std::make_unique<AmericanOption>(OptionType::Put, 95.0, 1.0, "MSFT", 50), -5);
+}
+
+void test_content_hashes(TestSuite &suite) {
+  suite.run_test("Content hashes depend only on values", [&]() {
+    Portfolio a, b, c;
+    buildBook(a, 10);
+    buildBook(b, 10);
+    buildBook(c, 11);
+    suite.assert_equal(1, ContentHash::hashPortfolio(a) == ContentHash::hashPortfolio(b),
+                       0.0, "Equal books hash equally");
+    suite.assert_equal(0, ContentHash::hashPortfolio(a) == ContentHash::hashPortfolio(c),
+                       0.0, "Quantity changes the hash");
+    // FNV-1a of an eight-byte zero row count: fixed across runs and builds
+    suite.assert_equal(1, ContentHash::hashPortfolio(Portfolio()) == 0xa8c7f832281a39c5ULL,
+                       0.0, "Empty portfolio digest");
+
+    std::map<std::string, MarketData> md;
+    md["AAPL"] = createMarketData("AAPL", 100.0, 0.05, 0.2);
+    md["MSFT"] = createMarketData("MSFT", 95.0, 0.05, 0.3);
+    std::map<std::string, MarketData> moved = md;
+    moved["MSFT"].spot_price = 95.01;
+    suite.assert_equal(0, ContentHash::hashMarketData(md) == ContentHash::hashMarketData(moved),
+                       0.0, "Spot changes the hash");
+
+    const RiskConfig seeded = RiskConfig().withRandomSeed(1);
+    suite.assert_equal(0, ContentHash::hashConfig(seeded) ==
+                              ContentHash::hashConfig(seeded.withRandomSeed(2)),
+                       0.0, "Seed changes the hash");
+    if (RiskCacheKey::of(a, md, seeded).toString().size() != 48) {
+      throw std::runtime_error("Key string should be 48 hex digits");
+    }
+  });
+}
+
+void test_cache_hits(TestSuite &suite) {
+  suite.run_test("Fixed-seed results are served from the cache", [&]() {
+    Portfolio portfolio;
+    buildBook(portfolio, 10);
+    std::map<std::string, MarketData> md;
+    md["AAPL"] = createMarketData("AAPL", 100.0, 0.05, 0.2);
+    md["MSFT"] = createMarketData("MSFT", 95.0, 0.05, 0.3);
+
+    const RiskEngine engine;
+    RiskResultCache cache;
+    const RiskConfig config = RiskConfig().withVaRSimulations(2000).withRandomSeed(3);
+
+    RiskResultCache::Source source = RiskResultCache::Source::Cached;
+    const PortfolioRiskResult first = cache.calculate(engine, portfolio, md, config, &source);
+    suite.assert_equal(1, source == RiskResultCache::Source::Computed, 0.0, "First call misses");
+    Portfolio rebuilt;
+    buildBook(rebuilt, 10);
+    const PortfolioRiskResult second = cache.calculate(engine, rebuilt, md, config, &source);
+    suite.assert_equal(1, source == RiskResultCache::Source::Cached, 0.0, "Identical inputs hit");
+    suite.assert_equal(first.value_at_risk_99, second.value_at_risk_99, 0.0, "Cached VaR");
+    suite.assert_equal(first.total_pv, second.total_pv, 0.0, "Cached PV");
+
+    cache.calculate(engine, portfolio, md, config.withoutFixedSeed(), &source);
+    suite.assert_equal(1, source == RiskResultCache::Source::Computed, 0.0,
+                       "Unseeded run bypasses the cache");
+    suite.assert_equal(1, cache.getHits(), 0.0, "Hits");
+    suite.assert_equal(1, cache.getMisses(), 0.0, "Misses");
+    suite.assert_equal(1, cache.size(), 0.0, "Entries");
+  });
+}
+
+void test_canonical_keys(TestSuite &suite) {
+  suite.run_test("Reordered and split books share a cache entry", [&]() {
+    Portfolio portfolio;
+    buildBook(portfolio, 10);
+    // Same net contracts: rows reversed, the call split in two and a
+    // contract that cancels out
+    Portfolio permuted;
+    permuted.addInstrument(
+        std::make_unique<AmericanOption>(OptionType::Put, 95.0, 1.0, "MSFT", 50), -5);
+    permuted.addInstrument(
+        std::make_unique<EuropeanOption>(OptionType::Call, 110.0, 0.5, "AAPL"), 3);
+    permuted.addInstrument(
+        std::make_unique<EuropeanOption>(OptionType::Call, 100.0, 0.5, "AAPL"), 4);
+    permuted.addInstrument(
+        std::make_unique<EuropeanOption>(OptionType::Call, 110.0, 0.5, "AAPL"), -3);
+    permuted.addInstrument(
+        std::make_unique<EuropeanOption>(OptionType::Call, 100.0, 0.5, "AAPL"), 6);
+    suite.assert_equal(1, ContentHash::hashPortfolio(portfolio) ==
+                              ContentHash::hashPortfolio(permuted),
+                       0.0, "Permuted book hashes equally");
+
+    std::map<std::string, MarketData> md;
+    md["AAPL"] = createMarketData("AAPL", 100.0, 0.05, 0.2);
+    md["MSFT"] = createMarketData("MSFT", 95.0, 0.05, 0.3);
+
+    const RiskEngine engine;
+    RiskResultCache cache;
+    const RiskConfig config = RiskConfig().withVaRSimulations(2000).withRandomSeed(3);
+
+    RiskResultCache::Source source = RiskResultCache::Source::Computed;
+    const PortfolioRiskResult first = cache.calculate(engine, portfolio, md, config, &source);
+    const PortfolioRiskResult cached = cache.calculate(engine, permuted, md, config, &source);
+    suite.assert_equal(1, source == RiskResultCache::Source::Cached, 0.0, "Permuted book hits");
+    suite.assert_equal(first.value_at_risk_99, cached.value_at_risk_99, 0.0, "Cached VaR");
+
+    // The engine agrees, so the shared entry is what a fresh run would give
+    const PortfolioRiskResult fresh = engine.calculatePortfolioRisk(permuted, md, config);
+    suite.assert_equal(fresh.value_at_risk_99, cached.value_at_risk_99, 1e-9, "Fresh VaR");
+    suite.assert_equal(fresh.total_pv, cached.total_pv, 1e-9, "Fresh PV");
+  });
+}
+
+void test_lru_eviction(TestSuite &suite) {
+  suite.run_test("Least recently used entries leave past the budget", [&]() {
+    RiskResultCache cache(2 * RiskResultCache::kEntryBytes);
+    PortfolioRiskResult result;
+    RiskCacheKey keys[3];
+    for (int i = 0; i < 3; ++i) {
+      keys[i].portfolio = i + 1;
+    }
+
+    result.total_pv = 1.0;
+    cache.insert(keys[0], result);
+    result.total_pv = 2.0;
+    cache.insert(keys[1], result);
+    cache.lookup(keys[0], result);
+    result.total_pv = 3.0;
+    cache.insert(keys[2], result);
+
+    suite.assert_equal(2, cache.size(), 0.0, "Budget holds two entries");
+    suite.assert_equal(1, cache.getEvictions(), 0.0, "One eviction");
+    suite.assert_equal(0, cache.lookup(keys[1], result), 0.0, "Oldest untouched entry evicted");
+    suite.assert_equal(1, cache.lookup(keys[0], result), 0.0, "Recently read entry kept");
+    suite.assert_equal(1.0, result.total_pv, 0.0, "Kept value");
+    suite.assert_equal(2 * RiskResultCache::kEntryBytes, cache.getBytes(), 0.0, "Bytes");
+  });
+}
+
+void test_single_flight(TestSuite &suite) {
+  suite.run_test("Identical concurrent calls share one run", [&]() {
+    Portfolio portfolio;
+    portfolio.addInstrument(
+        std::make_unique<EuropeanOption>(OptionType::Call, 100.0, 0.5, "AAPL"), 10);
+    std::map<std::string, MarketData> md;
+    md["AAPL"] = createMarketData("AAPL", 100.0, 0.05, 0.2);
+
+    const RiskEngine engine;
+    RiskResultCache cache;
+    // Unseeded, so separate runs would disagree and nothing is cached
+    const RiskConfig config = RiskConfig().withVaRSimulations(1000000);
+
+    std::vector<PortfolioRiskResult> results(4);
+    std::vector<RiskResultCache::Source> sources(4);
+    std::vector<std::thread> threads;
+    threads.emplace_back([&]() {
+      results[0] = cache.calculate(engine, portfolio, md, config, &sources[0]);
+    });
+    while (cache.getInFlight() == 0) {
+      std::this_thread::yield();
+    }
+    for (size_t i = 1; i < results.size(); ++i) {
+      threads.emplace_back([&, i]() {
+        results[i] = cache.calculate(engine, portfolio, md, config, &sources[i]);
+      });
+    }
+    for (std::thread &thread : threads) {
+      thread.join();
+    }
+
+    suite.assert_equal(1, sources[0] == RiskResultCache::Source::Computed, 0.0, "Leader ran");
+    suite.assert_equal(3, cache.getCoalesced(), 0.0, "Followers coalesced");
+    suite.assert_equal(0, cache.getInFlight(), 0.0, "Flight retired");
+    suite.assert_equal(0, cache.size(), 0.0, "Unseeded result not cached");
+    for (size_t i = 1; i < results.size(); ++i) {
+      suite.assert_equal(1, sources[i] == RiskResultCache::Source::Coalesced, 0.0, "Follower");
+      suite.assert_equal(results[0].value_at_risk_99, results[i].value_at_risk_99, 0.0,
+                         "Shared VaR");
+    }
+  });
+
+  suite.run_test("Seeded callers racing a finishing run compute once", [&]() {
+    Portfolio portfolio;
+    portfolio.addInstrument(
+        std::make_unique<EuropeanOption>(OptionType::Call, 100.0, 0.5, "AAPL"), 10);
+    std::map<std::string, MarketData> md;
+    md["AAPL"] = createMarketData("AAPL", 100.0, 0.05, 0.2);
+
+    const RiskEngine engine;
+    // Short runs, so callers keep arriving as the first one finishes
+    const RiskConfig config = RiskConfig().withVaRSimulations(2000).withRandomSeed(9);
+    for (int round = 0; round < 20; ++round) {
+      RiskResultCache cache;
+      std::vector<std::thread> threads;
+      for (int i = 0; i < 8; ++i) {
+        threads.emplace_back([&]() { cache.calculate(engine, portfolio, md, config); });
+      }
+      for (std::thread &thread : threads) {
+        thread.join();
+      }
+      suite.assert_equal(1, cache.getMisses(), 0.0, "One run started");
+      suite.assert_equal(7, cache.getHits() + cache.getCoalesced(), 0.0,
+                         "Every other caller hit or joined");
+    }
+  });
+}
+
+int main() {
+  TestSuite suite;
+
+  std::cout << "\n" << std::string(60, '=') << std::endl;
+  std::cout << "  Risk Result Cache Test Suite" << std::endl;
+  std::cout << std::string(60, '=') << "\n" << std::endl;
+
+  test_content_hashes(suite);
+  test_cache_hits(suite);
+  test_canonical_keys(suite);
+  test_lru_eviction(suite);
+  test_single_flight(suite);
+
+  suite.print_summary();
+
+  return suite.all_passed() ? 0 : 1;
+}
@@ -0,0 +1,329 @@
+#include "Instrument.h"
+#include "MarketData.h"
+#include "Portfolio.h"
+#include "RiskEngine.h"
+#include "RiskSession.h"
+#include "simple_test.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <map>
+#include <memory>
+#include <thread>
+
+MarketData createMarketData(const std::string &asset_id, double spot,
+                            double rate, double vol) {
+  MarketData md;
+  md.asset_id = asset_id;
+  md.spot_price = spot;
+  md.risk_free_rate = rate;
+  md.volatility = vol;
+  return md;
+}
+
+void buildBook(Portfolio &portfolio, MarketDataManager &market_data) {
+  const std::vector<std::string> assets = {"AAPL", "MSFT", "GOOG"};
+  for (size_t a = 0; a < assets.size(); ++a) {
+    market_data.addMarketData(
+        assets[a], createMarketData(assets[a], 100.0 + 10.0 * a, 0.05, 0.25));
+    portfolio.addInstrument(std::make_unique<EuropeanOption>(
+                                OptionType::Call, 100.0, 0.5, assets[a]),
+                            10);
+    portfolio.addInstrument(std::make_unique<EuropeanOption>(
+                                OptionType::Put, 95.0, 1.0, assets[a]),
+                            -5);
+    portfolio.addInstrument(std::make_unique<AmericanOption>(
+                                OptionType::Put, 105.0, 0.5, assets[a], 100),
+                            3);
+  }
+}
+
+PortfolioRiskResult fullRecompute(const Portfolio &portfolio,
+                                  const MarketDataManager &market_data) {
+  RiskEngine engine(100);
+  return engine.calculatePortfolioRisk(portfolio,
+                                       market_data.getAllMarketData());
+}
+
+void assertSameGreeks(TestSuite &suite, const PortfolioRiskResult &expected,
+                      const PortfolioRiskResult &actual) {
+  suite.assert_equal(expected.total_pv, actual.total_pv, 1e-9, "PV");
+  suite.assert_equal(expected.total_delta, actual.total_delta, 1e-9, "Delta");
+  suite.assert_equal(expected.total_gamma, actual.total_gamma, 1e-9, "Gamma");
+  suite.assert_equal(expected.total_vega, actual.total_vega, 1e-9, "Vega");
+  suite.assert_equal(expected.total_theta, actual.total_theta, 1e-9, "Theta");
+}
+
+void test_initial_refresh(TestSuite &suite) {
+  suite.run_test("First refresh matches RiskEngine Greeks", [&]() {
+    Portfolio portfolio;
+    MarketDataManager market_data;
+    buildBook(portfolio, market_data);
+
+    RiskSession session(portfolio, market_data);
+    const PortfolioRiskResult result = session.refresh();
+
+    assertSameGreeks(suite, fullRecompute(portfolio, market_data), result);
+    suite.assert_equal(9, session.getLastRepricedPositions(), 0.0,
+                     "All positions priced on first refresh");
+  });
+}
+
+void test_single_ticker_update(TestSuite &suite) {
+  suite.run_test("One ticker update reprices only its positions", [&]() {
+    Portfolio portfolio;
+    MarketDataManager market_data;
+    buildBook(portfolio, market_data);
+
+    RiskSession session(portfolio, market_data);
+    session.refresh();
+    const PortfolioRiskResult msft_before = session.getAssetSubtotal("MSFT");
+
+    market_data.updateMarketData("AAPL",
+                                 createMarketData("AAPL", 97.5, 0.05, 0.30));
+    const PortfolioRiskResult result = session.refresh();
+
+    suite.assert_equal(3, session.getLastRepricedPositions(), 0.0,
+                     "Only AAPL positions repriced");
+    assertSameGreeks(suite, fullRecompute(portfolio, market_data), result);
+    suite.assert_equal(msft_before.total_pv,
+                       session.getAssetSubtotal("MSFT").total_pv, 0.0,
+                       "MSFT subtotal untouched");
+
+    session.refresh();
+    suite.assert_equal(0, session.getLastRepricedPositions(), 0.0,
+                     "No reprice without a market change");
+  });
+}
+
+void test_many_ticks(TestSuite &suite) {
+  suite.run_test("Totals stay exact across many ticks", [&]() {
+    Portfolio portfolio;
+    MarketDataManager market_data;
+    buildBook(portfolio, market_data);
+
+    RiskSession session(portfolio, market_data);
+    session.refresh();
+    const std::vector<std::string> assets = {"AAPL", "MSFT", "GOOG"};
+    for (int tick = 1; tick <= 300; ++tick) {
+      const size_t a = tick % assets.size();
+      market_data.updateMarketData(
+          assets[a], createMarketData(assets[a], 100.0 + 10.0 * a + (tick % 7 - 3) * 1.5,
+                                      0.05, 0.25 + 0.01 * (tick % 5)));
+      session.refresh();
+    }
+
+    const PortfolioRiskResult result = session.getResult();
+    const PortfolioRiskResult expected = fullRecompute(portfolio, market_data);
+    suite.assert_equal(expected.total_pv, result.total_pv, 1e-12 * std::abs(expected.total_pv),
+                       "PV after many ticks");
+    suite.assert_equal(expected.total_gamma, result.total_gamma,
+                       1e-12 * std::abs(expected.total_gamma), "Gamma after many ticks");
+  });
+}
+
+void test_portfolio_edits(TestSuite &suite) {
+  suite.run_test("Portfolio edits recompute only the touched rows", [&]() {
+    Portfolio portfolio;
+    MarketDataManager market_data;
+    buildBook(portfolio, market_data);
+
+    RiskSession session(portfolio, market_data);
+    session.refresh();
+
+    // A PATCH: one quantity update, one removal and two additions
+    market_data.addMarketData("NVDA",
+                              createMarketData("NVDA", 95.0, 0.05, 0.4));
+    session.refresh();
+    portfolio.updateQuantity(0, 20);
+    portfolio.removePosition(portfolio.getHandle(4));
+    portfolio.addInstrument(std::make_unique<EuropeanOption>(
+                                OptionType::Call, 110.0, 0.75, "MSFT"),
+                            7);
+    portfolio.addInstrument(std::make_unique<EuropeanOption>(
+                                OptionType::Put, 90.0, 0.25, "NVDA"),
+                            4);
+    PortfolioRiskResult result = session.refresh();
+
+    suite.assert_equal(4, session.getLastRepricedPositions(), 0.0,
+                       "Only the touched rows recomputed");
+    assertSameGreeks(suite, fullRecompute(portfolio, market_data), result);
+
+    portfolio.updateQuantity(portfolio.getIndex(portfolio.getHandle(1)), -3);
+    result = session.refresh();
+    suite.assert_equal(1, session.getLastRepricedPositions(), 0.0,
+                       "Quantity update rescales one row");
+    assertSameGreeks(suite, fullRecompute(portfolio, market_data), result);
+
+    // Re-posting identical market data is not a change
+    const uint64_t version = market_data.getVersion();
+    market_data.updateMarketData("AAPL", market_data.getMarketData("AAPL"));
+    suite.assert_equal(static_cast<double>(version),
+                       static_cast<double>(market_data.getVersion()), 0.0,
+                       "Identical update keeps the version");
+    session.refresh();
+    suite.assert_equal(0, session.getLastRepricedPositions(), 0.0,
+                       "Nothing repriced");
+
+    // A book replaced wholesale is evaluated in full
+    portfolio.clear();
+    market_data.clear();
+    buildBook(portfolio, market_data);
+    result = session.refresh();
+    suite.assert_equal(9, session.getLastRepricedPositions(), 0.0,
+                       "Replaced book priced in full");
+    assertSameGreeks(suite, fullRecompute(portfolio, market_data), result);
+  });
+}
+
+void test_pinned_snapshot(TestSuite &suite) {
+  suite.run_test("Pinned snapshot is unaffected by later ticks", [&]() {
+    MarketDataManager market_data;
+    market_data.addMarketData("AAPL", createMarketData("AAPL", 100.0, 0.05, 0.25));
+    market_data.addMarketData("MSFT", createMarketData("MSFT", 300.0, 0.05, 0.25));
+
+    const auto pinned = market_data.snapshot();
+    market_data.updateMarketData("AAPL",
+                                 createMarketData("AAPL", 101.0, 0.05, 0.25));
+    market_data.removeMarketData("MSFT");
+
+    suite.assert_equal(100.0, pinned->getMarketData("AAPL").spot_price, 0.0,
+                       "Pinned AAPL spot");
+    suite.assert_equal(2, pinned->size(), 0.0, "Pinned size");
+    suite.assert_equal(101.0, market_data.getMarketData("AAPL").spot_price, 0.0,
+                       "Current AAPL spot");
+    suite.assert_equal(1, market_data.size(), 0.0, "Current size");
+    suite.assert_equal(2, market_data.getChangedAssets(pinned->getVersion()).size(),
+                       0.0, "Assets changed since pin");
+  });
+}
+
+void test_concurrent_ticks(TestSuite &suite) {
+  suite.run_test("Refresh sees a coherent market while ticks arrive", [&]() {
+    Portfolio portfolio;
+    MarketDataManager market_data;
+    buildBook(portfolio, market_data);
+    const uint64_t base_version = market_data.getVersion();
+
+    // Every tick moves all three spots up by one cent, one asset at a time
+    std::atomic<bool> done(false);
+    std::thread feed([&]() {
+      const std::vector<std::string> assets = {"AAPL", "MSFT", "GOOG"};
+      for (int tick = 1; tick <= 2000; ++tick) {
+        for (size_t a = 0; a < assets.size(); ++a) {
+          market_data.updateMarketData(
+              assets[a], createMarketData(assets[a], 100.0 + 10.0 * a + 0.01 * tick,
+                                          0.05, 0.25));
+        }
+      }
+      done = true;
+    });
+
+    RiskSession session(portfolio, market_data);
+    double worst_mismatch = 0.0;
+    std::string error;
+    while (!done && error.empty()) {
+      const auto snapshot = market_data.snapshot();
+      const uint64_t writes = snapshot->getVersion() - base_version;
+      const double complete_ticks = static_cast<double>(writes / 3);
+      worst_mismatch = std::max(
+          worst_mismatch,
+          std::abs(120.0 + 0.01 * complete_ticks -
+                   snapshot->getMarketData("GOOG").spot_price));
+      try {
+        session.refresh();
+      } catch (const std::exception &e) {
+        error = e.what();
+      }
+    }
+    feed.join();
+
+    if (!error.empty()) {
+      throw std::runtime_error(error);
+    }
+    suite.assert_equal(0.0, worst_mismatch, 1e-9,
+                       "GOOG spot matches snapshot version");
+
+    session.refresh();
+    assertSameGreeks(suite, fullRecompute(portfolio, market_data),
+                     session.getResult());
+  });
+}
+
+void test_tombstones_and_copies(TestSuite &suite) {
+  suite.run_test("Tombstones outlive only the snapshots that need them", [&]() {
+    MarketDataManager market_data;
+    market_data.addMarketData("AAPL", createMarketData("AAPL", 100.0, 0.05, 0.25));
+    market_data.addMarketData("MSFT", createMarketData("MSFT", 300.0, 0.05, 0.25));
+
+    auto pinned = market_data.snapshot();
+    const uint64_t pinned_version = pinned->getVersion();
+    market_data.removeMarketData("MSFT");
+    market_data.updateMarketData("AAPL",
+                                 createMarketData("AAPL", 101.0, 0.05, 0.25));
+    suite.assert_equal(2, market_data.getChangedAssets(pinned_version).size(),
+                       0.0, "Removal kept while the pin is held");
+
+    pinned.reset();
+    market_data.updateMarketData("AAPL",
+                                 createMarketData("AAPL", 102.0, 0.05, 0.25));
+    suite.assert_equal(1, market_data.getChangedAssets(pinned_version).size(),
+                       0.0, "Removal dropped once the pin is released");
+    suite.assert_equal(0, market_data.getAssetVersion("MSFT"), 0.0,
+                       "Tombstone purged");
+  });
+
+  suite.run_test("Copies share the snapshot and then diverge", [&]() {
+    MarketDataManager market_data;
+    market_data.addMarketData("AAPL", createMarketData("AAPL", 100.0, 0.05, 0.25));
+
+    MarketDataManager copy(market_data);
+    copy.updateMarketData("AAPL", createMarketData("AAPL", 90.0, 0.05, 0.25));
+    suite.assert_equal(100.0, market_data.getMarketData("AAPL").spot_price, 0.0,
+                       "Source unchanged");
+    suite.assert_equal(90.0, copy.getMarketData("AAPL").spot_price, 0.0,
+                       "Copy updated");
+
+    market_data = copy;
+    suite.assert_equal(90.0, market_data.getMarketData("AAPL").spot_price, 0.0,
+                       "Assigned");
+    suite.assert_equal(static_cast<double>(copy.getVersion()),
+                       static_cast<double>(market_data.getVersion()), 0.0,
+                       "Version carried over");
+  });
+
+  suite.run_test("clear() removes every asset with its own version", [&]() {
+    Portfolio portfolio;
+    MarketDataManager market_data;
+    buildBook(portfolio, market_data);
+    const uint64_t version = market_data.getVersion();
+    market_data.clear();
+
+    suite.assert_equal(0, market_data.size(), 0.0, "Empty");
+    suite.assert_equal(static_cast<double>(version + 3),
+                       static_cast<double>(market_data.getVersion()), 0.0,
+                       "One version per asset");
+    suite.assert_equal(3, market_data.getChangedAssets(version).size(), 0.0,
+                       "Every asset reported");
+  });
+}
+
+int main() {
+  TestSuite suite;
+
+  std::cout << "\n" << std::string(60, '=') << std::endl;
+  std::cout << "  RiskSession Test Suite" << std::endl;
+  std::cout << std::string(60, '=') << "\n" << std::endl;
+
+  test_initial_refresh(suite);
+  test_single_ticker_update(suite);
+  test_many_ticks(suite);
+  test_portfolio_edits(suite);
+  test_pinned_snapshot(suite);
+  test_concurrent_ticks(suite);
+  test_tombstones_and_copies(suite);
+
+  suite.print_summary();
+
+  return suite.all_passed() ? 0 : 1;
+}
@@ -2,9 +2,12 @@ from flask import Flask, request, jsonify, send_from_directory
 from flask_cors import CORS
 import quant_risk_engine
 import traceback
+import numpy as np
 from typing import Dict, Any, Optional, List
 from datetime import datetime
 from market_data_fetcher import get_market_data_fetcher, MarketDataCache
+from portfolio_sessions import PortfolioSessionStore
+from risk_jobs import RiskJobQueue, RiskJobQueueFull
 import os
 
 app = Flask(__name__)
@@ -13,6 +16,23 @@ CORS(app)
 DEFAULT_VAR_SIMULATIONS = 10000
 DEFAULT_VAR_CONFIDENCE = 0.95
 DEFAULT_VAR_TIME_HORIZON = 1.0
+MAX_REPORTED_ROW_ERRORS = 100
+
+# Philox shocks are a function of (seed, path, asset), so single scenarios of
+# a seeded run can be regenerated for tail_scenarios
+RANDOM_GENERATORS = {
+    'mersenne_twister': quant_risk_engine.RandomGenerator.MersenneTwister,
+    'philox': quant_risk_engine.RandomGenerator.Philox
+}
+MAX_TAIL_SCENARIOS = 100
+
+# Native positions hold 32-bit quantities; larger values fail inside the
+# binding, after earlier edits of a request may already have been applied
+MIN_QUANTITY = -2**31
+MAX_QUANTITY = 2**31 - 1
+
+def is_quantity(value: Any) -> bool:
+    return isinstance(value, int) and MIN_QUANTITY <= value <= MAX_QUANTITY
 
 def validate_portfolio_item(item: Dict[str, Any], index: int) -> None:
     required_fields = ['type', 'strike', 'expiry', 'asset_id', 'quantity']
@@ -33,15 +53,20 @@ def validate_portfolio_item(item: Dict[str, Any], index: int) -> None:
     if not isinstance(item['expiry'], (int, float)) or item['expiry'] <= 0:
         raise ValueError(f"Portfolio item {index}: expiry must be a positive number")
     
-    if not isinstance(item['quantity'], int):
-        raise ValueError(f"Portfolio item {index}: quantity must be an integer")
+    if not is_quantity(item['quantity']):
+        raise ValueError(f"Portfolio item {index}: quantity must be an integer between {MIN_QUANTITY} and {MAX_QUANTITY}")
     
     if not isinstance(item['asset_id'], str) or not item['asset_id'].strip():
         raise ValueError(f"Portfolio item {index}: asset_id must be a non-empty string")
     
     pricing_model = item.get('pricing_model', 'blackscholes').lower()
-    if pricing_model not in ['blackscholes', 'binomial', 'jumpdiffusion']:
-        raise ValueError(f"Portfolio item {index}: pricing_model must be 'blackscholes', 'binomial', or 'jumpdiffusion'")
+    if pricing_model not in ['blackscholes', 'binomial', 'jumpdiffusion', 'finitedifference',
+                             'andersenlakeoffengeld', 'baroneadesiwhaley']:
+        raise ValueError(f"Portfolio item {index}: pricing_model must be 'blackscholes', 'binomial', 'jumpdiffusion', 'finitedifference', 'andersenlakeoffengeld', or 'baroneadesiwhaley'")
+    
+    if (pricing_model in ['andersenlakeoffengeld', 'baroneadesiwhaley'] and
+            item.get('style', 'european').lower() != 'american'):
+        raise ValueError(f"Portfolio item {index}: pricing_model '{pricing_model}' requires style 'american'")
 
 def validate_market_data(asset_id: str, md: Dict[str, Any]) -> None:
     required_fields = ['spot', 'rate', 'vol']
@@ -67,7 +92,12 @@ def validate_var_parameters(params: Optional[Dict[str, Any]]) -> Dict[str, Any]:
         'simulations': DEFAULT_VAR_SIMULATIONS,
         'confidence': DEFAULT_VAR_CONFIDENCE,
         'time_horizon': DEFAULT_VAR_TIME_HORIZON,
-        'seed': None
+        'seed': None,
+        'fast_american_revaluation': False,
+        'jump_scenarios': False,
+        'diagnostics': False,
+        'random_generator': 'mersenne_twister',
+        'tail_scenarios': 0
     }
     
     if params is None:
@@ -98,6 +128,39 @@ def validate_var_parameters(params: Optional[Dict[str, Any]]) -> Dict[str, Any]:
                 raise ValueError("Random seed must be a non-negative integer")
             validated['seed'] = seed
     
+    if 'fast_american_revaluation' in params:
+        fast = params['fast_american_revaluation']
+        if not isinstance(fast, bool):
+            raise ValueError("fast_american_revaluation must be a boolean")
+        validated['fast_american_revaluation'] = fast
+    
+    if 'jump_scenarios' in params:
+        jump_scenarios = params['jump_scenarios']
+        if not isinstance(jump_scenarios, bool):
+            raise ValueError("jump_scenarios must be a boolean")
+        validated['jump_scenarios'] = jump_scenarios
+    
+    if 'diagnostics' in params:
+        diagnostics = params['diagnostics']
+        if not isinstance(diagnostics, bool):
+            raise ValueError("diagnostics must be a boolean")
+        validated['diagnostics'] = diagnostics
+    
+    if 'random_generator' in params:
+        generator = params['random_generator']
+        if generator not in RANDOM_GENERATORS:
+            raise ValueError("random_generator must be 'mersenne_twister' or 'philox'")
+        validated['random_generator'] = generator
+    
+    if 'tail_scenarios' in params:
+        tail_scenarios = params['tail_scenarios']
+        if not isinstance(tail_scenarios, int) or tail_scenarios < 0 or tail_scenarios > MAX_TAIL_SCENARIOS:
+            raise ValueError(f"tail_scenarios must be an integer between 0 and {MAX_TAIL_SCENARIOS}")
+        validated['tail_scenarios'] = tail_scenarios
+    
+    if validated['tail_scenarios'] and (validated['random_generator'] != 'philox' or validated['seed'] is None):
+        raise ValueError("tail_scenarios requires random_generator 'philox' and a seed")
+    
     return validated
 
 def auto_fetch_missing_market_data(portfolio_assets: set, provided_market_data: Dict[str, Any]) -> Dict[str, Any]:
@@ -150,6 +213,84 @@ def auto_fetch_missing_market_data(portfolio_assets: set, provided_market_data:
     
     return complete_market_data
 
+# Shared by all request threads: calculations release the GIL and take their
+# parameters from a per-request RiskConfig, so requests run in parallel
+RISK_ENGINE = quant_risk_engine.RiskEngine()
+
+# Fixed-seed results keyed by a content hash of book, market data and config;
+# the dashboard re-posting an unchanged book is then answered from memory.
+# Identical requests arriving while one is running share that run.
+RISK_CACHE_BYTES = int(os.environ.get('RISK_CACHE_BYTES', 8 * 1024 * 1024))
+RISK_RESULT_CACHE = quant_risk_engine.RiskResultCache(RISK_CACHE_BYTES)
+
+# Setting RISK_TRACE_EVENTS (events kept per thread) records every risk run
+# for GET /risk_trace, a trace-event file to open in Perfetto
+RISK_TRACE_EVENTS = int(os.environ.get('RISK_TRACE_EVENTS', 0))
+RISK_TRACE = quant_risk_engine.TraceRecorder(RISK_TRACE_EVENTS) if RISK_TRACE_EVENTS > 0 else None
+
+def risk_config(var_config: Dict[str, Any]) -> Any:
+    return quant_risk_engine.RiskConfig(
+        simulations=var_config['simulations'],
+        time_horizon_days=var_config['time_horizon'],
+        seed=var_config['seed'],
+        fast_american_revaluation=var_config['fast_american_revaluation'],
+        jump_diffusion_scenarios=var_config['jump_scenarios'],
+        diagnostics=var_config['diagnostics'],
+        trace=RISK_TRACE,
+        random_generator=RANDOM_GENERATORS[var_config['random_generator']]
+    )
+
+def tail_scenarios_to_json(scenarios: List[Any]) -> List[Dict[str, Any]]:
+    return [{
+        'path': scenario.path,
+        'pnl': scenario.pnl,
+        'spots': {asset_id: spot for asset_id, spot in scenario.spots}
+    } for scenario in scenarios]
+
+def diagnostics_to_json(diagnostics: Any) -> Dict[str, Any]:
+    counted = diagnostics.allocations_counted
+    phases = []
+    for p in diagnostics.phases:
+        phase = {'phase': p.phase, 'wall_seconds': p.wall_seconds, 'cpu_seconds': p.cpu_seconds}
+        if counted:
+            phase['allocations'] = p.allocations
+            phase['allocated_bytes'] = p.allocated_bytes
+        phases.append(phase)
+    result = {
+        'phases': phases,
+        'revaluations': dict(diagnostics.revaluations),
+        'slowest_positions': [
+            {'position': p.position, 'asset_id': p.asset_id,
+             'pricing_model': p.pricing_model, 'seconds': p.seconds}
+            for p in diagnostics.slowest_positions
+        ]
+    }
+    if counted:
+        result['allocations'] = diagnostics.allocations
+        result['allocated_bytes'] = diagnostics.allocated_bytes
+    return result
+
+def to_cpp_market_data(market_data: Dict[str, Any]) -> Dict[str, Any]:
+    market_data_map_cpp = {}
+    for asset_id, md_py in market_data.items():
+        dividend = md_py.get('dividend', 0.0)
+        market_data_map_cpp[asset_id] = quant_risk_engine.MarketData(
+            asset_id,
+            float(md_py['spot']),
+            float(md_py['rate']),
+            float(md_py['vol']),
+            float(dividend)
+        )
+    return market_data_map_cpp
+
+def apply_fd_grid(option: Any, item: Dict[str, Any]) -> None:
+    fd_grid = item.get('fd_grid', {})
+    if fd_grid:
+        option.set_finite_difference_grid(
+            int(fd_grid.get('space_steps', option.get_finite_difference_space_steps())),
+            int(fd_grid.get('time_steps', option.get_finite_difference_time_steps()))
+        )
+
 def create_option(item: Dict[str, Any]) -> Any:
     option_type = (quant_risk_engine.OptionType.Call 
                   if item['type'].lower() == 'call' 
@@ -166,6 +307,15 @@ def create_option(item: Dict[str, Any]) -> Any:
             item['asset_id'].strip(),
             binomial_steps
         )
+        
+        american_model = item.get('pricing_model', 'binomial').lower()
+        if american_model == 'finitedifference':
+            option.set_pricing_model(quant_risk_engine.PricingModel.FiniteDifference)
+            apply_fd_grid(option, item)
+        elif american_model == 'andersenlakeoffengeld':
+            option.set_pricing_model(quant_risk_engine.PricingModel.AndersenLakeOffengeld)
+        elif american_model == 'baroneadesiwhaley':
+            option.set_pricing_model(quant_risk_engine.PricingModel.BaroneAdesiWhaley)
     else:
         pricing_model_str = item.get('pricing_model', 'blackscholes').lower()
         
@@ -173,6 +323,8 @@ def create_option(item: Dict[str, Any]) -> Any:
             pricing_model = quant_risk_engine.PricingModel.Binomial
         elif pricing_model_str == 'jumpdiffusion':
             pricing_model = quant_risk_engine.PricingModel.MertonJumpDiffusion
+        elif pricing_model_str == 'finitedifference':
+            pricing_model = quant_risk_engine.PricingModel.FiniteDifference
         else:
             pricing_model = quant_risk_engine.PricingModel.BlackScholes
         
@@ -194,6 +346,9 @@ def create_option(item: Dict[str, Any]) -> Any:
             jump_mean = jump_params.get('mean', -0.05)
             jump_vol = jump_params.get('vol', 0.15)
             option.set_jump_parameters(lambda_val, jump_mean, jump_vol)
+        
+        if pricing_model_str == 'finitedifference':
+            apply_fd_grid(option, item)
     
     return option
 
@@ -330,120 +485,205 @@ def health_check():
         }), 500
 
 
-@app.route('/calculate_risk', methods=['POST'])
-def calculate_risk():
+class RequestError(Exception):
+    """A malformed request, reported as 400 with the message verbatim."""
+
+def prepare_risk_request(data: Any) -> Dict[str, Any]:
     """
-    Calculate portfolio risk with automatic market data fetching
-    Market data can be:
+    Validate a /calculate_risk body and build its native inputs. Market data
+    can be:
     1. Provided in request
     2. Empty {} - will auto-fetch from cache/YFinance
     3. Partial - will auto-fetch missing assets
     """
+    if not data:
+        raise RequestError('Request body must be valid JSON')
+    
+    if 'portfolio' not in data:
+        raise RequestError("Missing required field 'portfolio'")
+    
+    portfolio_data = data['portfolio']
+    market_data_map_py = data.get('market_data', {})  # Default to empty dict
+    var_params = data.get('var_parameters', None)
+    
+    if not isinstance(portfolio_data, list):
+        raise RequestError("Field 'portfolio' must be an array")
+    
+    if not isinstance(market_data_map_py, dict):
+        raise RequestError("Field 'market_data' must be an object")
+    
+    if len(portfolio_data) == 0:
+        raise RequestError('Portfolio cannot be empty')
+
+    # Validate portfolio items
+    for idx, item in enumerate(portfolio_data):
+        validate_portfolio_item(item, idx)
+    
+    # Get all unique assets in portfolio
+    portfolio_assets = set(item['asset_id'] for item in portfolio_data)
+    
+    # AUTO-FETCH: Get complete market data (provided + auto-fetched)
     try:
-        data = request.get_json()
-        
-        if not data:
-            return jsonify({'error': 'Request body must be valid JSON'}), 400
-        
-        if 'portfolio' not in data:
-            return jsonify({'error': "Missing required field 'portfolio'"}), 400
-        
-        portfolio_data = data['portfolio']
-        market_data_map_py = data.get('market_data', {})  # Default to empty dict
-        var_params = data.get('var_parameters', None)
-        
-        if not isinstance(portfolio_data, list):
-            return jsonify({'error': "Field 'portfolio' must be an array"}), 400
+        complete_market_data = auto_fetch_missing_market_data(
+            portfolio_assets, 
+            market_data_map_py
+        )
         
-        if not isinstance(market_data_map_py, dict):
-            return jsonify({'error': "Field 'market_data' must be an object"}), 400
+        # Track which assets were auto-fetched for response
+        auto_fetched = [asset for asset in portfolio_assets 
+                      if asset not in market_data_map_py or not market_data_map_py[asset]]
         
-        if len(portfolio_data) == 0:
-            return jsonify({'error': 'Portfolio cannot be empty'}), 400
+    except ValueError as e:
+        raise RequestError(str(e))
+    
+    # Validate the complete market data
+    for asset_id, md in complete_market_data.items():
+        validate_market_data(asset_id, md)
+    
+    var_config = validate_var_parameters(var_params)
 
-        # Validate portfolio items
-        for idx, item in enumerate(portfolio_data):
-            validate_portfolio_item(item, idx)
-        
-        # Get all unique assets in portfolio
-        portfolio_assets = set(item['asset_id'] for item in portfolio_data)
-        
-        # AUTO-FETCH: Get complete market data (provided + auto-fetched)
-        try:
-            complete_market_data = auto_fetch_missing_market_data(
-                portfolio_assets, 
-                market_data_map_py
-            )
-            
-            # Track which assets were auto-fetched for response
-            auto_fetched = [asset for asset in portfolio_assets 
-                          if asset not in market_data_map_py or not market_data_map_py[asset]]
-            
-        except ValueError as e:
-            return jsonify({'error': str(e)}), 400
-        
-        # Validate the complete market data
-        for asset_id, md in complete_market_data.items():
-            validate_market_data(asset_id, md)
-        
-        var_config = validate_var_parameters(var_params)
+    # Build portfolio
+    portfolio = quant_risk_engine.Portfolio()
+    portfolio.reserve(len(portfolio_data))
+    
+    for item in portfolio_data:
+        option = create_option(item)
+        portfolio.add_instrument(option, item['quantity'])
 
-        # Build portfolio
-        portfolio = quant_risk_engine.Portfolio()
-        portfolio.reserve(len(portfolio_data))
-        
-        for item in portfolio_data:
-            option = create_option(item)
-            portfolio.add_instrument(option, item['quantity'])
+    return {
+        'portfolio': portfolio,
+        'market_data': to_cpp_market_data(complete_market_data),
+        'var_config': var_config,
+        'auto_fetched': auto_fetched,
+        'complete_market_data': complete_market_data
+    }
 
-        # Convert market data to C++ format
-        market_data_map_cpp = {}
-        for asset_id, md_py in complete_market_data.items():
-            dividend = md_py.get('dividend', 0.0)
-            md_cpp = quant_risk_engine.MarketData(
-                asset_id,
-                float(md_py['spot']),
-                float(md_py['rate']),
-                float(md_py['vol']),
-                float(dividend)
-            )
-            market_data_map_cpp[asset_id] = md_cpp
+def risk_result_to_json(result_cpp: Any, prepared: Dict[str, Any]) -> Dict[str, Any]:
+    var_config = prepared['var_config']
+    result_py = {
+        'total_pv': result_cpp.total_pv,
+        'total_delta': result_cpp.total_delta,
+        'total_gamma': result_cpp.total_gamma,
+        'total_vega': result_cpp.total_vega,
+        'total_theta': result_cpp.total_theta,
+        'value_at_risk_95': result_cpp.value_at_risk_95,
+        'portfolio_size': len(prepared['portfolio']),
+        'var_parameters': {
+            'simulations': var_config['simulations'],
+            'confidence_level': var_config['confidence'],
+            'time_horizon_days': var_config['time_horizon']
+        },
+        'market_data_info': {
+            'auto_fetched_assets': prepared['auto_fetched'],
+            'market_data_used': prepared['complete_market_data']
+        }
+    }
+    if result_cpp.diagnostics.enabled:
+        result_py['diagnostics'] = diagnostics_to_json(result_cpp.diagnostics)
+    return result_py
 
-        # Calculate risk
-        engine = quant_risk_engine.RiskEngine()
-        engine.set_var_simulations(var_config['simulations'])
-        engine.set_var_time_horizon_days(var_config['time_horizon'])
-        
-        if var_config['seed'] is not None:
-            engine.set_random_seed(var_config['seed'])
-            engine.set_use_fixed_seed(True)
-        
-        result_cpp = engine.calculate_portfolio_risk(portfolio, market_data_map_cpp)
+@app.route('/calculate_risk', methods=['POST'])
+def calculate_risk():
+    """
+    Calculate portfolio risk with automatic market data fetching
+    (see prepare_risk_request)
+    """
+    try:
+        prepared = prepare_risk_request(request.get_json())
+
+        # Calculate risk; only fixed-seed runs are cached
+        config = risk_config(prepared['var_config'])
+        result_cpp, source = RISK_RESULT_CACHE.calculate(
+            RISK_ENGINE, prepared['portfolio'], prepared['market_data'], config)
         
         if not result_cpp.is_valid():
             return jsonify({'error': 'Risk calculation produced invalid results'}), 500
 
-        # Prepare response with market data info
-        result_py = {
-            'total_pv': result_cpp.total_pv,
-            'total_delta': result_cpp.total_delta,
-            'total_gamma': result_cpp.total_gamma,
-            'total_vega': result_cpp.total_vega,
-            'total_theta': result_cpp.total_theta,
-            'value_at_risk_95': result_cpp.value_at_risk_95,
-            'portfolio_size': len(portfolio),
-            'var_parameters': {
-                'simulations': var_config['simulations'],
-                'confidence_level': var_config['confidence'],
-                'time_horizon_days': var_config['time_horizon']
-            },
-            'market_data_info': {
-                'auto_fetched_assets': auto_fetched if auto_fetched else [],
-                'market_data_used': complete_market_data
-            }
-        }
+        result_py = risk_result_to_json(result_cpp, prepared)
+        result_py['cached'] = source == quant_risk_engine.RiskResultCache.Source.Cached
+        result_py['coalesced'] = source == quant_risk_engine.RiskResultCache.Source.Coalesced
+        if prepared['var_config']['tail_scenarios']:
+            result_py['tail_scenarios'] = tail_scenarios_to_json(RISK_ENGINE.worst_scenarios(
+                prepared['portfolio'], prepared['market_data'], config,
+                prepared['var_config']['tail_scenarios']))
         return jsonify(result_py), 200
 
+    except RequestError as e:
+        return jsonify({'error': str(e)}), 400
+    except ValueError as e:
+        return jsonify({'error': f'Validation error: {str(e)}'}), 400
+    except RuntimeError as e:
+        return jsonify({'error': f'Runtime error: {str(e)}'}), 500
+    except Exception as e:
+        app.logger.error(f"Unexpected error: {traceback.format_exc()}")
+        return jsonify({'error': f'Internal server error: {str(e)}'}), 500
+
+@app.route('/risk_cache', methods=['GET'])
+def risk_cache_stats():
+    lookups = RISK_RESULT_CACHE.hits + RISK_RESULT_CACHE.misses
+    return jsonify({
+        'entries': len(RISK_RESULT_CACHE),
+        'hits': RISK_RESULT_CACHE.hits,
+        'misses': RISK_RESULT_CACHE.misses,
+        'hit_rate': RISK_RESULT_CACHE.hits / lookups if lookups else 0.0,
+        'evictions': RISK_RESULT_CACHE.evictions,
+        'coalesced': RISK_RESULT_CACHE.coalesced,
+        'in_flight': RISK_RESULT_CACHE.in_flight,
+        'bytes': RISK_RESULT_CACHE.bytes,
+        'budget_bytes': RISK_RESULT_CACHE.budget_bytes
+    }), 200
+
+@app.route('/risk_cache', methods=['DELETE'])
+def clear_risk_cache():
+    RISK_RESULT_CACHE.clear()
+    return jsonify({'message': 'Risk result cache cleared'}), 200
+
+def risk_trace_disabled():
+    return jsonify({'error': 'Risk tracing is disabled; set RISK_TRACE_EVENTS to enable it'}), 404
+
+@app.route('/risk_trace', methods=['GET'])
+def get_risk_trace():
+    if RISK_TRACE is None:
+        return risk_trace_disabled()
+    return app.response_class(RISK_TRACE.to_json(), mimetype='application/json'), 200
+
+@app.route('/risk_trace', methods=['DELETE'])
+def clear_risk_trace():
+    if RISK_TRACE is None:
+        return risk_trace_disabled()
+    RISK_TRACE.clear()
+    return jsonify({'message': 'Risk trace cleared'}), 200
+
+RISK_JOBS = RiskJobQueue()
+
+def risk_job_not_found(job_id: str):
+    return jsonify({'error': f"Unknown risk job '{job_id}'"}), 404
+
+@app.route('/risk_jobs', methods=['POST'])
+def submit_risk_job():
+    """
+    Queue a /calculate_risk body for background calculation. Validation and
+    market data fetching happen here, so a bad request fails immediately;
+    the response carries the job id to poll.
+    """
+    try:
+        prepared = prepare_risk_request(request.get_json(silent=True))
+        config = risk_config(prepared['var_config'])
+
+        def run(control):
+            result_cpp = RISK_ENGINE.calculate_portfolio_risk(
+                prepared['portfolio'], prepared['market_data'], config, control)
+            if not result_cpp.is_valid():
+                raise RuntimeError('Risk calculation produced invalid results')
+            return risk_result_to_json(result_cpp, prepared)
+
+        job = RISK_JOBS.submit(run, prepared['var_config']['simulations'])
+        return jsonify(RISK_JOBS.snapshot(job)), 202
+
+    except RiskJobQueueFull as e:
+        return jsonify({'error': str(e)}), 429
+    except RequestError as e:
+        return jsonify({'error': str(e)}), 400
     except ValueError as e:
         return jsonify({'error': f'Validation error: {str(e)}'}), 400
     except RuntimeError as e:
@@ -452,6 +692,57 @@ def calculate_risk():
         app.logger.error(f"Unexpected error: {traceback.format_exc()}")
         return jsonify({'error': f'Internal server error: {str(e)}'}), 500
 
+@app.route('/risk_jobs/<job_id>', methods=['GET'])
+def get_risk_job(job_id):
+    """Status and progress; the full result once the job has completed."""
+    job = RISK_JOBS.get(job_id)
+    if job is None:
+        return risk_job_not_found(job_id)
+    return jsonify(RISK_JOBS.snapshot(job)), 200
+
+@app.route('/risk_jobs/<job_id>/partial', methods=['GET'])
+def get_risk_job_partial(job_id):
+    """
+    Greeks as soon as they are known, and VaR/ES estimated from the paths
+    simulated so far (refreshed every tenth of the run).
+    """
+    job = RISK_JOBS.get(job_id)
+    if job is None:
+        return risk_job_not_found(job_id)
+
+    control = job.control
+    response = {
+        'job_id': job.id,
+        'status': job.status,
+        'completed_simulations': control.get_completed_simulations(),
+        'total_simulations': job.total_simulations
+    }
+    partial = control.get_partial_result()
+    if control.has_greeks():
+        response['greeks'] = {
+            'total_pv': partial.total_pv,
+            'total_delta': partial.total_delta,
+            'total_gamma': partial.total_gamma,
+            'total_vega': partial.total_vega,
+            'total_theta': partial.total_theta
+        }
+    if control.has_partial_var():
+        response['var_estimate'] = {
+            'value_at_risk_95': partial.value_at_risk_95,
+            'value_at_risk_99': partial.value_at_risk_99,
+            'expected_shortfall_95': partial.expected_shortfall_95,
+            'expected_shortfall_99': partial.expected_shortfall_99
+        }
+    return jsonify(response), 200
+
+@app.route('/risk_jobs/<job_id>', methods=['DELETE'])
+def cancel_risk_job(job_id):
+    """Cancel a queued or running job; finished jobs are left as they are."""
+    job = RISK_JOBS.cancel(job_id)
+    if job is None:
+        return risk_job_not_found(job_id)
+    return jsonify(RISK_JOBS.snapshot(job)), 200
+
 @app.route('/price_option', methods=['POST'])
 def price_option():
     """
@@ -513,6 +804,7 @@ def price_option():
             'pricing_model': data.get('pricing_model', 'blackscholes'),
             'binomial_steps': data.get('binomial_steps', 100),
             'jump_parameters': data.get('jump_parameters', {}),
+            'fd_grid': data.get('fd_grid', {}),
             'quantity': 1
         })
         
@@ -545,6 +837,207 @@ def price_option():
         app.logger.error(f"Unexpected error: {traceback.format_exc()}")
         return jsonify({'error': f'Internal server error: {str(e)}'}), 500
 
+MAX_BULK_OPTIONS = 100000
+BULK_OPTION_COLUMNS = ['type', 'strike', 'expiry', 'asset_id', 'style', 'pricing_model']
+# Per-option model parameters /price_option accepts; the batch path prices
+# with the engine defaults, so requests carrying them are refused rather
+# than silently priced differently
+UNSUPPORTED_BULK_FIELDS = ['binomial_steps', 'jump_parameters', 'fd_grid']
+GREEK_NAMES = ['price', 'delta', 'gamma', 'vega', 'theta']
+
+# Pricing model codes for price_batch/greeks_batch, resolved as create_option
+# does: unknown European models price with Black-Scholes, and American
+# options without a matching model use the binomial tree
+EUROPEAN_MODEL_CODES = {
+    'blackscholes': int(quant_risk_engine.PricingModel.BlackScholes),
+    'binomial': int(quant_risk_engine.PricingModel.Binomial),
+    'jumpdiffusion': int(quant_risk_engine.PricingModel.MertonJumpDiffusion),
+    'finitedifference': int(quant_risk_engine.PricingModel.FiniteDifference),
+}
+AMERICAN_MODEL_CODES = {
+    'binomial': int(quant_risk_engine.PricingModel.Binomial),
+    'finitedifference': int(quant_risk_engine.PricingModel.FiniteDifference),
+    'andersenlakeoffengeld': int(quant_risk_engine.PricingModel.AndersenLakeOffengeld),
+    'baroneadesiwhaley': int(quant_risk_engine.PricingModel.BaroneAdesiWhaley),
+}
+
+def reject_unsupported_bulk_fields(fields: Dict[str, Any], where: str) -> None:
+    for field in UNSUPPORTED_BULK_FIELDS:
+        if field in fields:
+            raise RequestError(f"Field '{where}{field}' is not supported by /price_options; "
+                               f"use /price_option for per-option model parameters")
+
+def bulk_option_columns(options: Any) -> Dict[str, List[Any]]:
+    """Columnar options: equal-length lists, where asset_id, style and
+    pricing_model may also be one string for every option."""
+    if not isinstance(options, dict):
+        raise RequestError("Field 'options' must be an object of columns")
+    reject_unsupported_bulk_fields(options, 'options.')
+    for field in ['type', 'strike', 'expiry', 'asset_id']:
+        if field not in options:
+            raise RequestError(f"Missing required column 'options.{field}'")
+
+    lengths = {len(v) for v in options.values() if isinstance(v, list)}
+    if len(lengths) != 1:
+        raise RequestError("Option columns must be lists of the same length")
+    size = lengths.pop()
+
+    defaults = {'style': 'european', 'pricing_model': None}
+    columns = {}
+    for field in BULK_OPTION_COLUMNS:
+        value = options.get(field, defaults.get(field))
+        if isinstance(value, list):
+            columns[field] = value
+        elif field in ('asset_id', 'style', 'pricing_model') and (value is None or isinstance(value, str)):
+            columns[field] = [value] * size
+        else:
+            raise RequestError(f"Column 'options.{field}' must be a list")
+    return columns
+
+def option_chain_columns(chain: Any, limit: int) -> Dict[str, List[Any]]:
+    """Every (expiry, strike, type) of one underlying, expiry-major; chains
+    expanding to more than `limit` options are refused before expansion."""
+    if not isinstance(chain, dict):
+        raise RequestError("Field 'chain' must be an object")
+    reject_unsupported_bulk_fields(chain, 'chain.')
+    for field in ['asset_id', 'expiries', 'strikes']:
+        if field not in chain:
+            raise RequestError(f"Missing required field 'chain.{field}'")
+    expiries, strikes = chain['expiries'], chain['strikes']
+    types = chain.get('types', ['call', 'put'])
+    if not isinstance(expiries, list) or not isinstance(strikes, list) or not isinstance(types, list):
+        raise RequestError("Chain expiries, strikes and types must be lists")
+    if len(expiries) * len(strikes) * len(types) > limit:
+        raise RequestError(f'At most {MAX_BULK_OPTIONS} options can be priced per request')
+
+    columns = {field: [] for field in BULK_OPTION_COLUMNS}
+    for expiry in expiries:
+        for strike in strikes:
+            for option_type in types:
+                columns['type'].append(option_type)
+                columns['strike'].append(strike)
+                columns['expiry'].append(expiry)
+    size = len(columns['type'])
+    columns['asset_id'] = [chain['asset_id']] * size
+    columns['style'] = [chain.get('style', 'european')] * size
+    columns['pricing_model'] = [chain.get('pricing_model')] * size
+    return columns
+
+def bulk_model_code(style: str, pricing_model: Optional[str]) -> int:
+    name = (pricing_model or '').lower()
+    if style == 'american':
+        return AMERICAN_MODEL_CODES.get(name, AMERICAN_MODEL_CODES['binomial'])
+    return EUROPEAN_MODEL_CODES.get(name, EUROPEAN_MODEL_CODES['blackscholes'])
+
+@app.route('/price_options', methods=['POST'])
+def price_options():
+    """
+    Price many options in one native batch call: columnar options and/or a
+    chain definition in, columnar prices and Greeks out
+    """
+    try:
+        data = request.get_json(silent=True)
+        if not data or not isinstance(data, dict):
+            raise RequestError('Request body must be valid JSON')
+        if 'options' not in data and 'chain' not in data:
+            raise RequestError("Request must contain 'options' and/or 'chain'")
+        reject_unsupported_bulk_fields(data, '')
+
+        parts = []
+        if 'options' in data:
+            parts.append(bulk_option_columns(data['options']))
+        if 'chain' in data:
+            chains = data['chain'] if isinstance(data['chain'], list) else [data['chain']]
+            for chain in chains:
+                built = sum(len(part['type']) for part in parts)
+                parts.append(option_chain_columns(chain, MAX_BULK_OPTIONS - built))
+        columns = {field: [v for part in parts for v in part[field]] for field in BULK_OPTION_COLUMNS}
+
+        size = len(columns['type'])
+        if size == 0:
+            raise RequestError('No options to price')
+        if size > MAX_BULK_OPTIONS:
+            raise RequestError(f'At most {MAX_BULK_OPTIONS} options can be priced per request')
+
+        option_types = []
+        model_codes = []
+        american = []
+        for i in range(size):
+            option_type = columns['type'][i]
+            if not isinstance(option_type, str) or option_type.lower() not in ('call', 'put'):
+                raise ValueError(f"Option {i}: type must be 'call' or 'put'")
+            for field in ('strike', 'expiry'):
+                value = columns[field][i]
+                if isinstance(value, bool) or not isinstance(value, (int, float)):
+                    raise ValueError(f"Option {i}: {field} must be a number")
+            if not isinstance(columns['asset_id'][i], str) or not columns['asset_id'][i].strip():
+                raise ValueError(f"Option {i}: asset_id must be a non-empty string")
+            style = columns['style'][i]
+            if not isinstance(style, str) or style.lower() not in ('european', 'american'):
+                raise ValueError(f"Option {i}: style must be 'european' or 'american'")
+            pricing_model = columns['pricing_model'][i]
+            if pricing_model is not None and not isinstance(pricing_model, str):
+                raise ValueError(f"Option {i}: pricing_model must be a string")
+
+            option_types.append(0 if option_type.lower() == 'call' else 1)
+            model_codes.append(bulk_model_code(style.lower(), pricing_model))
+            american.append(1 if style.lower() == 'american' else 0)
+
+        asset_ids = [asset_id.strip() for asset_id in columns['asset_id']]
+        provided_market_data = data.get('market_data', {}) or {}
+        if not isinstance(provided_market_data, dict):
+            raise RequestError("Field 'market_data' must be an object")
+        market_data = auto_fetch_missing_market_data(set(asset_ids), provided_market_data)
+        for asset_id, md in market_data.items():
+            validate_market_data(asset_id, md)
+        auto_fetched = sorted(a for a in market_data if a not in provided_market_data or not provided_market_data[a])
+
+        arrays = {
+            'spot': np.array([float(market_data[a]['spot']) for a in asset_ids]),
+            'strike': np.array(columns['strike'], dtype=np.float64),
+            'expiry': np.array(columns['expiry'], dtype=np.float64),
+            'rate': np.array([float(market_data[a]['rate']) for a in asset_ids]),
+            'vol': np.array([float(market_data[a]['vol']) for a in asset_ids]),
+            'option_type': np.array(option_types, dtype=np.int32),
+            'model': np.array(model_codes, dtype=np.int32),
+            'american': np.array(american, dtype=np.uint8),
+            'dividend': np.array([float(market_data[a].get('dividend', 0.0)) for a in asset_ids]),
+        }
+
+        result = {
+            'count': size,
+            'type': columns['type'],
+            'strike': columns['strike'],
+            'expiry': columns['expiry'],
+            'asset_id': asset_ids,
+            'style': [s.lower() for s in columns['style']],
+        }
+        if data.get('greeks', True):
+            values = quant_risk_engine.greeks_batch(**arrays)
+            for row, name in enumerate(GREEK_NAMES):
+                result[name] = [None if np.isnan(v) else v for v in values[row].tolist()]
+        else:
+            values = quant_risk_engine.price_batch(**arrays)
+            result['price'] = [None if np.isnan(v) else v for v in values.tolist()]
+
+        # Elements the engine could not price come back as NaN, reported as null
+        result['failed'] = sum(1 for v in result['price'] if v is None)
+        result['market_data_info'] = {
+            'auto_fetched_assets': auto_fetched,
+            'market_data_used': market_data
+        }
+        return jsonify(result), 200
+
+    except RequestError as e:
+        return jsonify({'error': str(e)}), 400
+    except ValueError as e:
+        return jsonify({'error': f'Validation error: {str(e)}'}), 400
+    except RuntimeError as e:
+        return jsonify({'error': f'Runtime error: {str(e)}'}), 500
+    except Exception as e:
+        app.logger.error(f"Unexpected error: {traceback.format_exc()}")
+        return jsonify({'error': f'Internal server error: {str(e)}'}), 500
+
 @app.route('/portfolio/net_position/<asset_id>', methods=['POST'])
 def get_net_position(asset_id):
     try:
@@ -605,10 +1098,7 @@ def portfolio_summary():
             option = create_option(item)
             portfolio.add_instrument(option, item['quantity'])
         
-        assets = set(item['asset_id'] for item in portfolio_data)
-        net_positions = {}
-        for asset in assets:
-            net_positions[asset] = portfolio.get_total_quantity(asset)
+        net_positions = portfolio.get_net_positions()
         
         instrument_counts = {
             'european': sum(1 for item in portfolio_data if item.get('style', 'european') == 'european'),
@@ -619,7 +1109,7 @@ def portfolio_summary():
         
         return jsonify({
             'portfolio_size': len(portfolio),
-            'unique_assets': len(assets),
+            'unique_assets': len(net_positions),
             'net_positions': net_positions,
             'instrument_counts': instrument_counts
         }), 200
@@ -632,6 +1122,312 @@ def portfolio_summary():
         app.logger.error(f"Unexpected error: {traceback.format_exc()}")
         return jsonify({'error': f'Internal server error: {str(e)}'}), 500
 
+def ingestion_format(filename: str) -> Any:
+    extension = os.path.splitext(filename or '')[1].lower()
+    if extension == '.csv':
+        return quant_risk_engine.IngestionFormat.Csv
+    if extension in ('.jsonl', '.ndjson'):
+        return quant_risk_engine.IngestionFormat.JsonLines
+    raise ValueError(f"Unsupported file type '{filename}': expected .csv, .jsonl or .ndjson")
+
+def row_errors_to_json(errors: List[Any]) -> List[Dict[str, Any]]:
+    return [{'line': e.line, 'message': e.message} for e in errors[:MAX_REPORTED_ROW_ERRORS]]
+
+@app.route('/portfolio/upload', methods=['POST'])
+def upload_portfolio():
+    """
+    Bulk-load a portfolio (and optionally its market data) from CSV or
+    JSON-lines files. Parsing and validation run natively across threads;
+    invalid rows are reported by line and skipped.
+    """
+    try:
+        portfolio_file = request.files.get('portfolio')
+        if portfolio_file is None:
+            return jsonify({'error': "Missing required file 'portfolio'"}), 400
+
+        loaded = quant_risk_engine.parse_portfolio(
+            portfolio_file.read().decode('utf-8'),
+            ingestion_format(portfolio_file.filename)
+        )
+        portfolio = loaded.portfolio
+        net_positions = portfolio.get_net_positions()
+
+        result_py = {
+            'rows_read': loaded.rows_read,
+            'rows_loaded': len(portfolio),
+            'errors': row_errors_to_json(loaded.errors),
+            'error_count': len(loaded.errors),
+            'portfolio_size': len(portfolio),
+            'unique_assets': len(net_positions),
+            'net_positions': net_positions
+        }
+
+        market_data_file = request.files.get('market_data')
+        if market_data_file is not None:
+            market_data = quant_risk_engine.parse_market_data(
+                market_data_file.read().decode('utf-8'),
+                ingestion_format(market_data_file.filename)
+            )
+            result_py['market_data_errors'] = row_errors_to_json(market_data.errors)
+
+            market_data_map_cpp = market_data.market_data
+            missing = sorted(asset for asset in net_positions if asset not in market_data_map_cpp)
+            if missing:
+                result_py['error'] = f"Missing market data for assets: {', '.join(missing)}"
+                return jsonify(result_py), 400
+
+            if len(portfolio) > 0:
+                risk = RISK_ENGINE.calculate_portfolio_risk(portfolio, market_data_map_cpp)
+                if not risk.is_valid():
+                    return jsonify({'error': 'Risk calculation produced invalid results'}), 500
+                result_py['risk'] = {
+                    'total_pv': risk.total_pv,
+                    'total_delta': risk.total_delta,
+                    'total_gamma': risk.total_gamma,
+                    'total_vega': risk.total_vega,
+                    'total_theta': risk.total_theta,
+                    'value_at_risk_95': risk.value_at_risk_95
+                }
+
+        return jsonify(result_py), 200
+
+    except UnicodeDecodeError:
+        return jsonify({'error': 'Uploaded files must be UTF-8 text'}), 400
+    except ValueError as e:
+        return jsonify({'error': f'Validation error: {str(e)}'}), 400
+    except RuntimeError as e:
+        return jsonify({'error': f'Runtime error: {str(e)}'}), 500
+    except Exception as e:
+        app.logger.error(f"Unexpected error: {traceback.format_exc()}")
+        return jsonify({'error': f'Internal server error: {str(e)}'}), 500
+
+PORTFOLIO_SESSIONS = PortfolioSessionStore()
+
+def validated_items(items: Any, field: str) -> List[Dict[str, Any]]:
+    if not isinstance(items, list):
+        raise ValueError(f"Field '{field}' must be an array")
+    for idx, item in enumerate(items):
+        validate_portfolio_item(item, idx)
+    return items
+
+def validated_market_data(market_data: Any) -> Dict[str, Any]:
+    if not isinstance(market_data, dict):
+        raise ValueError("Field 'market_data' must be an object")
+    for asset_id, md in market_data.items():
+        validate_market_data(asset_id, md)
+    return to_cpp_market_data(market_data)
+
+def session_not_found(portfolio_id: str):
+    return jsonify({'error': f"Unknown portfolio '{portfolio_id}'"}), 404
+
+def session_summary(session) -> Dict[str, Any]:
+    net_positions = session.portfolio.get_net_positions()
+    return {
+        'portfolio_id': session.id,
+        'version': session.portfolio.get_version(),
+        'portfolio_size': len(session.portfolio),
+        'unique_assets': len(net_positions),
+        'net_positions': net_positions
+    }
+
+@app.route('/portfolios', methods=['POST'])
+def create_portfolio_session():
+    """
+    Register a book once; later requests edit and price it by id instead of
+    re-sending it.
+    """
+    try:
+        data = request.get_json(silent=True) or {}
+        items = validated_items(data.get('portfolio', []), 'portfolio')
+        market_data = validated_market_data(data.get('market_data', {}))
+        options = [create_option(item) for item in items]
+
+        session = PORTFOLIO_SESSIONS.create()
+        with session.lock:
+            session.portfolio.reserve(len(items))
+            handles = session.add_positions(items, options)
+            session.set_market_data(market_data)
+            response = session_summary(session)
+        response['handles'] = handles
+        return jsonify(response), 201
+
+    except ValueError as e:
+        return jsonify({'error': f'Validation error: {str(e)}'}), 400
+    except RuntimeError as e:
+        return jsonify({'error': f'Runtime error: {str(e)}'}), 500
+    except Exception as e:
+        app.logger.error(f"Unexpected error: {traceback.format_exc()}")
+        return jsonify({'error': f'Internal server error: {str(e)}'}), 500
+
+@app.route('/portfolios/<portfolio_id>', methods=['GET'])
+def get_portfolio_session(portfolio_id):
+    session = PORTFOLIO_SESSIONS.get(portfolio_id)
+    if session is None:
+        return session_not_found(portfolio_id)
+    with session.lock:
+        response = session_summary(session)
+        response['positions'] = [
+            dict(item, handle=handle) for handle, item in session.positions.items()
+        ]
+    return jsonify(response), 200
+
+@app.route('/portfolios/<portfolio_id>', methods=['PATCH'])
+def patch_portfolio_session(portfolio_id):
+    """
+    Incremental edit: {"update": [{"handle", "quantity"}], "remove": [handle],
+    "add": [portfolio items]}. Nothing is applied if any part is invalid.
+    """
+    session = PORTFOLIO_SESSIONS.get(portfolio_id)
+    if session is None:
+        return session_not_found(portfolio_id)
+    try:
+        data = request.get_json(silent=True)
+        if not isinstance(data, dict):
+            return jsonify({'error': 'Request body must be valid JSON'}), 400
+
+        items = validated_items(data.get('add', []), 'add')
+        removals = data.get('remove', [])
+        if not isinstance(removals, list) or not all(isinstance(h, int) for h in removals):
+            raise ValueError("Field 'remove' must be an array of position handles")
+        updates = []
+        for idx, update in enumerate(data.get('update', [])):
+            if (not isinstance(update, dict) or not isinstance(update.get('handle'), int)
+                    or not is_quantity(update.get('quantity'))):
+                raise ValueError(f"Update {idx}: 'handle' must be an integer and 'quantity' an integer between {MIN_QUANTITY} and {MAX_QUANTITY}")
+            updates.append((update['handle'], update['quantity']))
+        options = [create_option(item) for item in items]
+
+        with session.lock:
+            try:
+                added = session.apply_patch(updates, removals, items, options)
+            except KeyError as e:
+                return jsonify({'error': f"Unknown position handle {e.args[0]}"}), 404
+            response = session_summary(session)
+        response['added_handles'] = added
+        return jsonify(response), 200
+
+    except ValueError as e:
+        return jsonify({'error': f'Validation error: {str(e)}'}), 400
+    except RuntimeError as e:
+        return jsonify({'error': f'Runtime error: {str(e)}'}), 500
+    except Exception as e:
+        app.logger.error(f"Unexpected error: {traceback.format_exc()}")
+        return jsonify({'error': f'Internal server error: {str(e)}'}), 500
+
+@app.route('/portfolios/<portfolio_id>', methods=['DELETE'])
+def delete_portfolio_session(portfolio_id):
+    if not PORTFOLIO_SESSIONS.delete(portfolio_id):
+        return session_not_found(portfolio_id)
+    return jsonify({'success': True, 'portfolio_id': portfolio_id}), 200
+
+@app.route('/portfolios/<portfolio_id>/market_data', methods=['PUT'])
+def update_portfolio_session_market_data(portfolio_id):
+    session = PORTFOLIO_SESSIONS.get(portfolio_id)
+    if session is None:
+        return session_not_found(portfolio_id)
+    try:
+        data = request.get_json(silent=True) or {}
+        market_data = validated_market_data(data.get('market_data', {}))
+        with session.lock:
+            session.set_market_data(market_data)
+            version = session.market_data.get_version()
+        return jsonify({'portfolio_id': portfolio_id, 'market_data_version': version,
+                        'updated_assets': sorted(market_data.keys())}), 200
+
+    except ValueError as e:
+        return jsonify({'error': f'Validation error: {str(e)}'}), 400
+    except RuntimeError as e:
+        return jsonify({'error': f'Runtime error: {str(e)}'}), 500
+
+@app.route('/portfolios/<portfolio_id>/risk', methods=['POST'])
+def portfolio_session_risk(portfolio_id):
+    """
+    Greeks of a registered book, refreshed incrementally. Assets without
+    market data are fetched as in /calculate_risk. VaR needs a full Monte
+    Carlo run and is only computed when 'var_parameters' is given.
+    """
+    session = PORTFOLIO_SESSIONS.get(portfolio_id)
+    if session is None:
+        return session_not_found(portfolio_id)
+    try:
+        data = request.get_json(silent=True) or {}
+        market_data = validated_market_data(data.get('market_data', {}))
+        var_params = data.get('var_parameters')
+        var_config = validate_var_parameters(var_params) if var_params is not None else None
+
+        with session.lock:
+            session.set_market_data(market_data)
+            missing = session.missing_assets()
+            if missing:
+                fetched = auto_fetch_missing_market_data(set(missing), {})
+                for asset_id, md in fetched.items():
+                    validate_market_data(asset_id, md)
+                session.set_market_data(to_cpp_market_data(fetched))
+
+            if len(session.portfolio) == 0:
+                return jsonify({'error': 'Portfolio cannot be empty'}), 400
+
+            greeks, repriced, subtotals = session.refresh()
+            result_py = {
+                'portfolio_id': portfolio_id,
+                'total_pv': greeks.total_pv,
+                'total_delta': greeks.total_delta,
+                'total_gamma': greeks.total_gamma,
+                'total_vega': greeks.total_vega,
+                'total_theta': greeks.total_theta,
+                'portfolio_size': len(session.portfolio),
+                'repriced_positions': repriced,
+                'asset_subtotals': {
+                    asset: {
+                        'pv': s.total_pv,
+                        'delta': s.total_delta,
+                        'gamma': s.total_gamma,
+                        'vega': s.total_vega,
+                        'theta': s.total_theta
+                    } for asset, s in subtotals.items()
+                },
+                'market_data_info': {'auto_fetched_assets': missing}
+            }
+
+            if var_config is not None:
+                risk = RISK_ENGINE.calculate_portfolio_risk(
+                    session.portfolio,
+                    session.market_data.get_all_market_data(),
+                    risk_config(var_config)
+                )
+                result_py['value_at_risk_95'] = risk.value_at_risk_95
+                result_py['value_at_risk_99'] = risk.value_at_risk_99
+                result_py['var_parameters'] = {
+                    'simulations': var_config['simulations'],
+                    'confidence_level': var_config['confidence'],
+                    'time_horizon_days': var_config['time_horizon']
+                }
+                if risk.diagnostics.enabled:
+                    result_py['diagnostics'] = diagnostics_to_json(risk.diagnostics)
+
+        return jsonify(result_py), 200
+
+    except ValueError as e:
+        return jsonify({'error': f'Validation error: {str(e)}'}), 400
+    except RuntimeError as e:
+        return jsonify({'error': f'Runtime error: {str(e)}'}), 500
+    except Exception as e:
+        app.logger.error(f"Unexpected error: {traceback.format_exc()}")
+        return jsonify({'error': f'Internal server error: {str(e)}'}), 500
+
+@app.route('/portfolios/<portfolio_id>/net_position/<asset_id>', methods=['GET'])
+def portfolio_session_net_position(portfolio_id, asset_id):
+    session = PORTFOLIO_SESSIONS.get(portfolio_id)
+    if session is None:
+        return session_not_found(portfolio_id)
+    with session.lock:
+        net_quantity = session.portfolio.get_total_quantity(asset_id)
+    return jsonify({
+        'asset_id': asset_id,
+        'net_quantity': net_quantity,
+        'direction': 'long' if net_quantity > 0 else ('short' if net_quantity < 0 else 'flat')
+    }), 200
+
 @app.errorhandler(404)
 def not_found(error):
     return jsonify({'error': 'Endpoint not found'}), 404
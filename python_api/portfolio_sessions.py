@@ -0,0 +1,114 @@
+"""
+Server-side portfolio sessions
+
+A session owns a native Portfolio, a MarketDataManager and a RiskSession, so a
+book is parsed and built once and then edited in place. Greeks are refreshed
+incrementally: the RiskSession caches each position's Greeks by handle, so a
+PATCH prices only the added positions, rescales updated quantities and
+subtracts removed ones, and a market move reprices only the positions on the
+assets that changed.
+"""
+
+import threading
+import uuid
+from collections import OrderedDict
+from datetime import datetime
+from typing import Any, Dict, List, Optional, Tuple
+
+import quant_risk_engine
+
+MAX_PORTFOLIO_SESSIONS = 100
+
+
+class PortfolioSession:
+    """One registered book. Callers hold `lock` around every use."""
+
+    def __init__(self, session_id: str):
+        self.id = session_id
+        self.portfolio = quant_risk_engine.Portfolio()
+        self.market_data = quant_risk_engine.MarketDataManager()
+        self.risk_session = quant_risk_engine.RiskSession(self.portfolio, self.market_data)
+        self.lock = threading.Lock()
+        self.created_at = datetime.now()
+        # handle -> the portfolio item as submitted, with its current quantity
+        self.positions: Dict[int, Dict[str, Any]] = {}
+
+    def add_positions(self, items: List[Dict[str, Any]], options: List[Any]) -> List[int]:
+        handles = []
+        for item, option in zip(items, options):
+            handle = self.portfolio.add_instrument(option, item['quantity'])
+            self.positions[handle] = dict(item)
+            handles.append(handle)
+        return handles
+
+    def apply_patch(self, updates: List[Tuple[int, int]], removals: List[int],
+                    items: List[Dict[str, Any]], options: List[Any]) -> List[int]:
+        """Updates, then removals, then additions; unknown handles are rejected
+        before anything changes. Quantities must already be validated to the
+        int32 range, since the binding only rejects them mid-patch."""
+        for handle in [h for h, _ in updates] + removals:
+            if handle not in self.positions:
+                raise KeyError(handle)
+        removed = set(removals)
+        if len(removed) != len(removals) or any(h in removed for h, _ in updates):
+            raise ValueError("Each handle may be updated or removed at most once per patch")
+
+        for handle, quantity in updates:
+            self.portfolio.update_quantity(self.portfolio.get_index(handle), quantity)
+            self.positions[handle]['quantity'] = quantity
+        for handle in removals:
+            self.portfolio.remove_position(handle)
+            del self.positions[handle]
+        return self.add_positions(items, options)
+
+    def set_market_data(self, market_data: Dict[str, Any]) -> None:
+        for asset_id, md in market_data.items():
+            if self.market_data.has_market_data(asset_id):
+                self.market_data.update_market_data(asset_id, md)
+            else:
+                self.market_data.add_market_data(asset_id, md)
+
+    def assets(self) -> List[str]:
+        return sorted(self.portfolio.get_net_positions().keys())
+
+    def missing_assets(self) -> List[str]:
+        return [a for a in self.assets() if not self.market_data.has_market_data(a)]
+
+    def refresh(self) -> Tuple[Any, int, Dict[str, Any]]:
+        """Greeks for the current book and market, repricing only what changed."""
+        result = self.risk_session.refresh()
+        subtotals = {asset: self.risk_session.get_asset_subtotal(asset) for asset in self.assets()}
+        return result, self.risk_session.get_last_repriced_positions(), subtotals
+
+
+class PortfolioSessionStore:
+    """Registry of live sessions; the least recently used is dropped once
+    `max_sessions` are open."""
+
+    def __init__(self, max_sessions: int = MAX_PORTFOLIO_SESSIONS):
+        self.max_sessions = max_sessions
+        self._sessions: "OrderedDict[str, PortfolioSession]" = OrderedDict()
+        self._lock = threading.Lock()
+
+    def create(self) -> PortfolioSession:
+        session = PortfolioSession(uuid.uuid4().hex)
+        with self._lock:
+            self._sessions[session.id] = session
+            while len(self._sessions) > self.max_sessions:
+                self._sessions.popitem(last=False)
+        return session
+
+    def get(self, session_id: str) -> Optional[PortfolioSession]:
+        with self._lock:
+            session = self._sessions.get(session_id)
+            if session is not None:
+                self._sessions.move_to_end(session_id)
+            return session
+
+    def delete(self, session_id: str) -> bool:
+        with self._lock:
+            return self._sessions.pop(session_id, None) is not None
+
+    def __len__(self) -> int:
+        with self._lock:
+            return len(self._sessions)
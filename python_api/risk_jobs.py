@@ -0,0 +1,151 @@
+"""
+Asynchronous risk jobs
+
+A job runs one portfolio risk calculation on a bounded worker pool. The native
+RiskRunControl attached to each job reports simulation progress and partial
+results while it runs, and cancelling it stops the Monte Carlo loop within one
+block of paths.
+"""
+
+import os
+import threading
+import uuid
+from collections import OrderedDict
+from concurrent.futures import ThreadPoolExecutor
+from datetime import datetime
+from typing import Any, Callable, Dict, Optional
+
+import quant_risk_engine
+
+RISK_JOB_WORKERS = int(os.environ.get('RISK_JOB_WORKERS', min(4, os.cpu_count() or 1)))
+MAX_PENDING_RISK_JOBS = 32
+MAX_FINISHED_RISK_JOBS = 200
+
+QUEUED = 'queued'
+RUNNING = 'running'
+COMPLETED = 'completed'
+FAILED = 'failed'
+CANCELLED = 'cancelled'
+FINISHED = (COMPLETED, FAILED, CANCELLED)
+
+
+class RiskJobQueueFull(Exception):
+    pass
+
+
+class RiskJob:
+    """State of one submitted calculation. Fields change under the queue lock."""
+
+    def __init__(self, job_id: str, total_simulations: int):
+        self.id = job_id
+        self.control = quant_risk_engine.RiskRunControl()
+        self.total_simulations = total_simulations
+        self.status = QUEUED
+        self.created_at = datetime.now()
+        self.started_at: Optional[datetime] = None
+        self.finished_at: Optional[datetime] = None
+        self.result: Optional[Dict[str, Any]] = None
+        self.error: Optional[str] = None
+        self.future = None
+
+
+class RiskJobQueue:
+    """Runs jobs on `workers` threads. At most `max_pending` jobs may be queued
+    or running; the oldest finished jobs are forgotten past `max_finished`."""
+
+    def __init__(self, workers: int = RISK_JOB_WORKERS,
+                 max_pending: int = MAX_PENDING_RISK_JOBS,
+                 max_finished: int = MAX_FINISHED_RISK_JOBS):
+        self.workers = workers
+        self.max_pending = max_pending
+        self.max_finished = max_finished
+        self._executor = ThreadPoolExecutor(max_workers=workers, thread_name_prefix='risk-job')
+        self._jobs: "OrderedDict[str, RiskJob]" = OrderedDict()
+        self._lock = threading.Lock()
+
+    def submit(self, run: Callable[[Any], Dict[str, Any]], total_simulations: int) -> RiskJob:
+        """Queues run(control), which returns the job's JSON result."""
+        job = RiskJob(uuid.uuid4().hex, total_simulations)
+        with self._lock:
+            if self._pending() >= self.max_pending:
+                raise RiskJobQueueFull(f"{self.max_pending} risk jobs are already queued or running")
+            self._jobs[job.id] = job
+            self._prune()
+            job.future = self._executor.submit(self._run, job, run)
+        return job
+
+    def get(self, job_id: str) -> Optional[RiskJob]:
+        with self._lock:
+            return self._jobs.get(job_id)
+
+    def cancel(self, job_id: str) -> Optional[RiskJob]:
+        """Cancels a queued job outright and signals a running one to stop."""
+        with self._lock:
+            job = self._jobs.get(job_id)
+            if job is None or job.status in FINISHED:
+                return job
+            job.control.cancel()
+            if job.status == QUEUED and job.future.cancel():
+                self._finish(job, CANCELLED)
+            return job
+
+    def snapshot(self, job: RiskJob) -> Dict[str, Any]:
+        with self._lock:
+            completed = job.control.get_completed_simulations()
+            response = {
+                'job_id': job.id,
+                'status': job.status,
+                'progress': 1.0 if job.status == COMPLETED else job.control.get_progress(),
+                'completed_simulations': job.total_simulations if job.status == COMPLETED else completed,
+                'total_simulations': job.total_simulations,
+                'created_at': job.created_at.isoformat(),
+                'started_at': job.started_at.isoformat() if job.started_at else None,
+                'finished_at': job.finished_at.isoformat() if job.finished_at else None
+            }
+            if job.error is not None:
+                response['error'] = job.error
+            if job.result is not None:
+                response['result'] = job.result
+            return response
+
+    def stats(self) -> Dict[str, Any]:
+        with self._lock:
+            counts = {status: 0 for status in (QUEUED, RUNNING) + FINISHED}
+            for job in self._jobs.values():
+                counts[job.status] += 1
+            return {'workers': self.workers, 'max_pending': self.max_pending, 'jobs': counts}
+
+    def _run(self, job: RiskJob, run: Callable[[Any], Dict[str, Any]]) -> None:
+        with self._lock:
+            if job.control.is_cancelled():
+                self._finish(job, CANCELLED)
+                return
+            job.status = RUNNING
+            job.started_at = datetime.now()
+        try:
+            result = run(job.control)
+        except quant_risk_engine.RiskCalculationCancelled:
+            with self._lock:
+                self._finish(job, CANCELLED)
+            return
+        except Exception as e:
+            with self._lock:
+                job.error = str(e)
+                self._finish(job, FAILED)
+            return
+        with self._lock:
+            job.result = result
+            self._finish(job, COMPLETED)
+
+    def _finish(self, job: RiskJob, status: str) -> None:
+        job.status = status
+        job.finished_at = datetime.now()
+        self._prune()
+
+    def _pending(self) -> int:
+        return sum(1 for job in self._jobs.values() if job.status not in FINISHED)
+
+    def _prune(self) -> None:
+        finished = [job_id for job_id, job in self._jobs.items() if job.status in FINISHED]
+        for job_id in finished[:max(0, len(finished) - self.max_finished)]:
+            del self._jobs[job_id]
@@ -10,9 +10,21 @@ ext_modules = [
             '../cpp_engine/apps/main.cpp',
             '../cpp_engine/libraries/python_interface/src/pybind_wrapper.cpp',
             '../cpp_engine/libraries/qe_risk_engine/src/Portfolio.cpp',
+            '../cpp_engine/libraries/qe_risk_engine/src/PortfolioFile.cpp',
             '../cpp_engine/libraries/qe_risk_engine/src/RiskEngine.cpp',
+            '../cpp_engine/libraries/qe_risk_engine/src/RiskSession.cpp',
+            '../cpp_engine/libraries/qe_risk_engine/src/RiskResultCache.cpp',
+            '../cpp_engine/libraries/qe_risk_engine/src/Ingestion.cpp',
+            '../cpp_engine/libraries/qe_risk_engine/src/Json.cpp',
+            '../cpp_engine/libraries/qe_risk_engine/src/TraceRecorder.cpp',
+            '../cpp_engine/libraries/qe_risk_engine/src/Philox.cpp',
+            '../cpp_engine/libraries/qe_risk_engine/src/VaRShard.cpp',
+            '../cpp_engine/libraries/qe_risk_engine/src/BatchPricing.cpp',
             '../cpp_engine/libraries/qe_risk_engine/src/BlackScholes.cpp',
             '../cpp_engine/libraries/qe_risk_engine/src/BinomialTree.cpp',
+            '../cpp_engine/libraries/qe_risk_engine/src/FiniteDifference.cpp',
+            '../cpp_engine/libraries/qe_risk_engine/src/AndersenLakeOffengeld.cpp',
+            '../cpp_engine/libraries/qe_risk_engine/src/BaroneAdesiWhaley.cpp',
             '../cpp_engine/libraries/qe_risk_engine/src/JumpDiffusion.cpp',
             '../cpp_engine/libraries/qe_risk_engine/src/ImpliedVolatilitySurface.cpp',
             '../cpp_engine/libraries/qe_risk_engine/src/MarketData.cpp',
@@ -0,0 +1,73 @@
+"""
+Test Suite for the bulk pricing endpoint
+Checks /price_options against /price_option and its request limits
+"""
+
+import pytest
+
+MARKET_DATA = {'AAPL': {'spot': 180.0, 'rate': 0.045, 'vol': 0.28, 'dividend': 0.02}}
+
+
+class TestPriceOptions:
+    """Test /price_options"""
+    
+    @pytest.fixture
+    def client(self):
+        """Create test client"""
+        from app import app as flask_app
+        flask_app.config['TESTING'] = True
+        
+        with flask_app.test_client() as client:
+            yield client
+    
+    @pytest.mark.parametrize('style,pricing_model', [
+        ('european', 'blackscholes'),
+        ('european', 'jumpdiffusion'),
+        ('american', 'binomial'),
+    ])
+    def test_matches_price_option_with_dividend(self, client, style, pricing_model):
+        """Bulk Greeks equal single-option Greeks when the dividend is non-zero"""
+        strikes = [160.0, 180.0, 200.0]
+        response = client.post('/price_options', json={
+            'options': {'type': ['call', 'put', 'call'], 'strike': strikes, 'expiry': [0.5, 0.5, 1.0],
+                        'asset_id': 'AAPL', 'style': style, 'pricing_model': pricing_model},
+            'market_data': MARKET_DATA
+        })
+        assert response.status_code == 200
+        bulk = response.get_json()
+        assert bulk['failed'] == 0
+        assert bulk['market_data_info']['market_data_used']['AAPL']['dividend'] == 0.02
+        
+        for i, strike in enumerate(strikes):
+            response = client.post('/price_option', json={
+                'type': bulk['type'][i], 'strike': strike, 'expiry': bulk['expiry'][i],
+                'asset_id': 'AAPL', 'style': style, 'pricing_model': pricing_model,
+                'market_data': MARKET_DATA['AAPL']
+            })
+            assert response.status_code == 200
+            single = response.get_json()
+            for greek in ['price', 'delta', 'gamma', 'vega', 'theta']:
+                assert bulk[greek][i] == pytest.approx(single[greek], rel=1e-12, abs=1e-12)
+    
+    @pytest.mark.parametrize('field', ['binomial_steps', 'jump_parameters', 'fd_grid'])
+    def test_rejects_per_option_model_parameters(self, client, field):
+        """Parameters the batch path cannot honour are refused, not ignored"""
+        response = client.post('/price_options', json={
+            'chain': {'asset_id': 'AAPL', 'expiries': [0.5], 'strikes': [180.0], field: 200},
+            'market_data': MARKET_DATA
+        })
+        assert response.status_code == 400
+        assert field in response.get_json()['error']
+    
+    def test_rejects_oversized_chain(self, client):
+        """A chain past the option limit is refused before it is expanded"""
+        response = client.post('/price_options', json={
+            'chain': {'asset_id': 'AAPL', 'expiries': [0.5] * 1000, 'strikes': [180.0] * 1000},
+            'market_data': MARKET_DATA
+        })
+        assert response.status_code == 400
+        assert 'At most' in response.get_json()['error']
+
+
+if __name__ == '__main__':
+    pytest.main([__file__, '-v'])
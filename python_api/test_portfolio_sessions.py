@@ -0,0 +1,66 @@
+"""
+Test Suite for server-side portfolio sessions
+Checks that a rejected PATCH leaves the registered book untouched
+"""
+
+import pytest
+
+ITEM = {'type': 'call', 'strike': 180.0, 'expiry': 0.5, 'asset_id': 'AAPL', 'quantity': 10}
+MARKET_DATA = {'AAPL': {'spot': 180.0, 'rate': 0.045, 'vol': 0.28}}
+
+
+class TestPortfolioSessionPatch:
+    """Test PATCH /portfolios/<id>"""
+
+    @pytest.fixture
+    def client(self):
+        """Create test client"""
+        from app import app as flask_app
+        flask_app.config['TESTING'] = True
+
+        with flask_app.test_client() as client:
+            yield client
+
+    @pytest.fixture
+    def session(self, client):
+        """Register a two-position book"""
+        response = client.post('/portfolios', json={
+            'portfolio': [ITEM, dict(ITEM, strike=200.0, quantity=-5)],
+            'market_data': MARKET_DATA
+        })
+        assert response.status_code == 201
+        return response.get_json()
+
+    @pytest.mark.parametrize('quantity', [2**31, -2**31 - 1, 10**20])
+    @pytest.mark.parametrize('part', ['update', 'add'])
+    def test_out_of_range_quantity_changes_nothing(self, client, session, part, quantity):
+        """An int32 overflow in any part is refused before earlier parts apply"""
+        kept, removed = session['handles']
+        patch = {'update': [{'handle': kept, 'quantity': 7}], 'remove': [removed]}
+        if part == 'update':
+            patch['update'].append({'handle': removed, 'quantity': quantity})
+            patch['remove'] = []
+        else:
+            patch['add'] = [dict(ITEM, quantity=quantity)]
+
+        response = client.patch(f"/portfolios/{session['portfolio_id']}", json=patch)
+        assert response.status_code == 400
+        assert 'quantity' in response.get_json()['error']
+
+        book = client.get(f"/portfolios/{session['portfolio_id']}").get_json()
+        assert book['version'] == session['version']
+        assert sorted((p['handle'], p['quantity']) for p in book['positions']) == \
+            [(kept, 10), (removed, -5)]
+
+    def test_int32_bounds_are_accepted(self, client, session):
+        """The extremes of the native quantity type still go through"""
+        kept, other = session['handles']
+        response = client.patch(f"/portfolios/{session['portfolio_id']}", json={
+            'update': [{'handle': kept, 'quantity': 2**31 - 1},
+                       {'handle': other, 'quantity': -2**31}]
+        })
+        assert response.status_code == 200
+
+
+if __name__ == '__main__':
+    pytest.main([__file__, '-v'])